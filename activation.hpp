@@ -0,0 +1,210 @@
+/********************************************************************************
+* activation.hpp: Innehller aktiveringsfunktioner fr dense-lager via
+*                 enumerationen activation_function samt strukttemplaten
+*                 basic_activation. Varje lager har en egen aktiverings-
+*                 funktion, vilken vljs en gng per lager via en switch-sats,
+*                 varefter samtliga noder berknas i en loop utan ytterligare
+*                 frgreningar. Exponentialfunktionen samt tanh berknas via de
+*                 vektoriserade berkningskrnorna i strukten simd_kernels.
+********************************************************************************/
+#ifndef ACTIVATION_HPP_
+#define ACTIVATION_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "simd.hpp"
+#include <cstddef>
+
+/********************************************************************************
+* activation_function: Aktiveringsfunktion fr ett dense-lager:
+*
+*                      - relu      : max(0, x), vilket anvnds som default.
+*                      - leaky_relu: x om x > 0, annars 0.01 * x, vilket gr
+*                                    att inaktiva noder fortfarande trnas.
+*                      - sigmoid   : 1 / (1 + e^-x), utsignaler mellan 0 - 1.
+*                      - tanh      : tanh(x), utsignaler mellan -1 och 1.
+*                      - linear    : x, exempelvis fr regression i
+*                                    utgngslagret.
+*                      - softmax   : e^x / summan av e^x fr lagrets samtliga
+*                                    noder, vilket ger utsignaler som summeras
+*                                    till 1, exempelvis fr klassificering.
+*
+*                      Vrdena lagras i modellfiler och fr drmed inte ndras.
+********************************************************************************/
+enum class activation_function { relu, leaky_relu, sigmoid, tanh, linear, softmax };
+
+/********************************************************************************
+* basic_activation: Strukt fr berkning av aktiveringsfunktioner samt deras
+*                   derivator fr flyttal av typen T (float eller double).
+*                   Derivatan berknas via nodernas utsignaler i stllet fr
+*                   via summorna innan aktivering, vilket gr att inga extra
+*                   buffertar krvs vid baktpropagering.
+********************************************************************************/
+template <typename T>
+struct basic_activation
+{
+   using kernels_type = basic_simd_kernels<T>; /* Berkningskrnor fr aktuell flyttalstyp. */
+
+   static constexpr T leaky_relu_slope = T(0.01); /* Lutning fr negativa vrden vid leaky ReLU. */
+
+   /********************************************************************************
+   * activate: Erstter angivna summor med utsignaler enligt angiven
+   *           aktiveringsfunktion.
+   *
+   *           - function: Aktiveringsfunktionen som ska anvndas.
+   *           - data    : Pekare till nodernas summor, vilka skrivs ver.
+   *           - size    : Antalet noder.
+   ********************************************************************************/
+   static void activate(const activation_function function,
+                        T* data,
+                        const std::size_t size)
+   {
+      const auto& kernels = kernels_type::get();
+
+      switch (function)
+      {
+         case activation_function::relu:
+            kernels.relu(data, size);
+            break;
+         case activation_function::leaky_relu:
+            for (std::size_t i = 0; i < size; ++i)
+            {
+               data[i] = data[i] > 0 ? data[i] : data[i] * leaky_relu_slope;
+            }
+            break;
+         case activation_function::sigmoid:
+            kernels.sigmoid(data, size);
+            break;
+         case activation_function::tanh:
+            kernels.tanh(data, size);
+            break;
+         case activation_function::softmax:
+            softmax(data, size);
+            break;
+         default:
+            break;
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * derivative: Multiplicerar angivna fel med derivatan av angiven
+   *             aktiveringsfunktion, berknad via nodernas utsignaler. Vid
+   *             softmax beror varje utsignal p samtliga noders summor,
+   *             varfr felet i stllet multipliceras med hela Jacobimatrisen,
+   *             vilket ger error[i] = output[i] * (error[i] - summan av
+   *             error[j] * output[j]).
+   *
+   *             - function: Aktiveringsfunktionen som anvndes vid aktivering.
+   *             - error   : Pekare till nodernas fel, vilka skrivs ver.
+   *             - output  : Pekare till nodernas utsignaler.
+   *             - size    : Antalet noder.
+   ********************************************************************************/
+   static void derivative(const activation_function function,
+                          T* error,
+                          const T* output,
+                          const std::size_t size)
+   {
+      const auto& kernels = kernels_type::get();
+
+      switch (function)
+      {
+         case activation_function::relu:
+            kernels.delta_relu(error, output, size);
+            break;
+         case activation_function::leaky_relu:
+            for (std::size_t i = 0; i < size; ++i)
+            {
+               error[i] = output[i] > 0 ? error[i] : error[i] * leaky_relu_slope;
+            }
+            break;
+         case activation_function::sigmoid:
+            for (std::size_t i = 0; i < size; ++i)
+            {
+               error[i] *= output[i] * (T(1) - output[i]);
+            }
+            break;
+         case activation_function::tanh:
+            for (std::size_t i = 0; i < size; ++i)
+            {
+               error[i] *= T(1) - output[i] * output[i];
+            }
+            break;
+         case activation_function::softmax:
+         {
+            const auto sum = kernels.dot(error, output, size);
+
+            for (std::size_t i = 0; i < size; ++i)
+            {
+               error[i] = output[i] * (error[i] - sum);
+            }
+            break;
+         }
+         default:
+            break;
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * name: Returnerar namnet p angiven aktiveringsfunktion som text.
+   *
+   *       - function: Aktuell aktiveringsfunktion.
+   ********************************************************************************/
+   static const char* name(const activation_function function)
+   {
+      switch (function)
+      {
+         case activation_function::relu:       return "relu";
+         case activation_function::leaky_relu: return "leaky_relu";
+         case activation_function::sigmoid:    return "sigmoid";
+         case activation_function::tanh:       return "tanh";
+         case activation_function::linear:     return "linear";
+         case activation_function::softmax:    return "softmax";
+         default:                              return "unknown";
+      }
+   }
+
+private:
+   /********************************************************************************
+   * softmax: Berknar softmax fr angivna summor. Det strsta vrdet dras
+   *          frst av frn samtliga summor, vilket inte pverkar resultatet
+   *          men frhindrar att exponentialfunktionen ger fr stora tal.
+   *
+   *          - data: Pekare till nodernas summor, vilka skrivs ver.
+   *          - size: Antalet noder.
+   ********************************************************************************/
+   static void softmax(T* data,
+                       const std::size_t size)
+   {
+      if (size == 0) return;
+      auto max = data[0];
+      auto sum = T(0);
+
+      for (std::size_t i = 1; i < size; ++i)
+      {
+         max = data[i] > max ? data[i] : max;
+      }
+
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         data[i] -= max;
+      }
+
+      kernels_type::get().exp(data, size);
+
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         sum += data[i];
+      }
+
+      const auto scale = T(1) / sum;
+
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         data[i] *= scale;
+      }
+      return;
+   }
+};
+
+#endif /* ACTIVATION_HPP_ */
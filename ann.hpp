@@ -1,383 +1,2492 @@
 /********************************************************************************
 * ann.hpp: Innehller funktionalitet fr implementering av artificiella
-*          neurala ntverk via klassen ann (ANN = Artificial Neural Network).
+*          neurala ntverk via klasstemplaten basic_ann samt klassen ann
+*          (ANN = Artificial Neural Network).
 ********************************************************************************/
 #ifndef ANN_HPP_
 #define ANN_HPP_
 
 /* Inkluderingsdirektiv: */
 #include "dense_layer.hpp"
+#include "dataset.hpp"
+#include "model_file.hpp"
+#include "random.hpp"
+#include "parallel.hpp"
+#include "batch_loader.hpp"
 #include <vector>
+#include <initializer_list>
+#include <thread>
+#include <atomic>
 #include <iostream>
-#include <cstdlib>
+#include <utility>
 
 /********************************************************************************
-* ann: Klass fr implementering av neuralt ntverk innehllande ett ingngslager,
-*      ett dolt lager samt ett utgngslager med godtyckligt antal noder.
-*      Trningsdata kan passeras via vektorer. Efter trning kan prediktion
-*      med utskrift genomfras med godtycklig indata eller med indata frn 
-*      befintliga trningsuppstningar.
+* basic_early_stopping: Villkor fr att avbryta trningen i frtid, vilka
+*                       utvrderas efter varje epok. Som default anvnds inga
+*                       villkor, vilket innebr att samtliga epoker genomfrs.
+*                       Frlusten som utvrderas utgrs av valideringsfrlusten
+*                       om en andel av trningsdatan reserveras fr validering,
+*                       annars av trningsfrlusten.
 ********************************************************************************/
-class ann
+template <typename T>
+struct basic_early_stopping
 {
+   std::size_t patience{0}; /* Antalet epoker utan frbttring innan avbrott (0 = inget avbrott). */
+   T tolerance{0};          /* Minsta minskning av frlusten som rknas som en frbttring. */
+   T target_loss{0};        /* Trningen avbryts nr frlusten understiger detta vrde. */
+   T validation_split{0};   /* Andel av trningsdatan (0 - 1) som reserveras fr validering. */
+};
+
+/********************************************************************************
+* basic_train_stats: Statistik frn en trningsomgng, dr frlusten utgrs av
+*                    medelkvadratfelet (MSE) per utsignal. Trningsfrlusten
+*                    ackumuleras under epoken via felen som redan berknas vid
+*                    baktpropageringen, vilket innebr att varje bidrag
+*                    berknas innan parametrarna justeras fr aktuell
+*                    trningsuppsttning.
+********************************************************************************/
+template <typename T>
+struct basic_train_stats
+{
+   std::size_t epochs{0};          /* Antalet genomfrda epoker. */
+   std::size_t best_epoch{0};      /* Epoken (rknat frn 1) d lgst frlust uppmttes. */
+   T best_loss{0};                 /* Lgsta uppmtta frlust. */
+   bool stopped_early{false};      /* Indikerar ifall ngot villkor fr avbrott uppfylldes. */
+   std::vector<T> train_loss;      /* Trningsfrlusten fr varje epok. */
+   std::vector<T> validation_loss; /* Valideringsfrlusten fr varje epok (tom utan validering). */
+};
+
+/********************************************************************************
+* basic_ann: Klass fr implementering av neuralt ntverk innehllande ett
+*            ingngslager, godtyckligt antal dolda lager samt ett utgngslager
+*            med godtyckligt antal noder i varje lager. Lagren lagras i en
+*            vektor, dr det sista lagret utgr utgngslagret. Trningsdata
+*            kan passeras via vektorer. Efter trning kan prediktion med
+*            utskrift genomfras med godtycklig indata eller med indata frn
+*            befintliga trningsuppstningar. Samtliga parametrar, in- och
+*            utdata lagras som flyttal av typen T, dr float halverar
+*            ntverkets minnesbehov jmfrt med double och gr att dubbelt s
+*            mnga flyttal behandlas per SIMD-instruktion.
+********************************************************************************/
+template <typename T>
+class basic_ann
+{
+public:
+   using value_type = T;                                 /* Flyttalstyp fr parametrar samt in- och utdata. */
+   using layer_type = basic_dense_layer<T>;              /* Ntverkets dense-lager. */
+   using matrix_type = basic_matrix<T>;                  /* Matristyp fr batchbuffertar. */
+   using matrix_view_type = basic_matrix_view<T>;        /* Vy ver trningsdata lagrad av anvndaren. */
+   using inference_context = basic_inference_context<T>; /* Buffertar fr prediktion. */
+   using early_stopping_type = basic_early_stopping<T>;  /* Villkor fr avbrott av trningen. */
+   using train_stats_type = basic_train_stats<T>;        /* Statistik frn trningen. */
+   using optimizer_type = basic_optimizer<T>;            /* Instllningar fr justering av parametrar. */
+   using update_type = basic_optimizer_update<T>;        /* Instllningar fr en enskild justering. */
+   using schedule_type = basic_schedule<T>;              /* Schemalggning av lrhastigheten. */
+   using loader_type = basic_batch_loader<T>;            /* Asynkron inlsning av batchar. */
+   using loaded_batch_type = basic_loaded_batch<T>;      /* Batch packad av inlsningstrden. */
+
 private:
-   dense_layer hidden_layer_;                   /* Dolt lager. */
-   dense_layer output_layer_;                   /* Utgngslager. */
-   std::vector<std::vector<double>> train_in_;  /* Trningsdata in (insignaler). */
-   std::vector<std::vector<double>> train_out_; /* Trningsdata ut (referensvrden). */
-   std::vector<std::size_t> train_order_;       /* Lagrar ordningsfljden fr trningsdatan. */
+   /********************************************************************************
+   * layer_workspace: Trdlokala buffertar fr ett dense-lager vid parallell
+   *                  trning, vilket gr att varje trd kan genomfra framt-
+   *                  och baktpropagering samt berkna justeringar utan att
+   *                  skriva till det delade lagret. Utsignaler och fel placeras
+   *                  med raderna vxelvis i trdens arena, s att varje
+   *                  trningsexempels utsignaler och fel ligger intill
+   *                  varandra vid baktpropagering.
+   ********************************************************************************/
+   struct layer_workspace
+   {
+      matrix_type output;           /* Utsignaler, en rad per trningsexempel. */
+      matrix_type error;            /* Fel, en rad per trningsexempel. */
+      matrix_type weight_gradient;  /* Summerade viktbidrag fr aktuell batch. */
+      std::vector<T> bias_gradient; /* Summerade biasbidrag fr aktuell batch. */
+
+      static std::size_t arena_bytes(const layer_type& layer, const std::size_t num_samples, const bool gradients)
+      {
+         return 2 * memory_arena::round_up(matrix_type::storage_bytes(num_samples, layer.num_nodes())) +
+            (gradients ? memory_arena::round_up(matrix_type::storage_bytes(layer.num_nodes(), layer.num_weights())) : 0);
+      }
+
+      void resize(const layer_type& layer, const std::size_t num_samples, const bool gradients, memory_arena& arena)
+      {
+         matrix_type::resize_interleaved(this->output, this->error, num_samples, layer.num_nodes(), T(0), arena);
+         if (!gradients) return;
+         this->weight_gradient.resize(layer.num_nodes(), layer.num_weights(), T(0), arena);
+         this->bias_gradient.assign(layer.num_nodes(), T(0));
+         return;
+      }
+   };
+
+   /********************************************************************************
+   * worker_workspace: Samtliga trdlokala buffertar fr en trd vid parallell
+   *                   trning. Trdens matriser placeras i en egen arena, vilken
+   *                   allokeras av trden sjlv, s att minnet placeras nra
+   *                   trden p system med flera NUMA-noder. Varje arbetsyta
+   *                   startar dessutom p en egen cache-linje, vilket gr att
+   *                   trdarnas skrivningar till exempelvis loss aldrig delar
+   *                   cache-linje med en annan trds data.
+   ********************************************************************************/
+   struct alignas(memory_arena::alignment) worker_workspace
+   {
+      memory_arena arena;                  /* Minnesblock fr trdens matriser. */
+      matrix_type input;                   /* Insignaler fr trdens del av aktuell batch. */
+      matrix_type reference;               /* Referensvrden fr trdens del av aktuell batch. */
+      std::vector<layer_workspace> layers; /* Buffertar fr respektive lager. */
+      T loss{0};                           /* Summerade kvadrerade fel under aktuell epok. */
+
+      void resize(const std::vector<layer_type>& network_layers, const std::size_t num_samples,
+                  const bool gradients = true)
+      {
+         if (network_layers.empty()) return;
+         const auto num_inputs = network_layers.front().num_weights();
+         const auto num_outputs = network_layers.back().num_nodes();
+         auto size = memory_arena::round_up(matrix_type::storage_bytes(num_samples, num_inputs)) +
+            memory_arena::round_up(matrix_type::storage_bytes(num_samples, num_outputs));
+         for (const auto& i : network_layers) size += layer_workspace::arena_bytes(i, num_samples, gradients);
+
+         this->arena.reserve(size);
+         this->input.resize(num_samples, num_inputs, T(0), this->arena);
+         this->reference.resize(num_samples, num_outputs, T(0), this->arena);
+         this->layers.resize(network_layers.size());
+
+         for (std::size_t i = 0; i < network_layers.size(); ++i)
+         {
+            this->layers[i].resize(network_layers[i], num_samples, gradients, this->arena);
+         }
+         return;
+      }
+   };
+
+   std::vector<layer_type> layers_;        /* Dolda lager fljt av utgngslagret. */
+   std::vector<std::vector<T>> train_in_;  /* Trningsdata in (insignaler). */
+   std::vector<std::vector<T>> train_out_; /* Trningsdata ut (referensvrden). */
+   matrix_view_type train_in_view_;        /* Vy ver anvndarens indata (erstter train_in_). */
+   matrix_view_type train_out_view_;       /* Vy ver anvndarens utdata (erstter train_out_). */
+   std::vector<std::size_t> train_order_;  /* Lagrar ordningsfljden fr trningsdatan. */
+   random_generator generator_;            /* Generator fr startvrden och trningsordning. */
+   matrix_type batch_input_;               /* Insignaler fr aktuell batch, en rad per exempel. */
+   matrix_type batch_reference_;           /* Referensvrden fr aktuell batch. */
+   optimizer_type optimizer_;              /* Instllningar fr justering av parametrar. */
+   schedule_type schedule_;                /* Schemalggning av lrhastigheten. */
+   std::size_t optimizer_steps_{0};        /* Antalet genomfrda justeringar sedan nollstllning. */
+   std::size_t prefetch_{0};               /* Antalet buffertar vid asynkron inlsning (0 = synkron). */
+   bool transposed_weights_{false};        /* Indikerar ifall lagren har transponerade viktkopior. */
+   bool step_prepared_{false};             /* Indikerar ifall lagren r frberedda, se prepare_step. */
+   memory_arena arena_;                    /* Minnesblock fr lagrens matriser, se pack_layers. */
+
+   static constexpr std::size_t prefetch_chunk = 64; /* Trningsuppsttningar per buffert utan batchar. */
 
    /********************************************************************************
    * feedforward: Berknar nya utsignaler fr samtliga noder i det neurala ntverk
    *              via angiven indata.
    * 
-   *              - input: Referens till vektor innehllande ny indata.
+   *              - input: Pekare till ny indata.
+   *              - size : Antalet insignaler.
    ********************************************************************************/
-   void feedforward(const std::vector<double>& input)
+   void feedforward(const T* input,
+                    const std::size_t size)
    {
-      this->hidden_layer_.feedforward(input);
-      this->output_layer_.feedforward(this->hidden_layer_.output);
+      if (this->layers_.empty()) return;
+      ANN_INSTRUMENT_SCOPE(feedforward, 1);
+      this->layers_[0].feedforward(input, size, this->layers_[0].output.data());
+
+      for (std::size_t i = 1; i < this->layers_.size(); ++i)
+      {
+         this->layers_[i].feedforward(this->layers_[i - 1].output);
+      }
       return;
    }
 
    /********************************************************************************
-   * backpropagate: Berknar aktuella fel fr samtliga noder i angiven neuralt
-   *                ntverk via jmfrelse med referensdata innehllande korrekta
-   *                utsignaler, vilket jmfrs med predikterade utsignaler.
+   * backpropagate_optimize: Berknar aktuella fel fr samtliga noder i angivet
+   *                         neuralt ntverk via jmfrelse med referensdata
+   *                         och justerar samtidigt ntverkets parametrar fr
+   *                         att minska uppkommet fel. Utgngslagrets fel
+   *                         berknas frst, varefter varje lager i omvnd
+   *                         ordning berknar fregende lagers fel och
+   *                         justerar sina egna vikter i samma genomlsning
+   *                         av viktmatrisen, se medlemsfunktionen
+   *                         backpropagate_optimize i strukten dense_layer.
+   *                         Drmed lses varje viktmatris tv gnger per
+   *                         trningsuppsttning i stllet fr tre, med
+   *                         samma resultat som baktpropagering fljt av
+   *                         justering. Returnerar summan av utgngslagrets
+   *                         kvadrerade fel.
    *
-   *                - reference: Referens till vektor innehllande korrekta vrden.
+   *                         - input        : Pekare till aktuell indata.
+   *                         - size         : Antalet insignaler.
+   *                         - reference    : Pekare till korrekta vrden, vilka
+   *                                          mste innehlla num_outputs() flyttal.
+   *                         - update       : Instllningar fr aktuell justering,
+   *                                          se medlemsfunktionen next_update.
    ********************************************************************************/
-   void backpropagate(const std::vector<double>& reference)
+   T backpropagate_optimize(const T* input,
+                            const std::size_t size,
+                            const T* reference,
+                            const update_type& update)
    {
-      this->output_layer_.backpropagate(reference);
-      this->hidden_layer_.backpropagate(this->output_layer_);
-      return;
+      if (this->layers_.empty()) return T(0);
+      ANN_INSTRUMENT_SCOPE(backpropagate_optimize, 1);
+      const auto loss = this->layers_.back().backpropagate(reference);
+
+      for (auto i = this->layers_.size() - 1; i > 0; --i)
+      {
+         this->layers_[i].backpropagate_optimize(this->layers_[i - 1], update);
+      }
+
+      this->layers_[0].optimize(input, size, update);
+      return loss;
    }
 
    /********************************************************************************
-   * optimize: Justerar parametrar i angivet neuralt ntverk fr att minska 
-   *           uppkommet fel. Vid nsta prediktion br drmed felet ha minskat
-   *           och precisionen r d hgre.
+   * feedforward: Berknar nya utsignaler fr samtliga noder i det neurala ntverket
+   *              fr samtliga trningsexempel i aktuell batch.
    *
-   *           - input        : Referens till vektor innehllande aktuell indata.
-   *           - learning_rate: Lrhastigheten, avgr justeringsgraden av
-   *                            parametrarna vid fel.
+   *              - input      : Referens till batchens indata, en rad per exempel.
+   *              - num_samples: Antalet trningsexempel i aktuell batch.
    ********************************************************************************/
-   void optimize(const std::vector<double>& input,
-                 const double learning_rate)
+   void feedforward(const matrix_type& input,
+                    const std::size_t num_samples)
    {
-      this->output_layer_.optimize(this->hidden_layer_.output, learning_rate);
-      this->hidden_layer_.optimize(input, learning_rate);
+      if (this->layers_.empty()) return;
+      ANN_INSTRUMENT_SCOPE(feedforward, num_samples);
+      this->layers_[0].feedforward(input, num_samples);
+
+      for (std::size_t i = 1; i < this->layers_.size(); ++i)
+      {
+         this->layers_[i].feedforward(this->layers_[i - 1].batch_output, num_samples);
+      }
       return;
    }
 
    /********************************************************************************
-   * check_training_data_size: Kontrollerar s att antalet trningsuppsttningar
-   *                           med indata r samma som antalet trningsuppsttningar
-   *                           med utdata. Om detta inte r fallet kortas den
-   *                           strre trningsuppsttningen av s att den matchar
-   *                           den mindre uppsttningen.
+   * backpropagate: Berknar aktuella fel fr samtliga noder i det neurala ntverket
+   *                fr samtliga trningsexempel i aktuell batch. Returnerar
+   *                summan av utgngslagrets kvadrerade fel fr hela batchen.
+   *
+   *                - reference  : Referens till batchens referensvrden.
+   *                - num_samples: Antalet trningsexempel i aktuell batch.
    ********************************************************************************/
-   void check_training_data_size(void)
+   T backpropagate(const matrix_type& reference,
+                   const std::size_t num_samples)
    {
-      if (this->train_in_.size() != this->train_out_.size())
+      if (this->layers_.empty()) return T(0);
+      ANN_INSTRUMENT_SCOPE(backpropagate, num_samples);
+      const auto loss = this->layers_.back().backpropagate(reference, num_samples);
+
+      for (auto i = this->layers_.size() - 1; i > 0; --i)
       {
-         if (this->train_in_.size() > this->train_out_.size())
-         {
-            this->train_in_.resize(this->train_out_.size());
-         }
-         else
-         {
-            this->train_out_.resize(this->train_in_.size());
-         }
+         this->layers_[i].update_transposed();
+         this->layers_[i - 1].backpropagate(this->layers_[i], num_samples);
       }
-      return;
+      return loss;
    }
 
    /********************************************************************************
-   * init_training_order: Initierar vektor innehllande ordningsfljden fr
-   *                      trningsuppsttningarna. Vektorns storlek stts till
-   *                      antalet trningsuppsttningar och den tilldelas index
-   *                      i stigande ordning frn 0.
+   * optimize: Justerar parametrarna i det neurala ntverket en gng fr hela
+   *           aktuell batch.
+   *
+   *           - input      : Referens till batchens indata, en rad per exempel.
+   *           - num_samples: Antalet trningsexempel i aktuell batch.
+   *           - update     : Instllningar fr aktuell justering.
    ********************************************************************************/
-   void init_training_order(void)
+   void optimize(const matrix_type& input,
+                 const std::size_t num_samples,
+                 const update_type& update)
    {
-      this->train_order_.resize(this->train_in_.size());
+      if (this->layers_.empty()) return;
+      ANN_INSTRUMENT_SCOPE(optimize, num_samples);
 
-      for (std::size_t i = 0; i < this->train_order_.size(); ++i)
+      for (auto i = this->layers_.size() - 1; i > 0; --i)
       {
-         this->train_order_[i] = i;
+         this->layers_[i].optimize(this->layers_[i - 1].batch_output, num_samples, update);
       }
+
+      this->layers_[0].optimize(input, num_samples, update);
       return;
    }
 
    /********************************************************************************
-   * randomize_training_order: Randomiserar ordningsfljden fr befintliga 
-   *                           trningsuppsttningar i angivet neuralt ntverk.
-   *                           I praktiken flyttas innehllet p index i samt
-   *                           randomiserat index r.
+   * train_on_batch: Genomfr framt- och baktpropagering samt justering av
+   *                 parametrarna fr angiven batch. Returnerar summan av
+   *                 utgngslagrets kvadrerade fel fr hela batchen.
+   *
+   *                 - input        : Referens till batchens indata.
+   *                 - reference    : Referens till batchens referensvrden.
+   *                 - num_samples  : Antalet trningsexempel i aktuell batch.
+   *                 - learning_rate: Lrhastigheten fr aktuell epok.
    ********************************************************************************/
-   void randomize_training_order(void)
+   T train_on_batch(const matrix_type& input,
+                    const matrix_type& reference,
+                    const std::size_t num_samples,
+                    const T learning_rate)
    {
-      for (std::size_t i = 0; i < this->train_order_.size(); ++i)
+      this->feedforward(input, num_samples);
+      const auto loss = this->backpropagate(reference, num_samples);
+      this->optimize(input, num_samples, this->next_update(learning_rate));
+      return loss;
+   }
+
+   /********************************************************************************
+   * resize_batch: Allokerar samtliga buffertar som krvs fr batchtrning med
+   *               angiven batchstorlek. Allokering sker enbart om storleken
+   *               har ndrats sedan fregende trning.
+   *
+   *               - batch_size: Antalet trningsexempel per batch.
+   ********************************************************************************/
+   void resize_batch(const std::size_t batch_size)
+   {
+      if (this->batch_input_.rows() != batch_size ||
+          this->batch_input_.columns() != this->num_inputs())
       {
-         const auto r = std::rand() % this->train_order_.size();
-         const auto temp = this->train_order_[i];
-         this->train_order_[i] = this->train_order_[r];
-         this->train_order_[r] = temp;
+         this->batch_input_.resize(batch_size, this->num_inputs(), T(0));
+         this->batch_reference_.resize(batch_size, this->num_outputs(), T(0));
       }
+
+      for (auto& i : this->layers_)
+      {
+         i.resize_batch(batch_size);
+      }
+      this->pack_layers();
       return;
    }
 
-public:
-
    /********************************************************************************
-   * ann: Defaultkonstruktor, initierar ett tomt neuralt ntverk.
+   * resize_transposed: Allokerar alternativt frigr transponerade kopior av
+   *                    vikterna enligt vald instllning, se medlemsfunktionen
+   *                    set_transposed_weights. Ingngslagrets vikter anvnds
+   *                    aldrig vid baktpropagering, varfr enbart efterfljande
+   *                    lager erhller en kopia.
    ********************************************************************************/
-   ann(void) { }
+   void resize_transposed(void)
+   {
+      for (std::size_t i = 0; i < this->layers_.size(); ++i)
+      {
+         this->layers_[i].set_transposed(this->transposed_weights_ && i > 0);
+      }
+      return;
+   }
 
    /********************************************************************************
-   * ann: Initierar neuralt ntverk med angivet antal noder i respektive lager.
-   *
-   *      - num_inputs      : Antalet noder i ingngslagret (antalet insignaler).
-   *      - num_hidden_nodes: Antalet noder i det dolda lagret.
-   *      - num_outputs     : Antalet noder i utgngslagret (antalet utsignaler).
+   * update_transposed: Uppdaterar samtliga lagers inaktuella transponerade
+   *                    kopior av vikterna, exempelvis infr parallell trning
+   *                    dr kopiorna drefter hlls aktuella per nodintervall.
    ********************************************************************************/
-   ann(const std::size_t num_inputs,
-       const std::size_t num_hidden_nodes,
-       const std::size_t num_outputs)
+   void update_transposed(void)
    {
-      this->init(num_inputs, num_hidden_nodes, num_outputs);
+      for (auto& layer : this->layers_)
+      {
+         layer.update_transposed();
+      }
       return;
    }
 
    /********************************************************************************
-   * ~ann: Destruktor, tmmer neuralt ntverk automatiskt nr det gr ur scope.
+   * pack_layers: Placerar samtliga lagers vikter, batchbuffertar och tillstnd
+   *              fr justering efter varandra i ntverkets arena, s att
+   *              parametrarna ligger i ett enda minnesblock med varje matris p
+   *              en egen cache-linje. Om samtliga matriser redan r placerade i
+   *              arenan sker ingenting, annars allokeras en ny arena av exakt
+   *              rtt storlek dit samtliga matriser flyttas, varefter den
+   *              tidigare arenan frigrs. Anropas efter varje ndring av
+   *              lagrens storlek, allts vid initiering samt infr trning.
    ********************************************************************************/
-   ~ann(void)
+   void pack_layers(void)
    {
-      this->clear();
+      auto packed = true;
+      std::size_t size = 0;
+
+      for (const auto& i : this->layers_)
+      {
+         if (!i.is_placed_in(this->arena_)) packed = false;
+         size += i.arena_bytes();
+      }
+
+      if (packed) return;
+      memory_arena arena(size);
+
+      for (auto& i : this->layers_)
+      {
+         i.move_to(arena);
+      }
+
+      this->arena_ = std::move(arena);
       return;
    }
 
    /********************************************************************************
-   * hidden_layer: Returnerar en referens till det dolda lagret i angivet neuralt
-   *               ntverk s att anvndaren kan lsa innehllet, men inte skriva.
+   * load_batch: Kopierar in- och utdata fr angivna trningsuppsttningar till
+   *             de sammanhngande batchbuffertarna, dr varje trningsuppsttning
+   *             lagras p en egen rad. Om en trningsuppsttning innehller frre
+   *             vrden n ntverkets antal in- eller utgngar s stts
+   *             resterande vrden till 0.
+   *
+   *             - order      : Pekare till index fr trningsuppsttningarna.
+   *             - num_samples: Antalet trningsuppsttningar i aktuell batch.
    ********************************************************************************/
-   const dense_layer& hidden_layer(void) const
+   void load_batch(const std::size_t* order,
+                   const std::size_t num_samples)
    {
-      return this->hidden_layer_;
+      this->load_batch(order, num_samples, this->batch_input_, this->batch_reference_);
+      return;
    }
 
    /********************************************************************************
-   * output_layer: Returnerar en referens till utgngslagret i angivet neuralt
-   *               ntverk s att anvndaren kan lsa innehllet, men inte skriva.
+   * load_batch: Kopierar in- och utdata fr angivna trningsuppsttningar till
+   *             angivna matriser, exempelvis en trds lokala buffertar.
+   *
+   *             - order      : Pekare till index fr trningsuppsttningarna.
+   *             - num_samples: Antalet trningsuppsttningar som ska kopieras.
+   *             - input      : Referens till matris dr indatan lagras.
+   *             - reference  : Referens till matris dr utdatan lagras.
    ********************************************************************************/
-   const dense_layer& output_layer(void) const
+   void load_batch(const std::size_t* order,
+                   const std::size_t num_samples,
+                   matrix_type& input,
+                   matrix_type& reference) const
    {
-      return this->output_layer_;
+      for (std::size_t k = 0; k < num_samples; ++k)
+      {
+         const auto index = order[k];
+         copy_row(this->input_row(index), this->input_size(index), input[k], input.columns());
+         copy_row(this->reference_row(index), this->reference_size(index), reference[k], reference.columns());
+      }
+      return;
    }
 
    /********************************************************************************
-   * train_in: Returnerar en referens till en vektor innehllande trningsdata
-   *           bestende av insignaler.
+   * prepare_step: Frbereder lagrens tillstnd fr vald metod fr justering
+   *               infr inkrementell trning, vilket enbart sker vid frsta
+   *               anropet efter att metoden eller ntverkets lager har
+   *               ndrats via set_optimizer, init eller clear. vriga anrop
+   *               returnerar direkt, s att train_step och partial_fit inte
+   *               gr igenom lagren vid varje justering.
    ********************************************************************************/
-   const std::vector<std::vector<double>>& train_in(void) const
+   void prepare_step(void)
    {
-      return this->train_in_;
+      if (this->step_prepared_) return;
+
+      for (auto& layer : this->layers_)
+      {
+         layer.resize_optimizer(this->optimizer_);
+      }
+
+      this->pack_layers();
+      this->step_prepared_ = true;
+      return;
    }
 
    /********************************************************************************
-   * train_out: Returnerar en referens till en vektor innehllande trningsdata
-   *            bestende av utsignaler.
+   * start_loader: Startar angiven inlsare fr ntverkets trningsordning och
+   *               generator, dr varje buffert rymmer angivet antal
+   *               trningsuppsttningar, vilka packas via medlemsfunktionen
+   *               load_batch.
+   *
+   *               - loader    : Referens till inlsaren som ska startas.
+   *               - batch_size: Antalet trningsuppsttningar per buffert.
    ********************************************************************************/
-   const std::vector<std::vector<double>>& train_out(void) const
+   void start_loader(loader_type& loader,
+                     const std::size_t batch_size)
    {
-      return this->train_out_;
+      loader.start(this->train_order_, this->generator_, batch_size, this->num_inputs(), this->num_outputs(),
+                   [this](const std::size_t* order, const std::size_t num_samples, loaded_batch_type& batch)
+      {
+         this->load_batch(order, num_samples, batch.input, batch.reference);
+
+         for (std::size_t k = 0; k < num_samples; ++k)
+         {
+            const auto size = this->input_size(order[k]);
+            batch.input_size[k] = size < batch.input.columns() ? size : batch.input.columns();
+         }
+      });
+      return;
    }
 
    /********************************************************************************
-   * num_inputs: Returnerar antalet ingngsnoder i angivet neuralt ntverk, vilket
-   *             r samma som antalet vikter per nod i det dolda lagret.
+   * may_stop_early: Indikerar ifall angivna villkor kan avbryta trningen i
+   *                 frtid. Annars kan nsta epok pbrjas av inlsningstrden
+   *                 redan innan fregende epok har utvrderats, utan att
+   *                 generatorn anvnds fr en epok som aldrig genomfrs.
+   *
+   *                 - stopping: Referens till villkoren fr avbrott.
    ********************************************************************************/
-   std::size_t num_inputs(void) const
+   static bool may_stop_early(const early_stopping_type& stopping)
    {
-      return this->hidden_layer_.num_weights();
+      return stopping.patience > 0 || stopping.target_loss > T(0);
    }
 
    /********************************************************************************
-   * num_hidden_nodes: Returnerar antalet noder i det dolda lagret i angivet
-   *                   neuralt ntverk.
+   * propagate: Genomfr framt- och baktpropagering fr angivna
+   *            trningsuppsttningar via angiven trds lokala buffertar, dr
+   *            samtliga lagers fel lagras i buffertarna. Ntverkets parametrar
+   *            lses men ndras inte. Utgngslagrets kvadrerade fel adderas
+   *            till trdens summerade frlust.
+   *
+   *            - workspace  : Referens till trdens lokala buffertar.
+   *            - order      : Pekare till index fr trningsuppsttningarna.
+   *            - num_samples: Antalet trningsuppsttningar.
    ********************************************************************************/
-   std::size_t num_hidden_nodes(void) const
+   void propagate(worker_workspace& workspace,
+                  const std::size_t* order,
+                  const std::size_t num_samples) const
    {
-      return this->hidden_layer_.num_nodes();
+      auto& buffers = workspace.layers;
+      const auto last = this->layers_.size() - 1;
+      this->load_batch(order, num_samples, workspace.input, workspace.reference);
+
+      for (std::size_t i = 0; i <= last; ++i)
+      {
+         const auto& input = i > 0 ? buffers[i - 1].output : workspace.input;
+         this->layers_[i].feedforward(input, num_samples, buffers[i].output);
+      }
+
+      workspace.loss += this->layers_[last].backpropagate(workspace.reference, num_samples,
+                                                          buffers[last].output, buffers[last].error);
+
+      for (auto i = last; i > 0; --i)
+      {
+         this->layers_[i - 1].backpropagate(this->layers_[i], buffers[i].error, num_samples,
+                                            buffers[i - 1].output, buffers[i - 1].error);
+      }
+      return;
    }
 
    /********************************************************************************
-   * num_outputs: Returnerar antalet utgngsnoder i angivet neuralt ntverk.
+   * compute_gradient: Genomfr framt- och baktpropagering fr angivna
+   *                   trningsuppsttningar via angiven trds lokala buffertar
+   *                   och berknar summan av deras bidrag till justeringen av
+   *                   samtliga parametrar. Ntverkets parametrar lses men
+   *                   ndras inte, vilket gr att flera trdar kan anropa
+   *                   denna medlemsfunktion samtidigt. Utgngslagrets
+   *                   kvadrerade fel adderas till trdens summerade frlust.
+   *
+   *                   - workspace  : Referens till trdens lokala buffertar.
+   *                   - order      : Pekare till index fr trningsuppsttningarna.
+   *                   - num_samples: Antalet trningsuppsttningar.
    ********************************************************************************/
-   std::size_t num_outputs(void) const
+   void compute_gradient(worker_workspace& workspace,
+                         const std::size_t* order,
+                         const std::size_t num_samples) const
    {
-      return this->output_layer_.num_nodes();
+      auto& buffers = workspace.layers;
+      const auto last = this->layers_.size() - 1;
+      this->propagate(workspace, order, num_samples);
+
+      for (std::size_t i = 0; i <= last; ++i)
+      {
+         const auto& input = i > 0 ? buffers[i - 1].output : workspace.input;
+         this->layers_[i].gradient(input, buffers[i].error, num_samples,
+                                   buffers[i].weight_gradient, buffers[i].bias_gradient);
+      }
+      return;
    }
 
    /********************************************************************************
-   * num_training_sets: Returnerar antalet befintliga trningsuppsttningar i
-   *                    angivet neuralt ntverk.
+   * apply_gradients: Lgger till samtliga trdars berknade bidrag till de noder
+   *                  som angiven trd ansvarar fr. Noderna i varje lager delas
+   *                  upp i disjunkta intervall, ett per trd, och bidragen
+   *                  summeras alltid i trdordning 0, 1, 2... Drmed blir
+   *                  resultatet detsamma vid varje krning med samma antal
+   *                  trdar, oavsett i vilken ordning trdarna blir klara.
+   *
+   *                  Vid metoder med tillstnd (momentum, RMSProp och Adam) ska
+   *                  tillstnden uppdateras en gng per batch, varfr samtliga
+   *                  trdars bidrag frst summeras i den frsta trdens
+   *                  buffertar fr aktuella noder, varefter justeringen sker
+   *                  via summan. Eventuella transponerade kopior av vikterna
+   *                  uppdateras fr samma noder, s att kopiorna r aktuella
+   *                  infr nsta batch utan ytterligare synkronisering.
+   *
+   *                  - workspaces : Referens till samtliga trdars buffertar.
+   *                  - thread     : Index fr aktuell trd.
+   *                  - num_samples: Antalet trningsexempel i aktuell batch.
+   *                  - update     : Instllningar fr aktuell justering.
    ********************************************************************************/
-   std::size_t num_training_sets(void) const
+   void apply_gradients(std::vector<worker_workspace>& workspaces,
+                        const std::size_t thread,
+                        const std::size_t num_samples,
+                        const update_type& update)
    {
-      return this->train_order_.size();
+      const auto& kernels = layer_type::kernels_type::get();
+      const auto num_threads = workspaces.size();
+
+      for (std::size_t i = 0; i < this->layers_.size(); ++i)
+      {
+         auto& layer = this->layers_[i];
+         const auto first = layer.num_nodes() * thread / num_threads;
+         const auto last = layer.num_nodes() * (thread + 1) / num_threads;
+
+         if (update.method == optimizer_method::sgd)
+         {
+            const auto rate = update.rate / num_samples;
+
+            for (auto& j : workspaces)
+            {
+               layer.apply_gradient(j.layers[i].weight_gradient, j.layers[i].bias_gradient, rate, first, last);
+            }
+            layer.update_transposed(first, last);
+            continue;
+         }
+
+         auto& total = workspaces[0].layers[i];
+
+         for (std::size_t j = 1; j < num_threads; ++j)
+         {
+            const auto& part = workspaces[j].layers[i];
+
+            for (auto k = first; k < last; ++k)
+            {
+               total.bias_gradient[k] += part.bias_gradient[k];
+               kernels.axpy(T(1), part.weight_gradient[k], total.weight_gradient[k], layer.num_weights());
+            }
+         }
+
+         layer.apply_gradient(total.weight_gradient, total.bias_gradient, T(1) / num_samples, update, first, last);
+         layer.update_transposed(first, last);
+      }
+      return;
    }
 
    /********************************************************************************
-   * output: Returnerar en referens till utsignalerna i utgngslagret p angivet
-   *         neuralt ntverk.
+   * copy_row: Kopierar angivet antal vrden till angiven matrisrad. Om frre
+   *           vrden passeras n radens lngd s stts resterande vrden till 0.
+   *
+   *           - source     : Pekare till vrdena som ska kopieras.
+   *           - source_size: Antalet vrden som ska kopieras.
+   *           - destination: Pekare till brjan av aktuell matrisrad.
+   *           - size       : Radens lngd.
    ********************************************************************************/
-   const std::vector<double>& output(void) const
+   static void copy_row(const T* source,
+                        const std::size_t source_size,
+                        T* destination,
+                        const std::size_t size)
    {
-      return this->output_layer_.output;
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         destination[i] = i < source_size ? source[i] : T(0);
+      }
+      return;
    }
 
    /********************************************************************************
-   * init: Initierar neuralt ntverk med angivet antal noder i respektive lager.
-   * 
-   *       - num_inputs      : Antalet noder i ingngslagret (antalet insignaler).
-   *       - num_hidden_nodes: Antalet noder i det dolda lagret.
-   *       - num_outputs     : Antalet noder i utgngslagret (antalet utsignaler).
+   * input_row: Returnerar en pekare till indatan fr angiven trningsuppsttning,
+   *            antingen frn den lagrade kopian eller frn anvndarens buffert.
+   *
+   *            - index: Index fr aktuell trningsuppsttning.
    ********************************************************************************/
-   void init(const std::size_t num_inputs,
-             const std::size_t num_hidden_nodes,
-             const std::size_t num_outputs)
+   const T* input_row(const std::size_t index) const
    {
-       this->hidden_layer_.resize(num_hidden_nodes, num_inputs);
-       this->output_layer_.resize(num_outputs, num_hidden_nodes);
-       return;
+      return this->train_in_view_.empty() ? this->train_in_[index].data() : this->train_in_view_[index];
    }
 
    /********************************************************************************
-   * clear: Tmmer angivet neuralt ntverk.
+   * input_size: Returnerar antalet insignaler fr angiven trningsuppsttning.
+   *
+   *             - index: Index fr aktuell trningsuppsttning.
    ********************************************************************************/
-   void clear(void)
+   std::size_t input_size(const std::size_t index) const
    {
-      this->hidden_layer_.clear();
-      this->output_layer_.clear();
-      this->train_in_.clear();
-      this->train_out_.clear();
-      this->train_order_.clear();
-      return;
+      return this->train_in_view_.empty() ? this->train_in_[index].size() : this->train_in_view_.columns();
    }
 
    /********************************************************************************
-   * set_training_data: Lagrar trningsdata fr angivet neuralt ntverk via 
-   *                    kopiering av innehllet frn refererade vektorer.
-   *                    Ifall ett ojmnt antal trningsuppsttningar passeras,
-   *                    exempelvis sju fr indata och fem fr utdata, sparas
-   *                    endast antalet befintliga trningsuppsttningar som bestr
-   *                    av bde in- och utdata, allts fem i ovanstende exempel.
-   * 
-   *                    - train_in : Referens till vektor innehllande indata.
-   *                    - train_out: Referens till vektor innehllande utdata.
+   * reference_row: Returnerar en pekare till utdatan fr angiven
+   *                trningsuppsttning, antingen frn den lagrade kopian eller
+   *                frn anvndarens buffert.
+   *
+   *                - index: Index fr aktuell trningsuppsttning.
    ********************************************************************************/
-   void set_training_data(const std::vector<std::vector<double>>& train_in,
-                          const std::vector<std::vector<double>>& train_out)
+   const T* reference_row(const std::size_t index) const
    {
-      this->train_in_ = train_in; 
-      this->train_out_ = train_out;
-      this->check_training_data_size();
-      this->init_training_order();
-      return;
+      return this->train_out_view_.empty() ? this->train_out_[index].data() : this->train_out_view_[index];
    }
 
    /********************************************************************************
-   * train: Trnar angivet neuralt ntverk under angivet antal epoker med 
-   *        godtycklig lrhastighet.
-   * 
-   *        - num_epochs   : Antalet epoker som ska trning ska genomfras under.
-   *        - learning_rate: Lrhastigheten, avgr hur mycket ntverkets parametrar
-   *                         justeras vid fel.
+   * reference_size: Returnerar antalet referensvrden fr angiven
+   *                 trningsuppsttning.
+   *
+   *                 - index: Index fr aktuell trningsuppsttning.
    ********************************************************************************/
-   void train(const std::size_t num_epochs,
-              const double learning_rate)
+   std::size_t reference_size(const std::size_t index) const
    {
-      for (std::size_t i = 0; i < num_epochs; ++i) 
-      {
-         this->randomize_training_order(); 
-
-         for (auto& j : this->train_order_)
-         {
-            const auto& input = this->train_in_[j]; 
-            const auto& reference = this->train_out_[j]; 
-
-            this->feedforward(input);
-            this->backpropagate(reference);
-            this->optimize(input, learning_rate);
-         }
-      }   
-      return;
+      return this->train_out_view_.empty() ? this->train_out_[index].size() : this->train_out_view_.columns();
    }
 
    /********************************************************************************
-   * predict: Genomfr prediktion via angiven indata och returnerar en referens
-   *          till en vektor innehllande utdatan.
-   * 
-   *          - input: Referens till vektor innehllande indata.
+   * training_data_size: Returnerar antalet lagrade trningsuppsttningar med
+   *                     indata, oavsett hur trningsdatan har passerats.
    ********************************************************************************/
-   const std::vector<double>& predict(const std::vector<double>& input)
+   std::size_t training_data_size(void) const
    {
-      this->feedforward(input);
-      return this->output();
+      return this->train_in_view_.empty() ? this->train_in_.size() : this->train_in_view_.rows();
    }
 
    /********************************************************************************
-   * print: Genomfr prediktion med indata frn angiven vektor och skriver ut 
-   *        predikterad utdata via angiven utstrm, dr standardutenheten std::cout 
-   *        anvnds som default fr utskrift i terminalen. 
+   * feedforward: Berknar nya utsignaler fr samtliga lager via angiven indata
+   *              utan att ntverket ndras, dr de dolda lagrens utsignaler
+   *              lagras vxelvis i angivna buffertar fr prediktion och
+   *              utgngslagrets utsignaler i buffertens utsignaler.
    *
-   *        - input       : Referens till vektor innehllande indata.
-   *        - num_decimals: Antalet decimaler vid utskrift (default = 1).
-   *        - ostream     : Referens till godtycklig utstrm (default = std::cout).
+   *              - input  : Pekare till indatan.
+   *              - size   : Antalet insignaler.
+   *              - context: Referens till buffertar fr prediktion, vilka mste
+   *                         ha frberetts via medlemsfunktionen prepare.
    ********************************************************************************/
-   void print(const std::vector<std::vector<double>>& input,
-              const std::size_t num_decimals = 1,
-              std::ostream& ostream = std::cout)
+   void feedforward(const T* input,
+                    const std::size_t size,
+                    inference_context& context) const
    {
-      if (input.size() == 0) return;
-      const auto& end = input[input.size() - 1];
-      ostream << "--------------------------------------------------------------------------------\n";
-      
-      for (auto& i : input)
-      {
-         ostream << "Input:\t";
-         dense_layer::print(i, ostream, num_decimals);
-
-         ostream << "Output:\t";
-         dense_layer::print(this->predict(i), ostream, num_decimals);
+      if (this->layers_.empty()) return;
+      ANN_INSTRUMENT_SCOPE(feedforward, 1);
+      const auto num_layers = this->layers_.size();
+      this->layers_[0].feedforward(input, size, context.target(0, num_layers));
 
-         if (&i < &end) ostream << "\n";
+      for (std::size_t i = 1; i < num_layers; ++i)
+      {
+         this->layers_[i].feedforward(context.target(i - 1, num_layers), this->layers_[i - 1].num_nodes(),
+                                      context.target(i, num_layers));
       }
-
-      ostream << "--------------------------------------------------------------------------------\n\n";
       return;
    }
 
    /********************************************************************************
-   * print: Genomfr prediktion med samtliga befintliga trningsuppsttningars
-   *        indata och skriver ut predikterad utdata via angiven utstrm, dr
-   *        standardutenheten std::cout anvnds som default fr utskrift i 
-   *        terminalen.
-   * 
-   *        - num_decimals: Antalet decimaler vid utskrift (default = 1).
-   *        - ostream     : Referens till godtycklig utstrm (default = std::cout).
+   * prepare: Kontrollerar att angivna buffertar fr prediktion har rtt storlek
+   *          fr angivet neuralt ntverk och allokerar om dem annars. Vid
+   *          upprepade anrop med samma buffertar sker drmed ingen allokering.
+   *
+   *          - context   : Referens till buffertar fr prediktion.
+   *          - batch_size: Antalet exempel som batchbufferten ska rymma.
    ********************************************************************************/
-   void print(const std::size_t num_decimals = 1,
-              std::ostream& ostream = std::cout)
+   void prepare(inference_context& context,
+                const std::size_t batch_size) const
    {
-      this->print(this->train_in_, num_decimals, ostream);
+      context.prepare(this->layers_.size(), batch_size,
+                      [this](const std::size_t i) { return this->layers_[i].num_nodes(); });
       return;
    }
-};
 
+   /********************************************************************************
+   * check_training_data_size: Kontrollerar s att antalet trningsuppsttningar
+   *                           med indata r samma som antalet trningsuppsttningar
+   *                           med utdata. Om detta inte r fallet kortas den
+   *                           strre trningsuppsttningen av s att den matchar
+   *                           den mindre uppsttningen. Vid trningsdata i form
+   *                           av vyer kortas i stllet den strre vyn av.
+   ********************************************************************************/
+   void check_training_data_size(void)
+   {
+      if (!this->train_in_view_.empty())
+      {
+         const auto& in = this->train_in_view_;
+         const auto& out = this->train_out_view_;
+         const auto num_rows = in.rows() < out.rows() ? in.rows() : out.rows();
+         this->train_in_view_ = matrix_view_type(in.data(), num_rows, in.columns(), in.stride());
+         this->train_out_view_ = matrix_view_type(out.data(), num_rows, out.columns(), out.stride());
+      }
+      else if (this->train_in_.size() != this->train_out_.size())
+      {
+         if (this->train_in_.size() > this->train_out_.size())
+         {
+            this->train_in_.resize(this->train_out_.size());
+         }
+         else
+         {
+            this->train_out_.resize(this->train_in_.size());
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * init_training_order: Initierar vektor innehllande ordningsfljden fr
+   *                      trningsuppsttningarna. Vektorns storlek stts till
+   *                      antalet trningsuppsttningar och den tilldelas index
+   *                      i stigande ordning frn 0.
+   ********************************************************************************/
+   void init_training_order(void)
+   {
+      this->train_order_.resize(this->training_data_size());
+
+      for (std::size_t i = 0; i < this->train_order_.size(); ++i)
+      {
+         this->train_order_[i] = i;
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * randomize_training_order: Randomiserar ordningsfljden fr befintliga 
+   *                           trningsuppsttningar i angivet neuralt ntverk
+   *                           via ntverkets generator, dr samtliga ordningar
+   *                           r lika sannolika (Fisher-Yates).
+   ********************************************************************************/
+   void randomize_training_order(void)
+   {
+      this->generator_.shuffle(this->train_order_);
+      return;
+   }
+
+   /********************************************************************************
+   * split_validation: Reserverar angiven andel av trningsuppsttningarna fr
+   *                   validering. Uppsttningarna vljs slumpmssigt och tas
+   *                   bort ur trningsordningen, vilken terstlls via
+   *                   medlemsfunktionen init_training_order efter trningen.
+   *                   Minst en uppsttning lmnas kvar fr trning. Returnerar
+   *                   index fr de reserverade uppsttningarna.
+   *
+   *                   - validation_split: Andelen (0 - 1) som ska reserveras.
+   ********************************************************************************/
+   std::vector<std::size_t> split_validation(const T validation_split)
+   {
+      std::vector<std::size_t> validation;
+      const auto size = this->train_order_.size();
+      if (validation_split <= T(0) || size < 2) return validation;
+
+      auto num_validation = static_cast<std::size_t>(static_cast<double>(validation_split) * size);
+      if (num_validation >= size) num_validation = size - 1;
+
+      this->randomize_training_order();
+      validation.assign(this->train_order_.end() - num_validation, this->train_order_.end());
+      this->train_order_.resize(size - num_validation);
+      return validation;
+   }
+
+   /********************************************************************************
+   * validation_loss: Returnerar medelkvadratfelet per utsignal fr angivna
+   *                  trningsuppsttningar, dr prediktion genomfrs utan att
+   *                  ntverkets parametrar justeras.
+   *
+   *                  - validation: Referens till index fr uppsttningarna.
+   ********************************************************************************/
+   T validation_loss(const std::vector<std::size_t>& validation)
+   {
+      auto loss = T(0);
+
+      for (const auto& i : validation)
+      {
+         this->feedforward(this->input_row(i), this->input_size(i));
+         const auto reference = this->reference_row(i);
+         const auto size = this->reference_size(i);
+         const auto& output = this->output();
+
+         for (std::size_t j = 0; j < output.size(); ++j)
+         {
+            const auto error = (j < size ? reference[j] : T(0)) - output[j];
+            loss += error * error;
+         }
+      }
+      return validation.empty() ? T(0) : loss / static_cast<T>(validation.size() * this->num_outputs());
+   }
+
+   /********************************************************************************
+   * end_epoch: Lagrar frlusten fr senast genomfrd epok i angiven statistik
+   *            och utvrderar angivna villkor fr avbrott. Returnerar true om
+   *            trningen ska avbrytas, annars false.
+   *
+   *            - stats     : Referens till statistiken som uppdateras.
+   *            - stopping  : Referens till villkoren fr avbrott.
+   *            - loss      : Summan av de kvadrerade felen under epoken.
+   *            - validation: Referens till index fr valideringsdatan.
+   ********************************************************************************/
+   bool end_epoch(train_stats_type& stats,
+                  const early_stopping_type& stopping,
+                  const T loss,
+                  const std::vector<std::size_t>& validation)
+   {
+      return this->end_epoch(stats, stopping, loss, validation, this->train_order_.size());
+   }
+
+   /********************************************************************************
+   * end_epoch: Lagrar frlusten fr senast genomfrd epok i angiven statistik
+   *            och utvrderar angivna villkor fr avbrott, dr frlusten avser
+   *            angivet antal trningsuppsttningar, exempelvis samtliga
+   *            processers vid distribuerad trning. Returnerar true om
+   *            trningen ska avbrytas, annars false.
+   *
+   *            - stats      : Referens till statistiken som uppdateras.
+   *            - stopping   : Referens till villkoren fr avbrott.
+   *            - loss       : Summan av de kvadrerade felen under epoken.
+   *            - validation : Referens till index fr valideringsdatan.
+   *            - num_samples: Antalet trningsuppsttningar under epoken.
+   ********************************************************************************/
+   bool end_epoch(train_stats_type& stats,
+                  const early_stopping_type& stopping,
+                  const T loss,
+                  const std::vector<std::size_t>& validation,
+                  const std::size_t num_samples)
+   {
+      const auto num_values = num_samples * this->num_outputs();
+      stats.train_loss.push_back(num_values > 0 ? loss / static_cast<T>(num_values) : T(0));
+      auto current = stats.train_loss.back();
+      ++stats.epochs;
+
+      if (!validation.empty())
+      {
+         stats.validation_loss.push_back(this->validation_loss(validation));
+         current = stats.validation_loss.back();
+      }
+
+      if (stats.epochs == 1 || current < stats.best_loss - stopping.tolerance)
+      {
+         stats.best_loss = current;
+         stats.best_epoch = stats.epochs;
+      }
+
+      stats.stopped_early = current < stopping.target_loss ||
+         (stopping.patience > 0 && stats.epochs - stats.best_epoch >= stopping.patience);
+      return stats.stopped_early;
+   }
+
+   /********************************************************************************
+   * begin_training: Frbereder statistik, eventuell valideringsdata samt
+   *                 lagrens tillstnd fr vald metod fr justering infr
+   *                 trning under angivet antal epoker. Returnerar index fr
+   *                 valideringsdatan.
+   *
+   *                 - stats     : Referens till statistiken som frbereds.
+   *                 - stopping  : Referens till villkoren fr avbrott.
+   *                 - num_epochs: Maximalt antal epoker.
+   ********************************************************************************/
+   std::vector<std::size_t> begin_training(train_stats_type& stats,
+                                           const early_stopping_type& stopping,
+                                           const std::size_t num_epochs)
+   {
+      for (auto& layer : this->layers_)
+      {
+         layer.resize_optimizer(this->optimizer_);
+      }
+
+      this->pack_layers();
+      this->update_transposed();
+      stats.train_loss.reserve(num_epochs);
+      auto validation = this->split_validation(stopping.validation_split);
+      if (!validation.empty()) stats.validation_loss.reserve(num_epochs);
+      return validation;
+   }
+
+   /********************************************************************************
+   * end_training: terstller trningsordningen efter trning med
+   *               valideringsdata, s att samtliga trningsuppsttningar
+   *               anvnds vid nsta trning.
+   *
+   *               - validation: Referens till index fr valideringsdatan.
+   ********************************************************************************/
+   void end_training(const std::vector<std::size_t>& validation)
+   {
+      if (!validation.empty()) this->init_training_order();
+      return;
+   }
+
+   /********************************************************************************
+   * next_update: Returnerar instllningar fr nsta justering med angiven
+   *              lrhastighet, dr antalet genomfrda justeringar rknas upp.
+   *
+   *              - learning_rate: Lrhastigheten fr aktuell epok.
+   ********************************************************************************/
+   update_type next_update(const T learning_rate)
+   {
+      return this->optimizer_.update(learning_rate, ++this->optimizer_steps_);
+   }
+
+public:
+
+   /********************************************************************************
+   * basic_ann: Defaultkonstruktor, initierar ett tomt neuralt ntverk.
+   ********************************************************************************/
+   basic_ann(void) { }
+
+   /********************************************************************************
+   * basic_ann: Initierar neuralt ntverk med angivet antal noder i respektive
+   *            lager.
+   *
+   *            - num_inputs      : Antalet noder i ingngslagret (antalet insignaler).
+   *            - num_hidden_nodes: Antalet noder i det dolda lagret.
+   *            - num_outputs     : Antalet noder i utgngslagret (antalet utsignaler).
+   ********************************************************************************/
+   basic_ann(const std::size_t num_inputs,
+             const std::size_t num_hidden_nodes,
+             const std::size_t num_outputs)
+   {
+      this->init(num_inputs, num_hidden_nodes, num_outputs);
+      return;
+   }
+
+   /********************************************************************************
+   * basic_ann: Initierar neuralt ntverk med godtyckligt antal lager, dr antalet
+   *            noder i respektive lager anges i ordning frn ingngslagret till
+   *            utgngslagret. Exempelvis skapar { 2, 8, 4, 1 } ett ntverk med
+   *            tv ingngar, tv dolda lager med tta respektive fyra noder samt
+   *            en utgng.
+   *
+   *            - layer_sizes: Referens till vektor med antalet noder i varje
+   *                           lager, dr det frsta elementet utgr antalet
+   *                           insignaler.
+   ********************************************************************************/
+   explicit basic_ann(const std::vector<std::size_t>& layer_sizes)
+   {
+      this->init(layer_sizes);
+      return;
+   }
+
+   /********************************************************************************
+   * basic_ann: Initierar neuralt ntverk via en lista med antalet noder i
+   *            respektive lager, exempelvis basic_ann({ 2, 8, 1 }), se
+   *            konstruktorn ovan. Listan matchar exakt, vilket gr att ven
+   *            listor med tre element vljer denna konstruktor i stllet fr
+   *            en kopia konstruerad via konstruktorn med tre lagerstorlekar.
+   *
+   *            - layer_sizes: Lista med antalet noder i varje lager, dr det
+   *                           frsta elementet utgr antalet insignaler.
+   ********************************************************************************/
+   explicit basic_ann(const std::initializer_list<std::size_t> layer_sizes)
+   {
+      this->init(std::vector<std::size_t>(layer_sizes));
+      return;
+   }
+
+   /********************************************************************************
+   * ~basic_ann: Destruktor, tmmer neuralt ntverk automatiskt nr det gr ur
+   *             scope.
+   ********************************************************************************/
+   ~basic_ann(void)
+   {
+      this->clear();
+      return;
+   }
+
+   /********************************************************************************
+   * hidden_layer: Returnerar en referens till det frsta dolda lagret i angivet
+   *               neuralt ntverk s att anvndaren kan lsa innehllet, men
+   *               inte skriva. OBS! Ntverket mste innehlla minst ett lager.
+   ********************************************************************************/
+   const layer_type& hidden_layer(void) const
+   {
+      return this->layers_.front();
+   }
+
+   /********************************************************************************
+   * output_layer: Returnerar en referens till utgngslagret i angivet neuralt
+   *               ntverk s att anvndaren kan lsa innehllet, men inte skriva.
+   *               OBS! Ntverket mste innehlla minst ett lager.
+   ********************************************************************************/
+   const layer_type& output_layer(void) const
+   {
+      return this->layers_.back();
+   }
+
+   /********************************************************************************
+   * layer: Returnerar en referens till lagret p angivet index, dr index 0
+   *        utgr det frsta dolda lagret och index num_layers() - 1 utgr
+   *        utgngslagret.
+   *
+   *        - index: Index fr aktuellt lager.
+   ********************************************************************************/
+   const layer_type& layer(const std::size_t index) const
+   {
+      return this->layers_[index];
+   }
+
+   /********************************************************************************
+   * layers: Returnerar en referens till samtliga lager i angivet neuralt ntverk.
+   ********************************************************************************/
+   const std::vector<layer_type>& layers(void) const
+   {
+      return this->layers_;
+   }
+
+   /********************************************************************************
+   * num_layers: Returnerar antalet lager (dolda lager samt utgngslagret) i
+   *             angivet neuralt ntverk.
+   ********************************************************************************/
+   std::size_t num_layers(void) const
+   {
+      return this->layers_.size();
+   }
+
+   /********************************************************************************
+   * train_in: Returnerar en referens till en vektor innehllande trningsdata
+   *           bestende av insignaler. Vektorn r tom om trningsdatan har
+   *           passerats som en vy, se medlemsfunktionen train_in_view.
+   ********************************************************************************/
+   const std::vector<std::vector<T>>& train_in(void) const
+   {
+      return this->train_in_;
+   }
+
+   /********************************************************************************
+   * train_out: Returnerar en referens till en vektor innehllande trningsdata
+   *            bestende av utsignaler. Vektorn r tom om trningsdatan har
+   *            passerats som en vy, se medlemsfunktionen train_out_view.
+   ********************************************************************************/
+   const std::vector<std::vector<T>>& train_out(void) const
+   {
+      return this->train_out_;
+   }
+
+   /********************************************************************************
+   * train_in_view: Returnerar en vy ver anvndarens buffert med insignaler,
+   *                vilken r tom om trningsdatan har passerats som vektorer.
+   ********************************************************************************/
+   const matrix_view_type& train_in_view(void) const
+   {
+      return this->train_in_view_;
+   }
+
+   /********************************************************************************
+   * train_out_view: Returnerar en vy ver anvndarens buffert med utsignaler,
+   *                 vilken r tom om trningsdatan har passerats som vektorer.
+   ********************************************************************************/
+   const matrix_view_type& train_out_view(void) const
+   {
+      return this->train_out_view_;
+   }
+
+   /********************************************************************************
+   * num_inputs: Returnerar antalet ingngsnoder i angivet neuralt ntverk, vilket
+   *             r samma som antalet vikter per nod i det dolda lagret.
+   ********************************************************************************/
+   std::size_t num_inputs(void) const
+   {
+      return this->layers_.empty() ? 0 : this->layers_.front().num_weights();
+   }
+
+   /********************************************************************************
+   * num_hidden_nodes: Returnerar antalet noder i det frsta dolda lagret i
+   *                   angivet neuralt ntverk, eller 0 om dolda lager saknas.
+   ********************************************************************************/
+   std::size_t num_hidden_nodes(void) const
+   {
+      return this->layers_.size() > 1 ? this->layers_.front().num_nodes() : 0;
+   }
+
+   /********************************************************************************
+   * num_outputs: Returnerar antalet utgngsnoder i angivet neuralt ntverk.
+   ********************************************************************************/
+   std::size_t num_outputs(void) const
+   {
+      return this->layers_.empty() ? 0 : this->layers_.back().num_nodes();
+   }
+
+   /********************************************************************************
+   * num_training_sets: Returnerar antalet befintliga trningsuppsttningar i
+   *                    angivet neuralt ntverk.
+   ********************************************************************************/
+   std::size_t num_training_sets(void) const
+   {
+      return this->train_order_.size();
+   }
+
+   /********************************************************************************
+   * output: Returnerar en referens till utsignalerna i utgngslagret p angivet
+   *         neuralt ntverk.
+   ********************************************************************************/
+   const std::vector<T>& output(void) const
+   {
+      static const std::vector<T> empty;
+      return this->layers_.empty() ? empty : this->layers_.back().output;
+   }
+
+   /********************************************************************************
+   * init: Initierar neuralt ntverk med angivet antal noder i respektive lager.
+   * 
+   *       - num_inputs      : Antalet noder i ingngslagret (antalet insignaler).
+   *       - num_hidden_nodes: Antalet noder i det dolda lagret.
+   *       - num_outputs     : Antalet noder i utgngslagret (antalet utsignaler).
+   ********************************************************************************/
+   void init(const std::size_t num_inputs,
+             const std::size_t num_hidden_nodes,
+             const std::size_t num_outputs)
+   {
+       this->init({ num_inputs, num_hidden_nodes, num_outputs });
+       return;
+   }
+
+   /********************************************************************************
+   * init: Initierar neuralt ntverk med godtyckligt antal lager, dr antalet
+   *       noder i respektive lager anges i ordning frn ingngslagret till
+   *       utgngslagret. Samtliga lager allokeras hr, s att ingen allokering
+   *       sker vid trning eller prediktion.
+   *
+   *       Startvrdena hmtas frn ntverkets generator i ordning frn det
+   *       frsta dolda lagret.
+   *
+   *       - layer_sizes: Referens till vektor med antalet noder i varje lager,
+   *                      dr det frsta elementet utgr antalet insignaler.
+   *       - init       : Metod fr tilldelning av startvrden (default = uniform).
+   ********************************************************************************/
+   void init(const std::vector<std::size_t>& layer_sizes,
+             const weight_init init = weight_init::uniform)
+   {
+      this->layers_.clear();
+      this->optimizer_steps_ = 0;
+      this->step_prepared_ = false;
+      if (layer_sizes.size() < 2) return;
+      this->layers_.resize(layer_sizes.size() - 1);
+
+      for (std::size_t i = 0; i < this->layers_.size(); ++i)
+      {
+         this->layers_[i].resize(layer_sizes[i + 1], layer_sizes[i], this->generator_, init);
+      }
+      this->resize_transposed();
+      this->pack_layers();
+      return;
+   }
+
+   /********************************************************************************
+   * seed: Initierar om ntverkets generator frn angivet startvrde, vilken
+   *       anvnds vid tilldelning av startvrden samt vid randomisering av
+   *       trningsordningen. Samma startvrde ger drmed samma resultat vid
+   *       efterfljande anrop av randomize, init samt train.
+   *
+   *       - seed: Nytt startvrde fr generatorn.
+   ********************************************************************************/
+   void seed(const random_generator::result_type seed)
+   {
+      this->generator_.seed(seed);
+      return;
+   }
+
+   /********************************************************************************
+   * randomize: Tilldelar samtliga lager nya randomiserade startvrden frn
+   *            ntverkets generator utan att storleken ndras.
+   *
+   *            - init: Metod fr tilldelning av startvrden (default = uniform).
+   ********************************************************************************/
+   void randomize(const weight_init init = weight_init::uniform)
+   {
+      for (auto& layer : this->layers_)
+      {
+         layer.randomize(this->generator_, init);
+      }
+
+      this->reset_optimizer();
+      return;
+   }
+
+   /********************************************************************************
+   * prune: Stter angiven andel av vikterna i varje lager till 0, dr vikterna
+   *        med lgst absolutvrde i respektive lager vljs, se medlemsfunktionen
+   *        prune i strukten dense_layer. Returnerar totalt antal vikter som
+   *        sattes till 0. Det beskurna ntverket kan sedan anvndas fr gles
+   *        prediktion via klassen sparse_ann, alternativt finjusteras via
+   *        fortsatt trning fljt av ny beskrning.
+   *
+   *        - fraction: Andel (0 - 1) av vikterna som ska sttas till 0.
+   ********************************************************************************/
+   std::size_t prune(const T fraction)
+   {
+      std::size_t result = 0;
+
+      for (auto& layer : this->layers_)
+      {
+         result += layer.prune(fraction);
+      }
+      return result;
+   }
+
+   /********************************************************************************
+   * set_activation: Stter aktiveringsfunktionen i angivet lager, dr index 0
+   *                 utgr det frsta dolda lagret och num_layers() - 1 utgr
+   *                 utgngslagret. Som default anvnds ReLU i samtliga lager,
+   *                 vilket ven terstlls vid anrop av init.
+   *
+   *                 - index     : Index fr aktuellt lager.
+   *                 - activation: Ny aktiveringsfunktion.
+   ********************************************************************************/
+   void set_activation(const std::size_t index,
+                       const activation_function activation)
+   {
+      if (index < this->layers_.size()) this->layers_[index].activation = activation;
+      return;
+   }
+
+   /********************************************************************************
+   * set_hidden_activation: Stter aktiveringsfunktionen i samtliga dolda lager.
+   *
+   *                        - activation: Ny aktiveringsfunktion.
+   ********************************************************************************/
+   void set_hidden_activation(const activation_function activation)
+   {
+      for (std::size_t i = 0; i + 1 < this->layers_.size(); ++i)
+      {
+         this->layers_[i].activation = activation;
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * set_output_activation: Stter aktiveringsfunktionen i utgngslagret,
+   *                        exempelvis linear vid regression eller sigmoid
+   *                        alternativt softmax vid klassificering.
+   *
+   *                        - activation: Ny aktiveringsfunktion.
+   ********************************************************************************/
+   void set_output_activation(const activation_function activation)
+   {
+      if (!this->layers_.empty()) this->layers_.back().activation = activation;
+      return;
+   }
+
+   /********************************************************************************
+   * set_optimizer: Stter metoden fr justering av parametrar vid trning, dr
+   *                eventuella tillstnd nollstlls. Tillstnden allokeras vid
+   *                nsta trning och behlls sedan mellan upprepade anrop av
+   *                train, vilket gr att trningen kan fortstta dr den
+   *                slutade. Som default anvnds SGD.
+   *
+   *                - optimizer: Instllningar fr justering, exempelvis
+   *                             optimizer_type::adam().
+   ********************************************************************************/
+   void set_optimizer(const optimizer_type& optimizer)
+   {
+      this->optimizer_ = optimizer;
+      this->step_prepared_ = false;
+      this->reset_optimizer();
+      return;
+   }
+
+   /********************************************************************************
+   * optimizer: Returnerar instllningarna fr justering av parametrar.
+   ********************************************************************************/
+   const optimizer_type& optimizer(void) const
+   {
+      return this->optimizer_;
+   }
+
+   /********************************************************************************
+   * reset_optimizer: Nollstller samtliga lagers tillstnd fr justering samt
+   *                  antalet genomfrda justeringar, vilket ven sker vid anrop
+   *                  av init, randomize samt set_optimizer.
+   ********************************************************************************/
+   void reset_optimizer(void)
+   {
+      for (auto& layer : this->layers_)
+      {
+         layer.reset_optimizer();
+      }
+
+      this->optimizer_steps_ = 0;
+      return;
+   }
+
+   /********************************************************************************
+   * set_schedule: Stter schemalggningen av lrhastigheten, dr angiven
+   *               lrhastighet vid anrop av train utgr lrhastigheten vid
+   *               frsta epoken. Som default anvnds samma lrhastighet under
+   *               samtliga epoker.
+   *
+   *               - schedule: Schemalggning, exempelvis schedule_type::cosine().
+   ********************************************************************************/
+   void set_schedule(const schedule_type& schedule)
+   {
+      this->schedule_ = schedule;
+      return;
+   }
+
+   /********************************************************************************
+   * schedule: Returnerar schemalggningen av lrhastigheten.
+   ********************************************************************************/
+   const schedule_type& schedule(void) const
+   {
+      return this->schedule_;
+   }
+
+   /********************************************************************************
+   * set_prefetch: Stter antalet buffertar fr asynkron inlsning av
+   *               trningsdatan via medlemsfunktionen train, dr en egen trd
+   *               blandar trningsordningen och packar nsta batch (alternativt
+   *               nsta 64 trningsuppsttningar utan batchar) medan aktuell
+   *               batch trnas. Minnesbehovet begrnsas drmed till angivet
+   *               antal batchar. Ordningsfljden och drmed resultatet blir
+   *               detsamma som vid synkron inlsning, vilket anvnds som
+   *               default. Parallell trning via train_parallel pverkas inte.
+   *
+   *               - queue_size: Antalet buffertar, dr 2 innebr dubbelbuffring
+   *                             (0 = synkron inlsning).
+   ********************************************************************************/
+   void set_prefetch(const std::size_t queue_size)
+   {
+      this->prefetch_ = queue_size;
+      return;
+   }
+
+   /********************************************************************************
+   * prefetch: Returnerar antalet buffertar fr asynkron inlsning (0 = synkron).
+   ********************************************************************************/
+   std::size_t prefetch(void) const
+   {
+      return this->prefetch_;
+   }
+
+   /********************************************************************************
+   * set_transposed_weights: Aktiverar eller avaktiverar transponerade kopior
+   *                         av samtliga lagers vikter, bortsett frn
+   *                         ingngslagret. Vid baktpropagering i batchar lses
+   *                         d nsta lagers vikter via sammanhngande rader i
+   *                         kopian, vilken uppdateras hgst en gng per batch
+   *                         och enbart om vikterna har justerats sedan senast.
+   *                         Minnesbehovet fr vikterna frdubblas ungefr, se
+   *                         transposed_bytes, medan baktpropageringen fr
+   *                         lager som r fr sm fr blockad
+   *                         matrismultiplikation blir snabbare. Vid trning
+   *                         per trningsuppsttning samt via train_hogwild
+   *                         justeras vikterna fr ofta fr att kopian ska
+   *                         lna sig, varfr den d inte anvnds. Resultaten
+   *                         kan skilja sig i sista decimalerna till fljd av
+   *                         annan summeringsordning. Som default anvnds inga
+   *                         kopior.
+   *
+   *                         - enable: Indikerar ifall kopiorna ska anvndas.
+   ********************************************************************************/
+   void set_transposed_weights(const bool enable)
+   {
+      this->transposed_weights_ = enable;
+      this->resize_transposed();
+      this->pack_layers();
+      return;
+   }
+
+   /********************************************************************************
+   * transposed_weights: Indikerar ifall lagren har transponerade kopior av
+   *                     vikterna.
+   ********************************************************************************/
+   bool transposed_weights(void) const
+   {
+      return this->transposed_weights_;
+   }
+
+   /********************************************************************************
+   * transposed_bytes: Returnerar det totala minnesbehovet i byte fr samtliga
+   *                   lagers transponerade kopior av vikterna, vilket utgr
+   *                   kostnaden fr instllningen set_transposed_weights.
+   ********************************************************************************/
+   std::size_t transposed_bytes(void) const
+   {
+      std::size_t result = 0;
+
+      for (const auto& layer : this->layers_)
+      {
+         result += layer.transposed_bytes();
+      }
+      return result;
+   }
+
+   /********************************************************************************
+   * generator: Returnerar en referens till ntverkets generator.
+   ********************************************************************************/
+   random_generator& generator(void)
+   {
+      return this->generator_;
+   }
+
+   /********************************************************************************
+   * copy_model: Returnerar en kopia av ntverkets modell, allts samtliga
+   *             lagers bias, vikter och aktiveringsfunktioner samt valda
+   *             instllningar fr trning. Trningsdata, batchbuffertar och
+   *             tillstnd fr justering kopieras inte, vilket gr kopian
+   *             lmplig fr prediktion, exempelvis via klassen
+   *             snapshot_publisher medan originalet fortstter att trnas.
+   ********************************************************************************/
+   basic_ann copy_model(void) const
+   {
+      basic_ann result;
+      result.layers_.resize(this->layers_.size());
+      result.optimizer_ = this->optimizer_;
+      result.schedule_ = this->schedule_;
+      result.prefetch_ = this->prefetch_;
+      result.transposed_weights_ = this->transposed_weights_;
+      result.generator_ = this->generator_;
+
+      for (std::size_t i = 0; i < this->layers_.size(); ++i)
+      {
+         const auto& source = this->layers_[i];
+         auto& layer = result.layers_[i];
+         layer.output.assign(source.num_nodes(), T(0));
+         layer.error.assign(source.num_nodes(), T(0));
+         layer.bias = source.bias;
+         layer.weights = source.weights;
+         layer.activation = source.activation;
+      }
+      result.resize_transposed();
+      result.pack_layers();
+      return result;
+   }
+
+   /********************************************************************************
+   * clear: Tmmer angivet neuralt ntverk.
+   ********************************************************************************/
+   void clear(void)
+   {
+      this->layers_.clear();
+      this->arena_ = memory_arena();
+      this->step_prepared_ = false;
+      this->train_in_.clear();
+      this->train_out_.clear();
+      this->train_in_view_ = matrix_view_type();
+      this->train_out_view_ = matrix_view_type();
+      this->train_order_.clear();
+      this->batch_input_.clear();
+      this->batch_reference_.clear();
+      return;
+   }
+
+   /********************************************************************************
+   * set_training_data: Lagrar trningsdata fr angivet neuralt ntverk via 
+   *                    kopiering av innehllet frn refererade vektorer.
+   *                    Ifall ett ojmnt antal trningsuppsttningar passeras,
+   *                    exempelvis sju fr indata och fem fr utdata, sparas
+   *                    endast antalet befintliga trningsuppsttningar som bestr
+   *                    av bde in- och utdata, allts fem i ovanstende exempel.
+   * 
+   *                    - train_in : Referens till vektor innehllande indata.
+   *                    - train_out: Referens till vektor innehllande utdata.
+   ********************************************************************************/
+   void set_training_data(const std::vector<std::vector<T>>& train_in,
+                          const std::vector<std::vector<T>>& train_out)
+   {
+      this->train_in_view_ = matrix_view_type();
+      this->train_out_view_ = matrix_view_type();
+      this->train_in_ = train_in; 
+      this->train_out_ = train_out;
+      this->check_training_data_size();
+      this->init_training_order();
+      return;
+   }
+
+   /********************************************************************************
+   * set_training_data: Lagrar trningsdata fr angivet neuralt ntverk genom att
+   *                    flytta innehllet frn angivna vektorer, vilket gr att
+   *                    ingen kopiering sker. Vektorerna r tomma efter anropet.
+   *
+   *                    - train_in : Vektor innehllande indata.
+   *                    - train_out: Vektor innehllande utdata.
+   ********************************************************************************/
+   void set_training_data(std::vector<std::vector<T>>&& train_in,
+                          std::vector<std::vector<T>>&& train_out)
+   {
+      this->train_in_view_ = matrix_view_type();
+      this->train_out_view_ = matrix_view_type();
+      this->train_in_ = std::move(train_in);
+      this->train_out_ = std::move(train_out);
+      this->check_training_data_size();
+      this->init_training_order();
+      return;
+   }
+
+   /********************************************************************************
+   * set_training_data: Trnar i fortsttningen direkt p anvndarens buffertar,
+   *                    dr in- och utdata lagras radvis med en trningsuppsttning
+   *                    per rad. Ingen kopiering sker, vilket gr att ven mycket
+   *                    stora datamngder kan anvndas utan att minnesbehovet
+   *                    frdubblas. Buffertarna fr inte ndras eller frigras s
+   *                    lnge ntverket trnas eller trningsdatan skrivs ut.
+   *                    Tidigare lagrad trningsdata frigrs.
+   *
+   *                    - train_in : Vy ver indatan, en rad per trningsuppsttning.
+   *                    - train_out: Vy ver utdatan, en rad per trningsuppsttning.
+   ********************************************************************************/
+   void set_training_data(const matrix_view_type& train_in,
+                          const matrix_view_type& train_out)
+   {
+      std::vector<std::vector<T>>().swap(this->train_in_);
+      std::vector<std::vector<T>>().swap(this->train_out_);
+      this->train_in_view_ = train_in;
+      this->train_out_view_ = train_out;
+      this->check_training_data_size();
+      this->init_training_order();
+      return;
+   }
+
+   /********************************************************************************
+   * set_training_data: Trnar i fortsttningen direkt p angiven minnesmappad
+   *                    datafil, dr ingen kopiering sker och enbart de delar av
+   *                    filen som anvnds lses in av operativsystemet. Trning
+   *                    sker i slumpmssig ordning via index, vilket gr att
+   *                    filens innehll aldrig flyttas. Filen mste vara ppen
+   *                    s lnge ntverket trnas.
+   *
+   *                    - dataset: Referens till ppnad datafil.
+   ********************************************************************************/
+   void set_training_data(const basic_dataset_file<T>& dataset)
+   {
+      this->set_training_data(dataset.inputs(), dataset.outputs());
+      return;
+   }
+
+   /********************************************************************************
+   * save: Sparar ntverkets lager i en binr modellfil, vilken kan lsas in
+   *       igen via medlemsfunktionen load eller minnesmappas fr prediktion via
+   *       klassen basic_model_file. Returnerar true om filen kunde skrivas,
+   *       annars false.
+   *
+   *       - path: Skvg till modellfilen som ska skapas.
+   ********************************************************************************/
+   bool save(const char* path) const
+   {
+      return basic_model_file<T>::write(path, this->layers_);
+   }
+
+   /********************************************************************************
+   * load: Lser in lagren frn angiven modellfil, dr ntverkets tidigare lager
+   *       erstts. Trningsdatan pverkas inte. Returnerar true om filen kunde
+   *       lsas in, annars false, varvid ntverket lmnas ofrndrat.
+   *
+   *       - path: Skvg till modellfilen.
+   ********************************************************************************/
+   bool load(const char* path)
+   {
+      basic_model_file<T> model;
+      if (!model.open(path)) return false;
+      return this->load(model);
+   }
+
+   /********************************************************************************
+   * load: Kopierar lagren frn angiven ppnad modellfil, dr ntverkets
+   *       tidigare lager erstts. Returnerar true om modellen kunde lsas in,
+   *       annars false, varvid ntverket lmnas ofrndrat.
+   *
+   *       - model: Referens till ppnad modellfil.
+   ********************************************************************************/
+   bool load(const basic_model_file<T>& model)
+   {
+      if (!model.is_open()) return false;
+      std::vector<std::size_t> layer_sizes{ model.num_inputs() };
+
+      for (std::size_t i = 0; i < model.num_layers(); ++i)
+      {
+         layer_sizes.push_back(model.num_nodes(i));
+      }
+
+      this->init(layer_sizes);
+
+      for (std::size_t i = 0; i < this->layers_.size(); ++i)
+      {
+         auto& layer = this->layers_[i];
+         const auto weights = model.weights(i);
+         const auto bias = model.bias(i);
+
+         layer.activation = model.activation(i);
+
+         for (std::size_t j = 0; j < layer.num_nodes(); ++j)
+         {
+            layer.bias[j] = bias[j];
+            copy_row(weights[j], weights.columns(), layer.weights[j], layer.num_weights());
+         }
+      }
+      return true;
+   }
+
+   /********************************************************************************
+   * train: Trnar angivet neuralt ntverk under angivet antal epoker med 
+   *        godtycklig lrhastighet. Som default justeras parametrarna efter
+   *        varje trningsuppsttning. Vid en batchstorlek strre n 1 sker i
+   *        stllet trningen i batchar (mini-batch), dr framt- och
+   *        baktpropagering genomfrs fr hela batchen via matrisoperationer
+   *        och parametrarna justeras en gng per batch via medelvrdet av
+   *        batchens bidrag. Den sista batchen i varje epok kan innehlla frre
+   *        trningsuppsttningar ifall antalet inte r jmnt delbart.
+   *        Efter varje epok lagras frlusten och angivna villkor fr avbrott
+   *        utvrderas, varefter statistik frn trningen returneras.
+   *        Parametrarna justeras enligt vald metod, se set_optimizer, dr
+   *        lrhastigheten fr varje epok berknas via vald schemalggning,
+   *        se set_schedule. Via set_prefetch kan trningsdatan i stllet
+   *        lsas in asynkront av en egen trd.
+   * 
+   *        - num_epochs   : Antalet epoker som ska trning ska genomfras under.
+   *        - learning_rate: Lrhastigheten, avgr hur mycket ntverkets parametrar
+   *                         justeras vid fel.
+   *        - batch_size   : Antalet trningsuppsttningar per batch (default = 1).
+   *        - stopping     : Villkor fr att avbryta trningen i frtid (default =
+   *                         inga villkor, samtliga epoker genomfrs).
+   ********************************************************************************/
+   train_stats_type train(const std::size_t num_epochs,
+                          const T learning_rate,
+                          const std::size_t batch_size = 1,
+                          const early_stopping_type& stopping = early_stopping_type())
+   {
+      if (batch_size > 1)
+      {
+         return this->train_batch(num_epochs, learning_rate, batch_size, stopping);
+      }
+
+      train_stats_type stats;
+      const auto validation = this->begin_training(stats, stopping, num_epochs);
+      const auto overlap = !may_stop_early(stopping);
+      loader_type loader(this->prefetch_);
+      if (this->prefetch_ > 0) this->start_loader(loader, prefetch_chunk);
+
+      for (std::size_t i = 0; i < num_epochs; ++i) 
+      {
+         auto loss = T(0);
+         const auto rate = this->schedule_.rate(learning_rate, i, num_epochs);
+
+         if (this->prefetch_ > 0)
+         {
+            if (i == 0 || !overlap) loader.begin_epoch();
+
+            while (const auto batch = loader.next())
+            {
+               for (std::size_t k = 0; k < batch->num_samples; ++k)
+               {
+                  const auto input = batch->input[k];
+                  const auto size = batch->input_size[k];
+
+                  this->feedforward(input, size);
+                  loss += this->backpropagate_optimize(input, size, batch->reference[k], this->next_update(rate));
+               }
+            }
+
+            if (overlap && i + 1 < num_epochs) loader.begin_epoch();
+         }
+         else
+         {
+            this->randomize_training_order(); 
+
+            for (auto& j : this->train_order_)
+            {
+               const auto input = this->input_row(j);
+               const auto size = this->input_size(j);
+
+               this->feedforward(input, size);
+               loss += this->backpropagate_optimize(input, size, this->reference_row(j), this->next_update(rate));
+            }
+         }
+
+         if (this->end_epoch(stats, stopping, loss, validation)) break;
+      }
+
+      loader.stop();
+      this->end_training(validation);
+      return stats;
+   }
+
+   /********************************************************************************
+   * train_batch: Trnar angivet neuralt ntverk i batchar (mini-batch) under
+   *              angivet antal epoker. Trningsuppsttningarna fr varje batch
+   *              kopieras till sammanhngande buffertar, varefter framt- och
+   *              baktpropagering samt justering av parametrar genomfrs fr
+   *              hela batchen p en gng. Vid asynkron inlsning, se
+   *              set_prefetch, packas nsta batch av inlsningstrden medan
+   *              aktuell batch trnas.
+   *
+   *              - num_epochs   : Antalet epoker som trning ska genomfras under.
+   *              - learning_rate: Lrhastigheten, avgr hur mycket ntverkets
+   *                               parametrar justeras vid fel.
+   *              - batch_size   : Maximalt antal trningsuppsttningar per batch.
+   *              - stopping     : Villkor fr att avbryta trningen i frtid
+   *                               (default = inga villkor).
+   ********************************************************************************/
+   train_stats_type train_batch(const std::size_t num_epochs,
+                                const T learning_rate,
+                                const std::size_t batch_size,
+                                const early_stopping_type& stopping = early_stopping_type())
+   {
+      train_stats_type stats;
+      const auto validation = this->begin_training(stats, stopping, num_epochs);
+      const auto overlap = !may_stop_early(stopping);
+      loader_type loader(this->prefetch_);
+      this->resize_batch(batch_size);
+      if (this->prefetch_ > 0) this->start_loader(loader, batch_size);
+
+      for (std::size_t i = 0; i < num_epochs; ++i)
+      {
+         auto loss = T(0);
+         const auto rate = this->schedule_.rate(learning_rate, i, num_epochs);
+
+         if (this->prefetch_ > 0)
+         {
+            if (i == 0 || !overlap) loader.begin_epoch();
+
+            while (const auto batch = loader.next())
+            {
+               loss += this->train_on_batch(batch->input, batch->reference, batch->num_samples, rate);
+            }
+
+            if (overlap && i + 1 < num_epochs) loader.begin_epoch();
+         }
+         else
+         {
+            this->randomize_training_order();
+
+            for (std::size_t j = 0; j < this->train_order_.size(); j += batch_size)
+            {
+               const auto remaining = this->train_order_.size() - j;
+               const auto num_samples = remaining < batch_size ? remaining : batch_size;
+
+               this->load_batch(&this->train_order_[j], num_samples);
+               loss += this->train_on_batch(this->batch_input_, this->batch_reference_, num_samples, rate);
+            }
+         }
+
+         if (this->end_epoch(stats, stopping, loss, validation)) break;
+      }
+
+      loader.stop();
+      this->end_training(validation);
+      return stats;
+   }
+
+   /********************************************************************************
+   * train_parallel: Trnar angivet neuralt ntverk i batchar med angivet antal
+   *                 trdar. Varje batch delas upp i lika stora delar, en per
+   *                 trd, dr varje trd genomfr framt- och baktpropagering
+   *                 fr sin del via egna buffertar och berknar bidragen till
+   *                 justeringen av parametrarna. Drefter summeras samtliga
+   *                 trdars bidrag i fast trdordning och parametrarna justeras
+   *                 en gng per batch, dr ven justeringen delas upp mellan
+   *                 trdarna via disjunkta nodintervall. Med samma antal trdar
+   *                 och samma ordningsfljd fr trningsdatan blir resultatet
+   *                 drmed reproducerbart.
+   *
+   *                 - num_epochs   : Antalet epoker som trning ska genomfras under.
+   *                 - learning_rate: Lrhastigheten, avgr hur mycket ntverkets
+   *                                  parametrar justeras vid fel.
+   *                 - batch_size   : Antalet trningsuppsttningar per batch.
+   *                 - num_threads  : Antalet trdar (default = 0, vilket innebr
+   *                                  antalet tillgngliga hrdvarutrdar).
+   *                 - stopping     : Villkor fr att avbryta trningen i frtid
+   *                                  (default = inga villkor), vilka utvrderas
+   *                                  av den frsta trden efter varje epok.
+   ********************************************************************************/
+   train_stats_type train_parallel(const std::size_t num_epochs,
+                                   const T learning_rate,
+                                   const std::size_t batch_size,
+                                   const std::size_t num_threads = 0,
+                                   const early_stopping_type& stopping = early_stopping_type())
+   {
+      train_stats_type stats;
+      const auto validation = this->begin_training(stats, stopping, num_epochs);
+      auto stop = false;
+      const auto threads = default_num_threads(num_threads);
+      const auto samples = batch_size > 0 ? batch_size : 1;
+      const auto samples_per_thread = (samples + threads - 1) / threads;
+      std::vector<worker_workspace> workspaces(threads);
+      barrier sync(threads);
+      const auto first_step = this->optimizer_steps_;
+
+      auto worker = [&](const std::size_t thread)
+      {
+         auto step = first_step;
+         workspaces[thread].resize(this->layers_, samples_per_thread);
+
+         for (std::size_t i = 0; i < num_epochs; ++i)
+         {
+            if (thread == 0 && !stop) this->randomize_training_order();
+            sync.wait();
+            if (stop) break;
+            workspaces[thread].loss = T(0);
+            const auto rate = this->schedule_.rate(learning_rate, i, num_epochs);
+
+            for (std::size_t j = 0; j < this->train_order_.size(); j += samples)
+            {
+               const auto remaining = this->train_order_.size() - j;
+               const auto num_samples = remaining < samples ? remaining : samples;
+               const auto first = j + num_samples * thread / threads;
+               const auto last = j + num_samples * (thread + 1) / threads;
+
+               this->compute_gradient(workspaces[thread], &this->train_order_[0] + first, last - first);
+               sync.wait();
+               this->apply_gradients(workspaces, thread, num_samples, this->optimizer_.update(rate, ++step));
+               sync.wait();
+            }
+
+            if (thread == 0)
+            {
+               auto loss = T(0);
+               for (const auto& j : workspaces) loss += j.loss;
+               stop = this->end_epoch(stats, stopping, loss, validation);
+            }
+         }
+
+         if (thread == 0) this->optimizer_steps_ = step;
+      };
+
+      std::vector<std::thread> pool;
+
+      for (std::size_t i = 1; i < threads; ++i)
+      {
+         pool.emplace_back(worker, i);
+      }
+
+      worker(0);
+
+      for (auto& i : pool)
+      {
+         i.join();
+      }
+
+      this->end_training(validation);
+      return stats;
+   }
+
+   /********************************************************************************
+   * train_hogwild: Trnar angivet neuralt ntverk asynkront med angivet antal
+   *                trdar enligt metoden Hogwild, dr trdarna justerar de
+   *                delade parametrarna direkt utan lsning eller synkronisering
+   *                mellan batcharna. Varje trd hmtar nsta batch ur
+   *                trningsordningen via en gemensam atomr rknare, genomfr
+   *                framt- och baktpropagering via egna buffertar och justerar
+   *                drefter samtliga lager via SGD. Trdarna synkroniseras
+   *                enbart mellan epokerna, d trningsordningen blandas och
+   *                frlusten utvrderas.
+   *
+   *                Samtidiga justeringar frn olika trdar kan lsa inaktuella
+   *                parametrar eller skriva ver varandras bidrag, vilket
+   *                metoden frutstter r ovanligt och ofarligt nr varje
+   *                trningsexempel enbart pverkar en mindre del av
+   *                parametrarna, exempelvis vid glesa insignaler. Varje rad i
+   *                viktmatriserna startar p en egen cache-linje, varfr olika
+   *                noders vikter aldrig delar cache-linje. Enbart viktraderna
+   *                r utfyllda: varje lagers bias lagras ttt i en vektor,
+   *                varfr flera noders bias delar cache-linje och justeringar
+   *                av dem frn olika trdar kan orsaka falsk delning. Varje
+   *                bias justeras dock enbart en gng per nod och batch,
+   *                jmfrt med en hel rad vikter. Resultatet r inte
+   *                reproducerbart med fler n en trd, men med en trd blir
+   *                resultatet detsamma som vid trning via train_batch med SGD.
+   *                Vald metod fr justering ignoreras, dr SGD alltid anvnds,
+   *                d tillstnden fr momentum, RMSProp och Adam annars skulle
+   *                uppdateras av flera trdar samtidigt. Av samma anledning
+   *                anvnds inga transponerade kopior av vikterna, se
+   *                set_transposed_weights, vilka markeras som inaktuella av
+   *                den anropande trden innan trdarna startas. Trdarna
+   *                skriver drefter aldrig flaggan, se lagrens
+   *                medlemsfunktion optimize.
+   *
+   *                - num_epochs   : Antalet epoker som trning ska genomfras under.
+   *                - learning_rate: Lrhastigheten, avgr hur mycket ntverkets
+   *                                 parametrar justeras vid fel.
+   *                - batch_size   : Antalet trningsuppsttningar per justering
+   *                                 (default = 1).
+   *                - num_threads  : Antalet trdar (default = 0, vilket innebr
+   *                                 antalet tillgngliga hrdvarutrdar).
+   *                - stopping     : Villkor fr att avbryta trningen i frtid
+   *                                 (default = inga villkor), vilka utvrderas
+   *                                 av den frsta trden efter varje epok.
+   ********************************************************************************/
+   train_stats_type train_hogwild(const std::size_t num_epochs,
+                                  const T learning_rate,
+                                  const std::size_t batch_size = 1,
+                                  const std::size_t num_threads = 0,
+                                  const early_stopping_type& stopping = early_stopping_type())
+   {
+      train_stats_type stats;
+      const auto validation = this->begin_training(stats, stopping, num_epochs);
+      auto stop = false;
+      const auto threads = default_num_threads(num_threads);
+      const auto samples = batch_size > 0 ? batch_size : 1;
+      std::vector<worker_workspace> workspaces(threads);
+      std::atomic<std::size_t> cursor{0};
+
+      for (auto& layer : this->layers_)
+      {
+         layer.invalidate_transposed();
+      }
+
+      barrier sync(threads);
+
+      auto worker = [&](const std::size_t thread)
+      {
+         auto& workspace = workspaces[thread];
+         auto& buffers = workspace.layers;
+         workspace.resize(this->layers_, samples, false);
+
+         for (std::size_t i = 0; i < num_epochs; ++i)
+         {
+            if (thread == 0 && !stop)
+            {
+               this->randomize_training_order();
+               cursor.store(0, std::memory_order_relaxed);
+            }
+
+            sync.wait();
+            if (stop) break;
+            workspace.loss = T(0);
+            const auto rate = this->schedule_.rate(learning_rate, i, num_epochs);
+            const auto size = this->train_order_.size();
+
+            for (auto j = cursor.fetch_add(samples, std::memory_order_relaxed); j < size;
+                 j = cursor.fetch_add(samples, std::memory_order_relaxed))
+            {
+               const auto num_samples = size - j < samples ? size - j : samples;
+               this->propagate(workspace, &this->train_order_[0] + j, num_samples);
+
+               for (std::size_t k = 0; k < this->layers_.size(); ++k)
+               {
+                  const auto& input = k > 0 ? buffers[k - 1].output : workspace.input;
+                  this->layers_[k].optimize(input, buffers[k].error, num_samples, rate);
+               }
+            }
+
+            sync.wait();
+
+            if (thread == 0)
+            {
+               auto loss = T(0);
+               for (const auto& j : workspaces) loss += j.loss;
+               this->optimizer_steps_ += (size + samples - 1) / samples;
+               stop = this->end_epoch(stats, stopping, loss, validation);
+            }
+         }
+      };
+
+      std::vector<std::thread> pool;
+
+      for (std::size_t i = 1; i < threads; ++i)
+      {
+         pool.emplace_back(worker, i);
+      }
+
+      worker(0);
+
+      for (auto& i : pool)
+      {
+         i.join();
+      }
+
+      this->end_training(validation);
+      return stats;
+   }
+
+   /********************************************************************************
+   * train_distributed: Trnar angivet neuralt ntverk dataparallellt ver
+   *                    flera processer, exempelvis p olika datorer, dr varje
+   *                    process trnar p sin egen del av trningsdatan i
+   *                    batchar. Innan trningen kopieras parametrarna frn
+   *                    process 0 till vriga processer. Vid varje batch
+   *                    summeras samtliga processers bidrag till justeringen av
+   *                    parametrarna via angiven kommunikator, varefter varje
+   *                    process justerar parametrarna med samma summor, vilket
+   *                    gr att samtliga processer har identiska parametrar
+   *                    under hela trningen. Med en process blir resultatet
+   *                    detsamma som vid trning via train_parallel med en trd.
+   *
+   *                    Summeringen sker lager fr lager via en egen trd med
+   *                    brjan i utgngslagret, vilket gr att bidragen fr ett
+   *                    lager kommuniceras medan baktpropageringen fortstter
+   *                    genom fregende lager. Processer med frre batchar per
+   *                    epok bidrar med tomma batchar i slutet av epoken, s att
+   *                    samtliga processer genomfr lika mnga justeringar.
+   *
+   *                    Frlusten summeras ver samtliga processer efter varje
+   *                    epok, vilket gr att villkoren fr avbrott utvrderas
+   *                    lika i samtliga processer. Validering via
+   *                    validation_split stds drfr inte och ignoreras. Vid
+   *                    kommunikationsfel avbryts trningen, vilket indikeras av
+   *                    att kommunikatorns medlemsfunktion is_connected
+   *                    returnerar false.
+   *
+   *                    - num_epochs   : Antalet epoker som trning ska genomfras under.
+   *                    - learning_rate: Lrhastigheten, avgr hur mycket ntverkets
+   *                                     parametrar justeras vid fel.
+   *                    - batch_size   : Antalet trningsuppsttningar per batch och
+   *                                     process.
+   *                    - communicator : Referens till kommunikatorn, exempelvis av
+   *                                     typen tcp_communicator eller
+   *                                     mpi_communicator, vilken mste erbjuda
+   *                                     medlemsfunktionerna rank, size samt
+   *                                     allreduce.
+   *                    - stopping     : Villkor fr att avbryta trningen i frtid
+   *                                     (default = inga villkor).
+   ********************************************************************************/
+   template <typename Communicator>
+   train_stats_type train_distributed(const std::size_t num_epochs,
+                                      const T learning_rate,
+                                      const std::size_t batch_size,
+                                      Communicator& communicator,
+                                      const early_stopping_type& stopping = early_stopping_type())
+   {
+      train_stats_type stats;
+      auto conditions = stopping;
+      conditions.validation_split = T(0);
+      const auto validation = this->begin_training(stats, conditions, num_epochs);
+      if (this->layers_.empty()) return stats;
+      const auto samples = batch_size > 0 ? batch_size : 1;
+      const auto rank = communicator.rank();
+      const auto last = this->layers_.size() - 1;
+      auto ok = true;
+
+      for (auto& layer : this->layers_)
+      {
+         if (rank != 0)
+         {
+            layer.weights.fill(T(0));
+            layer.bias.assign(layer.bias.size(), T(0));
+         }
+         ok = ok && communicator.allreduce(layer.weights.data(), layer.weights.rows() * layer.weights.stride()) &&
+            communicator.allreduce(layer.bias.data(), layer.bias.size());
+         layer.invalidate_transposed();
+         layer.update_transposed();
+      }
+
+      std::vector<double> counts(communicator.size(), 0.0); /* Exakt upp till 2^53 oavsett T. */
+      counts[rank] = static_cast<double>(this->train_order_.size());
+      ok = ok && communicator.allreduce(counts.data(), counts.size());
+      std::size_t total = 0, num_batches = 0;
+
+      for (const auto i : counts)
+      {
+         const auto count = static_cast<std::size_t>(i);
+         const auto batches = (count + samples - 1) / samples;
+         total += count;
+         if (batches > num_batches) num_batches = batches;
+      }
+
+      std::vector<worker_workspace> workspaces(1);
+      auto& workspace = workspaces.front();
+      auto& buffers = workspace.layers;
+      workspace.resize(this->layers_, samples);
+      task_queue queue;
+
+      for (std::size_t i = 0; i < num_epochs && ok; ++i)
+      {
+         this->randomize_training_order();
+         workspace.loss = T(0);
+         const auto rate = this->schedule_.rate(learning_rate, i, num_epochs);
+         const auto size = this->train_order_.size();
+
+         for (std::size_t j = 0; j < num_batches && ok; ++j)
+         {
+            const auto first = j * samples;
+            const auto num_samples = first < size ? (size - first < samples ? size - first : samples) : 0;
+            std::size_t batch_samples = 0;
+
+            for (const auto k : counts)
+            {
+               const auto count = static_cast<std::size_t>(k);
+               if (first < count) batch_samples += count - first < samples ? count - first : samples;
+            }
+
+            this->load_batch(this->train_order_.data() + (num_samples > 0 ? first : 0), num_samples,
+                             workspace.input, workspace.reference);
+
+            for (std::size_t k = 0; k <= last; ++k)
+            {
+               const auto& input = k > 0 ? buffers[k - 1].output : workspace.input;
+               this->layers_[k].feedforward(input, num_samples, buffers[k].output);
+            }
+
+            workspace.loss += this->layers_[last].backpropagate(workspace.reference, num_samples,
+                                                                buffers[last].output, buffers[last].error);
+
+            for (auto k = last + 1; k-- > 0;)
+            {
+               if (k < last)
+               {
+                  this->layers_[k].backpropagate(this->layers_[k + 1], buffers[k + 1].error, num_samples,
+                                                 buffers[k].output, buffers[k].error);
+               }
+
+               const auto& input = k > 0 ? buffers[k - 1].output : workspace.input;
+               auto& buffer = buffers[k];
+               this->layers_[k].gradient(input, buffer.error, num_samples, buffer.weight_gradient, buffer.bias_gradient);
+               queue.push([&communicator, &buffer, &ok]
+               {
+                  ok = communicator.allreduce(buffer.weight_gradient.data(),
+                                              buffer.weight_gradient.rows() * buffer.weight_gradient.stride()) &&
+                     communicator.allreduce(buffer.bias_gradient.data(), buffer.bias_gradient.size()) && ok;
+               });
+            }
+
+            queue.wait();
+            if (ok) this->apply_gradients(workspaces, 0, batch_samples, this->next_update(rate));
+         }
+
+         auto loss = workspace.loss;
+         if (!ok || !communicator.allreduce(&loss, 1)) break;
+         if (this->end_epoch(stats, conditions, loss, validation, total)) break;
+      }
+
+      this->end_training(validation);
+      return stats;
+   }
+
+   /********************************************************************************
+   * train_step: Trnar ntverket inkrementellt via en enskild
+   *             trningsuppsttning, dr parametrarna justeras direkt p samma
+   *             stt som vid trning via train utan batchar. Varken
+   *             trningsdatan eller trningsordningen anvnds, vilket gr att
+   *             nya exempel kan trnas allteftersom de anlnder, exempelvis
+   *             frn en datastrm, utan att lagras. Vald metod fr justering
+   *             gller, dr metodens tillstnd behlls mellan anropen, medan
+   *             schemalggningen av lrhastigheten inte tillmpas. Returnerar
+   *             medelkvadratfelet per utsignal fre justeringen.
+   *
+   *             Parametrarna justeras p plats, varfr prediktion via samma
+   *             ntverk inte fr ske samtidigt frn andra trdar. Prediktion
+   *             under pgende trning br i stllet ske via kopior av
+   *             modellen som publiceras med jmna mellanrum, se klassen
+   *             snapshot_publisher.
+   *
+   *             - input        : Pekare till indatan.
+   *             - input_size   : Antalet insignaler.
+   *             - reference    : Pekare till referensvrdena, vilka mste
+   *                              innehlla num_outputs() flyttal.
+   *             - learning_rate: Lrhastigheten, avgr hur mycket ntverkets
+   *                              parametrar justeras vid fel.
+   ********************************************************************************/
+   T train_step(const T* input,
+                const std::size_t input_size,
+                const T* reference,
+                const T learning_rate)
+   {
+      if (this->layers_.empty()) return T(0);
+      this->prepare_step();
+      this->feedforward(input, input_size);
+      const auto loss = this->backpropagate_optimize(input, input_size, reference, this->next_update(learning_rate));
+      return loss / static_cast<T>(this->num_outputs());
+   }
+
+   /********************************************************************************
+   * train_step: Trnar ntverket inkrementellt via en enskild
+   *             trningsuppsttning lagrad i vektorer, se ovan. Ingen
+   *             justering sker om referensvrdena r frre n antalet
+   *             utsignaler, varvid 0 returneras.
+   *
+   *             - input        : Referens till vektor innehllande indata.
+   *             - reference    : Referens till vektor innehllande referensvrden.
+   *             - learning_rate: Lrhastigheten.
+   ********************************************************************************/
+   T train_step(const std::vector<T>& input,
+                const std::vector<T>& reference,
+                const T learning_rate)
+   {
+      if (reference.size() < this->num_outputs()) return T(0);
+      return this->train_step(input.data(), input.size(), reference.data(), learning_rate);
+   }
+
+   /********************************************************************************
+   * partial_fit: Trnar ntverket inkrementellt via en mindre batch, dr
+   *              parametrarna justeras en gng via medelvrdet av batchens
+   *              bidrag p samma stt som vid trning via train med batchar.
+   *              Raderna kopieras till ntverkets batchbuffertar, vilka enbart
+   *              allokeras om nr batchen r strre n tidigare, medan
+   *              trningsdatan inte anvnds. Som fr train_step behlls
+   *              metodens tillstnd mellan anropen, medan schemalggningen av
+   *              lrhastigheten inte tillmpas. Returnerar medelkvadratfelet
+   *              per utsignal fre justeringen, alternativt 0 om batchen r
+   *              tom.
+   *
+   *              - input        : Vy ver indatan, en rad per trningsuppsttning.
+   *              - reference    : Vy ver referensvrdena, en rad per
+   *                               trningsuppsttning. Vid olika antal rader
+   *                               anvnds enbart rader som finns i bgge vyerna.
+   *              - learning_rate: Lrhastigheten, avgr hur mycket ntverkets
+   *                               parametrar justeras vid fel.
+   ********************************************************************************/
+   T partial_fit(const matrix_view_type& input,
+                 const matrix_view_type& reference,
+                 const T learning_rate)
+   {
+      const auto num_samples = input.rows() < reference.rows() ? input.rows() : reference.rows();
+      if (this->layers_.empty() || num_samples == 0) return T(0);
+      const auto capacity = this->batch_input_.rows() > num_samples ? this->batch_input_.rows() : num_samples;
+      this->prepare_step();
+      this->resize_batch(capacity);
+
+      for (std::size_t k = 0; k < num_samples; ++k)
+      {
+         copy_row(input[k], input.columns(), this->batch_input_[k], this->batch_input_.columns());
+         copy_row(reference[k], reference.columns(), this->batch_reference_[k], this->batch_reference_.columns());
+      }
+
+      const auto loss = this->train_on_batch(this->batch_input_, this->batch_reference_, num_samples, learning_rate);
+      return loss / static_cast<T>(num_samples * this->num_outputs());
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via angiven indata och returnerar en referens
+   *          till en vektor innehllande utdatan.
+   * 
+   *          - input: Referens till vektor innehllande indata.
+   ********************************************************************************/
+   const std::vector<T>& predict(const std::vector<T>& input)
+   {
+      this->feedforward(input.data(), input.size());
+      return this->output();
+   }
+
+   /********************************************************************************
+   * make_inference_context: Returnerar buffertar fr prediktion med angivet
+   *                         neuralt ntverk, dr batchbufferten rymmer angivet
+   *                         antal exempel. Vid batchprediktion med fler exempel
+   *                         behandlas dessa i omgngar.
+   *
+   *                         - batch_size: Antalet exempel som batchbufferten
+   *                                       rymmer (default = 64).
+   ********************************************************************************/
+   inference_context make_inference_context(const std::size_t batch_size = 64) const
+   {
+      inference_context context;
+      this->prepare(context, batch_size);
+      return context;
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via angiven indata utan att ntverket ndras,
+   *          dr samtliga mellanresultat lagras i angivna buffertar. Returnerar
+   *          en referens till buffertens utsignaler. Flera trdar kan anropa
+   *          denna medlemsfunktion samtidigt, s lnge varje trd anvnder egna
+   *          buffertar och ntverket inte trnas under tiden.
+   *
+   *          - input  : Referens till vektor innehllande indata.
+   *          - context: Referens till buffertar fr prediktion.
+   ********************************************************************************/
+   const std::vector<T>& predict(const std::vector<T>& input,
+                                      inference_context& context) const
+   {
+      this->prepare(context, context.batch_size);
+      this->feedforward(input.data(), input.size(), context);
+      return context.output;
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via angiven indata utan att ntverket ndras och
+   *          skriver utsignalerna till angiven adress.
+   *
+   *          - input  : Pekare till indatan, vilken mste innehlla
+   *                     num_inputs() flyttal.
+   *          - output : Pekare till buffert dr utdatan lagras, vilken mste
+   *                     rymma num_outputs() flyttal.
+   *          - context: Referens till buffertar fr prediktion.
+   ********************************************************************************/
+   void predict(const T* input,
+                T* output,
+                inference_context& context) const
+   {
+      this->prepare(context, context.batch_size);
+      this->feedforward(input, this->num_inputs(), context);
+      const auto& result = context.output;
+
+      for (std::size_t i = 0; i < result.size(); ++i)
+      {
+         output[i] = result[i];
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * predict_batch: Genomfr prediktion fr angivet antal exempel lagrade radvis
+   *                i en sammanhngande matris, utan att ntverket ndras.
+   *                Exemplen behandlas i omgngar om batchbuffertens storlek,
+   *                dr varje viktrad teranvnds fr samtliga exempel i en omgng.
+   *                Utdatan skrivs radvis till angiven adress.
+   *
+   *                - input      : Pekare till indatan, num_inputs() flyttal per
+   *                               exempel lagrade direkt efter varandra.
+   *                - num_samples: Antalet exempel.
+   *                - output     : Pekare till buffert dr utdatan lagras, vilken
+   *                               mste rymma num_outputs() flyttal per exempel.
+   *                - context    : Referens till buffertar fr prediktion.
+   ********************************************************************************/
+   void predict_batch(const T* input,
+                      const std::size_t num_samples,
+                      T* output,
+                      inference_context& context) const
+   {
+      if (this->layers_.empty()) return;
+      ANN_INSTRUMENT_SCOPE(feedforward, num_samples);
+      this->prepare(context, context.batch_size > 0 ? context.batch_size : 1);
+      const auto chunk_size = context.batch_size;
+      const auto last = this->layers_.size() - 1;
+
+      for (std::size_t i = 0; i < num_samples; i += chunk_size)
+      {
+         const auto remaining = num_samples - i;
+         const auto count = remaining < chunk_size ? remaining : chunk_size;
+         auto source = input + i * this->num_inputs();
+         auto stride = this->num_inputs();
+         auto columns = this->num_inputs();
+
+         for (std::size_t j = 0; j < last; ++j)
+         {
+            auto& buffer = context.batch_target(j);
+            this->layers_[j].feedforward(source, stride, columns, count, buffer.data(), buffer.stride());
+            source = buffer.data();
+            stride = buffer.stride();
+            columns = this->layers_[j].num_nodes();
+         }
+
+         this->layers_[last].feedforward(source, stride, columns, count,
+                                         output + i * this->num_outputs(), this->num_outputs());
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * print: Genomfr prediktion med indata frn angiven vektor och skriver ut 
+   *        predikterad utdata via angiven utstrm, dr standardutenheten std::cout 
+   *        anvnds som default fr utskrift i terminalen. 
+   *
+   *        - input       : Referens till vektor innehllande indata.
+   *        - num_decimals: Antalet decimaler vid utskrift (default = 1).
+   *        - ostream     : Referens till godtycklig utstrm (default = std::cout).
+   ********************************************************************************/
+   void print(const std::vector<std::vector<T>>& input,
+              const std::size_t num_decimals = 1,
+              std::ostream& ostream = std::cout)
+   {
+      if (input.size() == 0) return;
+      const auto& end = input[input.size() - 1];
+      ostream << "--------------------------------------------------------------------------------\n";
+      
+      for (auto& i : input)
+      {
+         ostream << "Input:\t";
+         layer_type::print(i, ostream, num_decimals);
+
+         ostream << "Output:\t";
+         layer_type::print(this->predict(i), ostream, num_decimals);
+
+         if (&i < &end) ostream << "\n";
+      }
+
+      ostream << "--------------------------------------------------------------------------------\n\n";
+      return;
+   }
+
+   /********************************************************************************
+   * print: Genomfr prediktion med samtliga befintliga trningsuppsttningars
+   *        indata och skriver ut predikterad utdata via angiven utstrm, dr
+   *        standardutenheten std::cout anvnds som default fr utskrift i 
+   *        terminalen.
+   * 
+   *        - num_decimals: Antalet decimaler vid utskrift (default = 1).
+   *        - ostream     : Referens till godtycklig utstrm (default = std::cout).
+   ********************************************************************************/
+   void print(const std::size_t num_decimals = 1,
+              std::ostream& ostream = std::cout)
+   {
+      if (this->train_in_view_.empty())
+      {
+         this->print(this->train_in_, num_decimals, ostream);
+         return;
+      }
+
+      const auto& input = this->train_in_view_;
+      ostream << "--------------------------------------------------------------------------------\n";
+
+      for (std::size_t i = 0; i < input.rows(); ++i)
+      {
+         ostream << "Input:\t";
+         layer_type::print(input[i], input.columns(), ostream, num_decimals);
+
+         ostream << "Output:\t";
+         this->feedforward(input[i], input.columns());
+         layer_type::print(this->output(), ostream, num_decimals);
+
+         if (i + 1 < input.rows()) ostream << "\n";
+      }
+
+      ostream << "--------------------------------------------------------------------------------\n\n";
+      return;
+   }
+};
+
+/********************************************************************************
+* ann: Neuralt ntverk med parametrar samt in- och utdata av typen double.
+********************************************************************************/
+using ann = basic_ann<double>;
 
 #endif /* ANN_HPP_ */
\ No newline at end of file
@@ -0,0 +1,279 @@
+/********************************************************************************
+* batch_loader.hpp: Innehller asynkron inlsning av trningsdata via
+*                   klasstemplaten basic_batch_loader, dr en egen trd
+*                   blandar trningsordningen och packar nsta batch till en
+*                   sammanhngande buffert medan aktuell batch trnas. Antalet
+*                   buffertar r fast, vilket gr att minnesbehovet r
+*                   begrnsat oavsett datamngdens storlek, samtidigt som
+*                   exempelvis sidfel vid lsning frn en minnesmappad
+*                   datafil inte lngre blockerar trningen.
+********************************************************************************/
+#ifndef BATCH_LOADER_HPP_
+#define BATCH_LOADER_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "matrix.hpp"
+#include "random.hpp"
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstddef>
+
+/********************************************************************************
+* basic_loaded_batch: Buffertar fr en packad batch, dr varje
+*                     trningsuppsttning lagras p en egen rad. Vid frre
+*                     vrden n ntverkets antal in- eller utgngar stts
+*                     resterande vrden till 0.
+********************************************************************************/
+template <typename T>
+struct basic_loaded_batch
+{
+   basic_matrix<T> input;               /* Insignaler, en rad per trningsuppsttning. */
+   basic_matrix<T> reference;           /* Referensvrden, en rad per trningsuppsttning. */
+   std::vector<std::size_t> input_size; /* Antalet lagrade insignaler fr varje rad. */
+   std::size_t num_samples{0};          /* Antalet trningsuppsttningar (0 = epokens slut). */
+};
+
+/********************************************************************************
+* basic_batch_loader: Klass fr asynkron inlsning av batchar via en egen
+*                     trd och en begrnsad k av buffertar. Varje epok
+*                     pbrjas via medlemsfunktionen begin_epoch, varefter
+*                     inlsningstrden blandar trningsordningen via angiven
+*                     generator och packar epokens batchar en i taget via
+*                     angiven funktion. Batcharna hmtas i ordning via
+*                     medlemsfunktionen next, dr fregende batch lmnas
+*                     tillbaka vid varje anrop. Med tv buffertar (default)
+*                     packas allts nsta batch medan aktuell batch trnas.
+*
+*                     Trningsordningen och generatorn anvnds enbart av
+*                     inlsningstrden mellan anropet av begin_epoch och
+*                     epokens slut, varfr samma ordningsfljd som vid
+*                     synkron inlsning erhlls.
+********************************************************************************/
+template <typename T>
+class basic_batch_loader
+{
+public:
+   using batch_type = basic_loaded_batch<T>; /* Buffertar fr en packad batch. */
+   using fill_function = std::function<void(const std::size_t*, std::size_t, batch_type&)>;
+
+   /********************************************************************************
+   * basic_batch_loader: Initierar ny inlsare med angivet antal buffertar.
+   *
+   *                     - queue_size: Antalet buffertar, minst 1 (default = 2).
+   ********************************************************************************/
+   explicit basic_batch_loader(const std::size_t queue_size = 2)
+      : slots_(queue_size > 0 ? queue_size : 1) { }
+
+   basic_batch_loader(const basic_batch_loader&) = delete;
+   basic_batch_loader& operator=(const basic_batch_loader&) = delete;
+
+   /********************************************************************************
+   * ~basic_batch_loader: Avslutar inlsningstrden.
+   ********************************************************************************/
+   ~basic_batch_loader(void)
+   {
+      this->stop();
+      return;
+   }
+
+   /********************************************************************************
+   * start: Allokerar samtliga buffertar och startar inlsningstrden, vilken
+   *        vntar p att frsta epoken pbrjas. En eventuell tidigare
+   *        inlsning avslutas frst.
+   *
+   *        - order      : Referens till trningsordningen, vilken blandas
+   *                       infr varje epok.
+   *        - generator  : Referens till generatorn som anvnds fr blandning.
+   *        - batch_size : Maximalt antal trningsuppsttningar per batch.
+   *        - num_inputs : Antalet insignaler per trningsuppsttning.
+   *        - num_outputs: Antalet utsignaler per trningsuppsttning.
+   *        - fill       : Funktion som packar angivna trningsuppsttningar
+   *                       till angiven batch.
+   ********************************************************************************/
+   void start(std::vector<std::size_t>& order,
+              random_generator& generator,
+              const std::size_t batch_size,
+              const std::size_t num_inputs,
+              const std::size_t num_outputs,
+              fill_function fill)
+   {
+      this->stop();
+      this->order_ = &order;
+      this->generator_ = &generator;
+      this->batch_size_ = batch_size > 0 ? batch_size : 1;
+      this->fill_ = std::move(fill);
+      this->head_ = 0;
+      this->num_filled_ = 0;
+      this->holding_ = false;
+      this->num_requested_ = 0;
+      this->stopping_ = false;
+      this->num_waits_ = 0;
+
+      for (auto& slot : this->slots_)
+      {
+         slot.input.resize(this->batch_size_, num_inputs, T(0));
+         slot.reference.resize(this->batch_size_, num_outputs, T(0));
+         slot.input_size.assign(this->batch_size_, 0);
+         slot.num_samples = 0;
+      }
+
+      this->thread_ = std::thread(&basic_batch_loader::run, this);
+      return;
+   }
+
+   /********************************************************************************
+   * begin_epoch: Pbrjar nsta epok, vilket innebr att inlsningstrden
+   *              blandar trningsordningen och brjar packa epokens batchar.
+   *              Fregende epoks batchar mste ha hmtats dessfrinnan.
+   ********************************************************************************/
+   void begin_epoch(void)
+   {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      ++this->num_requested_;
+      this->condition_.notify_all();
+      return;
+   }
+
+   /********************************************************************************
+   * next: Lmnar tillbaka fregende batch och returnerar en pekare till nsta
+   *       batch i aktuell epok, dr anropande trd blockeras tills batchen har
+   *       packats. Returnerar nullptr vid epokens slut.
+   ********************************************************************************/
+   const batch_type* next(void)
+   {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+
+      if (this->holding_)
+      {
+         this->holding_ = false;
+         this->condition_.notify_all();
+      }
+
+      if (this->num_filled_ == 0) ++this->num_waits_;
+      this->condition_.wait(lock, [&] { return this->num_filled_ > 0; });
+      auto& slot = this->slots_[this->head_];
+      this->head_ = (this->head_ + 1) % this->slots_.size();
+      --this->num_filled_;
+
+      if (slot.num_samples == 0)
+      {
+         this->condition_.notify_all();
+         return nullptr;
+      }
+
+      this->holding_ = true;
+      return &slot;
+   }
+
+   /********************************************************************************
+   * stop: Avslutar inlsningstrden, ven mitt i en epok.
+   ********************************************************************************/
+   void stop(void)
+   {
+      if (!this->thread_.joinable()) return;
+      {
+         std::lock_guard<std::mutex> lock(this->mutex_);
+         this->stopping_ = true;
+         this->condition_.notify_all();
+      }
+      this->thread_.join();
+      return;
+   }
+
+   /********************************************************************************
+   * queue_size: Returnerar antalet buffertar.
+   ********************************************************************************/
+   std::size_t queue_size(void) const
+   {
+      return this->slots_.size();
+   }
+
+   /********************************************************************************
+   * num_waits: Returnerar antalet anrop av medlemsfunktionen next sedan start
+   *            dr ingen batch var frdigpackad, allts antalet gnger som
+   *            trningen har vntat p inlsningen.
+   ********************************************************************************/
+   std::size_t num_waits(void) const
+   {
+      return this->num_waits_;
+   }
+
+private:
+   /********************************************************************************
+   * run: Inlsningstrdens huvudloop, dr varje pbrjad epok blandas och
+   *      packas batch fr batch fljt av en tom batch som markerar epokens
+   *      slut. Packningen sker utan lsning, d en ledig buffert inte anvnds
+   *      av ngon annan trd.
+   ********************************************************************************/
+   void run(void)
+   {
+      std::size_t num_started = 0;
+
+      while (true)
+      {
+         {
+            std::unique_lock<std::mutex> lock(this->mutex_);
+            this->condition_.wait(lock, [&] { return this->stopping_ || this->num_requested_ > num_started; });
+            if (this->stopping_) return;
+         }
+
+         ++num_started;
+         auto& order = *this->order_;
+         this->generator_->shuffle(order);
+         std::size_t first = 0;
+
+         while (true)
+         {
+            const auto remaining = order.size() - first;
+            const auto num_samples = remaining < this->batch_size_ ? remaining : this->batch_size_;
+            std::size_t tail = 0;
+            {
+               std::unique_lock<std::mutex> lock(this->mutex_);
+               this->condition_.wait(lock, [&] { return this->stopping_ || this->num_free() > 0; });
+               if (this->stopping_) return;
+               tail = (this->head_ + this->num_filled_) % this->slots_.size();
+            }
+
+            auto& slot = this->slots_[tail];
+            slot.num_samples = num_samples;
+            if (num_samples > 0) this->fill_(order.data() + first, num_samples, slot);
+            {
+               std::lock_guard<std::mutex> lock(this->mutex_);
+               ++this->num_filled_;
+               this->condition_.notify_all();
+            }
+            if (num_samples == 0) break;
+            first += num_samples;
+         }
+      }
+   }
+
+   /********************************************************************************
+   * num_free: Returnerar antalet lediga buffertar, vilket frutstter att
+   *           mutexen r lst.
+   ********************************************************************************/
+   std::size_t num_free(void) const
+   {
+      return this->slots_.size() - this->num_filled_ - (this->holding_ ? 1 : 0);
+   }
+
+   std::vector<batch_type> slots_;            /* Buffertar fr packade batchar (ringbuffert). */
+   std::vector<std::size_t>* order_{nullptr}; /* Trningsordningen som blandas infr varje epok. */
+   random_generator* generator_{nullptr};     /* Generatorn som anvnds fr blandning. */
+   fill_function fill_;                       /* Packar trningsuppsttningar till en batch. */
+   std::size_t batch_size_{1};                /* Maximalt antal trningsuppsttningar per batch. */
+   std::size_t head_{0};                      /* Index fr nsta batch som ska hmtas. */
+   std::size_t num_filled_{0};                /* Antalet packade batchar som inte har hmtats. */
+   bool holding_{false};                      /* Indikerar ifall den senast hmtade batchen anvnds. */
+   std::size_t num_requested_{0};             /* Antalet pbrjade epoker. */
+   bool stopping_{false};                     /* Indikerar ifall inlsningstrden ska avslutas. */
+   std::size_t num_waits_{0};                 /* Antalet gnger som next har behvt vnta. */
+   std::mutex mutex_;                         /* Skyddar kns tillstnd ovan. */
+   std::condition_variable condition_;        /* Vcker vntande trdar vid ndringar i kn. */
+   std::thread thread_;                       /* Inlsningstrden. */
+};
+
+#endif /* BATCH_LOADER_HPP_ */
@@ -0,0 +1,1527 @@
+/********************************************************************************
+* benchmark.cpp: Prestandamtning av neurala ntverk implementerade via klassen
+*                ann samt klassen static_ann. Ett ntverk bestende av tv
+*                ingngar, tv noder i det dolda lagret samt en utgng trnas
+*                fr att detektera ett XOR-mnster, varefter tiden per
+*                prediktion samt per trningsepok mts fr bda klasserna.
+*                Drefter jmfrs batchprediktion med ett strre ntverk
+*                lagrat som flyttal av typen double respektive float, fljt
+*                av tiden tills trningsfrlusten nr en given mlniv vid
+*                trning med SGD respektive Adam, d Adams hgre kostnad per
+*                exempel ska vgas mot att frre epoker krvs.
+*
+*                Slutligen krs en benchmarksvit, dr dense-lagrens krnor
+*                (feedforward, backpropagate samt optimize) samt trning och
+*                prediktion med hela ntverk mts fr ett antal lagerbredder,
+*                batchstorlekar och trdantal. Fr varje mtning redovisas
+*                tid per exempel, exempel per sekund, GFLOP/s samt
+*                modellerad minnestrafik i byte per exempel. Den blockade
+*                matrismultiplikationen i "gemm.hpp" mts ven separat, dr
+*                andelen av mikrokrnans toppvrde redovisas. Toppvrdet mts
+*                med packade block som ryms i L1-cacheminnet och utgr drmed
+*                ett praktiskt toppvrde fr maskinen med aktuella krnor.
+*                Vid prediktion med ett exempel i taget mts ven latensen
+*                per anrop fr klassen ann respektive ett kompilerat ntverk
+*                via klassen compiled_ann, dr anropen sker vxelvis och
+*                redovisas som percentiler samt histogram. Prediktion via
+*                klassen inference_ann, vilken enbart lagrar parametrarna som
+*                krvs vid prediktion, mts bde med ett exempel i taget och
+*                i batchar.
+*
+*                Innan mtningarna kontrolleras att de vektoriserade krnorna
+*                fr justering av parametrar fljer referensversionen samt
+*                att olika vgar fr trning ger samma resultat, exempelvis
+*                trning per exempel, i batchar, parallellt samt distribuerat
+*                med respektive utan transponerade kopior av vikterna samt
+*                trning via train_hogwild med en trd respektive
+*                train_batch. Vidare kontrolleras att tv processer som
+*                trnar distribuerat via tcp_communicator ver 127.0.0.1
+*                med olika mnga exempel fr identiska parametrar. Drtill
+*                kontrolleras att lsare av versioner publicerade via
+*                snapshot_publisher alltid ser en intakt version medan nya
+*                versioner publiceras, dr programmet avslutas med
+*                returkoden 1 vid avvikelse.
+*
+*                Programmet tar fljande argument:
+*                --quick: Mindre svep och kortare mttid, exempelvis fr CI.
+*                --csv  : Skriver enbart benchmarksvitens resultat som CSV.
+*                --json : Skriver enbart benchmarksvitens resultat som JSON.
+********************************************************************************/
+#include "../ann.hpp"
+#include "../compiled_ann.hpp"
+#include "../distributed.hpp"
+#include "../inference_ann.hpp"
+#include "../quantized_ann.hpp"
+#include "../snapshot.hpp"
+#include "../sparse_ann.hpp"
+#include "../static_ann.hpp"
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+/********************************************************************************
+* measure: Anropar angiven funktion angivet antal gnger och returnerar
+*          genomsnittlig tid per anrop i nanosekunder.
+*
+*          - function  : Funktionen som ska mtas.
+*          - iterations: Antalet anrop.
+********************************************************************************/
+template <typename Function>
+static double measure(Function&& function,
+                      const std::size_t iterations)
+{
+   const auto start = std::chrono::steady_clock::now();
+
+   for (std::size_t i = 0; i < iterations; ++i)
+   {
+      function(i);
+   }
+
+   const auto end = std::chrono::steady_clock::now();
+   return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+/********************************************************************************
+* measure_predict_batch: Returnerar genomsnittlig tid i nanosekunder per exempel
+*                        vid batchprediktion med ett ntverk av angiven storlek,
+*                        dr samtliga parametrar lagras som flyttal av typen T.
+*
+*                        - layer_sizes: Antalet noder i varje lager.
+*                        - num_samples: Antalet exempel per anrop.
+*                        - iterations : Antalet anrop.
+********************************************************************************/
+template <typename T>
+static double measure_predict_batch(const std::vector<std::size_t>& layer_sizes,
+                                    const std::size_t num_samples,
+                                    const std::size_t iterations)
+{
+   const basic_ann<T> network(layer_sizes);
+   random_generator generator;
+   auto context = network.make_inference_context(num_samples);
+   std::vector<T> input(num_samples * network.num_inputs());
+   std::vector<T> output(num_samples * network.num_outputs());
+
+   for (auto& i : input)
+   {
+      i = generator.uniform<T>();
+   }
+
+   const auto time = measure([&](const std::size_t)
+   {
+      network.predict_batch(input.data(), num_samples, output.data(), context);
+   }, iterations);
+   return time / num_samples;
+}
+
+/********************************************************************************
+* print_header: Skriver ut kolumnrubriker fr en jmfrelse mellan tv varianter.
+*
+*               - baseline : Namnet p referensvarianten.
+*               - candidate: Namnet p varianten som jmfrs mot referensen.
+********************************************************************************/
+static void print_header(const char* baseline,
+                         const char* candidate)
+{
+   std::cout << std::left << std::setw(24) << "benchmark" << std::right << std::setw(14) << baseline
+             << std::setw(14) << candidate << std::setw(11) << "speedup\n";
+   return;
+}
+
+/********************************************************************************
+* print_result: Skriver ut resultatet av en mtning p en rad.
+*
+*               - name        : Namnet p aktuell mtning.
+*               - baseline_ns : Tid per anrop i nanosekunder fr referensvarianten.
+*               - candidate_ns: Tid per anrop i nanosekunder fr jmfrd variant.
+********************************************************************************/
+static void print_result(const char* name,
+                         const double baseline_ns,
+                         const double candidate_ns)
+{
+   std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+             << std::setw(14) << baseline_ns << std::setw(14) << candidate_ns
+             << std::setw(10) << std::setprecision(2) << baseline_ns / candidate_ns << "x\n";
+   return;
+}
+
+/********************************************************************************
+* latency_histogram: Frdelningen av tiden per anrop vid mtning av latens,
+*                    dr anropen rknas per tvpotens av nanosekunder, allts
+*                    index i fr anrop som tog mellan 2^i och 2^(i + 1) ns.
+*                    Tiden inkluderar avlsningen av klockan, vilken r
+*                    densamma fr samtliga mtta varianter.
+********************************************************************************/
+struct latency_histogram
+{
+   std::vector<std::size_t> buckets; /* Antalet anrop per tvpotens av nanosekunder. */
+   double p50{0};                    /* Median i nanosekunder. */
+   double p90{0};                    /* 90:e percentilen i nanosekunder. */
+   double p99{0};                    /* 99:e percentilen i nanosekunder. */
+   double p999{0};                   /* 99,9:e percentilen i nanosekunder. */
+   double max{0};                    /* Lngsta tid i nanosekunder. */
+};
+
+/********************************************************************************
+* benchmark_result: Resultatet av en mtning i benchmarksviten. Antalet
+*                   flyttalsoperationer rknas som en multiplikation samt en
+*                   addition per vikt och anrop. Minnestrafiken modelleras
+*                   som antalet byte parametrar som lses och skrivs per
+*                   exempel, dr parametrarna delas av samtliga exempel i en
+*                   batch, plus in- och utsignaler.
+********************************************************************************/
+struct benchmark_result
+{
+   std::string name;           /* Mtningens namn. */
+   const char* type;           /* Flyttalstyp ("double" eller "float"). */
+   std::size_t width;          /* Antalet noder per lager. */
+   std::size_t batch_size;     /* Antalet exempel per anrop. */
+   std::size_t threads;        /* Antalet trdar. */
+   double ns_per_sample;       /* Tid per exempel i nanosekunder. */
+   double flops_per_sample;    /* Antalet flyttalsoperationer per exempel. */
+   double bytes_per_sample;    /* Modellerad minnestrafik per exempel i byte. */
+   double peak_fraction{0};    /* Andel av mikrokrnans toppvrde, 0 om ej aktuellt. */
+   latency_histogram latency{}; /* Frdelning av tid per anrop, tom om ej aktuellt. */
+
+   /********************************************************************************
+   * samples_per_second: Returnerar antalet exempel per sekund.
+   ********************************************************************************/
+   double samples_per_second(void) const
+   {
+      return this->ns_per_sample > 0.0 ? 1e9 / this->ns_per_sample : 0.0;
+   }
+
+   /********************************************************************************
+   * gflops: Returnerar antalet miljarder flyttalsoperationer per sekund.
+   ********************************************************************************/
+   double gflops(void) const
+   {
+      return this->ns_per_sample > 0.0 ? this->flops_per_sample / this->ns_per_sample : 0.0;
+   }
+};
+
+/********************************************************************************
+* suite_options: Instllningar fr benchmarksviten.
+********************************************************************************/
+struct suite_options
+{
+   std::vector<std::size_t> widths;      /* Lagerbredder som mts. */
+   std::vector<std::size_t> batch_sizes; /* Batchstorlekar som mts. */
+   std::vector<std::size_t> threads;     /* Trdantal som mts vid parallell trning. */
+   std::size_t num_samples;              /* Antalet trningsuppsttningar vid trning. */
+   double min_time_ns;                   /* Minsta mttid per mtning i nanosekunder. */
+};
+
+/********************************************************************************
+* measure_for: Anropar angiven funktion tills minst angiven tid har frflutit,
+*              dr antalet anrop frdubblas mellan varje frsk, och returnerar
+*              genomsnittlig tid per anrop i nanosekunder. Funktionen anropas
+*              frst en gng utan mtning fr att vrma upp cacheminnet.
+*
+*              - function   : Funktionen som ska mtas.
+*              - min_time_ns: Minsta mttid i nanosekunder.
+********************************************************************************/
+template <typename Function>
+static double measure_for(Function&& function,
+                          const double min_time_ns)
+{
+   function(0);
+   std::size_t iterations = 1;
+
+   while (true)
+   {
+      const auto time = measure(function, iterations);
+      if (time * iterations >= min_time_ns || iterations >= (std::size_t(1) << 30)) return time;
+      iterations *= 2;
+   }
+}
+
+/********************************************************************************
+* measure_latency: Mter tiden fr varje enskilt anrop av angivna funktioner,
+*                  vilka anropas vxelvis s att strningar frn exempelvis
+*                  andra processer drabbar samtliga funktioner lika. Varje
+*                  funktion anropas frst en gng utan mtning fr att vrma
+*                  upp cacheminnet, varefter mtningen pgr tills minst
+*                  angiven tid har frflutit och minst min_calls anrop har
+*                  gjorts per funktion. Returnerar en frdelning per funktion.
+*
+*                  - functions  : Funktionerna som ska mtas.
+*                  - min_time_ns: Minsta mttid i nanosekunder.
+*                  - mean_ns    : Referens till vektor dr genomsnittlig tid per
+*                                 anrop lagras fr varje funktion.
+********************************************************************************/
+static std::vector<latency_histogram> measure_latency(const std::vector<std::function<void(std::size_t)>>& functions,
+                                                      const double min_time_ns,
+                                                      std::vector<double>& mean_ns)
+{
+   constexpr std::size_t min_calls = 1000;
+   constexpr std::size_t max_calls = std::size_t(1) << 20;
+   std::vector<std::vector<double>> times(functions.size());
+   auto elapsed = 0.0;
+
+   for (std::size_t j = 0; j < functions.size(); ++j)
+   {
+      functions[j](0);
+      times[j].reserve(min_calls);
+   }
+
+   for (std::size_t i = 0; (elapsed < min_time_ns || i < min_calls) && i < max_calls; ++i)
+   {
+      for (std::size_t j = 0; j < functions.size(); ++j)
+      {
+         const auto start = std::chrono::steady_clock::now();
+         functions[j](i);
+         const auto end = std::chrono::steady_clock::now();
+         times[j].push_back(std::chrono::duration<double, std::nano>(end - start).count());
+         elapsed += times[j].back();
+      }
+   }
+
+   std::vector<latency_histogram> result(functions.size());
+   mean_ns.assign(functions.size(), 0.0);
+
+   for (std::size_t j = 0; j < functions.size(); ++j)
+   {
+      auto& sorted = times[j];
+      auto& histogram = result[j];
+      std::sort(sorted.begin(), sorted.end());
+      auto percentile = [&](const double fraction)
+      {
+         const auto index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size()));
+         return sorted[index < sorted.size() ? index : sorted.size() - 1];
+      };
+
+      for (const auto time : sorted)
+      {
+         std::size_t bucket = 0;
+         while (bucket < 63 && static_cast<double>(std::size_t(1) << (bucket + 1)) <= time) ++bucket;
+         if (histogram.buckets.size() <= bucket) histogram.buckets.resize(bucket + 1, 0);
+         histogram.buckets[bucket]++;
+         mean_ns[j] += time / static_cast<double>(sorted.size());
+      }
+
+      histogram.p50 = percentile(0.5);
+      histogram.p90 = percentile(0.9);
+      histogram.p99 = percentile(0.99);
+      histogram.p999 = percentile(0.999);
+      histogram.max = sorted.back();
+   }
+   return result;
+}
+
+/********************************************************************************
+* fill_random: Fyller angiven buffert med slumptal mellan 0 - 1.
+*
+*              - data     : Pekare till bufferten.
+*              - size     : Antalet flyttal i bufferten.
+*              - generator: Referens till generatorn som anvnds.
+********************************************************************************/
+template <typename T>
+static void fill_random(T* data,
+                        const std::size_t size,
+                        random_generator& generator)
+{
+   for (std::size_t i = 0; i < size; ++i)
+   {
+      data[i] = generator.uniform<T>();
+   }
+   return;
+}
+
+/********************************************************************************
+* convergence_result: Resultatet av en mtning av tiden tills trningsfrlusten
+*                     understiger angiven mlniv. Om mlnivn inte ns fr
+*                     ngon lrhastighet r tiden ondlig.
+********************************************************************************/
+struct convergence_result
+{
+   double time_ms{std::numeric_limits<double>::infinity()}; /* Kortaste tid i millisekunder. */
+   std::size_t epochs{0};                                  /* Antalet epoker vid kortaste tid. */
+   double learning_rate{0};                                /* Lrhastighet vid kortaste tid. */
+};
+
+/********************************************************************************
+* measure_convergence: Returnerar kortaste tiden tills trningsfrlusten fr ett
+*                      ntverk med lagren 16-32-32-4 understiger angiven
+*                      mlniv med angiven metod fr justering, dr samtliga
+*                      lrhastigheter i learning_rates prvas med samma
+*                      startvrden. Mlvrdena ges av ett slumpmssigt
+*                      initierat lrarntverk med lagren 16-32-4, vilket gr
+*                      att uppgiften gr att lra sig exakt. Tiden per exempel
+*                      mts av benchmarksviten, medan denna mtning ven tar
+*                      hnsyn till hur mnga epoker respektive metod krver.
+*
+*                      - optimizer  : Metoden fr justering av parametrar.
+*                      - batch_size : Antalet exempel per batch.
+*                      - target_loss: Mlnivn fr trningsfrlusten (MSE).
+*                      - max_epochs : Maximalt antal epoker per lrhastighet.
+********************************************************************************/
+template <typename T>
+static convergence_result measure_convergence(const basic_optimizer<T>& optimizer,
+                                              const std::size_t batch_size,
+                                              const T target_loss,
+                                              const std::size_t max_epochs)
+{
+   constexpr std::size_t num_samples = 256;
+   const double learning_rates[] = { 0.001, 0.003, 0.01, 0.03 };
+   random_generator generator;
+   basic_ann<T> teacher({ 16, 32, 4 });
+   basic_matrix<T> train_in(num_samples, 16, T(0)), train_out(num_samples, 4, T(0));
+   auto context = teacher.make_inference_context(1);
+   convergence_result result;
+
+   generator.seed(7);
+   teacher.seed(3);
+   teacher.randomize(weight_init::he);
+
+   for (std::size_t i = 0; i < num_samples; ++i)
+   {
+      fill_random(train_in[i], 16, generator);
+      teacher.predict(train_in[i], train_out[i], context);
+   }
+
+   for (const auto rate : learning_rates)
+   {
+      basic_ann<T> network({ 16, 32, 32, 4 });
+      basic_early_stopping<T> stopping;
+      stopping.target_loss = target_loss;
+      network.seed(1);
+      network.randomize(weight_init::he);
+      network.set_optimizer(optimizer);
+      network.set_training_data(basic_matrix_view<T>(train_in), basic_matrix_view<T>(train_out));
+
+      const auto start = std::chrono::steady_clock::now();
+      const auto stats = network.train(max_epochs, static_cast<T>(rate), batch_size, stopping);
+      const auto time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+      if (stats.stopped_early && time < result.time_ms)
+      {
+         result = { time, stats.epochs, rate };
+      }
+   }
+   return result;
+}
+
+/********************************************************************************
+* print_convergence: Skriver ut tiden tills mlnivn ns fr SGD respektive
+*                    Adam p en rad, fljt av antalet epoker samt vald
+*                    lrhastighet fr respektive metod.
+*
+*                    - name: Namnet p aktuell mtning.
+*                    - sgd : Referens till resultatet fr SGD.
+*                    - adam: Referens till resultatet fr Adam.
+********************************************************************************/
+static void print_convergence(const char* name,
+                              const convergence_result& sgd,
+                              const convergence_result& adam)
+{
+   print_result(name, sgd.time_ms, adam.time_ms);
+   std::cout << std::setw(24) << "" << std::defaultfloat << "  epochs (rate): sgd " << sgd.epochs
+             << " (" << sgd.learning_rate << "), adam " << adam.epochs << " (" << adam.learning_rate << ")\n";
+   return;
+}
+
+/********************************************************************************
+* tanh_error_ulp: Returnerar strsta relativa felet fr aktiva krnors tanh
+*                 jmfrt med std::tanh, uttryckt i antalet avrundningsfel
+*                 (ulp) fr flyttalstypen T. Argumenten strcker sig
+*                 geometriskt frn 1e-30 till 20 med bda tecknen, vilket gr
+*                 att ven sm argument nra 0 kontrolleras. Kontrollen grs
+*                 inte fr NEON, vars krna saknar Taylorserien fr sm
+*                 argument, se simd.hpp.
+********************************************************************************/
+template <typename T>
+static double tanh_error_ulp(void)
+{
+   std::vector<T> input;
+
+   for (auto x = 1e-30; x < 20.0; x *= 1.01)
+   {
+      input.push_back(static_cast<T>(x));
+      input.push_back(static_cast<T>(-x));
+   }
+
+   auto output = input;
+   basic_simd_kernels<T>::get().tanh(output.data(), output.size());
+   auto result = 0.0;
+
+   for (std::size_t i = 0; i < input.size(); ++i)
+   {
+      const auto reference = std::tanh(static_cast<double>(input[i]));
+      const auto error = std::fabs((static_cast<double>(output[i]) - reference) / reference);
+      if (error > result) result = error;
+   }
+   return result / std::numeric_limits<T>::epsilon();
+}
+
+/********************************************************************************
+* optimizer_error_ulp: Returnerar strsta relativa felet fr de vektoriserade
+*                      krnorna momentum, rmsprop och adam jmfrt med
+*                      referensversionen, uttryckt i antalet avrundningsfel
+*                      (ulp) fr flyttalstypen T relativt det strsta beloppet
+*                      i respektive vektor, d tillstnd nra 0 annars ger
+*                      stora relativa fel vid kancellation. Samtliga
+*                      instruktionsuppsttningar som stds kontrolleras med
+*                      samma slumpmssiga gradienter, tillstnd och
+*                      parametrar under tre p varandra fljande justeringar,
+*                      dr antalet element varierar s att ven resterna
+*                      efter de fulla vektorerna kontrolleras. Bde
+*                      tillstnden och parametrarna jmfrs.
+********************************************************************************/
+template <typename T>
+static double optimizer_error_ulp(void)
+{
+   using kernels_type = basic_simd_kernels<T>;
+   using isa = simd_support::isa;
+   const auto reference = kernels_type::get(isa::scalar);
+   const T rate = T(0.01), momentum = T(0.9), beta1 = T(0.9), beta2 = T(0.999), epsilon = T(1e-8), scale = T(0.5);
+   random_generator generator;
+   auto result = 0.0;
+
+   auto compare = [&](const std::vector<T>& actual, const std::vector<T>& expected)
+   {
+      auto difference = 0.0, magnitude = static_cast<double>(std::numeric_limits<T>::min());
+
+      for (std::size_t i = 0; i < actual.size(); ++i)
+      {
+         difference = std::max(difference, std::fabs(static_cast<double>(actual[i]) - expected[i]));
+         magnitude = std::max(magnitude, std::fabs(static_cast<double>(expected[i])));
+      }
+      result = std::max(result, difference / magnitude);
+   };
+
+   for (const auto type : { isa::neon, isa::avx2, isa::avx512 })
+   {
+      if (!simd_support::supported(type)) continue;
+      const auto kernels = kernels_type::get(type);
+
+      for (std::size_t size = 1; size <= 67; size += 3)
+      {
+         std::vector<T> gradient(size), state1(size), state2(size), parameters(size);
+         generator.seed(size);
+
+         for (std::size_t i = 0; i < size; ++i)
+         {
+            state1[i] = generator.uniform<T>(T(-1), T(1));
+            state2[i] = generator.uniform<T>();
+            parameters[i] = generator.uniform<T>(T(-1), T(1));
+         }
+
+         for (std::size_t method = 0; method < 4; ++method)
+         {
+            auto expected1 = state1, expected2 = state2, expected = parameters;
+            auto actual1 = state1, actual2 = state2, actual = parameters;
+
+            for (std::size_t step = 0; step < 3; ++step)
+            {
+               for (auto& i : gradient)
+               {
+                  i = generator.uniform<T>(T(-1), T(1));
+               }
+
+               if (method < 2)
+               {
+                  reference.momentum(rate, momentum, scale, gradient.data(), expected1.data(), expected.data(),
+                                     size, method == 1);
+                  kernels.momentum(rate, momentum, scale, gradient.data(), actual1.data(), actual.data(),
+                                   size, method == 1);
+               }
+               else if (method == 2)
+               {
+                  reference.rmsprop(rate, beta2, epsilon, scale, gradient.data(), expected2.data(),
+                                    expected.data(), size);
+                  kernels.rmsprop(rate, beta2, epsilon, scale, gradient.data(), actual2.data(), actual.data(), size);
+               }
+               else
+               {
+                  reference.adam(rate, beta1, beta2, epsilon, scale, gradient.data(), expected1.data(),
+                                 expected2.data(), expected.data(), size);
+                  kernels.adam(rate, beta1, beta2, epsilon, scale, gradient.data(), actual1.data(),
+                               actual2.data(), actual.data(), size);
+               }
+            }
+
+            compare(actual1, expected1);
+            compare(actual2, expected2);
+            compare(actual, expected);
+         }
+      }
+   }
+   return result / std::numeric_limits<T>::epsilon();
+}
+
+/********************************************************************************
+* parameter_deviation: Returnerar strsta skillnaden mellan tv ntverks bias
+*                      och vikter, relativt det strsta beloppet bland det
+*                      frsta ntverkets parametrar. Ntverken mste ha samma
+*                      topologi.
+*
+*                      - first : Referens till det frsta ntverket.
+*                      - second: Referens till det andra ntverket.
+********************************************************************************/
+template <typename T>
+static double parameter_deviation(const basic_ann<T>& first,
+                                  const basic_ann<T>& second)
+{
+   auto max_difference = 0.0, max_value = 0.0;
+
+   auto compare = [&](const T a, const T b)
+   {
+      max_difference = std::max(max_difference, std::fabs(static_cast<double>(a) - b));
+      max_value = std::max(max_value, std::fabs(static_cast<double>(a)));
+   };
+
+   for (std::size_t i = 0; i < first.num_layers(); ++i)
+   {
+      const auto& a = first.layer(i);
+      const auto& b = second.layer(i);
+
+      for (std::size_t j = 0; j < a.num_nodes(); ++j)
+      {
+         compare(a.bias[j], b.bias[j]);
+
+         for (std::size_t k = 0; k < a.num_weights(); ++k)
+         {
+            compare(a.weights[j][k], b.weights[j][k]);
+         }
+      }
+   }
+   return max_value > 0.0 ? max_difference / max_value : max_difference;
+}
+
+/********************************************************************************
+* check_network: Ntverk med lagren 8-16-16-3 samt trningsdata fr
+*                kontrollerna nedan, dr startvrdena och datan r desamma vid
+*                varje anrop. Lagren r s sm att baktpropageringen i
+*                batchar inte sker via blockad matrismultiplikation, vilket
+*                gr att transponerade kopior av vikterna anvnds.
+********************************************************************************/
+struct check_network
+{
+   basic_matrix<double> train_in{64, 8, 0.0};  /* Insignaler, en rad per exempel. */
+   basic_matrix<double> train_out{64, 3, 0.0}; /* Referensvrden, en rad per exempel. */
+   ann network{std::vector<std::size_t>{ 8, 16, 16, 3 }};
+
+   /********************************************************************************
+   * check_network: Initierar ntverket och trningsdatan.
+   *
+   *                - transposed: Indikerar ifall transponerade kopior av
+   *                              vikterna ska anvndas.
+   ********************************************************************************/
+   explicit check_network(const bool transposed)
+   {
+      random_generator generator;
+      generator.seed(5);
+
+      for (std::size_t i = 0; i < this->train_in.rows(); ++i)
+      {
+         fill_random(this->train_in[i], this->train_in.columns(), generator);
+         fill_random(this->train_out[i], this->train_out.columns(), generator);
+      }
+
+      this->network.seed(1);
+      this->network.randomize(weight_init::he);
+      this->network.set_transposed_weights(transposed);
+      this->network.set_training_data(basic_matrix_view<double>(this->train_in),
+                                      basic_matrix_view<double>(this->train_out));
+      return;
+   }
+};
+
+/********************************************************************************
+* transposed_deviation: Returnerar skillnaden mellan parametrarna efter
+*                       trning med respektive utan transponerade kopior av
+*                       vikterna, se parameter_deviation. Kopiorna ndrar
+*                       enbart summeringsordningen vid baktpropagering, varfr
+*                       skillnaden ska vara av samma storleksordning som
+*                       avrundningsfelet. En kopia som inte markeras som
+*                       inaktuell efter att vikterna har justerats ger i
+*                       stllet felaktiga gradienter och en stor skillnad.
+*
+*                       - train: Funktion som trnar angivet ntverk.
+********************************************************************************/
+template <typename Train>
+static double transposed_deviation(Train&& train)
+{
+   check_network reference(false), candidate(true);
+   train(reference.network);
+   train(candidate.network);
+   return parameter_deviation(reference.network, candidate.network);
+}
+
+/********************************************************************************
+* hogwild_deviation: Returnerar skillnaden mellan parametrarna efter trning
+*                    via train_hogwild med en trd respektive via train_batch
+*                    med SGD, se parameter_deviation. Med en trd sker inga
+*                    samtidiga justeringar, varfr resultaten ska vara
+*                    identiska.
+********************************************************************************/
+static double hogwild_deviation(void)
+{
+   check_network reference(false), candidate(false);
+   reference.network.train_batch(20, 0.05, 8);
+   candidate.network.train_hogwild(20, 0.05, 8, 1);
+   return parameter_deviation(reference.network, candidate.network);
+}
+
+/********************************************************************************
+* hogwild_loss_ratio: Returnerar kvoten mellan trningsfrlusten efter den
+*                     sista respektive den frsta epoken vid trning via
+*                     train_hogwild med angivet antal trdar. Resultatet r
+*                     inte reproducerbart med fler n en trd, men frlusten
+*                     ska nd minska, vilket ger en kvot under 1.
+*
+*                     - num_threads: Antalet trdar.
+********************************************************************************/
+static double hogwild_loss_ratio(const std::size_t num_threads)
+{
+   check_network candidate(false);
+   const auto stats = candidate.network.train_hogwild(50, 0.05, 1, num_threads);
+   return stats.train_loss.back() / stats.train_loss.front();
+}
+
+/********************************************************************************
+* snapshot_errors: Returnerar antalet fel som observeras nr angivet antal
+*                  lsande trdar hmtar och predikterar via publicerade
+*                  versioner, medan den anropande trden trnar ntverket och
+*                  publicerar nya versioner via basic_snapshot_publisher.
+*                  Utsignalen fr varje version berknas innan versionen
+*                  publiceras och jmfrs med lsarnas prediktioner, dr
+*                  varje lsare predikterar upprepade gnger via varje hmtad
+*                  version. Drmed avsljas en version som har frigjorts och
+*                  skrivits ver medan en lsare anvnde den. Versionsnummer
+*                  som minskar fr en lsare samt versioner som inte har
+*                  frigjorts nr samtliga lsare har frstrts rknas ocks
+*                  som fel.
+*                  Kontrollen blir n striktare vid kompilering med
+*                  AddressSanitizer, som upptcker varje lsning av frigjort
+*                  minne.
+*
+*                  - num_readers : Antalet lsande trdar.
+*                  - num_versions: Antalet versioner som publiceras.
+********************************************************************************/
+static double snapshot_errors(const std::size_t num_readers,
+                              const std::size_t num_versions)
+{
+   check_network source(false);
+   auto& network = source.network;
+   snapshot_publisher publisher;
+   const std::vector<double> input(source.train_in[0], source.train_in[0] + source.train_in.columns());
+   std::vector<double> expected(num_versions + 1, 0.0);
+   std::vector<ann::inference_context> contexts;
+   std::vector<std::thread> readers;
+   std::atomic<bool> done{false};
+   std::atomic<std::size_t> errors{0};
+   auto publisher_context = network.make_inference_context(1);
+
+   for (std::size_t i = 0; i < num_readers; ++i)
+   {
+      contexts.push_back(network.make_inference_context(1));
+   }
+
+   for (std::size_t i = 0; i < num_readers; ++i)
+   {
+      readers.emplace_back([&, i]
+      {
+         auto reader = publisher.make_reader();
+         std::uint64_t last = 0;
+         if (!reader.is_valid()) ++errors;
+
+         while (!done.load(std::memory_order_acquire))
+         {
+            const auto snapshot = reader.acquire();
+            if (snapshot == nullptr) continue;
+            if (snapshot->version < last) ++errors;
+            last = snapshot->version;
+
+            for (std::size_t j = 0; j < 64; ++j)
+            {
+               if (snapshot->network.predict(input, contexts[i])[0] != expected[last]) ++errors;
+            }
+         }
+      });
+   }
+
+   for (std::size_t i = 1; i <= num_versions; ++i)
+   {
+      network.train(1, 0.05, 8);
+      auto model = network.copy_model();
+      expected[i] = model.predict(input, publisher_context)[0];
+      publisher.publish_model(std::move(model));
+   }
+
+   done.store(true, std::memory_order_release);
+
+   for (auto& i : readers)
+   {
+      i.join();
+   }
+   return static_cast<double>(errors + publisher.reclaim());
+}
+
+/********************************************************************************
+* distributed_deviation: Returnerar skillnaden mellan parametrarna i tv
+*                        processer efter trning via train_distributed, se
+*                        parameter_deviation. Processerna simuleras av tv
+*                        trdar, vilka kommunicerar via tcp_communicator ver
+*                        127.0.0.1 med var sitt ntverk med olika startvrden
+*                        samt olika mnga exempel, s att processen med frre
+*                        batchar bidrar med tomma batchar i slutet av varje
+*                        epok. Samtliga processer ska ha identiska parametrar
+*                        efter trningen. Om anslutningen misslyckas eller
+*                        bryts, eller om frlusten inte minskar under
+*                        trningen, returneras i stllet ondligheten.
+*
+*                        - num_samples: Antalet exempel fr den frsta
+*                                       processen, dr vriga exempel
+*                                       tilldelas den andra processen.
+********************************************************************************/
+static double distributed_deviation(const std::size_t num_samples)
+{
+   check_network first(false), second(false);
+   check_network* ranks[] = { &first, &second };
+   const auto port = 20000 + std::chrono::steady_clock::now().time_since_epoch().count() % 20000;
+   const std::vector<std::string> addresses{ "127.0.0.1:" + std::to_string(port),
+                                             "127.0.0.1:" + std::to_string(port + 1) };
+   bool passed[] = { false, false };
+   std::vector<std::thread> threads;
+
+   second.network.seed(2);
+   second.network.randomize(weight_init::he);
+
+   for (std::size_t i = 0; i < 2; ++i)
+   {
+      auto& rank = *ranks[i];
+      const auto begin = i == 0 ? 0 : num_samples;
+      const auto rows = i == 0 ? num_samples : rank.train_in.rows() - num_samples;
+      rank.network.set_training_data(
+         basic_matrix_view<double>(rank.train_in[begin], rows, rank.train_in.columns(), rank.train_in.stride()),
+         basic_matrix_view<double>(rank.train_out[begin], rows, rank.train_out.columns(), rank.train_out.stride()));
+
+      threads.emplace_back([&, i]
+      {
+         tcp_communicator communicator;
+         if (!communicator.connect(i, addresses, 10000)) return;
+         const auto stats = ranks[i]->network.train_distributed(20, 0.05, 8, communicator);
+         passed[i] = communicator.is_connected() && stats.train_loss.back() < stats.train_loss.front();
+      });
+   }
+
+   for (auto& i : threads)
+   {
+      i.join();
+   }
+
+   if (!passed[0] || !passed[1]) return std::numeric_limits<double>::infinity();
+   return parameter_deviation(first.network, second.network);
+}
+
+/********************************************************************************
+* check: Returnerar true om angiven avvikelse understiger angiven grns,
+*        annars skrivs ett felmeddelande ut och false returneras.
+*
+*        - name     : Namnet p aktuell kontroll.
+*        - deviation: Uppmtt avvikelse.
+*        - limit    : Strsta tilltna avvikelse.
+********************************************************************************/
+static bool check(const char* name,
+                  const double deviation,
+                  const double limit)
+{
+   if (deviation <= limit) return true;
+   std::cerr << "check failed: " << name << " deviates by " << deviation << " (limit " << limit << ")\n";
+   return false;
+}
+
+/********************************************************************************
+* run_layer_benchmarks: Mter ett dense-lagers krnor med angiven bredd, dr
+*                       lagret har lika mnga noder som vikter per nod. Vid
+*                       batchstorleken 1 mts medlemsfunktionerna per exempel,
+*                       annars batchversionerna. Vid batchstorleken 1 mts ven
+*                       framtpropagering med vriga aktiveringsfunktioner n
+*                       ReLU, s att kostnaden fr aktiveringen kan jmfras.
+*
+*                       - width     : Antalet noder samt vikter per nod.
+*                       - batch_size: Antalet exempel per anrop.
+*                       - options   : Referens till instllningar fr sviten.
+*                       - results   : Referens till vektor dr resultaten lagras.
+********************************************************************************/
+template <typename T>
+static void run_layer_benchmarks(const std::size_t width,
+                                 const std::size_t batch_size,
+                                 const suite_options& options,
+                                 std::vector<benchmark_result>& results)
+{
+   using layer_type = basic_dense_layer<T>;
+   random_generator generator;
+   layer_type layer, next;
+   layer.resize(width, width, generator, weight_init::he);
+   next.resize(width, width, generator, weight_init::he);
+   const auto type = sizeof(T) == sizeof(float) ? "float" : "double";
+   const auto value = static_cast<double>(sizeof(T));
+   const auto params = static_cast<double>(width * width);
+   const auto batch = static_cast<double>(batch_size);
+   const auto rate = T(1e-6);
+
+   auto add = [&](const char* name, const double time, const double flops, const double bytes)
+   {
+      results.push_back({ name, type, width, batch_size, 1, time, flops, bytes });
+   };
+
+   if (batch_size == 1)
+   {
+      std::vector<T> input(width), reference(width);
+      fill_random(input.data(), width, generator);
+      fill_random(reference.data(), width, generator);
+      fill_random(next.error.data(), width, generator);
+      layer.feedforward(input);
+
+      add("layer.feedforward", measure_for([&](const std::size_t) { layer.feedforward(input); }, options.min_time_ns),
+          2.0 * params, (params + 2.0 * width) * value);
+      add("layer.backpropagate.output",
+          measure_for([&](const std::size_t) { layer.backpropagate(reference); }, options.min_time_ns),
+          3.0 * width, 3.0 * width * value);
+      add("layer.backpropagate.hidden",
+          measure_for([&](const std::size_t) { layer.backpropagate(next); }, options.min_time_ns),
+          2.0 * params, (params + 3.0 * width) * value);
+      add("layer.optimize", measure_for([&](const std::size_t) { layer.optimize(input, rate); }, options.min_time_ns),
+          2.0 * params, (2.0 * params + 2.0 * width) * value);
+      add("layer.backpropagate_optimize",
+          measure_for([&](const std::size_t) { next.backpropagate_optimize(layer, rate); }, options.min_time_ns),
+          4.0 * params, (2.0 * params + 3.0 * width) * value);
+
+      for (const auto function : { activation_function::leaky_relu, activation_function::sigmoid,
+                                   activation_function::tanh, activation_function::linear,
+                                   activation_function::softmax })
+      {
+         const auto name = std::string("layer.feedforward.") + basic_activation<T>::name(function);
+         layer.activation = function;
+         add(name.c_str(), measure_for([&](const std::size_t) { layer.feedforward(input); }, options.min_time_ns),
+             2.0 * params, (params + 2.0 * width) * value);
+      }
+
+      layer.activation = activation_function::relu;
+      return;
+   }
+
+   basic_matrix<T> input(batch_size, width, T(0)), reference(batch_size, width, T(0));
+   layer.resize_batch(batch_size);
+   next.resize_batch(batch_size);
+
+   for (std::size_t i = 0; i < batch_size; ++i)
+   {
+      fill_random(input[i], width, generator);
+      fill_random(reference[i], width, generator);
+      fill_random(next.batch_error[i], width, generator);
+   }
+   layer.feedforward(input, batch_size);
+
+   add("layer.feedforward",
+       measure_for([&](const std::size_t) { layer.feedforward(input, batch_size); }, options.min_time_ns) / batch,
+       2.0 * params, (params / batch + 2.0 * width) * value);
+   add("layer.backpropagate.output",
+       measure_for([&](const std::size_t) { layer.backpropagate(reference, batch_size); }, options.min_time_ns) / batch,
+       3.0 * width, 3.0 * width * value);
+   add("layer.backpropagate.hidden",
+       measure_for([&](const std::size_t) { layer.backpropagate(next, batch_size); }, options.min_time_ns) / batch,
+       2.0 * params, (params / batch + 3.0 * width) * value);
+   add("layer.optimize",
+       measure_for([&](const std::size_t) { layer.optimize(input, batch_size, rate); }, options.min_time_ns) / batch,
+       2.0 * params, (2.0 * params / batch + 2.0 * width) * value);
+   return;
+}
+
+/********************************************************************************
+* run_gemm_peak: Mter mikrokrnan gemm i strukten simd_kernels med packade
+*                block som ryms i L1-cacheminnet, vilket utgr toppvrdet fr
+*                den blockade matrismultiplikationen. Varje rad i det packade
+*                blocket ur A rknas som ett exempel. Returnerar uppmtt antal
+*                GFLOP/s.
+*
+*                - options: Referens till instllningar fr sviten.
+*                - results: Referens till vektor dr resultatet lagras.
+********************************************************************************/
+template <typename T>
+static double run_gemm_peak(const suite_options& options,
+                            std::vector<benchmark_result>& results)
+{
+   const auto& kernels = basic_simd_kernels<T>::get();
+   const auto depth = basic_gemm<T>::depth_block;
+   const auto rows = kernels.gemm_rows;
+   const auto columns = kernels.gemm_columns;
+   const auto type = sizeof(T) == sizeof(float) ? "float" : "double";
+   random_generator generator;
+   std::vector<T, aligned_allocator<T>> a(rows * depth), b(columns * depth), c(rows * columns, T(0));
+   fill_random(a.data(), a.size(), generator);
+   fill_random(b.data(), b.size(), generator);
+
+   const auto time = measure_for([&](const std::size_t)
+   {
+      kernels.gemm(depth, a.data(), b.data(), c.data(), columns);
+   }, options.min_time_ns);
+
+   results.push_back({ "gemm.kernel", type, columns, rows, 1, time / static_cast<double>(rows),
+                       2.0 * static_cast<double>(columns * depth),
+                       static_cast<double>(depth + columns * depth / rows) * static_cast<double>(sizeof(T)), 1.0 });
+   return results.back().gflops();
+}
+
+/********************************************************************************
+* run_gemm_benchmarks: Mter den blockade matrismultiplikationen fr en batch
+*                      med angiven storlek och ett lager med angiven bredd,
+*                      bde som framtpropagering (input * weights^T) och som
+*                      baktpropagering (error * weights), oavsett ifall
+*                      dense-lagren skulle anvnda den fr aktuell storlek.
+*
+*                      - width     : Antalet noder samt vikter per nod.
+*                      - batch_size: Antalet exempel per anrop.
+*                      - peak      : Mikrokrnans toppvrde i GFLOP/s.
+*                      - options   : Referens till instllningar fr sviten.
+*                      - results   : Referens till vektor dr resultaten lagras.
+********************************************************************************/
+template <typename T>
+static void run_gemm_benchmarks(const std::size_t width,
+                                const std::size_t batch_size,
+                                const double peak,
+                                const suite_options& options,
+                                std::vector<benchmark_result>& results)
+{
+   using gemm_type = basic_gemm<T>;
+   random_generator generator;
+   basic_matrix<T> input(batch_size, width, T(0)), weights(width, width, T(0)), output(batch_size, width, T(0));
+   const auto type = sizeof(T) == sizeof(float) ? "float" : "double";
+   const auto value = static_cast<double>(sizeof(T));
+   const auto params = static_cast<double>(width * width);
+   const auto batch = static_cast<double>(batch_size);
+
+   for (std::size_t i = 0; i < batch_size; ++i)
+   {
+      fill_random(input[i], width, generator);
+   }
+
+   for (std::size_t i = 0; i < width; ++i)
+   {
+      fill_random(weights[i], width, generator);
+   }
+
+   auto add = [&](const char* name, const double time)
+   {
+      results.push_back({ name, type, width, batch_size, 1, time / batch, 2.0 * params,
+                          (params / batch + 2.0 * width) * value });
+      results.back().peak_fraction = peak > 0.0 ? results.back().gflops() / peak : 0.0;
+   };
+
+   add("gemm.multiply_transposed", measure_for([&](const std::size_t)
+   {
+      gemm_type::multiply_transposed(input.data(), input.stride(), weights.data(), weights.stride(),
+                                     output.data(), output.stride(), batch_size, width, width);
+   }, options.min_time_ns));
+   add("gemm.multiply", measure_for([&](const std::size_t)
+   {
+      gemm_type::multiply(input.data(), input.stride(), weights.data(), weights.stride(),
+                          output.data(), output.stride(), batch_size, width, width);
+   }, options.min_time_ns));
+   return;
+}
+
+/********************************************************************************
+* run_network_benchmarks: Mter trning under en epok samt prediktion med ett
+*                         ntverk bestende av tv lager med angiven bredd.
+*                         Vid batchstorleken 1 mts trning och prediktion
+*                         per exempel, annars trning i batchar med samtliga
+*                         trdantal samt batchprediktion. Vid batchstorleken 1
+*                         mts ven latensen per prediktion fr klassen ann
+*                         respektive ett kompilerat ntverk.
+*
+*                         - width     : Antalet noder i varje lager.
+*                         - batch_size: Antalet exempel per batch.
+*                         - options   : Referens till instllningar fr sviten.
+*                         - results   : Referens till vektor dr resultaten lagras.
+********************************************************************************/
+template <typename T>
+static void run_network_benchmarks(const std::size_t width,
+                                   const std::size_t batch_size,
+                                   const suite_options& options,
+                                   std::vector<benchmark_result>& results)
+{
+   random_generator generator;
+   basic_ann<T> network({ width, width, width });
+   network.randomize(weight_init::he);
+   const auto type = sizeof(T) == sizeof(float) ? "float" : "double";
+   const auto value = static_cast<double>(sizeof(T));
+   const auto params = 2.0 * width * width;
+   const auto batch = static_cast<double>(batch_size);
+   const auto samples = static_cast<double>(options.num_samples);
+   const auto rate = T(0.01) / static_cast<T>(width);
+
+   basic_matrix<T> train_in(options.num_samples, width, T(0)), train_out(options.num_samples, width, T(0));
+
+   for (std::size_t i = 0; i < options.num_samples; ++i)
+   {
+      fill_random(train_in[i], width, generator);
+      fill_random(train_out[i], width, generator);
+   }
+   network.set_training_data(basic_matrix_view<T>(train_in), basic_matrix_view<T>(train_out));
+
+   auto add = [&](const char* name, const std::size_t threads, const double time,
+                  const double flops, const double bytes)
+   {
+      results.push_back({ name, type, width, batch_size, threads, time, flops, bytes });
+   };
+
+   const auto train_flops = 6.0 * params;
+   const auto train_bytes = (4.0 * params / batch + 6.0 * width) * value;
+   const auto predict_bytes = (params / batch + 3.0 * width) * value;
+   const auto adam_bytes = train_bytes + 4.0 * params / batch * value;
+   const auto transposed_bytes = train_bytes + params / batch * value;
+
+   for (const auto threads : options.threads)
+   {
+      add("ann.train_hogwild", threads, measure_for([&](const std::size_t)
+      {
+         network.train_hogwild(1, rate, batch_size, threads);
+      }, options.min_time_ns) / samples, train_flops, train_bytes);
+   }
+
+   if (batch_size == 1)
+   {
+      add("ann.train", 1, measure_for([&](const std::size_t) { network.train(1, rate); }, options.min_time_ns) / samples,
+          train_flops, train_bytes);
+
+      network.set_optimizer(basic_optimizer<T>::adam());
+      add("ann.train.adam", 1, measure_for([&](const std::size_t) { network.train(1, rate); }, options.min_time_ns) / samples,
+          train_flops, adam_bytes);
+      network.set_optimizer(basic_optimizer<T>::sgd());
+
+      auto context = network.make_inference_context(1);
+      std::vector<T> output(width);
+      add("ann.predict", 1, measure_for([&](const std::size_t i)
+      {
+         network.predict(train_in[i % options.num_samples], output.data(), context);
+      }, options.min_time_ns), 2.0 * params, predict_bytes);
+
+      basic_compiled_ann<T> compiled(network);
+      add("compiled.predict", 1, measure_for([&](const std::size_t i)
+      {
+         compiled.predict(train_in[i % options.num_samples], output.data());
+      }, options.min_time_ns), 2.0 * params, predict_bytes);
+
+      basic_inference_ann<T> inference(network);
+      auto inference_context = inference.make_inference_context(1);
+      add("inference.predict", 1, measure_for([&](const std::size_t i)
+      {
+         inference.predict(train_in[i % options.num_samples], output.data(), inference_context);
+      }, options.min_time_ns), 2.0 * params, predict_bytes);
+
+      std::vector<double> mean_ns;
+      const auto latencies = measure_latency({
+         [&](const std::size_t i) { network.predict(train_in[i % options.num_samples], output.data(), context); },
+         [&](const std::size_t i) { compiled.predict(train_in[i % options.num_samples], output.data()); } },
+         options.min_time_ns, mean_ns);
+      add("latency.ann.predict", 1, mean_ns[0], 2.0 * params, predict_bytes);
+      results.back().latency = latencies[0];
+      add("latency.compiled.predict", 1, mean_ns[1], 2.0 * params, predict_bytes);
+      results.back().latency = latencies[1];
+
+      basic_quantized_ann<T> quantized(network);
+      add("quantized.predict", 1, measure_for([&](const std::size_t i)
+      {
+         quantized.predict(train_in[i % options.num_samples], width);
+      }, options.min_time_ns), 2.0 * params, params + 3.0 * width * value);
+
+      auto pruned = network;
+      pruned.prune(T(0.9));
+      basic_sparse_ann<T> sparse(pruned);
+      add("sparse.predict", 1, measure_for([&](const std::size_t i)
+      {
+         sparse.predict(train_in[i % options.num_samples], width);
+      }, options.min_time_ns), 2.0 * params * sparse.density(), sparse.size_bytes() + 3.0 * width * value);
+      return;
+   }
+
+   for (const auto threads : options.threads)
+   {
+      const auto time = threads == 1 ?
+         measure_for([&](const std::size_t) { network.train(1, rate, batch_size); }, options.min_time_ns) :
+         measure_for([&](const std::size_t) { network.train_parallel(1, rate, batch_size, threads); }, options.min_time_ns);
+      add(threads == 1 ? "ann.train" : "ann.train_parallel", threads, time / samples, train_flops, train_bytes);
+   }
+
+   network.set_optimizer(basic_optimizer<T>::adam());
+   add("ann.train.adam", 1, measure_for([&](const std::size_t) { network.train(1, rate, batch_size); },
+                                        options.min_time_ns) / samples, train_flops, adam_bytes);
+   network.set_optimizer(basic_optimizer<T>::sgd());
+
+   network.set_prefetch(2);
+   add("ann.train.prefetch", 1, measure_for([&](const std::size_t) { network.train(1, rate, batch_size); },
+                                            options.min_time_ns) / samples, train_flops, train_bytes);
+   network.set_prefetch(0);
+
+   network.set_transposed_weights(true);
+   add("ann.train.transposed", 1, measure_for([&](const std::size_t) { network.train(1, rate, batch_size); },
+                                              options.min_time_ns) / samples, train_flops, transposed_bytes);
+   network.set_transposed_weights(false);
+
+   const auto num_batch = batch_size < options.num_samples ? batch_size : options.num_samples;
+   auto context = network.make_inference_context(num_batch);
+   std::vector<T> input(num_batch * width);
+   fill_random(input.data(), input.size(), generator);
+   std::vector<T> outputs(num_batch * width);
+
+   add("ann.predict_batch", 1, measure_for([&](const std::size_t)
+   {
+      network.predict_batch(input.data(), num_batch, outputs.data(), context);
+   }, options.min_time_ns) / static_cast<double>(num_batch), 2.0 * params, predict_bytes);
+
+   basic_inference_ann<T> inference(network);
+   auto inference_context = inference.make_inference_context(num_batch);
+   add("inference.predict_batch", 1, measure_for([&](const std::size_t)
+   {
+      inference.predict_batch(input.data(), num_batch, outputs.data(), inference_context);
+   }, options.min_time_ns) / static_cast<double>(num_batch), 2.0 * params, predict_bytes);
+   return;
+}
+
+/********************************************************************************
+* run_suite: Kr benchmarksviten fr flyttal av typen T med samtliga
+*            kombinationer av lagerbredd och batchstorlek. Mikrokrnan fr
+*            matrismultiplikation mts frst, s att den blockade
+*            matrismultiplikationen kan redovisas som andel av toppvrdet.
+*
+*            - options: Referens till instllningar fr sviten.
+*            - results: Referens till vektor dr resultaten lagras.
+********************************************************************************/
+template <typename T>
+static void run_suite(const suite_options& options,
+                      std::vector<benchmark_result>& results)
+{
+   const auto peak = run_gemm_peak<T>(options, results);
+
+   for (const auto width : options.widths)
+   {
+      for (const auto batch_size : options.batch_sizes)
+      {
+         run_layer_benchmarks<T>(width, batch_size, options, results);
+         if (batch_size > 1) run_gemm_benchmarks<T>(width, batch_size, peak, options, results);
+         run_network_benchmarks<T>(width, batch_size, options, results);
+      }
+   }
+   return;
+}
+
+/********************************************************************************
+* make_suite_options: Returnerar instllningar fr benchmarksviten, dr
+*                     trdantalen utgrs av 1 samt jmna tvpotenser upp till
+*                     antalet tillgngliga hrdvarutrdar.
+*
+*                     - quick: Indikerar ifall ett mindre svep ska anvndas.
+********************************************************************************/
+static suite_options make_suite_options(const bool quick)
+{
+   suite_options options;
+   options.widths = quick ? std::vector<std::size_t>{ 16, 64 } : std::vector<std::size_t>{ 16, 64, 256, 1024 };
+   options.batch_sizes = { 1, 16, 64 };
+   options.num_samples = quick ? 64 : 256;
+   options.min_time_ns = quick ? 5e6 : 5e7;
+   const auto hardware = std::thread::hardware_concurrency();
+
+   for (std::size_t i = 1; i <= (hardware > 0 ? hardware : 1); i *= 2)
+   {
+      options.threads.push_back(i);
+   }
+
+   if (hardware > 1 && options.threads.back() != hardware)
+   {
+      options.threads.push_back(hardware);
+   }
+   return options;
+}
+
+/********************************************************************************
+* print_table: Skriver ut benchmarksvitens resultat som en tabell.
+*
+*              - results: Referens till resultaten.
+********************************************************************************/
+static void print_table(const std::vector<benchmark_result>& results)
+{
+   std::cout << std::left << std::setw(32) << "benchmark" << std::setw(8) << "type" << std::right
+             << std::setw(7) << "width" << std::setw(7) << "batch" << std::setw(9) << "threads"
+             << std::setw(14) << "ns/sample" << std::setw(14) << "samples/s"
+             << std::setw(10) << "GFLOP/s" << std::setw(14) << "bytes/sample" << std::setw(8) << "peak\n";
+
+   for (const auto& i : results)
+   {
+      std::cout << std::left << std::setw(32) << i.name << std::setw(8) << i.type << std::right
+                << std::setw(7) << i.width << std::setw(7) << i.batch_size << std::setw(9) << i.threads
+                << std::fixed << std::setprecision(1) << std::setw(14) << i.ns_per_sample
+                << std::setprecision(0) << std::setw(14) << i.samples_per_second()
+                << std::setprecision(2) << std::setw(10) << i.gflops()
+                << std::setprecision(0) << std::setw(13) << i.bytes_per_sample;
+
+      if (i.peak_fraction > 0.0) std::cout << std::setw(7) << i.peak_fraction * 100.0 << "%\n";
+      else std::cout << std::setw(8) << "-\n";
+   }
+   return;
+}
+
+/********************************************************************************
+* print_latency: Skriver ut percentiler samt histogram fr samtliga mtningar
+*                av latens i benchmarksvitens resultat, dr histogrammet
+*                anger antalet anrop per tvpotens av nanosekunder.
+*
+*                - results: Referens till resultaten.
+********************************************************************************/
+static void print_latency(const std::vector<benchmark_result>& results)
+{
+   std::cout << std::left << std::setw(32) << "benchmark" << std::setw(8) << "type" << std::right
+             << std::setw(7) << "width" << std::setw(12) << "p50 [ns]" << std::setw(12) << "p90 [ns]"
+             << std::setw(12) << "p99 [ns]" << std::setw(12) << "p99.9 [ns]" << std::setw(12) << "max [ns]\n";
+
+   for (const auto& i : results)
+   {
+      if (i.latency.buckets.empty()) continue;
+      std::cout << std::left << std::setw(32) << i.name << std::setw(8) << i.type << std::right
+                << std::setw(7) << i.width << std::fixed << std::setprecision(0)
+                << std::setw(12) << i.latency.p50 << std::setw(12) << i.latency.p90
+                << std::setw(12) << i.latency.p99 << std::setw(12) << i.latency.p999
+                << std::setw(12) << i.latency.max << "\n" << std::setw(10) << "histogram:";
+
+      for (std::size_t j = 0; j < i.latency.buckets.size(); ++j)
+      {
+         if (i.latency.buckets[j] > 0) std::cout << " " << (std::size_t(1) << j) << "ns:" << i.latency.buckets[j];
+      }
+      std::cout << "\n";
+   }
+   return;
+}
+
+/********************************************************************************
+* print_csv: Skriver ut benchmarksvitens resultat som CSV med en rubrikrad.
+*
+*            - results: Referens till resultaten.
+********************************************************************************/
+static void print_csv(const std::vector<benchmark_result>& results)
+{
+   std::cout << "benchmark,type,kernels,width,batch_size,threads,ns_per_sample,"
+             << "samples_per_second,gflops,bytes_per_sample,peak_fraction,p50_ns,p99_ns,p999_ns\n";
+
+   for (const auto& i : results)
+   {
+      std::cout << i.name << "," << i.type << "," << simd_kernels::name(simd_kernels::get().type) << ","
+                << i.width << "," << i.batch_size << "," << i.threads << ","
+                << std::setprecision(6) << i.ns_per_sample << "," << i.samples_per_second() << ","
+                << i.gflops() << "," << i.bytes_per_sample << "," << i.peak_fraction << ","
+                << i.latency.p50 << "," << i.latency.p99 << "," << i.latency.p999 << "\n";
+   }
+   return;
+}
+
+/********************************************************************************
+* print_json: Skriver ut benchmarksvitens resultat som ett JSON-objekt.
+*
+*             - results: Referens till resultaten.
+********************************************************************************/
+static void print_json(const std::vector<benchmark_result>& results)
+{
+   std::cout << "{\n  \"kernels\": \"" << simd_kernels::name(simd_kernels::get().type) << "\",\n"
+             << "  \"results\": [\n" << std::setprecision(6);
+
+   for (std::size_t i = 0; i < results.size(); ++i)
+   {
+      const auto& r = results[i];
+      std::cout << "    { \"benchmark\": \"" << r.name << "\", \"type\": \"" << r.type
+                << "\", \"width\": " << r.width << ", \"batch_size\": " << r.batch_size
+                << ", \"threads\": " << r.threads << ", \"ns_per_sample\": " << r.ns_per_sample
+                << ", \"samples_per_second\": " << r.samples_per_second() << ", \"gflops\": " << r.gflops()
+                << ", \"bytes_per_sample\": " << r.bytes_per_sample
+                << ", \"peak_fraction\": " << r.peak_fraction;
+
+      if (!r.latency.buckets.empty())
+      {
+         std::cout << ", \"latency\": { \"p50_ns\": " << r.latency.p50 << ", \"p90_ns\": " << r.latency.p90
+                   << ", \"p99_ns\": " << r.latency.p99 << ", \"p999_ns\": " << r.latency.p999
+                   << ", \"max_ns\": " << r.latency.max << ", \"histogram\": [";
+
+         for (std::size_t j = 0; j < r.latency.buckets.size(); ++j)
+         {
+            std::cout << (j > 0 ? ", " : "") << r.latency.buckets[j];
+         }
+         std::cout << "] }";
+      }
+      std::cout << " }" << (i + 1 < results.size() ? ",\n" : "\n");
+   }
+
+   std::cout << "  ]\n}\n";
+   return;
+}
+
+/********************************************************************************
+* main: Kontrollerar frst att aktiva krnors tanh fljer std::tanh, att
+*       samtliga krnor fr justering fljer referensversionen, att
+*       trning ger samma parametrar oavsett valda instllningar samt att
+*       publicerade versioner frblir intakta fr lsarna, se check, varvid
+*       programmet avslutas med returkoden 1 vid avvikelse. Drefter
+*       trnas ett dynamiskt samt ett statiskt ntverk med samma startvrden
+*       fr XOR-mnstret och kontrolleras att bda predikterar samma utdata.
+*       Sedan mts tiden per prediktion samt per trningsepok. Slutligen
+*       mts tiden per exempel vid batchprediktion med double respektive float
+*       samt tiden tills en given trningsfrlust ns med SGD respektive Adam,
+*       fljt av benchmarksviten. Vid argumenten --csv eller --json krs enbart
+*       benchmarksviten, vars resultat d skrivs ut i angivet format.
+*
+*       - argc: Antalet argument.
+*       - argv: Argumenten, se beskrivningen ovan.
+********************************************************************************/
+int main(const int argc,
+         const char** argv)
+{
+   auto quick = false, csv = false, json = false;
+
+   for (int i = 1; i < argc; ++i)
+   {
+      if (std::strcmp(argv[i], "--quick") == 0) quick = true;
+      else if (std::strcmp(argv[i], "--csv") == 0) csv = true;
+      else if (std::strcmp(argv[i], "--json") == 0) json = true;
+      else
+      {
+         std::cerr << "Usage: " << argv[0] << " [--quick] [--csv | --json]\n";
+         return 1;
+      }
+   }
+
+   const auto options = make_suite_options(quick);
+   std::vector<benchmark_result> results;
+   constexpr auto max_tanh_error_ulp = 8.0;
+   const auto check_tanh = simd_kernels::get().type != simd_support::isa::neon;
+   const auto tanh_error_f64 = check_tanh ? tanh_error_ulp<double>() : 0.0;
+   const auto tanh_error_f32 = check_tanh ? tanh_error_ulp<float>() : 0.0;
+
+   if (tanh_error_f64 > max_tanh_error_ulp || tanh_error_f32 > max_tanh_error_ulp)
+   {
+      std::cerr << "tanh deviates from std::tanh: " << tanh_error_f64 << " ulp (double), "
+                << tanh_error_f32 << " ulp (float)\n";
+      return 1;
+   }
+
+   constexpr auto max_optimizer_error_ulp = 8.0;
+   constexpr auto max_training_deviation = 1e-9;
+   auto passed = check("optimizer kernels vs scalar (double, ulp)", optimizer_error_ulp<double>(),
+                       max_optimizer_error_ulp);
+   passed = check("optimizer kernels vs scalar (float, ulp)", optimizer_error_ulp<float>(),
+                  max_optimizer_error_ulp) && passed;
+   passed = check("transposed weights (per sample)",
+                  transposed_deviation([](ann& network) { network.train(5, 0.05); }),
+                  max_training_deviation) && passed;
+   passed = check("transposed weights (batch)",
+                  transposed_deviation([](ann& network) { network.train(20, 0.05, 8); }),
+                  max_training_deviation) && passed;
+   passed = check("transposed weights (parallel)",
+                  transposed_deviation([](ann& network) { network.train_parallel(20, 0.05, 8, 2); }),
+                  max_training_deviation) && passed;
+   passed = check("transposed weights (distributed)", transposed_deviation([](ann& network)
+   {
+      tcp_communicator communicator;
+      network.train_distributed(20, 0.05, 8, communicator);
+   }), max_training_deviation) && passed;
+   passed = check("distributed (2 ranks over TCP)", distributed_deviation(37), 0.0) && passed;
+   passed = check("hogwild (1 thread) vs train_batch", hogwild_deviation(), 0.0) && passed;
+   passed = check("hogwild (4 threads) loss ratio", hogwild_loss_ratio(4), 0.5) && passed;
+   passed = check("snapshot readers (errors)", snapshot_errors(3, quick ? 1000 : 5000), 0.0) && passed;
+   if (!passed) return 1;
+
+   if (csv || json)
+   {
+      run_suite<double>(options, results);
+      run_suite<float>(options, results);
+      if (json) print_json(results);
+      else print_csv(results);
+      return 0;
+   }
+
+   const std::vector<std::vector<double>> train_in = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+   const std::vector<std::vector<double>> train_out = { { 0 }, { 1 }, { 1 }, { 0 } };
+   const std::vector<static_ann<2, 2, 1>::input_type> static_in = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+   const std::vector<static_ann<2, 2, 1>::output_type> static_out = { { 0 }, { 1 }, { 1 }, { 0 } };
+   const std::size_t predict_iterations = quick ? 1000000 : 10000000;
+   const std::size_t train_iterations = quick ? 20000 : 200000;
+
+   ann ann1(2, 2, 1);
+   static_ann<2, 2, 1> ann2;
+
+   ann1.set_training_data(train_in, train_out);
+   ann2.set_training_data(static_in, static_out);
+
+   ann1.seed(1);
+   ann1.train(1000, 0.02);
+   ann2.seed(1);
+   ann2.train(1000, 0.02);
+
+   auto max_deviation = 0.0;
+
+   for (std::size_t i = 0; i < train_in.size(); ++i)
+   {
+      const auto deviation = std::fabs(ann1.predict(train_in[i])[0] - ann2.predict(static_in[i])[0]);
+      if (deviation > max_deviation) max_deviation = deviation;
+   }
+
+   volatile double sink = 0.0;
+
+   const auto dynamic_predict = measure([&](const std::size_t i) { sink = ann1.predict(train_in[i & 3])[0]; },
+                                        predict_iterations);
+   const auto static_predict = measure([&](const std::size_t i) { sink = ann2.predict(static_in[i & 3])[0]; },
+                                       predict_iterations);
+   const auto dynamic_train = measure([&](const std::size_t) { ann1.train(1, 0.02); }, train_iterations);
+   const auto static_train = measure([&](const std::size_t) { ann2.train(1, 0.02); }, train_iterations);
+   (void)sink;
+
+   std::cout << "XOR 2-2-1, kernels: " << simd_kernels::name(simd_kernels::get().type)
+             << ", max deviation ann vs static_ann: " << std::scientific << max_deviation << "\n";
+   if (check_tanh)
+   {
+      std::cout << "max error tanh vs std::tanh: " << std::fixed << std::setprecision(2) << tanh_error_f64
+                << " ulp (double), " << tanh_error_f32 << " ulp (float)\n" << std::defaultfloat;
+   }
+   std::cout << "\n";
+   print_header("ann [ns]", "static [ns]");
+   print_result("predict", dynamic_predict, static_predict);
+   print_result("train (1 epoch)", dynamic_train, static_train);
+
+   const std::vector<std::size_t> layer_sizes = { 256, 256, 256, 16 };
+   const auto double_batch = measure_predict_batch<double>(layer_sizes, 64, 2000);
+   const auto float_batch = measure_predict_batch<float>(layer_sizes, 64, 2000);
+
+   std::cout << "\nMLP 256-256-256-16, predict_batch with 64 samples, time per sample:\n\n";
+   print_header("double [ns]", "float [ns]");
+   print_result("predict_batch", double_batch, float_batch);
+
+   const auto target_loss = quick ? 1e-2f : 5e-3f;
+   const std::size_t max_epochs = quick ? 500 : 2000;
+
+   std::cout << "\nMLP 16-32-32-4 (float), time until training loss < " << target_loss
+             << ", best of learning rates 0.001 - 0.03:\n\n";
+   print_header("sgd [ms]", "adam [ms]");
+
+   for (const std::size_t batch_size : { 1, 16 })
+   {
+      const auto name = "train (batch " + std::to_string(batch_size) + ")";
+      print_convergence(name.c_str(),
+                        measure_convergence(basic_optimizer<float>::sgd(), batch_size, target_loss, max_epochs),
+                        measure_convergence(basic_optimizer<float>::adam(), batch_size, target_loss, max_epochs));
+   }
+
+   run_suite<double>(options, results);
+   run_suite<float>(options, results);
+   std::cout << "\nBenchmark suite, kernels: " << simd_kernels::name(simd_kernels::get().type) << "\n\n";
+   print_table(results);
+   std::cout << "\nLatency per single prediction, calls interleaved:\n\n";
+   print_latency(results);
+   return 0;
+}
@@ -0,0 +1,341 @@
+/********************************************************************************
+* compiled_ann.hpp: Innehller prediktion med lg latens via klasstemplaten
+*                   basic_compiled_ann, dr ett trnat neuralt ntverk
+*                   kompileras till en ofrnderlig exekveringsplan fr
+*                   prediktion med ett exempel i taget. Varje lagers vikter
+*                   packas om i paneler anpassade efter vektorbredden fr
+*                   aktuell instruktionsuppsttning, varefter bias,
+*                   skalrprodukter och aktivering berknas per panel via
+*                   mikrokrnan gemv i strukten simd_kernels. Samtliga
+*                   buffertar allokeras vid kompileringen, dr tv buffertar
+*                   fr utsignaler anvnds vxelvis av samtliga lager, och
+*                   prediktionsloopen innehller inga storlekskontroller.
+********************************************************************************/
+#ifndef COMPILED_ANN_HPP_
+#define COMPILED_ANN_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "ann.hpp"
+#include "simd.hpp"
+#include "activation.hpp"
+#include "matrix.hpp"
+#include <vector>
+#include <cstddef>
+
+/********************************************************************************
+* basic_compiled_ann: Klass fr prediktion med lg latens via ett trnat
+*                     neuralt ntverk med flyttal av typen T. Vid kompilering
+*                     delas varje lagers noder in i paneler om gemm_columns
+*                     noder, dr panelens vikter lagras insignal fr
+*                     insignal, allts vikten fr nod j och insignal p p
+*                     index p * gemm_columns + j inom panelen. Varje steg i
+*                     mikrokrnan lser drmed en sammanhngande vektor med
+*                     vikter, vilket gr att inga horisontella summeringar
+*                     krvs. Ofullstndiga paneler fylls ut med nollor.
+*
+*                     Vid ReLU-aktivering berknas aktiveringen direkt i
+*                     mikrokrnan, medan vriga aktiveringsfunktioner
+*                     berknas fr hela lagret efter att samtliga paneler
+*                     har berknats. Berkningarna r ekvivalenta med
+*                     flyttalsntverkets, bortsett frn avrundningsskillnader
+*                     till fljd av annan summeringsordning.
+*
+*                     Mikrokrnan vljs vid kompileringen, varfr ntverket
+*                     mste kompileras om efter byte av instruktionsuppsttning
+*                     via medlemsfunktionen select i strukten simd_kernels,
+*                     liksom efter fortsatt trning. Det kompilerade ntverket
+*                     r fristende, vilket gr att flyttalsntverket kan
+*                     frigras efter kompileringen. Flera trdar kan predikera
+*                     samtidigt s lnge varje trd anvnder en egen kopia.
+********************************************************************************/
+template <typename T>
+class basic_compiled_ann
+{
+public:
+   using value_type = T;                        /* Flyttalstyp fr in- och utdata. */
+   using ann_type = basic_ann<T>;               /* Flyttalsntverket som kompileras. */
+   using layer_type = basic_dense_layer<T>;     /* Flyttalsntverkets dense-lager. */
+   using kernels_type = basic_simd_kernels<T>;  /* Berkningskrnor fr aktuell flyttalstyp. */
+   using activation_type = basic_activation<T>; /* Aktiveringsfunktioner fr aktuell flyttalstyp. */
+
+private:
+   using gemv_type = void (*)(std::size_t, const T*, const T*, const T*, T*, bool);
+   using buffer_type = std::vector<T, aligned_allocator<T>>;
+
+   /********************************************************************************
+   * step: Ett steg i exekveringsplanen, motsvarande ett dense-lager, dr
+   *       vikter och bias anges som index i planens gemensamma buffertar.
+   ********************************************************************************/
+   struct step
+   {
+      std::size_t weights{0};                                    /* Index fr lagrets frsta panel. */
+      std::size_t bias{0};                                       /* Index fr lagrets frsta bias. */
+      std::size_t num_inputs{0};                                 /* Antalet insignaler (vikter per nod). */
+      std::size_t num_nodes{0};                                  /* Antalet noder. */
+      std::size_t num_panels{0};                                 /* Antalet paneler. */
+      activation_function activation{activation_function::relu}; /* Lagrets aktiveringsfunktion. */
+   };
+
+   std::vector<step> steps_;       /* Exekveringsplan med ett steg per lager. */
+   buffer_type weights_;           /* Samtliga lagers packade paneler efter varandra. */
+   buffer_type bias_;              /* Samtliga lagers bias, utfyllda till hela paneler. */
+   buffer_type buffers_;           /* Tv buffertar fr utsignaler, vilka anvnds vxelvis. */
+   std::size_t buffer_size_{0};    /* Antalet flyttal per buffert fr utsignaler. */
+   std::vector<T> input_;          /* Insignaler till ingngslagret, utfyllda med 0. */
+   std::vector<T> output_;         /* Utsignaler frn senaste prediktion. */
+   gemv_type gemv_{nullptr};       /* Mikrokrna som valdes vid kompileringen. */
+   std::size_t panel_size_{0};     /* Antalet noder per panel. */
+
+   /********************************************************************************
+   * round_up: Returnerar angivet vrde avrundat uppt till en multipel av
+   *           angiven faktor.
+   *
+   *           - value : Vrdet som ska avrundas.
+   *           - factor: Faktorn som vrdet avrundas till en multipel av.
+   ********************************************************************************/
+   static constexpr std::size_t round_up(const std::size_t value,
+                                         const std::size_t factor)
+   {
+      return (value + factor - 1) / factor * factor;
+   }
+
+   /********************************************************************************
+   * run: Genomfr prediktion enligt exekveringsplanen med indata lagrad p
+   *      angiven adress, vilken mste innehlla num_inputs() flyttal, och
+   *      returnerar en pekare till utgngslagrets utsignaler. Lagren skriver
+   *      vxelvis till respektive buffert fr utsignaler, dr fregende
+   *      lagers buffert utgr insignaler till nsta lager.
+   *
+   *      - input: Pekare till indatan.
+   ********************************************************************************/
+   const T* run(const T* input)
+   {
+      const auto weights = this->weights_.data();
+      const auto bias = this->bias_.data();
+      const auto first_buffer = this->buffers_.data();
+      const auto second_buffer = first_buffer + this->buffer_size_;
+      const auto gemv = this->gemv_;
+      const auto panel_size = this->panel_size_;
+      auto target = first_buffer;
+
+      for (auto layer = this->steps_.data(); layer != this->steps_.data() + this->steps_.size(); ++layer)
+      {
+         const auto relu = layer->activation == activation_function::relu;
+         const auto panel_weights = layer->num_inputs * panel_size;
+         auto a = weights + layer->weights;
+         auto b = bias + layer->bias;
+         auto y = target;
+
+         for (std::size_t i = 0; i < layer->num_panels; ++i, a += panel_weights, b += panel_size, y += panel_size)
+         {
+            gemv(layer->num_inputs, a, input, b, y, relu);
+         }
+
+         if (!relu) activation_type::activate(layer->activation, target, layer->num_nodes);
+         input = target;
+         target = target == first_buffer ? second_buffer : first_buffer;
+      }
+      return input;
+   }
+
+public:
+   /********************************************************************************
+   * basic_compiled_ann: Defaultkonstruktor, initierar ett tomt kompilerat
+   *                     ntverk.
+   ********************************************************************************/
+   basic_compiled_ann(void) { }
+
+   /********************************************************************************
+   * basic_compiled_ann: Initierar kompilerat ntverk via angivet trnat
+   *                     neuralt ntverk, se medlemsfunktionen compile.
+   *
+   *                     - network: Referens till det trnade ntverket.
+   ********************************************************************************/
+   explicit basic_compiled_ann(const ann_type& network)
+   {
+      this->compile(network.layers());
+      return;
+   }
+
+   /********************************************************************************
+   * compile: Kompilerar angivna lager till en exekveringsplan, dr eventuell
+   *          tidigare plan erstts. Mikrokrnan samt panelernas storlek vljs
+   *          utefter de berkningskrnor som fr nrvarande anvnds. Samtliga
+   *          buffertar allokeras hr, s att ingen allokering sker vid
+   *          prediktion.
+   *
+   *          - layers: Referens till lagren som ska kompileras, exempelvis
+   *                    via medlemsfunktionen layers i klassen ann.
+   ********************************************************************************/
+   void compile(const std::vector<layer_type>& layers)
+   {
+      const auto& kernels = kernels_type::get();
+      this->gemv_ = kernels.gemv;
+      this->panel_size_ = kernels.gemm_columns;
+      this->steps_.assign(layers.size(), step());
+      std::size_t num_weights = 0, num_bias = 0;
+      this->buffer_size_ = 0;
+
+      for (std::size_t i = 0; i < layers.size(); ++i)
+      {
+         auto& layer = this->steps_[i];
+         const auto padded_nodes = round_up(layers[i].num_nodes(), this->panel_size_);
+         layer.weights = num_weights;
+         layer.bias = num_bias;
+         layer.num_inputs = layers[i].num_weights();
+         layer.num_nodes = layers[i].num_nodes();
+         layer.num_panels = padded_nodes / this->panel_size_;
+         layer.activation = layers[i].activation;
+         num_weights += padded_nodes * layer.num_inputs;
+         num_bias += padded_nodes;
+         if (padded_nodes > this->buffer_size_) this->buffer_size_ = padded_nodes;
+      }
+
+      this->weights_.assign(num_weights, T(0));
+      this->bias_.assign(num_bias, T(0));
+      this->buffers_.assign(2 * this->buffer_size_, T(0));
+
+      for (std::size_t i = 0; i < layers.size(); ++i)
+      {
+         const auto& source = layers[i];
+         const auto& layer = this->steps_[i];
+         auto panel = this->weights_.data() + layer.weights;
+
+         for (std::size_t j = 0; j < layer.num_nodes; ++j)
+         {
+            const auto row = source.weights[j];
+            const auto column = panel + j / this->panel_size_ * layer.num_inputs * this->panel_size_
+               + j % this->panel_size_;
+
+            for (std::size_t k = 0; k < layer.num_inputs; ++k)
+            {
+               column[k * this->panel_size_] = row[k];
+            }
+            this->bias_[layer.bias + j] = source.bias[j];
+         }
+      }
+
+      this->input_.assign(this->num_inputs(), T(0));
+      this->output_.assign(this->num_outputs(), T(0));
+      return;
+   }
+
+   /********************************************************************************
+   * num_inputs: Returnerar antalet insignaler.
+   ********************************************************************************/
+   std::size_t num_inputs(void) const
+   {
+      return this->steps_.empty() ? 0 : this->steps_.front().num_inputs;
+   }
+
+   /********************************************************************************
+   * num_outputs: Returnerar antalet utsignaler.
+   ********************************************************************************/
+   std::size_t num_outputs(void) const
+   {
+      return this->steps_.empty() ? 0 : this->steps_.back().num_nodes;
+   }
+
+   /********************************************************************************
+   * num_layers: Returnerar antalet lager (dolda lager samt utgngslagret).
+   ********************************************************************************/
+   std::size_t num_layers(void) const
+   {
+      return this->steps_.size();
+   }
+
+   /********************************************************************************
+   * panel_size: Returnerar antalet noder per panel, vilket bestms av
+   *             instruktionsuppsttningen som anvndes vid kompileringen.
+   ********************************************************************************/
+   std::size_t panel_size(void) const
+   {
+      return this->panel_size_;
+   }
+
+   /********************************************************************************
+   * size_bytes: Returnerar minnesbehovet fr exekveringsplanen, allts
+   *             packade vikter och bias inklusive utfyllnad samt buffertar
+   *             fr utsignaler.
+   ********************************************************************************/
+   std::size_t size_bytes(void) const
+   {
+      return (this->weights_.size() + this->bias_.size() + this->buffers_.size()) * sizeof(T);
+   }
+
+   /********************************************************************************
+   * output: Returnerar en referens till utsignalerna frn senaste prediktion.
+   ********************************************************************************/
+   const std::vector<T>& output(void) const
+   {
+      return this->output_;
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via angiven indata och returnerar en
+   *          referens till en vektor innehllande utdatan.
+   *
+   *          - input: Referens till vektor innehllande indata.
+   ********************************************************************************/
+   const std::vector<T>& predict(const std::vector<T>& input)
+   {
+      return this->predict(input.data(), input.size());
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via indata lagrad p angiven adress och
+   *          returnerar en referens till en vektor innehllande utdatan.
+   *          Vid frre insignaler n frvntat stts resterande insignaler
+   *          till 0, medan verskjutande insignaler ignoreras.
+   *
+   *          - input: Pekare till indatan.
+   *          - size : Antalet insignaler.
+   ********************************************************************************/
+   const std::vector<T>& predict(const T* input,
+                                 const std::size_t size)
+   {
+      if (this->steps_.empty()) return this->output();
+
+      if (size < this->input_.size())
+      {
+         for (std::size_t i = 0; i < this->input_.size(); ++i)
+         {
+            this->input_[i] = i < size ? input[i] : T(0);
+         }
+         input = this->input_.data();
+      }
+
+      this->predict(input, this->output_.data());
+      return this->output();
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via indata lagrad p angiven adress och
+   *          skriver utsignalerna till angiven adress, utan kontroller av
+   *          storlekar, vilket ger lgst latens.
+   *
+   *          - input : Pekare till indatan, vilken mste innehlla
+   *                    num_inputs() flyttal.
+   *          - output: Pekare till buffert dr utdatan lagras, vilken mste
+   *                    rymma num_outputs() flyttal.
+   ********************************************************************************/
+   void predict(const T* input,
+                T* output)
+   {
+      if (this->steps_.empty()) return;
+      const auto result = this->run(input);
+
+      for (std::size_t i = 0; i < this->steps_.back().num_nodes; ++i)
+      {
+         output[i] = result[i];
+      }
+      return;
+   }
+};
+
+/********************************************************************************
+* compiled_ann: Kompilerat neuralt ntverk skapat frn klassen ann.
+********************************************************************************/
+using compiled_ann = basic_compiled_ann<double>;
+
+#endif /* COMPILED_ANN_HPP_ */
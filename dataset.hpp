@@ -0,0 +1,268 @@
+/********************************************************************************
+* dataset.hpp: Innehller funktionalitet fr lagring av trningsdata i ett
+*              kompakt binrt filformat via klasstemplaten basic_dataset_file.
+*              Filen minnesmappas (mmap) vid lsning, vilket gr att ven
+*              datamngder som r strre n arbetsminnet kan anvndas fr
+*              trning utan att filen frst lses in eller tolkas.
+*
+*              Filformatet bestr av ett huvud om 64 byte fljt av samtliga
+*              trningsuppsttningar lagrade radvis, dr varje rad innehller
+*              indatan direkt fljd av utdatan:
+*
+*              Offset  Storlek  Innehll
+*              0       8        Identifierare "ANNDATA" avslutad med '\0'.
+*              8       4        Formatets version (fr nrvarande 1).
+*              12      4        Byteordning, 0x01020304 lagrat i vrdens
+*                               byteordning, s att filer frn en vrd med
+*                               annan byteordning kan avvisas.
+*              16      4        Flyttalstyp (4 = float, 8 = double).
+*              20      4        Reserverat, stts till 0.
+*              24      8        Antalet rader (trningsuppsttningar).
+*              32      8        Antalet insignaler per rad.
+*              40      8        Antalet utsignaler per rad.
+*              48      16       Reserverat, stts till 0.
+*              64      ...      Rader med (insignaler + utsignaler) flyttal.
+********************************************************************************/
+#ifndef DATASET_HPP_
+#define DATASET_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "matrix.hpp"
+#include "mapped_file.hpp"
+#include <fstream>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/********************************************************************************
+* dataset_header: Huvudet i brjan av varje datafil, se beskrivningen av
+*                 filformatet ovan.
+********************************************************************************/
+struct dataset_header
+{
+   char magic[8];              /* Identifierare "ANNDATA". */
+   std::uint32_t version;      /* Formatets version. */
+   std::uint32_t byte_order;   /* Byteordning (0x01020304). */
+   std::uint32_t value_size;   /* Storlek per flyttal i byte. */
+   std::uint32_t reserved0;    /* Reserverat. */
+   std::uint64_t num_rows;     /* Antalet trningsuppsttningar. */
+   std::uint64_t num_inputs;   /* Antalet insignaler per rad. */
+   std::uint64_t num_outputs;  /* Antalet utsignaler per rad. */
+   std::uint64_t reserved1[2]; /* Reserverat. */
+
+   static constexpr std::uint32_t current_version = 1;            /* Aktuell version. */
+   static constexpr std::uint32_t native_byte_order = 0x01020304; /* Vrdens byteordning. */
+};
+
+static_assert(sizeof(dataset_header) == 64, "dataset_header must be 64 bytes!");
+
+/********************************************************************************
+* basic_dataset_file: Klasstemplat fr lsning av trningsdata lagrad i en
+*                     datafil med flyttal av typen T. Filen minnesmappas
+*                     enbart fr lsning, varefter in- och utdatan kan lsas
+*                     via vyer utan kopiering. Operativsystemet lser drmed
+*                     in enbart de delar av filen som faktiskt anvnds, vilka
+*                     kan frigras igen vid minnesbrist. Vyerna r giltiga s
+*                     lnge filen r ppen.
+********************************************************************************/
+template <typename T>
+class basic_dataset_file
+{
+public:
+   using value_type = T;                          /* Flyttalstyp i filen. */
+   using matrix_view_type = basic_matrix_view<T>; /* Vy ver in- eller utdatan. */
+
+   /********************************************************************************
+   * basic_dataset_file: Initierar nytt objekt utan ppnad fil.
+   ********************************************************************************/
+   basic_dataset_file(void) { }
+
+   /********************************************************************************
+   * basic_dataset_file: ppnar angiven datafil, se medlemsfunktionen open.
+   *
+   *                     - path: Skvg till datafilen.
+   ********************************************************************************/
+   explicit basic_dataset_file(const char* path)
+   {
+      this->open(path);
+      return;
+   }
+
+   basic_dataset_file(const basic_dataset_file&) = delete;
+   basic_dataset_file& operator=(const basic_dataset_file&) = delete;
+
+   /********************************************************************************
+   * ~basic_dataset_file: Stnger datafilen nr objektet gr ur scope.
+   ********************************************************************************/
+   ~basic_dataset_file(void)
+   {
+      this->close();
+      return;
+   }
+
+   /********************************************************************************
+   * open: ppnar och minnesmappar angiven datafil. Eventuell tidigare ppnad
+   *       fil stngs frst. Returnerar true om filen kunde ppnas, annars
+   *       false, exempelvis om filen saknas, har fel format, annan
+   *       byteordning eller en annan flyttalstyp n T.
+   *
+   *       - path: Skvg till datafilen.
+   ********************************************************************************/
+   bool open(const char* path)
+   {
+      this->close();
+      if (!this->file_.open(path)) return false;
+
+      if (!this->validate())
+      {
+         this->close();
+         return false;
+      }
+      return true;
+   }
+
+   /********************************************************************************
+   * close: Stnger datafilen och frigr minnesmappningen.
+   ********************************************************************************/
+   void close(void)
+   {
+      this->file_.close();
+      this->header_ = nullptr;
+      this->data_ = nullptr;
+      return;
+   }
+
+   /********************************************************************************
+   * is_open: Indikerar ifall en datafil fr nrvarande r ppen.
+   ********************************************************************************/
+   bool is_open(void) const
+   {
+      return this->header_ != nullptr;
+   }
+
+   /********************************************************************************
+   * num_rows: Returnerar antalet trningsuppsttningar i ppnad datafil.
+   ********************************************************************************/
+   std::size_t num_rows(void) const
+   {
+      return this->header_ ? static_cast<std::size_t>(this->header_->num_rows) : 0;
+   }
+
+   /********************************************************************************
+   * num_inputs: Returnerar antalet insignaler per trningsuppsttning.
+   ********************************************************************************/
+   std::size_t num_inputs(void) const
+   {
+      return this->header_ ? static_cast<std::size_t>(this->header_->num_inputs) : 0;
+   }
+
+   /********************************************************************************
+   * num_outputs: Returnerar antalet utsignaler per trningsuppsttning.
+   ********************************************************************************/
+   std::size_t num_outputs(void) const
+   {
+      return this->header_ ? static_cast<std::size_t>(this->header_->num_outputs) : 0;
+   }
+
+   /********************************************************************************
+   * inputs: Returnerar en vy ver indatan, en rad per trningsuppsttning.
+   ********************************************************************************/
+   matrix_view_type inputs(void) const
+   {
+      if (!this->is_open()) return matrix_view_type();
+      return matrix_view_type(this->data_, this->num_rows(), this->num_inputs(), this->row_size());
+   }
+
+   /********************************************************************************
+   * outputs: Returnerar en vy ver utdatan, en rad per trningsuppsttning.
+   ********************************************************************************/
+   matrix_view_type outputs(void) const
+   {
+      if (!this->is_open()) return matrix_view_type();
+      return matrix_view_type(this->data_ + this->num_inputs(), this->num_rows(),
+                              this->num_outputs(), this->row_size());
+   }
+
+   /********************************************************************************
+   * write: Skriver angiven in- och utdata till en ny datafil. Antalet rader
+   *        stts till det minsta av antalet rader i vyerna. Returnerar true
+   *        om filen kunde skrivas, annars false.
+   *
+   *        - path   : Skvg till datafilen som ska skapas.
+   *        - inputs : Vy ver indatan, en rad per trningsuppsttning.
+   *        - outputs: Vy ver utdatan, en rad per trningsuppsttning.
+   ********************************************************************************/
+   static bool write(const char* path,
+                     const matrix_view_type& inputs,
+                     const matrix_view_type& outputs)
+   {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      if (!file) return false;
+
+      dataset_header header;
+      std::memset(&header, 0, sizeof(header));
+      std::memcpy(header.magic, "ANNDATA", 8);
+      header.version = dataset_header::current_version;
+      header.byte_order = dataset_header::native_byte_order;
+      header.value_size = sizeof(T);
+      header.num_rows = inputs.rows() < outputs.rows() ? inputs.rows() : outputs.rows();
+      header.num_inputs = inputs.columns();
+      header.num_outputs = outputs.columns();
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+      for (std::size_t i = 0; i < header.num_rows; ++i)
+      {
+         file.write(reinterpret_cast<const char*>(inputs[i]), inputs.columns() * sizeof(T));
+         file.write(reinterpret_cast<const char*>(outputs[i]), outputs.columns() * sizeof(T));
+      }
+      return static_cast<bool>(file);
+   }
+
+private:
+   /********************************************************************************
+   * row_size: Returnerar antalet flyttal per rad i datafilen.
+   ********************************************************************************/
+   std::size_t row_size(void) const
+   {
+      return this->num_inputs() + this->num_outputs();
+   }
+
+   /********************************************************************************
+   * validate: Kontrollerar att huvudet i mappad fil r giltigt, att filen r
+   *           tillrckligt stor fr samtliga rader och att flyttalstypen
+   *           verensstmmer med T.
+   ********************************************************************************/
+   bool validate(void)
+   {
+      const auto size = this->file_.size();
+      if (size < sizeof(dataset_header)) return false;
+      const auto header = static_cast<const dataset_header*>(this->file_.data());
+
+      if (std::memcmp(header->magic, "ANNDATA", 8) != 0 ||
+          header->version != dataset_header::current_version ||
+          header->byte_order != dataset_header::native_byte_order ||
+          header->value_size != sizeof(T))
+      {
+         return false;
+      }
+
+      const auto row_size = header->num_inputs + header->num_outputs;
+      const auto available = (size - sizeof(dataset_header)) / sizeof(T);
+      if (row_size > 0 && header->num_rows > available / row_size) return false;
+
+      this->header_ = header;
+      this->data_ = reinterpret_cast<const T*>(static_cast<const char*>(this->file_.data()) + sizeof(dataset_header));
+      return true;
+   }
+
+   mapped_file file_;                     /* Minnesmappad datafil. */
+   const dataset_header* header_{nullptr}; /* Filens huvud, eller nullptr om stngd. */
+   const T* data_{nullptr};                /* Den frsta radens frsta flyttal. */
+};
+
+/********************************************************************************
+* dataset_file: Datafil med flyttal av typen double.
+********************************************************************************/
+using dataset_file = basic_dataset_file<double>;
+
+#endif /* DATASET_HPP_ */
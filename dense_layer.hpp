@@ -1,54 +1,91 @@
 /********************************************************************************
 * dense_layer.hpp: Innehller funktionalitet fr implementering av dense-lager
-*                  i neurala ntverk via strukten dense_layer.
+*                  i neurala ntverk via strukttemplaten basic_dense_layer.
 ********************************************************************************/
 #ifndef DENSE_LAYER_HPP_
 #define DENSE_LAYER_HPP_
 
 /* Inkluderingsdirektiv: */
+#include "matrix.hpp"
+#include "simd.hpp"
+#include "gemm.hpp"
+#include "activation.hpp"
+#include "optimizer.hpp"
+#include "random.hpp"
+#include "instrumentation.hpp"
 #include <vector>
+#include <array>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
-#include <cstdlib>
+#include <cmath>
 
 /********************************************************************************
-* dense_layer: Strukt fr implementering av dense-lager med valbart antal noder
-*              samt vikter per nod i neurala ntverk. Bias och vikter fr
-*              samtliga noder erhller randomiserade startvrden mellan 0 - 1,
-*              vriga parametrar stts till 0 vid start.
+* basic_dense_layer: Strukt fr implementering av dense-lager med valbart antal
+*                    noder samt vikter per nod i neurala ntverk, dr samtliga
+*                    parametrar lagras som flyttal av typen T (float eller
+*                    double). Bias och vikter fr samtliga noder erhller
+*                    randomiserade startvrden enligt vald metod (som default
+*                    mellan 0 - 1), vriga parametrar stts till 0 vid start.
+*                    Varje lager har en egen aktiveringsfunktion, vilken som
+*                    default utgrs av ReLU. Vid justering via momentum,
+*                    RMSProp eller Adam lagras tillstnden i matriser med samma
+*                    layout som vikterna, se medlemsfunktionen resize_optimizer.
 ********************************************************************************/
-struct dense_layer
+template <typename T>
+struct basic_dense_layer
 {
-   std::vector<double> output;               /* Nodernas utsignaler. */
-   std::vector<double> error;                /* Nodernas uppmtta fel/avvikelser. */
-   std::vector<double> bias;                 /* Nodernas vilovrden (m-vrden). */
-   std::vector<std::vector<double>> weights; /* Nodernas vikter (k-vrden). */
+   using value_type = T;                          /* Flyttalstyp fr samtliga parametrar. */
+   using matrix_type = basic_matrix<T>;           /* Matristyp fr vikter och batchbuffertar. */
+   using kernels_type = basic_simd_kernels<T>;    /* Berkningskrnor fr aktuell flyttalstyp. */
+   using gemm_type = basic_gemm<T>;               /* Blockad matrismultiplikation. */
+   using activation_type = basic_activation<T>;   /* Aktiveringsfunktioner fr aktuell flyttalstyp. */
+   using optimizer_type = basic_optimizer<T>;     /* Instllningar fr justering av parametrar. */
+   using update_type = basic_optimizer_update<T>; /* Instllningar fr en enskild justering. */
+
+   std::vector<T> output;          /* Nodernas utsignaler. */
+   std::vector<T> error;           /* Nodernas uppmtta fel/avvikelser. */
+   std::vector<T> bias;            /* Nodernas vilovrden (m-vrden). */
+   matrix_type weights;            /* Nodernas vikter (k-vrden), en rad per nod. */
+   matrix_type weights_transposed; /* Valfri transponerad kopia av vikterna, en rad per vikt. */
+   matrix_type batch_output;       /* Utsignaler vid batchtrning, en rad per trningsexempel. */
+   matrix_type batch_error;        /* Fel vid batchtrning, en rad per trningsexempel. */
+   matrix_type weight_moment1;     /* Vikternas frsta ordningens tillstnd, en rad per nod. */
+   matrix_type weight_moment2;     /* Vikternas andra ordningens tillstnd, en rad per nod. */
+   std::vector<T> bias_moment1;    /* Biasvrdenas frsta ordningens tillstnd. */
+   std::vector<T> bias_moment2;    /* Biasvrdenas andra ordningens tillstnd. */
+   std::vector<T> gradient_buffer; /* Viktbidrag fr en nod vid batchjustering med tillstnd. */
+   activation_function activation; /* Lagrets aktiveringsfunktion. */
+
+   static constexpr std::size_t transpose_block = 8; /* Block (rader och kolumner) vid transponering. */
 
    /********************************************************************************
-   * dense_layer: Initierar nytt tomt dense-lager.
+   * basic_dense_layer: Initierar nytt tomt dense-lager.
    ********************************************************************************/
-   dense_layer(void) { }
+   basic_dense_layer(void)
+      : activation{activation_function::relu} { }
 
    /********************************************************************************
-   * dense_layer: Initierar nytt dense-lager av angiven storlek.
+   * basic_dense_layer: Initierar nytt dense-lager av angiven storlek.
    * 
-   *              - num_nodes  : Antalet noder i det nya dense-lagret.
-   *              - num_weights: Antalet vikter per nod i det nya dense-lagret.
+   *                    - num_nodes  : Antalet noder i det nya dense-lagret.
+   *                    - num_weights: Antalet vikter per nod i det nya dense-lagret.
    ********************************************************************************/
-   dense_layer(const std::size_t num_nodes,
-               const std::size_t num_weights)
+   basic_dense_layer(const std::size_t num_nodes,
+                     const std::size_t num_weights)
+      : activation{activation_function::relu}
    {
       this->resize(num_nodes, num_weights);
       return;
    }
 
    /********************************************************************************
-   * ~dense_layer: Tmmer angivet dense-lager om detta lager gr ur scope,
-   *               exempelvis om ett lokalt dense-lager har deklarerats och
-   *               funktionen dr detta lager har deklarerats avslutas (lagret
-   *               frigrs d automatiskt frn stacken).
+   * ~basic_dense_layer: Tmmer angivet dense-lager om detta lager gr ur scope,
+   *                     exempelvis om ett lokalt dense-lager har deklarerats och
+   *                     funktionen dr detta lager har deklarerats avslutas
+   *                     (lagret frigrs d automatiskt frn stacken).
    ********************************************************************************/
-   ~dense_layer(void)
+   ~basic_dense_layer(void)
    {
       this->clear();
       return;
@@ -67,7 +104,7 @@ struct dense_layer
    ********************************************************************************/
    inline std::size_t num_weights(void) const
    {
-      return this->weights.size() ? this->weights[0].size() : 0;
+      return this->weights.columns();
    }
 
    /********************************************************************************
@@ -79,14 +116,267 @@ struct dense_layer
       this->error.clear();
       this->bias.clear();
       this->weights.clear();
+      this->weights_transposed.clear();
+      this->batch_output.clear();
+      this->batch_error.clear();
+      this->weight_moment1.clear();
+      this->weight_moment2.clear();
+      this->bias_moment1.clear();
+      this->bias_moment2.clear();
+      this->gradient_buffer.clear();
+      this->transposed_stale_ = true;
+      return;
+   }
+
+   /********************************************************************************
+   * set_transposed: Aktiverar eller avaktiverar en transponerad kopia av lagrets
+   *                 vikter, dr rad i innehller samtliga noders vikter fr
+   *                 insignal i. Kopian anvnds vid baktpropagering genom
+   *                 fregende lager, vars fel d berknas via skalrprodukter
+   *                 mot sammanhngande rader i stllet fr via axpy ver hela
+   *                 felvektorn fr varje nod i detta lager. Kopian krver lika
+   *                 mycket minne som vikterna, se transposed_bytes, och mste
+   *                 uppdateras via update_transposed efter att vikterna har
+   *                 ndrats. Fram till dess anvnds den vanliga varianten.
+   *
+   *                 - enable: Indikerar ifall kopian ska anvndas.
+   ********************************************************************************/
+   void set_transposed(const bool enable)
+   {
+      if (!enable)
+      {
+         this->weights_transposed.clear();
+      }
+      else if (this->weights_transposed.rows() != this->num_weights() ||
+               this->weights_transposed.columns() != this->num_nodes())
+      {
+         this->weights_transposed.resize(this->num_weights(), this->num_nodes(), T(0));
+      }
+
+      this->transposed_stale_ = true;
+      return;
+   }
+
+   /********************************************************************************
+   * has_transposed: Indikerar ifall lagret har en transponerad kopia av vikterna.
+   ********************************************************************************/
+   inline bool has_transposed(void) const
+   {
+      return this->weights_transposed.rows() > 0 && this->weights_transposed.columns() > 0;
+   }
+
+   /********************************************************************************
+   * is_transposed_current: Indikerar ifall den transponerade kopian finns och
+   *                        motsvarar lagrets aktuella vikter.
+   ********************************************************************************/
+   inline bool is_transposed_current(void) const
+   {
+      return this->has_transposed() && !this->transposed_stale_;
+   }
+
+   /********************************************************************************
+   * transposed_bytes: Returnerar minnesbehovet fr den transponerade kopian av
+   *                   vikterna i byte, inklusive utfyllnad av varje rad.
+   ********************************************************************************/
+   std::size_t transposed_bytes(void) const
+   {
+      return matrix_type::storage_bytes(this->weights_transposed.rows(), this->weights_transposed.columns());
+   }
+
+   /********************************************************************************
+   * invalidate_transposed: Markerar den transponerade kopian som inaktuell,
+   *                        vilket mste anropas efter att vikterna har skrivits
+   *                        direkt. Kopiornas korrekthet vilar helt p att varje
+   *                        vg som skriver vikterna markerar kopian: varje
+   *                        medlemsfunktion som justerar vikterna, exempelvis
+   *                        samtliga varianter av optimize, mste antingen
+   *                        anropa invalidate_transposed eller i sin
+   *                        beskrivning ange att anroparen gr det (alternativt
+   *                        uppdaterar kopian fr samma nodintervall, se
+   *                        apply_gradient). Benchmarkprogrammet kontrollerar
+   *                        att trning med och utan kopior ger samma
+   *                        parametrar. Flaggan skrivs enbart om den ndras,
+   *                        men r inte atomr, varfr anropet inte fr ske frn
+   *                        flera trdar samtidigt.
+   ********************************************************************************/
+   void invalidate_transposed(void)
+   {
+      if (!this->transposed_stale_) this->transposed_stale_ = true;
+      return;
+   }
+
+   /********************************************************************************
+   * update_transposed: Uppdaterar den transponerade kopian av vikterna ifall
+   *                    den r inaktuell, vilket gr att upprepade anrop utan
+   *                    mellanliggande justering inte kostar ngot.
+   ********************************************************************************/
+   void update_transposed(void)
+   {
+      if (!this->has_transposed() || !this->transposed_stale_) return;
+      this->update_transposed(0, this->num_nodes());
+      this->transposed_stale_ = false;
+      return;
+   }
+
+   /********************************************************************************
+   * update_transposed: Kopierar vikterna fr noderna i intervallet [first_node,
+   *                    last_node) till motsvarande kolumner i den transponerade
+   *                    kopian, i block om transpose_block rader och kolumner s
+   *                    att bde lsning och skrivning sker inom cacheminnet.
+   *                    Genom att dela upp noderna i disjunkta intervall kan
+   *                    flera trdar uppdatera kopian samtidigt, exempelvis
+   *                    direkt efter medlemsfunktionen apply_gradient. Kopians
+   *                    flagga ndras inte, varfr samtliga noder mste
+   *                    uppdateras fr att kopian ska frbli aktuell.
+   *
+   *                    - first_node: Index fr den frsta noden som kopieras.
+   *                    - last_node : Index efter den sista noden som kopieras.
+   ********************************************************************************/
+   void update_transposed(const std::size_t first_node,
+                          const std::size_t last_node)
+   {
+      if (!this->has_transposed()) return;
+      const auto end = last_node < this->num_nodes() ? last_node : this->num_nodes();
+
+      for (auto i = first_node; i < end; i += transpose_block)
+      {
+         const auto rows_end = end - i < transpose_block ? end : i + transpose_block;
+
+         for (std::size_t j = 0; j < this->num_weights(); j += transpose_block)
+         {
+            const auto columns_end = this->num_weights() - j < transpose_block ? this->num_weights() : j + transpose_block;
+
+            for (auto row = i; row < rows_end; ++row)
+            {
+               const auto source = this->weights[row];
+
+               for (auto column = j; column < columns_end; ++column)
+               {
+                  this->weights_transposed[column][row] = source[column];
+               }
+            }
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * batch_size: Returnerar det maximala antalet trningsexempel som angivet
+   *             dense-lager kan behandla per batch.
+   ********************************************************************************/
+   inline std::size_t batch_size(void) const
+   {
+      return this->batch_output.rows();
+   }
+
+   /********************************************************************************
+   * resize_batch: Allokerar buffertar fr utsignaler och fel vid batchtrning,
+   *               s att angivet antal trningsexempel kan behandlas per batch.
+   *               Buffertarna allokeras enbart om storleken ndras, vilket gr
+   *               att ingen allokering sker i sjlva trningsloopen.
+   *
+   *               - batch_size: Maximalt antal trningsexempel per batch.
+   ********************************************************************************/
+   void resize_batch(const std::size_t batch_size)
+   {
+      if (this->batch_output.rows() != batch_size ||
+          this->batch_output.columns() != this->num_nodes())
+      {
+         this->batch_output.resize(batch_size, this->num_nodes(), T(0));
+         this->batch_error.resize(batch_size, this->num_nodes(), T(0));
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * resize_optimizer: Allokerar tillstnd fr angiven metod fr justering, dr
+   *                   tillstnd som metoden inte anvnder tms. Tillstnden
+   *                   allokeras och nollstlls enbart om storleken ndras,
+   *                   vilket gr att de behlls mellan upprepade trningar.
+   *
+   *                   - optimizer: Instllningar fr justering av parametrar.
+   ********************************************************************************/
+   void resize_optimizer(const optimizer_type& optimizer)
+   {
+      resize_state(this->weight_moment1, this->bias_moment1, optimizer.uses_moment1());
+      resize_state(this->weight_moment2, this->bias_moment2, optimizer.uses_moment2());
+      const auto buffer_size = optimizer.method == optimizer_method::sgd ? 0 : this->num_weights();
+      if (this->gradient_buffer.size() != buffer_size) this->gradient_buffer.assign(buffer_size, T(0));
+      return;
+   }
+
+   /********************************************************************************
+   * reset_optimizer: Nollstller samtliga tillstnd fr justering, exempelvis
+   *                  innan ny trning frn nya startvrden.
+   ********************************************************************************/
+   void reset_optimizer(void)
+   {
+      this->weight_moment1.fill(T(0));
+      this->weight_moment2.fill(T(0));
+      this->bias_moment1.assign(this->bias_moment1.size(), T(0));
+      this->bias_moment2.assign(this->bias_moment2.size(), T(0));
       return;
    }
 
+   /********************************************************************************
+   * arena_bytes: Returnerar antalet byte som lagrets matriser krver i en
+   *              arena, se medlemsfunktionen move_to.
+   ********************************************************************************/
+   std::size_t arena_bytes(void) const
+   {
+      std::size_t result = 0;
+
+      for (const auto buffer : this->matrices())
+      {
+         result += memory_arena::round_up(matrix_type::storage_bytes(buffer->rows(), buffer->columns()));
+      }
+      return result;
+   }
+
+   /********************************************************************************
+   * is_placed_in: Indikerar ifall samtliga lagrets matriser r tomma eller
+   *               placerade i angiven arena.
+   *
+   *               - arena: Referens till arenan som ska kontrolleras.
+   ********************************************************************************/
+   bool is_placed_in(const memory_arena& arena) const
+   {
+      for (const auto buffer : this->matrices())
+      {
+         if (!buffer->is_placed_in(arena)) return false;
+      }
+      return true;
+   }
+
+   /********************************************************************************
+   * move_to: Flyttar lagrets vikter, batchbuffertar och tillstnd fr justering
+   *          till angiven arena, s att lagrets matriser ligger efter varandra
+   *          i samma minnesblock med varje matris p en egen cache-linje.
+   *          Batchbuffertarna fr utsignaler och fel placeras med raderna
+   *          vxelvis, se medlemsfunktionen resize_interleaved i klassen
+   *          basic_matrix. Matriser som inte ryms i arenan lmnas orrda.
+   *          Returnerar false om ngon matris inte kunde flyttas.
+   *
+   *          - arena: Referens till arenan som matriserna flyttas till.
+   ********************************************************************************/
+   bool move_to(memory_arena& arena)
+   {
+      auto result = matrix_type::move_interleaved(this->batch_output, this->batch_error, arena);
+
+      for (const auto buffer : this->matrices())
+      {
+         if (buffer == &this->batch_output || buffer == &this->batch_error) continue;
+         if (!buffer->move_to(arena)) result = false;
+      }
+      return result;
+   }
+
    /********************************************************************************
    * resize: Stter antalet noder och vikter per nod i angiven vektor. Bias och
-   *         vikter tilldelas randomiserade startvrden mellan 0 - 1, vriga
-   *         parametrar stts till 0 vid start. Innan storleken stts s tms
-   *         dense-lagret fr att gra initieringen enklare.
+   *         vikter tilldelas randomiserade startvrden mellan 0 - 1 via
+   *         anropande trds generator, vriga parametrar stts till 0 vid
+   *         start. Innan storleken stts s tms dense-lagret fr att gra
+   *         initieringen enklare.
    * 
    *         - num_nodes  : Antalet noder i dense-lagret.
    *         - num_weights: Antalet vikter per nod i dense-lagret.
@@ -94,22 +384,154 @@ struct dense_layer
    void resize(const std::size_t num_nodes,
                const std::size_t num_weights)
    {
-      this->output.resize(num_nodes, 0.0);
-      this->error.resize(num_nodes, 0.0);
-      this->bias.resize(num_nodes, 0.0);
-      this->weights.resize(num_nodes, std::vector<double>(num_weights, 0.0));
+      this->resize(num_nodes, num_weights, random_generator::thread_local_instance());
+      return;
+   }
+
+   /********************************************************************************
+   * resize: Stter antalet noder och vikter per nod i angiven vektor, dr bias
+   *         och vikter tilldelas randomiserade startvrden frn angiven
+   *         generator enligt angiven metod, se medlemsfunktionen randomize.
+   *         vriga parametrar stts till 0 vid start.
+   * 
+   *         - num_nodes  : Antalet noder i dense-lagret.
+   *         - num_weights: Antalet vikter per nod i dense-lagret.
+   *         - generator  : Referens till generatorn som startvrdena hmtas frn.
+   *         - init       : Metod fr tilldelning av startvrden (default = uniform).
+   ********************************************************************************/
+   void resize(const std::size_t num_nodes,
+               const std::size_t num_weights,
+               random_generator& generator,
+               const weight_init init = weight_init::uniform)
+   {
+      this->output.assign(num_nodes, T(0));
+      this->error.assign(num_nodes, T(0));
+      this->bias.assign(num_nodes, T(0));
+      this->weights.resize(num_nodes, num_weights, T(0));
+      if (this->has_transposed()) this->set_transposed(true);
+      this->randomize(generator, init);
+      return;
+   }
+
+   /********************************************************************************
+   * randomize: Tilldelar bias och vikter nya randomiserade startvrden frn
+   *            angiven generator, dr varje nods bias fljs av nodens vikter.
+   *            Vid metoden uniform erhller samtliga parametrar startvrden
+   *            mellan 0 - 1. Vid metoderna xavier och he stts bias till 0,
+   *            medan vikterna erhller startvrden mellan -a och a, dr a
+   *            beror p lagrets storlek, se enumerationen weight_init.
+   *
+   *            - generator: Referens till generatorn som startvrdena hmtas frn.
+   *            - init     : Metod fr tilldelning av startvrden (default = uniform).
+   ********************************************************************************/
+   void randomize(random_generator& generator,
+                  const weight_init init = weight_init::uniform)
+   {
+      const auto limit = weight_init_limit<T>(init, this->num_nodes(), this->num_weights());
+
+      for (std::size_t i = 0; i < this->num_nodes(); ++i)
+      {
+         if (init == weight_init::uniform)
+         {
+            this->bias[i] = generator.uniform<T>();
+
+            for (std::size_t j = 0; j < this->num_weights(); ++j)
+            {
+               this->weights[i][j] = generator.uniform<T>();
+            }
+         }
+         else
+         {
+            this->bias[i] = T(0);
+
+            for (std::size_t j = 0; j < this->num_weights(); ++j)
+            {
+               this->weights[i][j] = generator.uniform<T>(-limit, limit);
+            }
+         }
+      }
+      this->invalidate_transposed();
+      return;
+   }
+
+   /********************************************************************************
+   * prune: Stter angiven andel av lagrets vikter till 0, dr vikterna med
+   *        lgst absolutvrde vljs (magnitude pruning). Bias pverkas inte.
+   *        Samtliga vikter under trskelvrdet stts frst till 0, varefter
+   *        vikter lika med trskelvrdet stts till 0 i radordning tills
+   *        angiven andel har uppntts. Returnerar antalet vikter som sattes
+   *        till 0. Vid fortsatt trning justeras ven vikter som tidigare
+   *        satts till 0.
+   *
+   *        - fraction: Andel (0 - 1) av lagrets vikter som ska sttas till 0.
+   ********************************************************************************/
+   std::size_t prune(const T fraction)
+   {
+      const auto total = this->num_nodes() * this->num_weights();
+      const auto limit = fraction > 0 ? (fraction < 1 ? fraction : T(1)) : T(0);
+      const auto count = static_cast<std::size_t>(limit * static_cast<T>(total));
+      if (count == 0) return 0;
+      std::vector<T> magnitudes;
+      magnitudes.reserve(total);
+
+      for (std::size_t i = 0; i < this->num_nodes(); ++i)
+      {
+         for (std::size_t j = 0; j < this->num_weights(); ++j)
+         {
+            magnitudes.push_back(std::fabs(this->weights[i][j]));
+         }
+      }
+
+      std::nth_element(magnitudes.begin(), magnitudes.begin() + (count - 1), magnitudes.end());
+      const auto threshold = magnitudes[count - 1];
+      std::size_t num_pruned = 0;
 
-      for (std::size_t i = 0; i < num_nodes; ++i)
+      for (std::size_t i = 0; i < this->num_nodes(); ++i)
       {
-         this->bias[i] = this->get_random();
+         const auto row = this->weights[i];
 
-         for (std::size_t j = 0; j < num_weights; ++j)
+         for (std::size_t j = 0; j < this->num_weights(); ++j)
          {
-            this->weights[i][j] = this->get_random();
+            if (std::fabs(row[j]) < threshold)
+            {
+               row[j] = T(0);
+               ++num_pruned;
+            }
          }
       }
 
-      return;
+      for (std::size_t i = 0; i < this->num_nodes() && num_pruned < count; ++i)
+      {
+         const auto row = this->weights[i];
+
+         for (std::size_t j = 0; j < this->num_weights() && num_pruned < count; ++j)
+         {
+            if (std::fabs(row[j]) == threshold)
+            {
+               row[j] = T(0);
+               ++num_pruned;
+            }
+         }
+      }
+      this->invalidate_transposed();
+      return num_pruned;
+   }
+
+   /********************************************************************************
+   * num_nonzero_weights: Returnerar antalet vikter som inte r 0.
+   ********************************************************************************/
+   std::size_t num_nonzero_weights(void) const
+   {
+      std::size_t result = 0;
+
+      for (std::size_t i = 0; i < this->num_nodes(); ++i)
+      {
+         for (std::size_t j = 0; j < this->num_weights(); ++j)
+         {
+            if (this->weights[i][j] != T(0)) ++result;
+         }
+      }
+      return result;
    }
 
    /********************************************************************************
@@ -119,15 +541,33 @@ struct dense_layer
    *        - ostream     : Referens till angiven utstrm.
    *        - num_decimals: Antalet decimaler i utskriften.
    ********************************************************************************/
-   static void print(const std::vector<double>& data,
+   static void print(const std::vector<T>& data,
+                     std::ostream& ostream = std::cout,
+                     const std::size_t num_decimals = 1)
+   {
+      print(data.data(), data.size(), ostream, num_decimals);
+      return;
+   }
+
+   /********************************************************************************
+   * print: Skriver ut angivet antal flyttal frn angiven adress p en rad via
+   *        angiven utstrm, exempelvis en rad i en matris.
+   *
+   *        - data        : Pekare till det frsta flyttalet som ska skrivas ut.
+   *        - size        : Antalet flyttal som ska skrivas ut.
+   *        - ostream     : Referens till angiven utstrm.
+   *        - num_decimals: Antalet decimaler i utskriften.
+   ********************************************************************************/
+   static void print(const T* data,
+                     const std::size_t size,
                      std::ostream& ostream = std::cout,
                      const std::size_t num_decimals = 1)
    {
       ostream << std::fixed;
 
-      for (auto& i : data)
+      for (std::size_t i = 0; i < size; ++i)
       {
-         ostream << std::setprecision(num_decimals) << i << " ";
+         ostream << std::setprecision(num_decimals) << data[i] << " ";
       }
 
       ostream << "\n";
@@ -145,7 +585,8 @@ struct dense_layer
    {
       ostream << "--------------------------------------------------------------------------------\n";
       ostream << "Number of nodes: " << this->num_nodes() << "\n";
-      ostream << "Number of weights per node: " << this->num_weights() << "\n\n";
+      ostream << "Number of weights per node: " << this->num_weights() << "\n";
+      ostream << "Activation: " << activation_type::name(this->activation) << "\n\n";
 
       ostream << "Output: ";
       this->print(this->output, ostream);
@@ -161,7 +602,7 @@ struct dense_layer
       for (std::size_t i = 0; i < this->num_nodes(); ++i)
       {
          ostream << "Node " << i + 1 << ": ";
-         this->print(this->weights[i], ostream);
+         this->print(this->weights[i], this->num_weights(), ostream);
       }
 
       ostream << "--------------------------------------------------------------------------------\n\n";
@@ -171,26 +612,68 @@ struct dense_layer
    /********************************************************************************
    * feedforward: Berknar nya utsignaler fr varje nod i angivet dense-lager
    *              genom att summera respektive nods bias samt indata (vikter *
-   *              nya insignaler). Om denna summa verstiger 0 s r noden 
-   *              aktiverad och utsignalen stts till berknad summa. Annars r 
-   *              noden inaktiverad och utsignalen stts d till 0.
+   *              nya insignaler). Utsignalen utgrs sedan av lagrets
+   *              aktiveringsfunktion applicerad p summan, vilket vid ReLU
+   *              innebr att utsignalen stts till summan om denna verstiger
+   *              0, annars till 0.
    * 
    *              - input: Referens till vektor med nya insignaler.
    ********************************************************************************/
-   void feedforward(const std::vector<double>& input)
+   void feedforward(const std::vector<T>& input)
    {
-      for (std::size_t i = 0; i < this->num_nodes(); ++i)
-      {
-         auto sum = this->bias[i];
+      this->feedforward(input.data(), input.size(), this->output.data());
+      return;
+   }
 
-         for (std::size_t j = 0; j < this->num_weights() && j < input.size(); ++j)
-         {
-            sum += input[j] * this->weights[i][j];
-         }
+   /********************************************************************************
+   * feedforward: Berknar nya utsignaler fr varje nod i angivet dense-lager via
+   *              angivna insignaler och lagrar dessa i angiven buffert i stllet
+   *              fr i lagrets egen vektor output. Lagret ndras drmed inte,
+   *              vilket gr att flera trdar kan anvnda samma lager samtidigt.
+   *
+   *              - input  : Pekare till de nya insignalerna.
+   *              - size   : Antalet insignaler.
+   *              - outputs: Pekare till buffert dr utsignalerna lagras, vilken
+   *                         mste rymma num_nodes() flyttal.
+   ********************************************************************************/
+   void feedforward(const T* input,
+                    const std::size_t size,
+                    T* outputs) const
+   {
+      feedforward(this->weights, this->bias.data(), input, size, outputs, this->activation);
+      return;
+   }
+
+   /********************************************************************************
+   * feedforward: Berknar utsignaler via angivna vikter och bias, vilka inte
+   *              behver tillhra ett dense-lager, exempelvis vikter lagrade i
+   *              en minnesmappad modellfil. Antalet noder utgrs av antalet
+   *              rader i viktmatrisen.
+   *
+   *              - weights   : Vy ver vikterna, en rad per nod.
+   *              - bias      : Pekare till nodernas bias.
+   *              - input     : Pekare till insignalerna.
+   *              - size      : Antalet insignaler.
+   *              - outputs   : Pekare till buffert dr utsignalerna lagras.
+   *              - activation: Aktiveringsfunktion (default = ReLU).
+   ********************************************************************************/
+   static void feedforward(const basic_matrix_view<T>& weights,
+                           const T* bias,
+                           const T* input,
+                           const std::size_t size,
+                           T* outputs,
+                           const activation_function activation = activation_function::relu)
+   {
+      ANN_INSTRUMENT_SCOPE(layer_feedforward, 1);
+      const auto& kernels = kernels_type::get();
+      const auto num_inputs = weights.columns() < size ? weights.columns() : size;
 
-         this->output[i] = this->relu(sum);
+      for (std::size_t i = 0; i < weights.rows(); ++i)
+      {
+         outputs[i] = bias[i] + kernels.dot(input, weights[i], num_inputs);
       }
 
+      activation_type::activate(activation, outputs, weights.rows());
       return;
    }
 
@@ -200,17 +683,40 @@ struct dense_layer
    *                r avsedd enbart fr utgngslager, se den alternativa
    *                medlemsfunktionen med samma namn fr dolda lager.
    * 
+   *                Returnerar summan av de kvadrerade avvikelserna.
+   * 
    *                - reference: Referens till vektor innehllande referensvrden.
    ********************************************************************************/
-   void backpropagate(const std::vector<double>& reference)
+   T backpropagate(const std::vector<T>& reference)
+   {
+      return this->backpropagate(reference.data());
+   }
+
+   /********************************************************************************
+   * backpropagate: Berknar fel/avvikelser i angivet utgngslager via
+   *                referensvrden lagrade p angiven adress, exempelvis en rad
+   *                i en matris. OBS! Denna medlemsfunktion r avsedd enbart fr
+   *                utgngslager. Returnerar summan av de kvadrerade
+   *                avvikelserna (innan derivatan av aktiveringsfunktionen
+   *                tas i tanke), vilket anvnds fr att berkna frlusten
+   *                vid trning utan extra genomrkning.
+   *
+   *                - reference: Pekare till referensvrdena, vilka mste
+   *                             innehlla num_nodes() flyttal.
+   ********************************************************************************/
+   T backpropagate(const T* reference)
    {
+      ANN_INSTRUMENT_SCOPE(layer_backpropagate, 1);
+      auto loss = T(0);
+
       for (std::size_t i = 0; i < this->num_nodes(); ++i)
       {
-         const auto dev = reference[i] - this->output[i];
-         this->error[i] = dev * delta_relu(this->output[i]);
+         this->error[i] = reference[i] - this->output[i];
+         loss += this->error[i] * this->error[i];
       }
 
-      return;
+      activation_type::derivative(this->activation, this->error.data(), this->output.data(), this->num_nodes());
+      return loss;
    }
 
    /********************************************************************************
@@ -219,22 +725,137 @@ struct dense_layer
    *                r avsedd enbart fr dolda lager, se den alternativa
    *                medlemsfunktionen med samma namn fr utgngslager.
    *
+   *                Nsta lagers vikter lses radvis, dr felet fr nod j i
+   *                nsta lager multipliceras med samtliga vikter p rad j och
+   *                adderas till respektive nods fel i detta lager. Drmed lses
+   *                viktmatrisen sekventiellt i stllet fr kolumnvis. Om nsta
+   *                lager har en aktuell transponerad kopia av vikterna, se
+   *                medlemsfunktionen set_transposed, berknas i stllet varje
+   *                nods fel som skalrprodukten mellan nsta lagers fel och
+   *                motsvarande rad i kopian, vilket gr att varje fel enbart
+   *                skrivs en gng.
+   *
    *                - next_layer: Referens till nsta/efterfljande dense-lager.
    ********************************************************************************/
-   void backpropagate(const dense_layer& next_layer)
+   void backpropagate(const basic_dense_layer& next_layer)
    {
+      ANN_INSTRUMENT_SCOPE(layer_backpropagate, 1);
+      const auto& kernels = kernels_type::get();
+      const auto num_nodes = this->num_nodes() < next_layer.num_weights() ? this->num_nodes() : next_layer.num_weights();
+
       for (std::size_t i = 0; i < this->num_nodes(); ++i)
       {
-         auto sum = 0.0;
+         this->error[i] = T(0);
+      }
 
+      if (next_layer.is_transposed_current())
+      {
+         for (std::size_t i = 0; i < num_nodes; ++i)
+         {
+            this->error[i] = kernels.dot(next_layer.error.data(), next_layer.weights_transposed[i],
+                                         next_layer.num_nodes());
+         }
+      }
+      else
+      {
          for (std::size_t j = 0; j < next_layer.num_nodes(); ++j)
          {
-            sum += next_layer.error[j] * next_layer.weights[j][i];
+            kernels.axpy(next_layer.error[j], next_layer.weights[j], this->error.data(), num_nodes);
          }
+      }
+
+      activation_type::derivative(this->activation, this->error.data(), this->output.data(), this->num_nodes());
+      return;
+   }
+
+   /********************************************************************************
+   * backpropagate_optimize: Berknar fel/avvikelser i angivet fregende lager
+   *                         via detta lagers fel och vikter och justerar
+   *                         samtidigt detta lagers bias och vikter, dr
+   *                         fregende lagers utsignaler utgr insignaler.
+   *                         Varje viktrad anvnds frst fr att berkna
+   *                         fregende lagers fel och justeras direkt drefter
+   *                         medan den ligger kvar i cacheminnet, vilket gr att
+   *                         viktmatrisen enbart lses in frn minnet en gng i
+   *                         stllet fr tv. Resultatet blir detsamma som vid
+   *                         anrop av backpropagate fr fregende lager fljt
+   *                         av optimize fr detta lager, d varje rad anvnds
+   *                         fr felberkningen innan den justeras.
+   *
+   *                         - previous     : Referens till fregende dense-lager.
+   *                         - learning_rate: Indikerar hur hg andel av aktuellt
+   *                                          fel som bias och vikter ska justeras.
+   ********************************************************************************/
+   void backpropagate_optimize(basic_dense_layer& previous,
+                               const T learning_rate)
+   {
+      ANN_INSTRUMENT_SCOPE(layer_backpropagate_optimize, 1);
+      const auto& kernels = kernels_type::get();
+      const auto num_inputs = this->num_inputs(previous.num_nodes());
+      const auto previous_error = previous.error.data();
+      const auto previous_output = previous.output.data();
+
+      for (std::size_t i = 0; i < previous.num_nodes(); ++i)
+      {
+         previous_error[i] = T(0);
+      }
+
+      for (std::size_t j = 0; j < this->num_nodes(); ++j)
+      {
+         const auto row = this->weights[j];
+         const auto delta = this->error[j] * learning_rate;
+         kernels.axpy(this->error[j], row, previous_error, num_inputs);
+         this->bias[j] += delta;
+         kernels.axpy(delta, previous_output, row, num_inputs);
+      }
+
+      activation_type::derivative(previous.activation, previous_error, previous_output, previous.num_nodes());
+      this->invalidate_transposed();
+      return;
+   }
+
+   /********************************************************************************
+   * backpropagate_optimize: Berknar fel/avvikelser i angivet fregende lager
+   *                         och justerar samtidigt detta lagers bias och vikter
+   *                         enligt angivna instllningar, dr varje viktrad
+   *                         justeras tillsammans med motsvarande rader med
+   *                         tillstnd. Vid SGD anvnds den vanliga varianten.
+   *
+   *                         - previous: Referens till fregende dense-lager.
+   *                         - update  : Instllningar fr aktuell justering.
+   ********************************************************************************/
+   void backpropagate_optimize(basic_dense_layer& previous,
+                               const update_type& update)
+   {
+      if (update.method == optimizer_method::sgd)
+      {
+         this->backpropagate_optimize(previous, update.rate);
+         return;
+      }
+
+      ANN_INSTRUMENT_SCOPE(layer_backpropagate_optimize, 1);
+      const auto& kernels = kernels_type::get();
+      const auto num_inputs = this->num_inputs(previous.num_nodes());
+      const auto previous_error = previous.error.data();
+      const auto previous_output = previous.output.data();
 
-         this->error[i] = sum * this->delta_relu(this->output[i]);
+      for (std::size_t i = 0; i < previous.num_nodes(); ++i)
+      {
+         previous_error[i] = T(0);
+      }
+
+      for (std::size_t j = 0; j < this->num_nodes(); ++j)
+      {
+         const auto row = this->weights[j];
+         kernels.axpy(this->error[j], row, previous_error, num_inputs);
+         update.apply(row, state_at(this->weight_moment1, j), state_at(this->weight_moment2, j),
+                      previous_output, num_inputs, this->error[j]);
       }
 
+      update.apply(this->bias.data(), state_at(this->bias_moment1), state_at(this->bias_moment2),
+                   this->error.data(), this->num_nodes(), T(1));
+      activation_type::derivative(previous.activation, previous_error, previous_output, previous.num_nodes());
+      this->invalidate_transposed();
       return;
    }
 
@@ -251,63 +872,787 @@ struct dense_layer
    *           - learning_rate: Indikerar hur hg andel av aktuell fel som
    *                            bias och vikter ska justeras.
    ********************************************************************************/
-   void optimize(const std::vector<double>& input,
-                 const double learning_rate)
+   void optimize(const std::vector<T>& input,
+                 const T learning_rate)
    {
-      for (std::size_t i = 0; i < this->num_nodes(); ++i)
-      {
-         this->bias[i] += this->error[i] * learning_rate;
-
-         for (std::size_t j = 0; j < this->num_weights() && j < input.size(); ++j)
-         {
-            this->weights[i][j] += this->error[i] * learning_rate * input[j];
-         }
-      }
-
+      this->optimize(input.data(), input.size(), learning_rate);
       return;
    }
 
-private:
    /********************************************************************************
-   * get_random: Returnerar ett randomiserat flyttal mellan 0.0 - 1.0.
+   * optimize: Justerar bias och vikter i angivet dense-lager via insignaler
+   *           lagrade p angiven adress, exempelvis en rad i en matris.
+   *
+   *           - input        : Pekare till insignalerna.
+   *           - size         : Antalet insignaler.
+   *           - learning_rate: Indikerar hur hg andel av aktuell fel som
+   *                            bias och vikter ska justeras.
    ********************************************************************************/
-   static inline double get_random(void)
+   void optimize(const T* input,
+                 const std::size_t size,
+                 const T learning_rate)
    {
-      return static_cast<double>(std::rand()) / RAND_MAX;
-   }
+      ANN_INSTRUMENT_SCOPE(layer_optimize, 1);
+      const auto& kernels = kernels_type::get();
+      const auto num_inputs = this->num_inputs(size);
+
+      for (std::size_t i = 0; i < this->num_nodes(); ++i)
+      {
+         const auto delta = this->error[i] * learning_rate;
+         this->bias[i] += delta;
+         kernels.axpy(delta, input, this->weights[i], num_inputs);
+      }
+
+      this->invalidate_transposed();
+      return;
+   }
 
    /********************************************************************************
-   * relu: Implementerar en ReLU-funktion, dr utsignalen y stts till angiven
-   *       summa sum om denna summa verstiger 0, annars stts utsignalen till 0.
-   *       Utsignalen y returneras efter berkning. Om summan verstiger 0 s r 
-   *       aktuell nod aktiverad, annars r den inaktiverad:
-   * 
-   *       sum > 0  => y = sum (noden aktiverad)
-   *       sum <= 0 => y = 0   (noden inaktiverad)
-   * 
-   *       - sum: Summan av nodens bias samt  indata (insignaler * vikter).
+   * optimize: Justerar bias och vikter i angivet dense-lager via insignaler
+   *           lagrade p angiven adress enligt angivna instllningar. Vid SGD
+   *           anvnds den vanliga varianten.
+   *
+   *           - input : Pekare till insignalerna.
+   *           - size  : Antalet insignaler.
+   *           - update: Instllningar fr aktuell justering.
+   ********************************************************************************/
+   void optimize(const T* input,
+                 const std::size_t size,
+                 const update_type& update)
+   {
+      if (update.method == optimizer_method::sgd)
+      {
+         this->optimize(input, size, update.rate);
+         return;
+      }
+
+      ANN_INSTRUMENT_SCOPE(layer_optimize, 1);
+      const auto num_inputs = this->num_inputs(size);
+
+      for (std::size_t i = 0; i < this->num_nodes(); ++i)
+      {
+         update.apply(this->weights[i], state_at(this->weight_moment1, i), state_at(this->weight_moment2, i),
+                      input, num_inputs, this->error[i]);
+      }
+
+      update.apply(this->bias.data(), state_at(this->bias_moment1), state_at(this->bias_moment2),
+                   this->error.data(), this->num_nodes(), T(1));
+      this->invalidate_transposed();
+      return;
+   }
+
+   /********************************************************************************
+   * feedforward: Berknar nya utsignaler fr samtliga trningsexempel i angiven
+   *              batch, dr varje rad i matrisen input utgr insignalerna fr
+   *              ett trningsexempel. Resultatet lagras radvis i batch_output.
+   *
+   *              - input      : Referens till matris med insignaler, en rad per
+   *                             trningsexempel.
+   *              - num_samples: Antalet trningsexempel i aktuell batch.
+   ********************************************************************************/
+   void feedforward(const matrix_type& input,
+                    const std::size_t num_samples)
+   {
+      this->feedforward(input, num_samples, this->batch_output);
+      return;
+   }
+
+   /********************************************************************************
+   * feedforward: Berknar nya utsignaler fr samtliga trningsexempel i angiven
+   *              batch och lagrar dessa radvis i angiven matris, vilket gr att
+   *              flera trdar kan anvnda samma lager med egna buffertar.
+   *              Berkningen motsvarar matrismultiplikationen input * weights^T,
+   *              dr den yttre loopen gr ver lagrets noder s att varje rad
+   *              i viktmatrisen teranvnds fr hela batchen medan den ligger
+   *              kvar i cacheminnet. Fr stora lager, vars viktmatris inte ryms
+   *              i cacheminnet, anvnds i stllet blockad matrismultiplikation
+   *              via klasstemplaten basic_gemm.
+   *
+   *              - input      : Referens till matris med insignaler, en rad per
+   *                             trningsexempel.
+   *              - num_samples: Antalet trningsexempel i aktuell batch.
+   *              - outputs    : Referens till matris dr utsignalerna lagras.
+   ********************************************************************************/
+   void feedforward(const matrix_type& input,
+                    const std::size_t num_samples,
+                    matrix_type& outputs) const
+   {
+      this->feedforward(input.data(), input.stride(), input.columns(), num_samples,
+                        outputs.data(), outputs.stride());
+      return;
+   }
+
+   /********************************************************************************
+   * feedforward: Berknar nya utsignaler fr samtliga trningsexempel i angiven
+   *              batch, dr bde in- och utsignaler lagras radvis i godtyckliga
+   *              buffertar med angivet avstnd (stride) mellan raderna.
+   *
+   *              - input        : Pekare till den frsta radens insignaler.
+   *              - input_stride : Avstndet mellan tv rader med insignaler.
+   *              - size         : Antalet insignaler per rad.
+   *              - num_samples  : Antalet rader (trningsexempel).
+   *              - outputs      : Pekare till den frsta radens utsignaler.
+   *              - output_stride: Avstndet mellan tv rader med utsignaler.
+   ********************************************************************************/
+   void feedforward(const T* input,
+                    const std::size_t input_stride,
+                    const std::size_t size,
+                    const std::size_t num_samples,
+                    T* outputs,
+                    const std::size_t output_stride) const
+   {
+      feedforward(this->weights, this->bias.data(), input, input_stride, size,
+                  num_samples, outputs, output_stride, this->activation);
+      return;
+   }
+
+   /********************************************************************************
+   * feedforward: Berknar utsignaler fr samtliga exempel i angiven batch via
+   *              angivna vikter och bias, vilka inte behver tillhra ett
+   *              dense-lager, exempelvis vikter lagrade i en minnesmappad
+   *              modellfil.
+   *
+   *              - weights      : Vy ver vikterna, en rad per nod.
+   *              - bias         : Pekare till nodernas bias.
+   *              - input        : Pekare till den frsta radens insignaler.
+   *              - input_stride : Avstndet mellan tv rader med insignaler.
+   *              - size         : Antalet insignaler per rad.
+   *              - num_samples  : Antalet rader (exempel).
+   *              - outputs      : Pekare till den frsta radens utsignaler.
+   *              - output_stride: Avstndet mellan tv rader med utsignaler.
+   *              - activation   : Aktiveringsfunktion (default = ReLU).
    ********************************************************************************/
-   static inline double relu(const double sum)
+   static void feedforward(const basic_matrix_view<T>& weights,
+                           const T* bias,
+                           const T* input,
+                           const std::size_t input_stride,
+                           const std::size_t size,
+                           const std::size_t num_samples,
+                           T* outputs,
+                           const std::size_t output_stride,
+                           const activation_function activation = activation_function::relu)
    {
-      return sum > 0.0 ? sum : 0.0;
+      ANN_INSTRUMENT_SCOPE(layer_feedforward, num_samples);
+      const auto& kernels = kernels_type::get();
+      const auto num_inputs = weights.columns() < size ? weights.columns() : size;
+
+      if (gemm_type::is_worthwhile(num_samples, weights.rows(), num_inputs))
+      {
+         for (std::size_t k = 0; k < num_samples; ++k)
+         {
+            std::copy(bias, bias + weights.rows(), outputs + k * output_stride);
+         }
+
+         gemm_type::multiply_transposed(input, input_stride, weights.data(), weights.stride(),
+                                        outputs, output_stride, num_samples, weights.rows(), num_inputs);
+      }
+      else
+      {
+         for (std::size_t i = 0; i < weights.rows(); ++i)
+         {
+            const auto row = weights[i];
+
+            for (std::size_t k = 0; k < num_samples; ++k)
+            {
+               outputs[k * output_stride + i] = bias[i] + kernels.dot(input + k * input_stride, row, num_inputs);
+            }
+         }
+      }
+
+      for (std::size_t k = 0; k < num_samples; ++k)
+      {
+         activation_type::activate(activation, outputs + k * output_stride, weights.rows());
+      }
+
+      return;
    }
 
    /********************************************************************************
-   * delta_relu: Implementerar en funktion fr att berkna derivatan av 
-   *             ReLU-funktionen, dr utsignalen dy stts till 1.0 om angiven nod
-   *             r aktiverad, vilket kontrolleras via ingende argument output,
-   *             som utgrs av nodens aktuella utsignal. Annars returneras 0.0.
-   *             Via detta vrde rknas endast fel/avvikelser p aktiverade noder,
-   *             vilket ocks medfr att enbart aktiverade noder justeras vid
-   *             optimering. Utsignal dy returneras vid terhopp enligt nedan:
+   * backpropagate: Berknar fel/avvikelser i angivet utgngslager fr samtliga
+   *                trningsexempel i angiven batch via referensvrden lagrade
+   *                radvis i matrisen reference. OBS! Denna medlemsfunktion r
+   *                avsedd enbart fr utgngslager. Returnerar summan av de
+   *                kvadrerade avvikelserna fr samtliga trningsexempel.
    *
-   *             output > 0  => dy = 1 (noden aktiverad, fel berknas)
-   *             output <= 0 => dy = 0 (noden inaktiverad, fel berknas inte)
+   *                - reference  : Referens till matris innehllande referensvrden,
+   *                               en rad per trningsexempel.
+   *                - num_samples: Antalet trningsexempel i aktuell batch.
    ********************************************************************************/
-   static inline double delta_relu(const double output)
+   T backpropagate(const matrix_type& reference,
+                   const std::size_t num_samples)
    {
-      return output > 0.0 ? 1.0 : 0.0;
+      return this->backpropagate(reference, num_samples, this->batch_output, this->batch_error);
+   }
+
+   /********************************************************************************
+   * backpropagate: Berknar fel/avvikelser i angivet utgngslager fr samtliga
+   *                trningsexempel i angiven batch via angivna buffertar fr
+   *                lagrets utsignaler och fel. OBS! Denna medlemsfunktion r
+   *                avsedd enbart fr utgngslager. Returnerar summan av de
+   *                kvadrerade avvikelserna fr samtliga trningsexempel.
+   *
+   *                - reference  : Referens till matris innehllande referensvrden,
+   *                               en rad per trningsexempel.
+   *                - num_samples: Antalet trningsexempel i aktuell batch.
+   *                - outputs    : Referens till matris med lagrets utsignaler.
+   *                - errors     : Referens till matris dr lagrets fel lagras.
+   ********************************************************************************/
+   T backpropagate(const matrix_type& reference,
+                   const std::size_t num_samples,
+                   const matrix_type& outputs,
+                   matrix_type& errors) const
+   {
+      ANN_INSTRUMENT_SCOPE(layer_backpropagate, num_samples);
+      auto loss = T(0);
+
+      for (std::size_t k = 0; k < num_samples; ++k)
+      {
+         const auto ref = reference[k];
+         const auto out = outputs[k];
+         const auto err = errors[k];
+
+         for (std::size_t i = 0; i < this->num_nodes(); ++i)
+         {
+            err[i] = ref[i] - out[i];
+            loss += err[i] * err[i];
+         }
+
+         activation_type::derivative(this->activation, err, out, this->num_nodes());
+      }
+
+      return loss;
+   }
+
+   /********************************************************************************
+   * backpropagate: Berknar fel/avvikelser i angivet dolt lager fr samtliga
+   *                trningsexempel i angiven batch via parametrar frn nsta
+   *                lager. OBS! Denna medlemsfunktion r avsedd enbart fr
+   *                dolda lager.
+   *
+   *                - next_layer : Referens till nsta/efterfljande dense-lager.
+   *                - num_samples: Antalet trningsexempel i aktuell batch.
+   ********************************************************************************/
+   void backpropagate(const basic_dense_layer& next_layer,
+                      const std::size_t num_samples)
+   {
+      this->backpropagate(next_layer, next_layer.batch_error, num_samples,
+                          this->batch_output, this->batch_error);
+      return;
+   }
+
+   /********************************************************************************
+   * backpropagate: Berknar fel/avvikelser i angivet dolt lager fr samtliga
+   *                trningsexempel i angiven batch via nsta lagers vikter samt
+   *                angivna buffertar, vilket motsvarar matrismultiplikationen
+   *                next_error * next_layer.weights. Den yttre loopen gr ver
+   *                nsta lagers noder, s att varje viktrad lses en gng per
+   *                batch. Fr stora lager anvnds i stllet blockad
+   *                matrismultiplikation via klasstemplaten basic_gemm. Om nsta
+   *                lager har en aktuell transponerad kopia av vikterna berknas
+   *                produkten i vriga fall som next_error * weights_transposed^T
+   *                via skalrprodukter, dr varje rad i kopian teranvnds fr
+   *                hela batchen p samma stt som vid framtpropagering.
+   *                OBS! Denna medlemsfunktion r avsedd enbart fr dolda lager.
+   *
+   *                - next_layer : Referens till nsta/efterfljande dense-lager.
+   *                - next_error : Referens till matris med nsta lagers fel.
+   *                - num_samples: Antalet trningsexempel i aktuell batch.
+   *                - outputs    : Referens till matris med lagrets utsignaler.
+   *                - errors     : Referens till matris dr lagrets fel lagras.
+   ********************************************************************************/
+   void backpropagate(const basic_dense_layer& next_layer,
+                      const matrix_type& next_error,
+                      const std::size_t num_samples,
+                      const matrix_type& outputs,
+                      matrix_type& errors) const
+   {
+      ANN_INSTRUMENT_SCOPE(layer_backpropagate, num_samples);
+      const auto& kernels = kernels_type::get();
+      const auto num_nodes = this->num_nodes() < next_layer.num_weights() ? this->num_nodes() : next_layer.num_weights();
+
+      for (std::size_t k = 0; k < num_samples; ++k)
+      {
+         const auto err = errors[k];
+
+         for (std::size_t i = 0; i < this->num_nodes(); ++i)
+         {
+            err[i] = T(0);
+         }
+      }
+
+      if (gemm_type::is_worthwhile(num_samples, num_nodes, next_layer.num_nodes()))
+      {
+         gemm_type::multiply(next_error.data(), next_error.stride(), next_layer.weights.data(),
+                             next_layer.weights.stride(), errors.data(), errors.stride(),
+                             num_samples, num_nodes, next_layer.num_nodes());
+      }
+      else if (next_layer.is_transposed_current())
+      {
+         for (std::size_t i = 0; i < num_nodes; ++i)
+         {
+            const auto row = next_layer.weights_transposed[i];
+
+            for (std::size_t k = 0; k < num_samples; ++k)
+            {
+               errors[k][i] = kernels.dot(next_error[k], row, next_layer.num_nodes());
+            }
+         }
+      }
+      else
+      {
+         for (std::size_t j = 0; j < next_layer.num_nodes(); ++j)
+         {
+            const auto next_weights = next_layer.weights[j];
+
+            for (std::size_t k = 0; k < num_samples; ++k)
+            {
+               kernels.axpy(next_error[k][j], next_weights, errors[k], num_nodes);
+            }
+         }
+      }
+
+      for (std::size_t k = 0; k < num_samples; ++k)
+      {
+         activation_type::derivative(this->activation, errors[k], outputs[k], this->num_nodes());
+      }
+
+      return;
+   }
+
+   /********************************************************************************
+   * optimize: Justerar bias och vikter i angivet dense-lager en gng fr hela
+   *           angiven batch. Justeringen utgrs av medelvrdet av samtliga
+   *           trningsexempels bidrag, vilket motsvarar matrismultiplikationen
+   *           batch_error^T * input skalad med learning_rate / num_samples.
+   *           Drmed skrivs varje vikt endast en gng per batch.
+   *
+   *           - input        : Referens till matris innehllande insignaler,
+   *                            en rad per trningsexempel.
+   *           - num_samples  : Antalet trningsexempel i aktuell batch.
+   *           - learning_rate: Indikerar hur hg andel av aktuell fel som
+   *                            bias och vikter ska justeras.
+   ********************************************************************************/
+   void optimize(const matrix_type& input,
+                 const std::size_t num_samples,
+                 const T learning_rate)
+   {
+      this->optimize(input, this->batch_error, num_samples, learning_rate);
+      this->invalidate_transposed();
+      return;
+   }
+
+   /********************************************************************************
+   * optimize: Justerar bias och vikter i angivet dense-lager en gng fr hela
+   *           angiven batch via angivna fel i stllet fr batch_error, vilket
+   *           gr att flera trdar kan justera samma lager via egna buffertar.
+   *           Ingen synkronisering sker, varfr samtidiga justeringar frn
+   *           olika trdar kan skriva ver varandras bidrag, se
+   *           medlemsfunktionen train_hogwild i klassen ann. Av samma
+   *           anledning markeras den transponerade kopian inte som inaktuell,
+   *           vilket anroparen i stllet mste gra en gng via
+   *           invalidate_transposed, s att trdarna aldrig skriver flaggan.
+   *
+   *           - input        : Referens till matris innehllande insignaler,
+   *                            en rad per trningsexempel.
+   *           - errors       : Referens till matris med lagrets fel, en rad
+   *                            per trningsexempel.
+   *           - num_samples  : Antalet trningsexempel i aktuell batch.
+   *           - learning_rate: Indikerar hur hg andel av aktuell fel som
+   *                            bias och vikter ska justeras.
+   ********************************************************************************/
+   void optimize(const matrix_type& input,
+                 const matrix_type& errors,
+                 const std::size_t num_samples,
+                 const T learning_rate)
+   {
+      ANN_INSTRUMENT_SCOPE(layer_optimize, num_samples);
+      if (num_samples == 0) return;
+      const auto& kernels = kernels_type::get();
+      const auto num_inputs = this->num_inputs(input.columns());
+      const auto rate = learning_rate / num_samples;
+
+      for (std::size_t i = 0; i < this->num_nodes(); ++i)
+      {
+         const auto row = this->weights[i];
+         T bias_sum = 0;
+
+         for (std::size_t k = 0; k < num_samples; ++k)
+         {
+            const auto delta = errors[k][i] * rate;
+            bias_sum += delta;
+            kernels.axpy(delta, input[k], row, num_inputs);
+         }
+
+         this->bias[i] += bias_sum;
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * optimize: Justerar bias och vikter i angivet dense-lager en gng fr hela
+   *           angiven batch enligt angivna instllningar. Varje nods bidrag
+   *           summeras frst i gradient_buffer, varefter nodens vikter och
+   *           tillstnd justeras med bidragens medelvrde. Vid SGD anvnds den
+   *           vanliga varianten.
+   *
+   *           - input      : Referens till matris innehllande insignaler,
+   *                          en rad per trningsexempel.
+   *           - num_samples: Antalet trningsexempel i aktuell batch.
+   *           - update     : Instllningar fr aktuell justering.
+   ********************************************************************************/
+   void optimize(const matrix_type& input,
+                 const std::size_t num_samples,
+                 const update_type& update)
+   {
+      if (update.method == optimizer_method::sgd)
+      {
+         this->optimize(input, num_samples, update.rate);
+         return;
+      }
+
+      ANN_INSTRUMENT_SCOPE(layer_optimize, num_samples);
+      if (num_samples == 0) return;
+      const auto& kernels = kernels_type::get();
+      const auto num_inputs = this->num_inputs(input.columns());
+      const auto scale = T(1) / num_samples;
+      const auto buffer = this->gradient_buffer.data();
+
+      for (std::size_t i = 0; i < this->num_nodes(); ++i)
+      {
+         T bias_sum = 0;
+
+         for (std::size_t j = 0; j < num_inputs; ++j)
+         {
+            buffer[j] = T(0);
+         }
+
+         for (std::size_t k = 0; k < num_samples; ++k)
+         {
+            bias_sum += this->batch_error[k][i];
+            kernels.axpy(this->batch_error[k][i], input[k], buffer, num_inputs);
+         }
+
+         update.apply(this->weights[i], state_at(this->weight_moment1, i), state_at(this->weight_moment2, i),
+                      buffer, num_inputs, scale);
+         update.apply(&this->bias[i], state_at(this->bias_moment1, i), state_at(this->bias_moment2, i),
+                      &bias_sum, 1, scale);
+      }
+
+      this->invalidate_transposed();
+      return;
+   }
+
+   /********************************************************************************
+   * gradient: Berknar summan av samtliga trningsexempels bidrag till
+   *           justeringen av bias och vikter fr angiven batch, utan att
+   *           lagrets parametrar ndras. Resultatet skrivs ver till angivna
+   *           buffertar och kan sedan lggas till parametrarna via
+   *           medlemsfunktionen apply_gradient, exempelvis efter att flera
+   *           trdars bidrag har berknats parallellt.
+   *
+   *           - input          : Referens till matris innehllande insignaler,
+   *                              en rad per trningsexempel.
+   *           - errors         : Referens till matris med lagrets fel.
+   *           - num_samples    : Antalet trningsexempel i aktuell batch.
+   *           - weight_gradient: Referens till matris dr viktbidragen lagras,
+   *                              vilken mste ha samma storlek som weights.
+   *           - bias_gradient  : Referens till vektor dr biasbidragen lagras.
+   ********************************************************************************/
+   void gradient(const matrix_type& input,
+                 const matrix_type& errors,
+                 const std::size_t num_samples,
+                 matrix_type& weight_gradient,
+                 std::vector<T>& bias_gradient) const
+   {
+      ANN_INSTRUMENT_SCOPE(layer_optimize, num_samples);
+      const auto& kernels = kernels_type::get();
+      const auto num_inputs = this->num_inputs(input.columns());
+
+      for (std::size_t i = 0; i < this->num_nodes(); ++i)
+      {
+         const auto row = weight_gradient[i];
+         T bias_sum = 0;
+
+         for (std::size_t j = 0; j < this->num_weights(); ++j)
+         {
+            row[j] = T(0);
+         }
+
+         for (std::size_t k = 0; k < num_samples; ++k)
+         {
+            bias_sum += errors[k][i];
+            kernels.axpy(errors[k][i], input[k], row, num_inputs);
+         }
+
+         bias_gradient[i] = bias_sum;
+      }
+
+      return;
+   }
+
+   /********************************************************************************
+   * apply_gradient: Lgger till angivna bidrag, skalade med angiven faktor, till
+   *                 bias och vikter fr noderna i intervallet [first_node,
+   *                 last_node). Genom att dela upp noderna i disjunkta intervall
+   *                 kan flera trdar justera samma lager samtidigt. Eventuell
+   *                 transponerad kopia av vikterna uppdateras inte, utan br
+   *                 uppdateras fr samma intervall via update_transposed.
+   *
+   *                 - weight_gradient: Referens till matris med viktbidrag.
+   *                 - bias_gradient  : Referens till vektor med biasbidrag.
+   *                 - rate           : Skalfaktor, exempelvis lrhastigheten
+   *                                    dividerat med antalet trningsexempel.
+   *                 - first_node     : Index fr den frsta noden som justeras.
+   *                 - last_node      : Index efter den sista noden som justeras.
+   ********************************************************************************/
+   void apply_gradient(const matrix_type& weight_gradient,
+                       const std::vector<T>& bias_gradient,
+                       const T rate,
+                       const std::size_t first_node,
+                       const std::size_t last_node)
+   {
+      ANN_INSTRUMENT_SCOPE(layer_optimize, 0);
+      const auto& kernels = kernels_type::get();
+
+      for (std::size_t i = first_node; i < last_node && i < this->num_nodes(); ++i)
+      {
+         this->bias[i] += bias_gradient[i] * rate;
+         kernels.axpy(rate, weight_gradient[i], this->weights[i], this->num_weights());
+      }
+
+      return;
+   }
+
+   /********************************************************************************
+   * apply_gradient: Justerar bias och vikter fr noderna i intervallet
+   *                 [first_node, last_node) via angivna bidrag enligt angivna
+   *                 instllningar. Tillstnden fr varje nod ligger p samma
+   *                 rad som nodens vikter, vilket gr att disjunkta intervall
+   *                 ven hr kan justeras av olika trdar samtidigt. Vid SGD
+   *                 anvnds den vanliga varianten. Liksom dr uppdateras inte
+   *                 eventuell transponerad kopia, vilket anroparen ansvarar fr.
+   *
+   *                 - weight_gradient: Referens till matris med viktbidrag.
+   *                 - bias_gradient  : Referens till vektor med biasbidrag.
+   *                 - scale          : Skalfaktor fr bidragen, exempelvis 1
+   *                                    dividerat med antalet trningsexempel.
+   *                 - update         : Instllningar fr aktuell justering.
+   *                 - first_node     : Index fr den frsta noden som justeras.
+   *                 - last_node      : Index efter den sista noden som justeras.
+   ********************************************************************************/
+   void apply_gradient(const matrix_type& weight_gradient,
+                       const std::vector<T>& bias_gradient,
+                       const T scale,
+                       const update_type& update,
+                       const std::size_t first_node,
+                       const std::size_t last_node)
+   {
+      if (update.method == optimizer_method::sgd)
+      {
+         this->apply_gradient(weight_gradient, bias_gradient, update.rate * scale, first_node, last_node);
+         return;
+      }
+
+      ANN_INSTRUMENT_SCOPE(layer_optimize, 0);
+
+      for (std::size_t i = first_node; i < last_node && i < this->num_nodes(); ++i)
+      {
+         update.apply(this->weights[i], state_at(this->weight_moment1, i), state_at(this->weight_moment2, i),
+                      weight_gradient[i], this->num_weights(), scale);
+         update.apply(&this->bias[i], state_at(this->bias_moment1, i), state_at(this->bias_moment2, i),
+                      &bias_gradient[i], 1, scale);
+      }
+
+      return;
+   }
+
+private:
+   bool transposed_stale_{true}; /* Indikerar ifall weights_transposed r inaktuell. */
+
+   /********************************************************************************
+   * num_inputs: Returnerar antalet insignaler som ska anvndas vid berkning,
+   *             vilket utgrs av det minsta av antalet vikter per nod samt
+   *             antalet passerade insignaler. Grnsen berknas en gng innan
+   *             looparna i stllet fr vid varje iteration, vilket gr att
+   *             looparna kan vektoriseras.
+   *
+   *             - num_values: Antalet passerade insignaler.
+   ********************************************************************************/
+   inline std::size_t num_inputs(const std::size_t num_values) const
+   {
+      return this->num_weights() < num_values ? this->num_weights() : num_values;
+   }
+
+   /********************************************************************************
+   * matrices: Returnerar pekare till lagrets matriser i den ordning som de
+   *           placeras i en arena.
+   ********************************************************************************/
+   std::array<matrix_type*, 6> matrices(void)
+   {
+      return { &this->weights, &this->weights_transposed, &this->batch_output,
+               &this->batch_error, &this->weight_moment1, &this->weight_moment2 };
+   }
+
+   /********************************************************************************
+   * matrices: Returnerar pekare till lagrets matriser i den ordning som de
+   *           placeras i en arena.
+   ********************************************************************************/
+   std::array<const matrix_type*, 6> matrices(void) const
+   {
+      return { &this->weights, &this->weights_transposed, &this->batch_output,
+               &this->batch_error, &this->weight_moment1, &this->weight_moment2 };
+   }
+
+   /********************************************************************************
+   * resize_state: Allokerar angivna tillstnd fr vikter och bias med samma
+   *               storlek som lagrets parametrar, alternativt tmmer dem om
+   *               tillstnden inte anvnds.
+   *
+   *               - weight_state: Referens till vikternas tillstnd.
+   *               - bias_state  : Referens till biasvrdenas tillstnd.
+   *               - used        : Indikerar ifall tillstnden anvnds.
+   ********************************************************************************/
+   void resize_state(matrix_type& weight_state,
+                     std::vector<T>& bias_state,
+                     const bool used)
+   {
+      const auto num_nodes = used ? this->num_nodes() : 0;
+      const auto num_weights = used ? this->num_weights() : 0;
+
+      if (weight_state.rows() != num_nodes || weight_state.columns() != num_weights)
+      {
+         weight_state.resize(num_nodes, num_weights, T(0));
+         bias_state.assign(num_nodes, T(0));
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * state_at: Returnerar en pekare till angiven rad i angivna tillstnd,
+   *           alternativt nullptr om tillstnden inte anvnds.
+   *
+   *           - state: Referens till tillstnden.
+   *           - row  : Radens index.
+   ********************************************************************************/
+   static inline T* state_at(matrix_type& state,
+                             const std::size_t row)
+   {
+      return row < state.rows() ? state[row] : nullptr;
+   }
+
+   /********************************************************************************
+   * state_at: Returnerar en pekare till angivet element i angivna tillstnd,
+   *           alternativt nullptr om tillstnden inte anvnds.
+   *
+   *           - state: Referens till tillstnden.
+   *           - index: Elementets index (default = 0).
+   ********************************************************************************/
+   static inline T* state_at(std::vector<T>& state,
+                             const std::size_t index = 0)
+   {
+      return index < state.size() ? state.data() + index : nullptr;
    }
 };
 
+/********************************************************************************
+* basic_inference_context: Buffertar fr prediktion via en fljd av dense-lager
+*                          utan att lagren ndras, exempelvis via de konstanta
+*                          varianterna av medlemsfunktionerna predict och
+*                          predict_batch i klassen ann. Varje trd som genomfr
+*                          prediktion br ha en egen instans, vilket gr att
+*                          flera trdar kan dela samma trnade ntverk. Skapas
+*                          lmpligen via medlemsfunktionen make_inference_context,
+*                          varefter ingen ytterligare allokering sker vid
+*                          prediktion.
+*
+*                          De dolda lagren skriver vxelvis till tv buffertar
+*                          (ping-pong), dr lager i skriver till buffert i % 2
+*                          och lser fregende lagers utsignaler frn den
+*                          andra bufferten, medan utgngslagret skriver till en
+*                          egen buffert. Buffertarna rymmer det bredaste dolda
+*                          lagret, vilket gr att minnesbehovet r oberoende av
+*                          antalet lager och att samma buffertar teranvnds
+*                          av samtliga lager, s att de frblir i cacheminnet.
+********************************************************************************/
+template <typename T>
+struct basic_inference_context
+{
+   std::array<std::vector<T>, 2> activations;        /* Dolda lagers utsignaler, anvnds vxelvis. */
+   std::vector<T> output;                            /* Utgngslagrets utsignaler. */
+   std::array<basic_matrix<T>, 2> batch_activations; /* Dolda lagers utsignaler vid batchprediktion. */
+   std::size_t batch_size{0};                        /* Antalet exempel per omgng vid batchprediktion. */
+
+   /********************************************************************************
+   * prepare: Kontrollerar att buffertarna har rtt storlek fr angivet antal
+   *          lager och allokerar om dem annars. Vid upprepade anrop fr samma
+   *          ntverk sker drmed ingen allokering.
+   *
+   *          - num_layers : Antalet lager (dolda lager samt utgngslagret).
+   *          - num_samples: Antalet exempel som batchbuffertarna ska rymma.
+   *          - num_nodes  : Funktion som returnerar antalet noder i lager i.
+   ********************************************************************************/
+   template <typename NumNodes>
+   void prepare(const std::size_t num_layers,
+                const std::size_t num_samples,
+                NumNodes&& num_nodes)
+   {
+      std::size_t width = 0;
+      const std::size_t num_outputs = num_layers > 0 ? num_nodes(num_layers - 1) : 0;
+      this->batch_size = num_samples;
+
+      for (std::size_t i = 0; i + 1 < num_layers; ++i)
+      {
+         const std::size_t size = num_nodes(i);
+         if (size > width) width = size;
+      }
+
+      for (auto& buffer : this->activations)
+      {
+         if (width > buffer.capacity()) ANN_INSTRUMENT_ALLOCATION(width * sizeof(T));
+         if (buffer.size() != width) buffer.assign(width, T(0));
+      }
+
+      if (num_outputs > this->output.capacity()) ANN_INSTRUMENT_ALLOCATION(num_outputs * sizeof(T));
+      if (this->output.size() != num_outputs) this->output.assign(num_outputs, T(0));
+
+      for (auto& buffer : this->batch_activations)
+      {
+         if (buffer.rows() != num_samples || buffer.columns() != width)
+         {
+            buffer.resize(num_samples, width, T(0));
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * target: Returnerar en pekare till bufferten som angivet lager skriver sina
+   *         utsignaler till vid prediktion med ett exempel.
+   *
+   *         - layer     : Index fr aktuellt lager.
+   *         - num_layers: Antalet lager (dolda lager samt utgngslagret).
+   ********************************************************************************/
+   T* target(const std::size_t layer,
+             const std::size_t num_layers)
+   {
+      return layer + 1 == num_layers ? this->output.data() : this->activations[layer % 2].data();
+   }
+
+   /********************************************************************************
+   * batch_target: Returnerar en referens till bufferten som angivet dolt lager
+   *               skriver sina utsignaler till vid batchprediktion.
+   *
+   *               - layer: Index fr aktuellt dolt lager.
+   ********************************************************************************/
+   basic_matrix<T>& batch_target(const std::size_t layer)
+   {
+      return this->batch_activations[layer % 2];
+   }
+};
+
+/********************************************************************************
+* dense_layer: Dense-lager med parametrar av typen double.
+********************************************************************************/
+using dense_layer = basic_dense_layer<double>;
+
 #endif /* DENSE_LAYER_HPP_ */
\ No newline at end of file
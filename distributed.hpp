@@ -0,0 +1,604 @@
+/********************************************************************************
+* distributed.hpp: Innehller kommunikation mellan flera processer vid
+*                  distribuerad trning via klassen tcp_communicator, dr
+*                  processerna kopplas samman i en ring via TCP och summerar
+*                  exempelvis lagrens viktbidrag via ring-allreduce. Om
+*                  makrot ANN_USE_MPI r definierat finns ven klassen
+*                  mpi_communicator, vilken i stllet anvnder MPI_Allreduce.
+*                  Bda klasserna kan anvndas vid trning via
+*                  medlemsfunktionen train_distributed i klassen ann.
+********************************************************************************/
+#ifndef DISTRIBUTED_HPP_
+#define DISTRIBUTED_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef ANN_USE_MPI
+#include <mpi.h>
+#endif
+
+/********************************************************************************
+* tcp_communicator: Klass fr kommunikation mellan ett fast antal processer,
+*                   dr varje process har ett index (rank) och en adress p
+*                   formatet "vrd:port". Vid anslutning lyssnar varje process
+*                   p sin egen adress och ansluter till nsta process i
+*                   ringen, vilket ger en anslutning till nsta samt en frn
+*                   fregende process.
+*
+*                   Summering sker via ring-allreduce, dr flyttalen delas upp
+*                   i lika mnga delar som antalet processer. Frst summeras
+*                   varje del runt ringen (reduce-scatter), varefter de frdiga
+*                   summorna skickas runt ringen (allgather). Varje process
+*                   skickar och tar drmed emot 2 * (n - 1) / n av flyttalen
+*                   oavsett antalet processer, och samtliga processer erhller
+*                   exakt samma summor, d varje del summeras av en enda
+*                   process. Samtliga processer mste ha samma flyttalstyp och
+*                   byteordning.
+*
+*                   Samtliga funktioner som kommunicerar returnerar false vid
+*                   fel eller om ingen data har tagits emot inom angiven
+*                   tidsgrns, varvid anslutningarna stngs.
+********************************************************************************/
+class tcp_communicator
+{
+public:
+#if defined(_WIN32)
+   using socket_type = SOCKET; /* Typ fr socketar. */
+#else
+   using socket_type = int;    /* Typ fr socketar. */
+#endif
+
+   /********************************************************************************
+   * tcp_communicator: Initierar ny kommunikator utan anslutningar, vilken
+   *                   fungerar som en ensam process.
+   ********************************************************************************/
+   tcp_communicator(void) { }
+
+   tcp_communicator(const tcp_communicator&) = delete;
+   tcp_communicator& operator=(const tcp_communicator&) = delete;
+
+   /********************************************************************************
+   * ~tcp_communicator: Stnger samtliga anslutningar.
+   ********************************************************************************/
+   ~tcp_communicator(void)
+   {
+      this->close();
+      return;
+   }
+
+   /********************************************************************************
+   * connect: Ansluter till vriga processer i ringen, dr samtliga processer
+   *          ska anropa denna medlemsfunktion med samma adresser. Anslutning
+   *          till nsta process upprepas tills den lyckas eller tidsgrnsen
+   *          har passerats, vilket gr att processerna kan startas i valfri
+   *          ordning. Eventuella tidigare anslutningar stngs frst.
+   *          Returnerar true om anslutningarna kunde upprttas, annars false.
+   *
+   *          - rank      : Index fr aktuell process (0 - antalet adresser - 1).
+   *          - addresses : Referens till vektor med samtliga processers
+   *                        adresser p formatet "vrd:port", i rankordning.
+   *          - timeout_ms: Tidsgrns i millisekunder fr anslutning samt
+   *                        fr varje efterfljande verfring (default = 60 s).
+   ********************************************************************************/
+   bool connect(const std::size_t rank,
+                const std::vector<std::string>& addresses,
+                const int timeout_ms = 60000)
+   {
+      this->close();
+      this->failed_ = false;
+      if (rank >= addresses.size()) return false;
+      this->rank_ = rank;
+      this->size_ = addresses.size();
+      this->timeout_ms_ = timeout_ms;
+      if (this->size_ == 1) return true;
+      if (!startup()) return this->fail();
+
+      const auto next = (rank + 1) % this->size_;
+      const auto previous = (rank + this->size_ - 1) % this->size_;
+      this->listener_ = listen_on(addresses[rank]);
+      if (this->listener_ == invalid_socket()) return this->fail();
+
+      const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+      while ((this->next_ = connect_to(addresses[next])) == invalid_socket())
+      {
+         if (std::chrono::steady_clock::now() > deadline) return this->fail();
+         std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      }
+
+      const auto own = static_cast<std::uint32_t>(rank);
+      if (!send_all(this->next_, &own, sizeof(own))) return this->fail();
+      if (!wait_for(this->listener_, POLLIN, timeout_ms)) return this->fail();
+      this->previous_ = ::accept(this->listener_, nullptr, nullptr);
+      if (this->previous_ == invalid_socket()) return this->fail();
+
+      std::uint32_t sender = 0;
+      if (!this->receive_all(this->previous_, &sender, sizeof(sender)) || sender != previous) return this->fail();
+      close_socket(this->listener_);
+      return set_nonblocking(this->next_) && set_nonblocking(this->previous_) ? true : this->fail();
+   }
+
+   /********************************************************************************
+   * close: Stnger samtliga anslutningar, varefter kommunikatorn fungerar som
+   *        en ensam process igen.
+   ********************************************************************************/
+   void close(void)
+   {
+      close_socket(this->listener_);
+      close_socket(this->next_);
+      close_socket(this->previous_);
+      this->rank_ = 0;
+      this->size_ = 1;
+      return;
+   }
+
+   /********************************************************************************
+   * is_connected: Indikerar ifall kommunikatorn r ansluten till vriga
+   *               processer, alternativt utgr en ensam process. Returnerar
+   *               false efter ett kommunikationsfel.
+   ********************************************************************************/
+   bool is_connected(void) const
+   {
+      return !this->failed_;
+   }
+
+   /********************************************************************************
+   * rank: Returnerar index fr aktuell process.
+   ********************************************************************************/
+   std::size_t rank(void) const
+   {
+      return this->rank_;
+   }
+
+   /********************************************************************************
+   * size: Returnerar antalet processer i ringen.
+   ********************************************************************************/
+   std::size_t size(void) const
+   {
+      return this->size_;
+   }
+
+   /********************************************************************************
+   * allreduce: Summerar angivna flyttal ver samtliga processer via
+   *            ring-allreduce, dr resultatet skrivs ver till samma minne i
+   *            samtliga processer. Samtliga processer mste anropa denna
+   *            medlemsfunktion i samma ordning med samma antal flyttal.
+   *            Returnerar true om summeringen lyckades, annars false.
+   *
+   *            - data: Pekare till flyttalen som ska summeras.
+   *            - size: Antalet flyttal.
+   ********************************************************************************/
+   template <typename T>
+   bool allreduce(T* data, const std::size_t size)
+   {
+      if (this->failed_) return false;
+      if (this->size_ == 1 || size == 0) return true;
+      const auto n = this->size_;
+      auto first = [&](const std::size_t chunk) { return size * (chunk % n) / n; };
+      auto last = [&](const std::size_t chunk) { return size * (chunk % n + 1) / n; };
+      this->buffer_.resize((size / n + 1) * sizeof(T));
+
+      for (std::size_t step = 0; step + 1 < n; ++step)
+      {
+         const auto send = this->rank_ + n - step;
+         const auto receive = this->rank_ + n - step - 1;
+         if (!this->exchange(data + first(send), (last(send) - first(send)) * sizeof(T),
+                             this->buffer_.data(), (last(receive) - first(receive)) * sizeof(T))) return false;
+
+         for (std::size_t i = first(receive); i < last(receive); ++i)
+         {
+            T value;
+            std::memcpy(&value, this->buffer_.data() + (i - first(receive)) * sizeof(T), sizeof(T));
+            data[i] += value;
+         }
+      }
+
+      for (std::size_t step = 0; step + 1 < n; ++step)
+      {
+         const auto send = this->rank_ + n - step + 1;
+         const auto receive = this->rank_ + n - step;
+         if (!this->exchange(data + first(send), (last(send) - first(send)) * sizeof(T),
+                             data + first(receive), (last(receive) - first(receive)) * sizeof(T))) return false;
+      }
+      return true;
+   }
+
+private:
+   /********************************************************************************
+   * exchange: Skickar angivet antal byte till nsta process och tar samtidigt
+   *           emot angivet antal byte frn fregende process. verfringarna
+   *           sker utan blockering via poll, vilket gr att samtliga processer
+   *           kan skicka samtidigt utan att socketarnas buffertar fylls.
+   *
+   *           - send         : Pekare till datan som ska skickas.
+   *           - send_bytes   : Antalet byte som ska skickas.
+   *           - receive      : Pekare till minnet dr mottagen data lagras.
+   *           - receive_bytes: Antalet byte som ska tas emot.
+   ********************************************************************************/
+   bool exchange(const void* send,
+                 std::size_t send_bytes,
+                 void* receive,
+                 std::size_t receive_bytes)
+   {
+      auto out = static_cast<const char*>(send);
+      auto in = static_cast<char*>(receive);
+
+      while (send_bytes > 0 || receive_bytes > 0)
+      {
+         pollfd fds[2] = { { this->next_, static_cast<short>(send_bytes > 0 ? POLLOUT : 0), 0 },
+                           { this->previous_, static_cast<short>(receive_bytes > 0 ? POLLIN : 0), 0 } };
+         if (poll_sockets(fds, 2, this->timeout_ms_) <= 0) return this->fail();
+
+         if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) return this->fail();
+         if (fds[1].revents & (POLLERR | POLLNVAL)) return this->fail();
+
+         if (fds[0].revents & POLLOUT)
+         {
+            const auto sent = ::send(this->next_, out, chunk_size(send_bytes), send_flags());
+            if (sent < 0 && !would_block()) return this->fail();
+            if (sent > 0) { out += sent; send_bytes -= static_cast<std::size_t>(sent); }
+         }
+
+         if (fds[1].revents & (POLLIN | POLLHUP))
+         {
+            const auto received = ::recv(this->previous_, in, chunk_size(receive_bytes), 0);
+            if (received == 0 || (received < 0 && !would_block())) return this->fail();
+            if (received > 0) { in += received; receive_bytes -= static_cast<std::size_t>(received); }
+         }
+      }
+      return true;
+   }
+
+   /********************************************************************************
+   * receive_all: Tar emot exakt angivet antal byte frn angiven socket, vilken
+   *              frutstts blockera.
+   *
+   *              - socket: Socketen som datan tas emot frn.
+   *              - data  : Pekare till minnet dr mottagen data lagras.
+   *              - size  : Antalet byte som ska tas emot.
+   ********************************************************************************/
+   bool receive_all(const socket_type socket,
+                    void* data,
+                    std::size_t size) const
+   {
+      auto in = static_cast<char*>(data);
+
+      while (size > 0)
+      {
+         if (!wait_for(socket, POLLIN, this->timeout_ms_)) return false;
+         const auto received = ::recv(socket, in, chunk_size(size), 0);
+         if (received <= 0) return false;
+         in += received;
+         size -= static_cast<std::size_t>(received);
+      }
+      return true;
+   }
+
+   /********************************************************************************
+   * fail: Stnger samtliga anslutningar efter ett fel och returnerar false.
+   ********************************************************************************/
+   bool fail(void)
+   {
+      this->close();
+      this->failed_ = true;
+      return false;
+   }
+
+   /********************************************************************************
+   * split_address: Delar upp angiven adress p formatet "vrd:port" i vrd och
+   *                port, dr vrden kan utelmnas fr samtliga grnssnitt.
+   *
+   *                - address: Referens till adressen.
+   *                - host   : Referens till strng dr vrden lagras.
+   *                - port   : Referens till strng dr porten lagras.
+   ********************************************************************************/
+   static bool split_address(const std::string& address,
+                             std::string& host,
+                             std::string& port)
+   {
+      const auto separator = address.rfind(':');
+      if (separator == std::string::npos || separator + 1 == address.size()) return false;
+      host = address.substr(0, separator);
+      port = address.substr(separator + 1);
+      return true;
+   }
+
+   /********************************************************************************
+   * resolve: Returnerar adressinformation fr angiven adress, vilken frigrs
+   *          via freeaddrinfo, alternativt nullptr vid fel.
+   *
+   *          - address: Referens till adressen p formatet "vrd:port".
+   *          - passive: Indikerar ifall adressen ska anvndas fr att lyssna.
+   ********************************************************************************/
+   static addrinfo* resolve(const std::string& address,
+                            const bool passive)
+   {
+      std::string host, port;
+      if (!split_address(address, host, port)) return nullptr;
+      addrinfo hints;
+      std::memset(&hints, 0, sizeof(hints));
+      hints.ai_family = AF_UNSPEC;
+      hints.ai_socktype = SOCK_STREAM;
+      hints.ai_flags = passive ? AI_PASSIVE : 0;
+      addrinfo* result = nullptr;
+      if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result) != 0) return nullptr;
+      return result;
+   }
+
+   /********************************************************************************
+   * listen_on: Returnerar en socket som lyssnar p angiven adress, alternativt
+   *            en ogiltig socket vid fel.
+   *
+   *            - address: Referens till adressen p formatet "vrd:port".
+   ********************************************************************************/
+   static socket_type listen_on(const std::string& address)
+   {
+      const auto info = resolve(address, true);
+      if (info == nullptr) return invalid_socket();
+      auto result = invalid_socket();
+
+      for (auto i = info; i != nullptr && result == invalid_socket(); i = i->ai_next)
+      {
+         result = ::socket(i->ai_family, i->ai_socktype, i->ai_protocol);
+         if (result == invalid_socket()) continue;
+         const int enable = 1;
+         ::setsockopt(result, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&enable), sizeof(enable));
+         if (::bind(result, i->ai_addr, static_cast<int>(i->ai_addrlen)) != 0 || ::listen(result, 1) != 0)
+         {
+            close_socket(result);
+         }
+      }
+
+      ::freeaddrinfo(info);
+      return result;
+   }
+
+   /********************************************************************************
+   * connect_to: Returnerar en socket ansluten till angiven adress, dr Nagles
+   *             algoritm r avstngd, alternativt en ogiltig socket vid fel.
+   *
+   *             - address: Referens till adressen p formatet "vrd:port".
+   ********************************************************************************/
+   static socket_type connect_to(const std::string& address)
+   {
+      const auto info = resolve(address, false);
+      if (info == nullptr) return invalid_socket();
+      auto result = invalid_socket();
+
+      for (auto i = info; i != nullptr && result == invalid_socket(); i = i->ai_next)
+      {
+         result = ::socket(i->ai_family, i->ai_socktype, i->ai_protocol);
+         if (result == invalid_socket()) continue;
+         if (::connect(result, i->ai_addr, static_cast<int>(i->ai_addrlen)) != 0) close_socket(result);
+      }
+
+      if (result != invalid_socket())
+      {
+         const int enable = 1;
+         ::setsockopt(result, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enable), sizeof(enable));
+      }
+
+      ::freeaddrinfo(info);
+      return result;
+   }
+
+   /********************************************************************************
+   * send_all: Skickar exakt angivet antal byte via angiven socket, vilken
+   *           frutstts blockera.
+   *
+   *           - socket: Socketen som datan skickas via.
+   *           - data  : Pekare till datan som ska skickas.
+   *           - size  : Antalet byte som ska skickas.
+   ********************************************************************************/
+   static bool send_all(const socket_type socket,
+                        const void* data,
+                        std::size_t size)
+   {
+      auto out = static_cast<const char*>(data);
+
+      while (size > 0)
+      {
+         const auto sent = ::send(socket, out, chunk_size(size), send_flags());
+         if (sent <= 0) return false;
+         out += sent;
+         size -= static_cast<std::size_t>(sent);
+      }
+      return true;
+   }
+
+   /********************************************************************************
+   * wait_for: Vntar tills angiven hndelse intrffar fr angiven socket.
+   *           Returnerar false vid fel eller om tidsgrnsen passeras.
+   *
+   *           - socket    : Socketen som ska bevakas.
+   *           - events    : Hndelserna som ska invntas, exempelvis POLLIN.
+   *           - timeout_ms: Tidsgrns i millisekunder.
+   ********************************************************************************/
+   static bool wait_for(const socket_type socket,
+                        const short events,
+                        const int timeout_ms)
+   {
+      pollfd fd = { socket, events, 0 };
+      return poll_sockets(&fd, 1, timeout_ms) > 0 && (fd.revents & events);
+   }
+
+   /********************************************************************************
+   * chunk_size: Returnerar antalet byte som skickas eller tas emot per anrop,
+   *             begrnsat till 1 MiB d antalet anges som int p Windows.
+   *
+   *             - size: Antalet terstende byte.
+   ********************************************************************************/
+   static int chunk_size(const std::size_t size)
+   {
+      return static_cast<int>(size < (1u << 20) ? size : (1u << 20));
+   }
+
+#if defined(_WIN32)
+   static socket_type invalid_socket(void) { return INVALID_SOCKET; }
+   static int send_flags(void) { return 0; }
+   static bool would_block(void) { return WSAGetLastError() == WSAEWOULDBLOCK; }
+   static int poll_sockets(pollfd* fds, const std::size_t num_fds, const int timeout_ms)
+   {
+      return WSAPoll(fds, static_cast<ULONG>(num_fds), timeout_ms);
+   }
+
+   static bool startup(void)
+   {
+      static const bool result = [] { WSADATA data; return WSAStartup(MAKEWORD(2, 2), &data) == 0; }();
+      return result;
+   }
+
+   static bool set_nonblocking(const socket_type socket)
+   {
+      u_long enable = 1;
+      return ioctlsocket(socket, FIONBIO, &enable) == 0;
+   }
+
+   static void close_socket(socket_type& socket)
+   {
+      if (socket != INVALID_SOCKET) closesocket(socket);
+      socket = INVALID_SOCKET;
+      return;
+   }
+#else
+   static socket_type invalid_socket(void) { return -1; }
+   static int send_flags(void) { return MSG_NOSIGNAL; }
+   static bool would_block(void) { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+   static int poll_sockets(pollfd* fds, const std::size_t num_fds, const int timeout_ms)
+   {
+      return ::poll(fds, static_cast<nfds_t>(num_fds), timeout_ms);
+   }
+
+   static bool startup(void) { return true; }
+
+   static bool set_nonblocking(const socket_type socket)
+   {
+      const auto flags = ::fcntl(socket, F_GETFL, 0);
+      return flags >= 0 && ::fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+   }
+
+   static void close_socket(socket_type& socket)
+   {
+      if (socket >= 0) ::close(socket);
+      socket = -1;
+      return;
+   }
+#endif
+
+   socket_type listener_{invalid_socket()}; /* Lyssnande socket under anslutningen. */
+   socket_type next_{invalid_socket()};     /* Anslutning till nsta process i ringen. */
+   socket_type previous_{invalid_socket()}; /* Anslutning frn fregende process i ringen. */
+   std::size_t rank_{0};                    /* Index fr aktuell process. */
+   std::size_t size_{1};                    /* Antalet processer i ringen. */
+   int timeout_ms_{60000};                  /* Tidsgrns fr varje verfring i millisekunder. */
+   bool failed_{false};                     /* Indikerar ifall ett kommunikationsfel har uppsttt. */
+   std::vector<char> buffer_;               /* Mottagna delsummor vid reduce-scatter. */
+};
+
+#ifdef ANN_USE_MPI
+/********************************************************************************
+* mpi_communicator: Klass fr kommunikation mellan processerna i angiven
+*                   MPI-kommunikator via MPI_Allreduce, med samma grnssnitt
+*                   som klassen tcp_communicator. MPI mste ha initierats via
+*                   MPI_Init innan kommunikatorn anvnds.
+********************************************************************************/
+class mpi_communicator
+{
+public:
+   /********************************************************************************
+   * mpi_communicator: Initierar ny kommunikator fr angiven MPI-kommunikator.
+   *
+   *                   - comm: MPI-kommunikatorn (default = MPI_COMM_WORLD).
+   ********************************************************************************/
+   explicit mpi_communicator(MPI_Comm comm = MPI_COMM_WORLD)
+      : comm_{comm}
+   {
+      int value = 0;
+      MPI_Comm_rank(comm, &value);
+      this->rank_ = static_cast<std::size_t>(value);
+      MPI_Comm_size(comm, &value);
+      this->size_ = static_cast<std::size_t>(value);
+      return;
+   }
+
+   /********************************************************************************
+   * is_connected: Indikerar ifall inget kommunikationsfel har uppsttt.
+   ********************************************************************************/
+   bool is_connected(void) const
+   {
+      return !this->failed_;
+   }
+
+   /********************************************************************************
+   * rank: Returnerar index fr aktuell process.
+   ********************************************************************************/
+   std::size_t rank(void) const
+   {
+      return this->rank_;
+   }
+
+   /********************************************************************************
+   * size: Returnerar antalet processer.
+   ********************************************************************************/
+   std::size_t size(void) const
+   {
+      return this->size_;
+   }
+
+   /********************************************************************************
+   * allreduce: Summerar angivna flyttal ver samtliga processer p plats.
+   *            Returnerar true om summeringen lyckades, annars false.
+   *
+   *            - data: Pekare till flyttalen som ska summeras.
+   *            - size: Antalet flyttal.
+   ********************************************************************************/
+   template <typename T>
+   bool allreduce(T* data, const std::size_t size)
+   {
+      if (this->failed_) return false;
+      if (size == 0) return true;
+      const auto type = sizeof(T) == sizeof(float) ? MPI_FLOAT : MPI_DOUBLE;
+      this->failed_ = MPI_Allreduce(MPI_IN_PLACE, data, static_cast<int>(size), type, MPI_SUM,
+                                    this->comm_) != MPI_SUCCESS;
+      return !this->failed_;
+   }
+
+private:
+   MPI_Comm comm_;       /* MPI-kommunikatorn. */
+   std::size_t rank_{0}; /* Index fr aktuell process. */
+   std::size_t size_{1}; /* Antalet processer. */
+   bool failed_{false};  /* Indikerar ifall ett kommunikationsfel har uppsttt. */
+};
+#endif /* ANN_USE_MPI */
+
+#endif /* DISTRIBUTED_HPP_ */
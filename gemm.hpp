@@ -0,0 +1,376 @@
+/********************************************************************************
+* gemm.hpp: Innehller blockad matrismultiplikation via klasstemplaten
+*           basic_gemm, vilken anvnds av dense-lagrens batchade framt- och
+*           baktpropagering nr viktmatrisen r fr stor fr att rymmas i
+*           cacheminnet. Matriserna delas upp i block som ryms i respektive
+*           cacheniv, dr blocken ur bda matriserna packas till
+*           sammanhngande minne innan de multipliceras via mikrokrnan gemm
+*           i strukten simd_kernels.
+*
+*           Vid kompilering med makrot ANN_USE_BLAS anvnds i stllet
+*           cblas_sgemm respektive cblas_dgemm frn ett valfritt
+*           BLAS-bibliotek, exempelvis OpenBLAS, vilket d mste lnkas in.
+********************************************************************************/
+#ifndef GEMM_HPP_
+#define GEMM_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "matrix.hpp"
+#include "simd.hpp"
+#include <vector>
+#include <cstddef>
+
+#ifdef ANN_USE_BLAS
+#include <cblas.h>
+#endif
+
+/********************************************************************************
+* basic_gemm: Klasstemplat fr blockad multiplikation av radvis lagrade
+*             matriser med flyttal av typen T, dr produkten adderas till C.
+*             Uppdelningen fljer den vanliga metoden fr hgpresterande
+*             matrismultiplikation: en panel ur B om depth_block rader och
+*             column_block kolumner packas s att den ryms i L3-cacheminnet,
+*             varefter ett block ur A om row_block rader packas s att det
+*             ryms i L2-cacheminnet. Mikrokrnan multiplicerar sedan ett
+*             ftal rader ur A med ett ftal kolumner ur B i taget, dr den
+*             packade delen av B ryms i L1-cacheminnet och resultatet hlls i
+*             register. Ofullstndiga block i kanterna fylls ut med nollor
+*             vid packningen.
+*
+*             Packningsbuffertarna r trdlokala och allokeras enbart nr de
+*             behver vxa, vilket gr att flera trdar kan multiplicera
+*             samtidigt utan allokering i trningsloopen. Produkterna
+*             summeras i annan ordning n via skalrprodukter rad fr rad,
+*             varfr resultatet kan skilja sig ngot i sista decimalerna.
+********************************************************************************/
+template <typename T>
+struct basic_gemm
+{
+   using kernels_type = basic_simd_kernels<T>; /* Berkningskrnor fr aktuell flyttalstyp. */
+
+   static constexpr std::size_t depth_block = 256;          /* Gemensam dimension per panel (L1/L2). */
+   static constexpr std::size_t row_block = 96;             /* Rader ur A per block (L2). */
+   static constexpr std::size_t column_block = 1024;        /* Kolumner ur B per panel (L3). */
+   static constexpr std::size_t min_rows = 32;              /* Minsta antal rader i A fr blockad multiplikation. */
+   static constexpr std::size_t min_bytes = 128 * 1024;     /* Minsta storlek p B fr blockad multiplikation. */
+
+   /********************************************************************************
+   * is_worthwhile: Indikerar ifall blockad multiplikation lnar sig fr angivna
+   *                dimensioner, vilket r fallet nr B inte ryms i L1- eller
+   *                L2-cacheminnet och A har tillrckligt mnga rader fr att
+   *                kostnaden fr att packa B ska tjnas in. Vid frre rader,
+   *                exempelvis sm batchar, anvnds i stllet skalrprodukter.
+   *
+   *                - rows   : Antalet rader i A och C.
+   *                - columns: Antalet kolumner i B och C.
+   *                - depth  : Antalet kolumner i A, allts den gemensamma
+   *                           dimensionen.
+   ********************************************************************************/
+   static bool is_worthwhile(const std::size_t rows,
+                             const std::size_t columns,
+                             const std::size_t depth)
+   {
+      return rows >= min_rows && columns * depth * sizeof(T) >= min_bytes;
+   }
+
+   /********************************************************************************
+   * multiply: Berknar C += A * B, dr A har angivet antal rader och depth
+   *           kolumner, B har depth rader och angivet antal kolumner samt C
+   *           har angivet antal rader och kolumner. Samtliga matriser lagras
+   *           radvis med angivet avstnd (stride) mellan raderna, vilket
+   *           exempelvis motsvarar nsta lagers fel multiplicerat med dess
+   *           viktmatris vid baktpropagering.
+   *
+   *           - a       : Pekare till den frsta raden i A.
+   *           - a_stride: Avstndet mellan tv rader i A.
+   *           - b       : Pekare till den frsta raden i B.
+   *           - b_stride: Avstndet mellan tv rader i B.
+   *           - c       : Pekare till den frsta raden i C.
+   *           - c_stride: Avstndet mellan tv rader i C.
+   *           - rows    : Antalet rader i A och C.
+   *           - columns : Antalet kolumner i B och C.
+   *           - depth   : Antalet kolumner i A samt rader i B.
+   ********************************************************************************/
+   static void multiply(const T* a, const std::size_t a_stride,
+                        const T* b, const std::size_t b_stride,
+                        T* c, const std::size_t c_stride,
+                        const std::size_t rows, const std::size_t columns, const std::size_t depth)
+   {
+#ifdef ANN_USE_BLAS
+      blas_gemm(CblasNoTrans, a, a_stride, b, b_stride, c, c_stride, rows, columns, depth);
+#else
+      run(false, a, a_stride, b, b_stride, c, c_stride, rows, columns, depth);
+#endif
+      return;
+   }
+
+   /********************************************************************************
+   * multiply_transposed: Berknar C += A * B^T, dr B har angivet antal rader
+   *                      och depth kolumner, vilket exempelvis motsvarar
+   *                      insignalerna fr en batch multiplicerade med ett
+   *                      lagers viktmatris, dr varje nods vikter utgr en
+   *                      rad i B. vriga parametrar motsvarar multiply.
+   *
+   *                      - a       : Pekare till den frsta raden i A.
+   *                      - a_stride: Avstndet mellan tv rader i A.
+   *                      - b       : Pekare till den frsta raden i B.
+   *                      - b_stride: Avstndet mellan tv rader i B.
+   *                      - c       : Pekare till den frsta raden i C.
+   *                      - c_stride: Avstndet mellan tv rader i C.
+   *                      - rows    : Antalet rader i A och C.
+   *                      - columns : Antalet rader i B samt kolumner i C.
+   *                      - depth   : Antalet kolumner i A och B.
+   ********************************************************************************/
+   static void multiply_transposed(const T* a, const std::size_t a_stride,
+                                   const T* b, const std::size_t b_stride,
+                                   T* c, const std::size_t c_stride,
+                                   const std::size_t rows, const std::size_t columns, const std::size_t depth)
+   {
+#ifdef ANN_USE_BLAS
+      blas_gemm(CblasTrans, a, a_stride, b, b_stride, c, c_stride, rows, columns, depth);
+#else
+      run(true, a, a_stride, b, b_stride, c, c_stride, rows, columns, depth);
+#endif
+      return;
+   }
+
+private:
+   /********************************************************************************
+   * run: Genomfr den blockade multiplikationen, dr B antingen lagras med
+   *      en rad per kolumn i C (transponerad) eller med en rad per steg i den
+   *      gemensamma dimensionen.
+   *
+   *      - transposed: Indikerar ifall B lagras transponerad.
+   ********************************************************************************/
+   static void run(const bool transposed,
+                   const T* a, const std::size_t a_stride,
+                   const T* b, const std::size_t b_stride,
+                   T* c, const std::size_t c_stride,
+                   const std::size_t rows, const std::size_t columns, const std::size_t depth)
+   {
+      const auto& kernels = kernels_type::get();
+      const auto mr = kernels.gemm_rows;
+      const auto nr = kernels.gemm_columns;
+      auto& buffers = thread_buffers();
+      buffers.a.resize(round_up(row_block, mr) * depth_block);
+      buffers.b.resize(round_up(column_block, nr) * depth_block);
+      buffers.tile.resize(mr * nr);
+
+      for (std::size_t jc = 0; jc < columns; jc += column_block)
+      {
+         const auto nc = columns - jc < column_block ? columns - jc : column_block;
+
+         for (std::size_t pc = 0; pc < depth; pc += depth_block)
+         {
+            const auto kc = depth - pc < depth_block ? depth - pc : depth_block;
+            if (transposed) pack_b_transposed(b + jc * b_stride + pc, b_stride, nc, kc, nr, buffers.b.data());
+            else pack_b(b + pc * b_stride + jc, b_stride, nc, kc, nr, buffers.b.data());
+
+            for (std::size_t ic = 0; ic < rows; ic += row_block)
+            {
+               const auto mc = rows - ic < row_block ? rows - ic : row_block;
+               pack_a(a + ic * a_stride + pc, a_stride, mc, kc, mr, buffers.a.data());
+
+               for (std::size_t jr = 0; jr < nc; jr += nr)
+               {
+                  const auto packed_b = buffers.b.data() + jr * kc;
+
+                  for (std::size_t ir = 0; ir < mc; ir += mr)
+                  {
+                     const auto packed_a = buffers.a.data() + ir * kc;
+                     const auto block = c + (ic + ir) * c_stride + jc + jr;
+
+                     if (ir + mr <= mc && jr + nr <= nc)
+                     {
+                        kernels.gemm(kc, packed_a, packed_b, block, c_stride);
+                        continue;
+                     }
+
+                     const auto tile = buffers.tile.data();
+                     for (std::size_t i = 0; i < mr * nr; ++i) tile[i] = T(0);
+                     kernels.gemm(kc, packed_a, packed_b, tile, nr);
+
+                     for (std::size_t i = 0; i < mr && ir + i < mc; ++i)
+                     {
+                        for (std::size_t j = 0; j < nr && jr + j < nc; ++j)
+                        {
+                           block[i * c_stride + j] += tile[i * nr + j];
+                        }
+                     }
+                  }
+               }
+            }
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * pack_a: Packar angivet block ur A till grupper om mr rader, dr varje
+   *         grupp lagras kolumn fr kolumn och saknade rader stts till 0.
+   *
+   *         - a     : Pekare till blockets frsta element.
+   *         - stride: Avstndet mellan tv rader i A.
+   *         - rows  : Antalet rader i blocket.
+   *         - depth : Antalet kolumner i blocket.
+   *         - mr    : Antalet rader per grupp.
+   *         - packed: Pekare till minnet dr blocket packas.
+   ********************************************************************************/
+   static void pack_a(const T* a, const std::size_t stride,
+                      const std::size_t rows, const std::size_t depth,
+                      const std::size_t mr, T* packed)
+   {
+      for (std::size_t ir = 0; ir < rows; ir += mr, packed += mr * depth)
+      {
+         for (std::size_t i = 0; i < mr; ++i)
+         {
+            const auto row = a + (ir + i) * stride;
+
+            if (ir + i < rows)
+            {
+               for (std::size_t p = 0; p < depth; ++p) packed[p * mr + i] = row[p];
+            }
+            else
+            {
+               for (std::size_t p = 0; p < depth; ++p) packed[p * mr + i] = T(0);
+            }
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * pack_b: Packar angiven panel ur B till grupper om nr kolumner, dr varje
+   *         grupp lagras rad fr rad och saknade kolumner stts till 0.
+   *
+   *         - b      : Pekare till panelens frsta element.
+   *         - stride : Avstndet mellan tv rader i B.
+   *         - columns: Antalet kolumner i panelen.
+   *         - depth  : Antalet rader i panelen.
+   *         - nr     : Antalet kolumner per grupp.
+   *         - packed : Pekare till minnet dr panelen packas.
+   ********************************************************************************/
+   static void pack_b(const T* b, const std::size_t stride,
+                      const std::size_t columns, const std::size_t depth,
+                      const std::size_t nr, T* packed)
+   {
+      for (std::size_t jr = 0; jr < columns; jr += nr, packed += nr * depth)
+      {
+         const auto size = columns - jr < nr ? columns - jr : nr;
+
+         for (std::size_t p = 0; p < depth; ++p)
+         {
+            const auto row = b + p * stride + jr;
+
+            for (std::size_t j = 0; j < size; ++j) packed[p * nr + j] = row[j];
+            for (std::size_t j = size; j < nr; ++j) packed[p * nr + j] = T(0);
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * pack_b_transposed: Packar angiven panel ur transponerad B, dr varje rad i
+   *                    B utgr en kolumn i panelen, till samma format som
+   *                    pack_b. Panelen skrivs sammanhngande medan nr rader i
+   *                    B lses parallellt, vilket hrdvarans frhmtning av
+   *                    data hanterar vl.
+   *
+   *                    - b      : Pekare till panelens frsta element.
+   *                    - stride : Avstndet mellan tv rader i B.
+   *                    - columns: Antalet rader i B som ingr i panelen.
+   *                    - depth  : Antalet kolumner i B som ingr i panelen.
+   *                    - nr     : Antalet kolumner per grupp.
+   *                    - packed : Pekare till minnet dr panelen packas.
+   ********************************************************************************/
+   static void pack_b_transposed(const T* b, const std::size_t stride,
+                                 const std::size_t columns, const std::size_t depth,
+                                 const std::size_t nr, T* packed)
+   {
+      for (std::size_t jr = 0; jr < columns; jr += nr, packed += nr * depth)
+      {
+         const auto size = columns - jr < nr ? columns - jr : nr;
+         const auto rows = b + jr * stride;
+
+         for (std::size_t p = 0; p < depth; ++p)
+         {
+            for (std::size_t j = 0; j < size; ++j) packed[p * nr + j] = rows[j * stride + p];
+            for (std::size_t j = size; j < nr; ++j) packed[p * nr + j] = T(0);
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * round_up: Returnerar angivet vrde avrundat uppt till en jmn multipel
+   *           av angiven faktor.
+   *
+   *           - value : Vrdet som ska avrundas.
+   *           - factor: Faktorn som vrdet avrundas till.
+   ********************************************************************************/
+   static constexpr std::size_t round_up(const std::size_t value,
+                                         const std::size_t factor)
+   {
+      return (value + factor - 1) / factor * factor;
+   }
+
+   /********************************************************************************
+   * packing_buffers: Trdlokala buffertar fr packade block samt ett
+   *                  ofullstndigt block i kanterna av C.
+   ********************************************************************************/
+   struct packing_buffers
+   {
+      std::vector<T, aligned_allocator<T>> a;    /* Packat block ur A. */
+      std::vector<T, aligned_allocator<T>> b;    /* Packad panel ur B. */
+      std::vector<T, aligned_allocator<T>> tile; /* Block i C vid kanterna. */
+   };
+
+   /********************************************************************************
+   * thread_buffers: Returnerar en referens till anropande trds buffertar.
+   ********************************************************************************/
+   static packing_buffers& thread_buffers(void)
+   {
+      thread_local packing_buffers buffers;
+      return buffers;
+   }
+
+#ifdef ANN_USE_BLAS
+   /********************************************************************************
+   * blas_gemm: Berknar C += A * op(B) via angivet BLAS-bibliotek, dr op(B)
+   *            utgrs av B eller B^T.
+   *
+   *            - transpose: Anger ifall B ska transponeras.
+   ********************************************************************************/
+   static void blas_gemm(const CBLAS_TRANSPOSE transpose,
+                         const T* a, const std::size_t a_stride,
+                         const T* b, const std::size_t b_stride,
+                         T* c, const std::size_t c_stride,
+                         const std::size_t rows, const std::size_t columns, const std::size_t depth)
+   {
+      if (rows == 0 || columns == 0 || depth == 0) return;
+      blas_call(transpose, static_cast<int>(rows), static_cast<int>(columns), static_cast<int>(depth),
+                a, static_cast<int>(a_stride), b, static_cast<int>(b_stride), c, static_cast<int>(c_stride));
+      return;
+   }
+
+   /********************************************************************************
+   * blas_call: Anropar cblas_dgemm respektive cblas_sgemm beroende p
+   *            flyttalstyp, dr produkten adderas till C (beta = 1).
+   ********************************************************************************/
+   static void blas_call(const CBLAS_TRANSPOSE transpose, const int m, const int n, const int k,
+                         const double* a, const int lda, const double* b, const int ldb, double* c, const int ldc)
+   {
+      cblas_dgemm(CblasRowMajor, CblasNoTrans, transpose, m, n, k, 1.0, a, lda, b, ldb, 1.0, c, ldc);
+      return;
+   }
+
+   static void blas_call(const CBLAS_TRANSPOSE transpose, const int m, const int n, const int k,
+                         const float* a, const int lda, const float* b, const int ldb, float* c, const int ldc)
+   {
+      cblas_sgemm(CblasRowMajor, CblasNoTrans, transpose, m, n, k, 1.0f, a, lda, b, ldb, 1.0f, c, ldc);
+      return;
+   }
+#endif
+};
+
+#endif /* GEMM_HPP_ */
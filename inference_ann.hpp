@@ -0,0 +1,345 @@
+/********************************************************************************
+* inference_ann.hpp: Innehller ett neuralt ntverk enbart fr prediktion via
+*                    klasstemplaten basic_inference_ann, vilket skapas frn
+*                    ett trnat ntverk och enbart lagrar varje lagers vikter,
+*                    bias och aktiveringsfunktion. Fel, batchbuffertar,
+*                    tillstnd fr justering samt trningsdata utelmnas,
+*                    och samtliga lager delar tv buffertar fr utsignaler
+*                    som anvnds vxelvis, se strukten inference_context.
+*                    Berkningarna sker via samma krnor som i klassen ann,
+*                    vilket gr att prediktionerna r identiska.
+********************************************************************************/
+#ifndef INFERENCE_ANN_HPP_
+#define INFERENCE_ANN_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "ann.hpp"
+#include "dense_layer.hpp"
+#include "activation.hpp"
+#include "matrix.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+/********************************************************************************
+* basic_inference_ann: Klass fr prediktion via ett trnat neuralt ntverk med
+*                      flyttal av typen T, dr enbart parametrarna som krvs
+*                      vid prediktion lagras. Samtliga lagers vikter placeras
+*                      efter varandra i en gemensam arena, se klassen
+*                      memory_arena, medan utsignalerna lagras i en instans av
+*                      strukten inference_context, vars buffertar rymmer det
+*                      bredaste lagret oavsett antalet lager. Vid prediktion
+*                      frn flera trdar samtidigt anvnds de konstanta
+*                      varianterna av medlemsfunktionerna predict och
+*                      predict_batch med en egen instans av inference_context
+*                      per trd. Ntverket r fristende, vilket gr att
+*                      flyttalsntverket kan frigras efter konverteringen.
+********************************************************************************/
+template <typename T>
+class basic_inference_ann
+{
+public:
+   using value_type = T;                                 /* Flyttalstyp fr in- och utdata. */
+   using ann_type = basic_ann<T>;                        /* Flyttalsntverket som konverteras. */
+   using layer_type = basic_dense_layer<T>;              /* Flyttalsntverkets dense-lager. */
+   using matrix_type = basic_matrix<T>;                  /* Matristyp fr vikterna. */
+   using matrix_view_type = basic_matrix_view<T>;        /* Vy ver ett lagers vikter. */
+   using inference_context = basic_inference_context<T>; /* Buffertar fr prediktion. */
+
+private:
+   /********************************************************************************
+   * inference_layer: Parametrarna fr ett dense-lager som krvs vid prediktion.
+   ********************************************************************************/
+   struct inference_layer
+   {
+      matrix_type weights;                                       /* Nodernas vikter, en rad per nod. */
+      std::vector<T> bias;                                       /* Nodernas bias. */
+      activation_function activation{activation_function::relu}; /* Lagrets aktiveringsfunktion. */
+   };
+
+   std::vector<inference_layer> layers_; /* Dolda lager fljt av utgngslagret. */
+   memory_arena arena_;                  /* Minnesblock fr samtliga lagers vikter. */
+   inference_context context_;           /* Buffertar fr de icke-konstanta prediktionerna. */
+
+   /********************************************************************************
+   * prepare: Kontrollerar att angivna buffertar fr prediktion har rtt storlek
+   *          fr ntverket och allokerar om dem annars.
+   *
+   *          - context   : Referens till buffertar fr prediktion.
+   *          - batch_size: Antalet exempel som batchbufferten ska rymma.
+   ********************************************************************************/
+   void prepare(inference_context& context,
+                const std::size_t batch_size) const
+   {
+      context.prepare(this->layers_.size(), batch_size,
+                      [this](const std::size_t i) { return this->num_nodes(i); });
+      return;
+   }
+
+public:
+   /********************************************************************************
+   * basic_inference_ann: Defaultkonstruktor, initierar ett tomt ntverk.
+   ********************************************************************************/
+   basic_inference_ann(void) { }
+
+   /********************************************************************************
+   * basic_inference_ann: Initierar ntverk fr prediktion via angivet trnat
+   *                      neuralt ntverk, se medlemsfunktionen convert.
+   *
+   *                      - network: Referens till det trnade ntverket.
+   ********************************************************************************/
+   explicit basic_inference_ann(const ann_type& network)
+   {
+      this->convert(network.layers());
+      return;
+   }
+
+   /********************************************************************************
+   * convert: Kopierar vikter, bias och aktiveringsfunktion frn angivna lager,
+   *          dr eventuella tidigare lager erstts. Vikterna placeras efter
+   *          varandra i en ny arena av exakt rtt storlek, varefter buffertarna
+   *          fr prediktion med ett exempel i taget allokeras.
+   *
+   *          - layers: Referens till lagren som ska konverteras, exempelvis
+   *                    via medlemsfunktionen layers i klassen ann.
+   ********************************************************************************/
+   void convert(const std::vector<layer_type>& layers)
+   {
+      std::size_t size = 0;
+
+      for (const auto& i : layers)
+      {
+         size += memory_arena::round_up(matrix_type::storage_bytes(i.num_nodes(), i.num_weights()));
+      }
+
+      this->layers_.assign(layers.size(), inference_layer());
+      this->arena_ = memory_arena(size);
+
+      for (std::size_t i = 0; i < layers.size(); ++i)
+      {
+         const auto& source = layers[i];
+         auto& layer = this->layers_[i];
+         layer.weights.resize(source.num_nodes(), source.num_weights(), T(0), this->arena_);
+         layer.bias = source.bias;
+         layer.activation = source.activation;
+
+         for (std::size_t j = 0; j < source.num_nodes(); ++j)
+         {
+            std::copy(source.weights[j], source.weights[j] + source.num_weights(), layer.weights[j]);
+         }
+      }
+
+      this->prepare(this->context_, 1);
+      return;
+   }
+
+   /********************************************************************************
+   * num_inputs: Returnerar antalet insignaler.
+   ********************************************************************************/
+   std::size_t num_inputs(void) const
+   {
+      return this->layers_.empty() ? 0 : this->layers_.front().weights.columns();
+   }
+
+   /********************************************************************************
+   * num_outputs: Returnerar antalet utsignaler.
+   ********************************************************************************/
+   std::size_t num_outputs(void) const
+   {
+      return this->layers_.empty() ? 0 : this->layers_.back().weights.rows();
+   }
+
+   /********************************************************************************
+   * num_layers: Returnerar antalet lager (dolda lager samt utgngslagret).
+   ********************************************************************************/
+   std::size_t num_layers(void) const
+   {
+      return this->layers_.size();
+   }
+
+   /********************************************************************************
+   * num_nodes: Returnerar antalet noder i angivet lager.
+   *
+   *            - layer: Index fr aktuellt lager.
+   ********************************************************************************/
+   std::size_t num_nodes(const std::size_t layer) const
+   {
+      return this->layers_[layer].weights.rows();
+   }
+
+   /********************************************************************************
+   * size_bytes: Returnerar minnesbehovet fr samtliga lagers vikter inklusive
+   *             utfyllnad samt bias.
+   ********************************************************************************/
+   std::size_t size_bytes(void) const
+   {
+      std::size_t result = 0;
+
+      for (const auto& layer : this->layers_)
+      {
+         result += matrix_type::storage_bytes(layer.weights.rows(), layer.weights.columns())
+            + layer.bias.size() * sizeof(T);
+      }
+      return result;
+   }
+
+   /********************************************************************************
+   * make_inference_context: Returnerar buffertar fr prediktion med ntverket,
+   *                         dr batchbufferten rymmer angivet antal exempel.
+   *
+   *                         - batch_size: Antalet exempel som batchbufferten
+   *                                       rymmer (default = 64).
+   ********************************************************************************/
+   inference_context make_inference_context(const std::size_t batch_size = 64) const
+   {
+      inference_context context;
+      this->prepare(context, batch_size);
+      return context;
+   }
+
+   /********************************************************************************
+   * output: Returnerar en referens till utsignalerna frn senaste prediktion
+   *         via de icke-konstanta varianterna av medlemsfunktionen predict.
+   ********************************************************************************/
+   const std::vector<T>& output(void) const
+   {
+      return this->context_.output;
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via angiven indata och returnerar en
+   *          referens till en vektor innehllande utdatan.
+   *
+   *          - input: Referens till vektor innehllande indata.
+   ********************************************************************************/
+   const std::vector<T>& predict(const std::vector<T>& input)
+   {
+      return this->predict(input, this->context_);
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via angiven indata, dr samtliga
+   *          mellanresultat lagras i angivna buffertar. Returnerar en
+   *          referens till buffertens utsignaler. Vid frre insignaler n
+   *          frvntat utelmnas resterande insignaler, som i klassen ann.
+   *
+   *          - input  : Referens till vektor innehllande indata.
+   *          - context: Referens till buffertar fr prediktion.
+   ********************************************************************************/
+   const std::vector<T>& predict(const std::vector<T>& input,
+                                 inference_context& context) const
+   {
+      this->feedforward(input.data(), input.size(), context);
+      return context.output;
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via angiven indata och skriver utsignalerna
+   *          till angiven adress.
+   *
+   *          - input  : Pekare till indatan, vilken mste innehlla
+   *                     num_inputs() flyttal.
+   *          - output : Pekare till buffert dr utdatan lagras, vilken mste
+   *                     rymma num_outputs() flyttal.
+   *          - context: Referens till buffertar fr prediktion.
+   ********************************************************************************/
+   void predict(const T* input,
+                T* output,
+                inference_context& context) const
+   {
+      this->feedforward(input, this->num_inputs(), context);
+
+      for (std::size_t i = 0; i < context.output.size(); ++i)
+      {
+         output[i] = context.output[i];
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * predict_batch: Genomfr prediktion fr angivet antal exempel lagrade radvis
+   *                i en sammanhngande matris. Exemplen behandlas i omgngar
+   *                om batchbuffertens storlek, dr de dolda lagren skriver
+   *                vxelvis till buffertens tv batchbuffertar. Utdatan skrivs
+   *                radvis till angiven adress.
+   *
+   *                - input      : Pekare till indatan, num_inputs() flyttal per
+   *                               exempel lagrade direkt efter varandra.
+   *                - num_samples: Antalet exempel.
+   *                - output     : Pekare till buffert dr utdatan lagras, vilken
+   *                               mste rymma num_outputs() flyttal per exempel.
+   *                - context    : Referens till buffertar fr prediktion.
+   ********************************************************************************/
+   void predict_batch(const T* input,
+                      const std::size_t num_samples,
+                      T* output,
+                      inference_context& context) const
+   {
+      if (this->layers_.empty()) return;
+      this->prepare(context, context.batch_size > 0 ? context.batch_size : 1);
+      const auto chunk_size = context.batch_size;
+      const auto last = this->layers_.size() - 1;
+
+      for (std::size_t i = 0; i < num_samples; i += chunk_size)
+      {
+         const auto remaining = num_samples - i;
+         const auto count = remaining < chunk_size ? remaining : chunk_size;
+         auto source = input + i * this->num_inputs();
+         auto stride = this->num_inputs();
+         auto columns = this->num_inputs();
+
+         for (std::size_t j = 0; j < last; ++j)
+         {
+            const auto& layer = this->layers_[j];
+            auto& buffer = context.batch_target(j);
+            layer_type::feedforward(matrix_view_type(layer.weights), layer.bias.data(), source, stride, columns,
+                                    count, buffer.data(), buffer.stride(), layer.activation);
+            source = buffer.data();
+            stride = buffer.stride();
+            columns = layer.weights.rows();
+         }
+
+         const auto& layer = this->layers_[last];
+         layer_type::feedforward(matrix_view_type(layer.weights), layer.bias.data(), source, stride, columns,
+                                 count, output + i * this->num_outputs(), this->num_outputs(), layer.activation);
+      }
+      return;
+   }
+
+private:
+   /********************************************************************************
+   * feedforward: Berknar utsignaler fr samtliga lager via angiven indata,
+   *              dr de dolda lagren skriver vxelvis till buffertens tv
+   *              buffertar och utgngslagret till buffertens utsignaler.
+   *
+   *              - input  : Pekare till indatan.
+   *              - size   : Antalet insignaler.
+   *              - context: Referens till buffertar fr prediktion.
+   ********************************************************************************/
+   void feedforward(const T* input,
+                    std::size_t size,
+                    inference_context& context) const
+   {
+      if (this->layers_.empty()) return;
+      this->prepare(context, context.batch_size);
+      const auto num_layers = this->layers_.size();
+
+      for (std::size_t i = 0; i < num_layers; ++i)
+      {
+         const auto& layer = this->layers_[i];
+         const auto target = context.target(i, num_layers);
+         layer_type::feedforward(matrix_view_type(layer.weights), layer.bias.data(), input, size, target,
+                                 layer.activation);
+         input = target;
+         size = layer.weights.rows();
+      }
+      return;
+   }
+};
+
+/********************************************************************************
+* inference_ann: Neuralt ntverk fr prediktion skapat frn klassen ann.
+********************************************************************************/
+using inference_ann = basic_inference_ann<double>;
+
+#endif /* INFERENCE_ANN_HPP_ */
@@ -0,0 +1,371 @@
+/********************************************************************************
+* instrumentation.hpp: Innehller valfri instrumentering av trning och
+*                      prediktion via klassen instrumentation. Vid kompilering
+*                      med makrot ANN_ENABLE_INSTRUMENTATION mts tid (i
+*                      nanosekunder samt processorcykler), antalet anrop och
+*                      antalet behandlade exempel fr framtpropagering,
+*                      baktpropagering och justering av parametrar, bde fr
+*                      hela ntverk och fr enskilda lager. ven antalet
+*                      allokeringar av buffertar rknas.
+*
+*                      Utan makrot erstts samtliga mtpunkter av tomma
+*                      satser, vilket innebr att instrumenteringen inte
+*                      pverkar prestandan alls. Klassen instrumentation finns
+*                      dock alltid, s att kod som lser statistiken kan
+*                      kompileras oavsett instllning.
+********************************************************************************/
+#ifndef INSTRUMENTATION_HPP_
+#define INSTRUMENTATION_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(ANN_ENABLE_INSTRUMENTATION)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define ANN_INSTRUMENT_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ANN_INSTRUMENT_RDTSC 1
+#endif
+#endif
+
+/********************************************************************************
+* instrumentation_phase: Enumeration fr de faser som mts, dr faserna utan
+*                        prefix avser hela ntverk och faserna med prefixet
+*                        layer_ avser enskilda lager. Lagrens tid ingr allts
+*                        ven i motsvarande fas fr hela ntverket.
+********************************************************************************/
+enum class instrumentation_phase
+{
+   feedforward,                  /* Framtpropagering genom hela ntverket. */
+   backpropagate,                /* Baktpropagering genom hela ntverket. */
+   optimize,                     /* Justering av parametrarna i hela ntverket. */
+   backpropagate_optimize,       /* Sammanslagen baktpropagering och justering i hela ntverket. */
+   layer_feedforward,            /* Framtpropagering genom ett lager. */
+   layer_backpropagate,          /* Baktpropagering genom ett lager. */
+   layer_optimize,               /* Berkning och justering av ett lagers parametrar. */
+   layer_backpropagate_optimize, /* Sammanslagen baktpropagering och justering i ett lager. */
+   count                         /* Antalet faser. */
+};
+
+/********************************************************************************
+* phase_counters: Rknare fr en fas.
+********************************************************************************/
+struct phase_counters
+{
+   std::uint64_t calls{0};       /* Antalet anrop. */
+   std::uint64_t samples{0};     /* Antalet behandlade exempel. */
+   std::uint64_t nanoseconds{0}; /* Summerad tid i nanosekunder. */
+   std::uint64_t cycles{0};      /* Summerat antal processorcykler (0 om det saknas std). */
+};
+
+/********************************************************************************
+* instrumentation_stats: gonblicksbild av samtliga rknare.
+********************************************************************************/
+struct instrumentation_stats
+{
+   phase_counters phases[static_cast<std::size_t>(instrumentation_phase::count)]; /* Rknare per fas. */
+   std::uint64_t allocations{0};                                                  /* Antalet allokeringar. */
+   std::uint64_t allocated_bytes{0};                                              /* Summerat antal allokerade byte. */
+
+   /********************************************************************************
+   * operator[]: Returnerar en referens till rknarna fr angiven fas.
+   *
+   *             - phase: Fasen vars rknare ska returneras.
+   ********************************************************************************/
+   const phase_counters& operator[](const instrumentation_phase phase) const
+   {
+      return this->phases[static_cast<std::size_t>(phase)];
+   }
+};
+
+/********************************************************************************
+* instrumentation_listener: Grnssnitt fr mottagning av samtliga mtningar
+*                           nr de sker, exempelvis fr vidarebefordran till
+*                           ett externt system fr mtvrden. Mottagaren
+*                           anropas frn den trd dr mtningen skedde och
+*                           mste drmed vara trdsker vid parallell trning.
+********************************************************************************/
+class instrumentation_listener
+{
+public:
+   virtual ~instrumentation_listener(void) { }
+
+   /********************************************************************************
+   * on_phase: Anropas efter varje mtt anrop av angiven fas.
+   *
+   *           - phase      : Den fas som mttes.
+   *           - num_samples: Antalet exempel som behandlades.
+   *           - nanoseconds: Tiden i nanosekunder.
+   *           - cycles     : Antalet processorcykler (0 om det saknas std).
+   ********************************************************************************/
+   virtual void on_phase(const instrumentation_phase phase,
+                         const std::size_t num_samples,
+                         const std::uint64_t nanoseconds,
+                         const std::uint64_t cycles) = 0;
+
+   /********************************************************************************
+   * on_allocation: Anropas efter varje allokering av en buffert.
+   *
+   *                - bytes: Antalet allokerade byte.
+   ********************************************************************************/
+   virtual void on_allocation(const std::size_t bytes)
+   {
+      (void)bytes;
+      return;
+   }
+};
+
+/********************************************************************************
+* instrumentation: Klass fr insamling av mtvrden, vilka lagras globalt via
+*                  atomiska rknare s att ven mtningar frn samtliga
+*                  trdar vid parallell trning summeras. Statistiken lses
+*                  via medlemsfunktionen snapshot och nollstlls via reset.
+*                  Via medlemsfunktionen set_listener kan en mottagare som
+*                  anropas vid varje mtning anges vid krning.
+********************************************************************************/
+class instrumentation
+{
+public:
+   /********************************************************************************
+   * enabled: Indikerar ifall instrumenteringen r aktiverad vid kompilering.
+   ********************************************************************************/
+   static constexpr bool enabled(void)
+   {
+#if defined(ANN_ENABLE_INSTRUMENTATION)
+      return true;
+#else
+      return false;
+#endif
+   }
+
+   /********************************************************************************
+   * snapshot: Returnerar en gonblicksbild av samtliga rknare.
+   ********************************************************************************/
+   static instrumentation_stats snapshot(void)
+   {
+      const auto& data = storage();
+      instrumentation_stats stats;
+
+      for (std::size_t i = 0; i < num_phases; ++i)
+      {
+         stats.phases[i].calls = data.phases[i].calls.load(std::memory_order_relaxed);
+         stats.phases[i].samples = data.phases[i].samples.load(std::memory_order_relaxed);
+         stats.phases[i].nanoseconds = data.phases[i].nanoseconds.load(std::memory_order_relaxed);
+         stats.phases[i].cycles = data.phases[i].cycles.load(std::memory_order_relaxed);
+      }
+
+      stats.allocations = data.allocations.load(std::memory_order_relaxed);
+      stats.allocated_bytes = data.allocated_bytes.load(std::memory_order_relaxed);
+      return stats;
+   }
+
+   /********************************************************************************
+   * reset: Nollstller samtliga rknare.
+   ********************************************************************************/
+   static void reset(void)
+   {
+      auto& data = storage();
+
+      for (auto& i : data.phases)
+      {
+         i.calls.store(0, std::memory_order_relaxed);
+         i.samples.store(0, std::memory_order_relaxed);
+         i.nanoseconds.store(0, std::memory_order_relaxed);
+         i.cycles.store(0, std::memory_order_relaxed);
+      }
+
+      data.allocations.store(0, std::memory_order_relaxed);
+      data.allocated_bytes.store(0, std::memory_order_relaxed);
+      return;
+   }
+
+   /********************************************************************************
+   * set_listener: Anger mottagaren som anropas vid varje mtning, eller
+   *               nullptr fr att inte anvnda ngon mottagare. Mottagaren
+   *               mste finnas kvar s lnge den r angiven.
+   *
+   *               - listener: Pekare till mottagaren.
+   ********************************************************************************/
+   static void set_listener(instrumentation_listener* listener)
+   {
+      storage().listener.store(listener, std::memory_order_release);
+      return;
+   }
+
+   /********************************************************************************
+   * phase_name: Returnerar namnet p angiven fas.
+   *
+   *             - phase: Fasen vars namn ska returneras.
+   ********************************************************************************/
+   static const char* phase_name(const instrumentation_phase phase)
+   {
+      switch (phase)
+      {
+         case instrumentation_phase::feedforward:
+            return "feedforward";
+         case instrumentation_phase::backpropagate:
+            return "backpropagate";
+         case instrumentation_phase::optimize:
+            return "optimize";
+         case instrumentation_phase::backpropagate_optimize:
+            return "backpropagate_optimize";
+         case instrumentation_phase::layer_feedforward:
+            return "layer_feedforward";
+         case instrumentation_phase::layer_backpropagate:
+            return "layer_backpropagate";
+         case instrumentation_phase::layer_optimize:
+            return "layer_optimize";
+         case instrumentation_phase::layer_backpropagate_optimize:
+            return "layer_backpropagate_optimize";
+         default:
+            return "unknown";
+      }
+   }
+
+   /********************************************************************************
+   * record: Lagrar en mtning av angiven fas och vidarebefordrar den till
+   *         eventuell mottagare.
+   *
+   *         - phase      : Den fas som mttes.
+   *         - num_samples: Antalet exempel som behandlades.
+   *         - nanoseconds: Tiden i nanosekunder.
+   *         - cycles     : Antalet processorcykler.
+   ********************************************************************************/
+   static void record(const instrumentation_phase phase,
+                      const std::size_t num_samples,
+                      const std::uint64_t nanoseconds,
+                      const std::uint64_t cycles)
+   {
+      auto& data = storage();
+      auto& counters = data.phases[static_cast<std::size_t>(phase)];
+      counters.calls.fetch_add(1, std::memory_order_relaxed);
+      counters.samples.fetch_add(num_samples, std::memory_order_relaxed);
+      counters.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+      counters.cycles.fetch_add(cycles, std::memory_order_relaxed);
+
+      const auto listener = data.listener.load(std::memory_order_acquire);
+      if (listener) listener->on_phase(phase, num_samples, nanoseconds, cycles);
+      return;
+   }
+
+   /********************************************************************************
+   * record_allocation: Lagrar en allokering och vidarebefordrar den till
+   *                    eventuell mottagare.
+   *
+   *                    - bytes: Antalet allokerade byte.
+   ********************************************************************************/
+   static void record_allocation(const std::size_t bytes)
+   {
+      auto& data = storage();
+      data.allocations.fetch_add(1, std::memory_order_relaxed);
+      data.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+      const auto listener = data.listener.load(std::memory_order_acquire);
+      if (listener) listener->on_allocation(bytes);
+      return;
+   }
+
+   /********************************************************************************
+   * cycles: Returnerar processorns cykelrknare, eller 0 om det saknas std.
+   ********************************************************************************/
+   static inline std::uint64_t cycles(void)
+   {
+#if defined(ANN_INSTRUMENT_RDTSC)
+      return static_cast<std::uint64_t>(__rdtsc());
+#else
+      return 0;
+#endif
+   }
+
+   /********************************************************************************
+   * scope: Mter tiden frn konstruktion till destruktion och lagrar den som
+   *        en mtning av angiven fas, se makrot ANN_INSTRUMENT_SCOPE.
+   ********************************************************************************/
+   class scope
+   {
+   public:
+      scope(const instrumentation_phase phase,
+            const std::size_t num_samples)
+         : phase_{phase}, num_samples_{num_samples},
+           start_{std::chrono::steady_clock::now()}, start_cycles_{cycles()} { }
+
+      scope(const scope&) = delete;
+      scope& operator=(const scope&) = delete;
+
+      ~scope(void)
+      {
+         const auto end_cycles = cycles();
+         const auto time = std::chrono::steady_clock::now() - this->start_;
+         record(this->phase_, this->num_samples_,
+                static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count()),
+                end_cycles - this->start_cycles_);
+         return;
+      }
+
+   private:
+      instrumentation_phase phase_;                 /* Fasen som mts. */
+      std::size_t num_samples_;                     /* Antalet exempel som behandlas. */
+      std::chrono::steady_clock::time_point start_; /* Tidpunkt vid start. */
+      std::uint64_t start_cycles_;                  /* Cykelrknare vid start. */
+   };
+
+private:
+   static constexpr std::size_t num_phases = static_cast<std::size_t>(instrumentation_phase::count);
+
+   /********************************************************************************
+   * atomic_counters: Atomiska rknare fr en fas.
+   ********************************************************************************/
+   struct atomic_counters
+   {
+      std::atomic<std::uint64_t> calls{0};
+      std::atomic<std::uint64_t> samples{0};
+      std::atomic<std::uint64_t> nanoseconds{0};
+      std::atomic<std::uint64_t> cycles{0};
+   };
+
+   /********************************************************************************
+   * shared_data: Samtliga globala rknare samt aktuell mottagare.
+   ********************************************************************************/
+   struct shared_data
+   {
+      atomic_counters phases[num_phases];
+      std::atomic<std::uint64_t> allocations{0};
+      std::atomic<std::uint64_t> allocated_bytes{0};
+      std::atomic<instrumentation_listener*> listener{nullptr};
+   };
+
+   /********************************************************************************
+   * storage: Returnerar en referens till de globala rknarna.
+   ********************************************************************************/
+   static shared_data& storage(void)
+   {
+      static shared_data data;
+      return data;
+   }
+};
+
+/********************************************************************************
+* ANN_INSTRUMENT_SCOPE: Mter resterande del av aktuellt block som angiven fas
+*                       med angivet antal exempel. Utan makrot
+*                       ANN_ENABLE_INSTRUMENTATION erstts mtpunkten av en
+*                       tom sats, dr argumenten inte utvrderas.
+*
+* ANN_INSTRUMENT_ALLOCATION: Rknar en allokering om angivet antal byte.
+********************************************************************************/
+#if defined(ANN_ENABLE_INSTRUMENTATION)
+#define ANN_INSTRUMENT_CONCAT_(a, b) a##b
+#define ANN_INSTRUMENT_CONCAT(a, b) ANN_INSTRUMENT_CONCAT_(a, b)
+#define ANN_INSTRUMENT_SCOPE(phase, num_samples) \
+   const instrumentation::scope ANN_INSTRUMENT_CONCAT(instrumentation_scope_, __LINE__)(instrumentation_phase::phase, num_samples)
+#define ANN_INSTRUMENT_ALLOCATION(bytes) instrumentation::record_allocation(bytes)
+#else
+#define ANN_INSTRUMENT_SCOPE(phase, num_samples) ((void)0)
+#define ANN_INSTRUMENT_ALLOCATION(bytes) ((void)0)
+#endif
+
+#endif /* INSTRUMENTATION_HPP_ */
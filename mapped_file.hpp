@@ -0,0 +1,197 @@
+/********************************************************************************
+* mapped_file.hpp: Innehller funktionalitet fr minnesmappning (mmap) av filer
+*                  enbart fr lsning via klassen mapped_file, vilket anvnds
+*                  av datafiler samt modellfiler. Filens innehll lses d in
+*                  av operativsystemet frst nr det anvnds.
+********************************************************************************/
+#ifndef MAPPED_FILE_HPP_
+#define MAPPED_FILE_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/********************************************************************************
+* mapped_file: Klass fr minnesmappning av en fil enbart fr lsning, via mmap
+*              p POSIX-system samt MapViewOfFile p Windows. Mappningen
+*              frigrs automatiskt nr objektet gr ur scope.
+********************************************************************************/
+class mapped_file
+{
+public:
+   /********************************************************************************
+   * mapped_file: Initierar nytt objekt utan mappad fil.
+   ********************************************************************************/
+   mapped_file(void) { }
+
+   mapped_file(const mapped_file&) = delete;
+   mapped_file& operator=(const mapped_file&) = delete;
+
+   /********************************************************************************
+   * ~mapped_file: Frigr mappningen nr objektet gr ur scope.
+   ********************************************************************************/
+   ~mapped_file(void)
+   {
+      this->unmap();
+      return;
+   }
+
+   /********************************************************************************
+   * open: ppnar och minnesmappar angiven fil. Eventuell tidigare mappad fil
+   *       frigrs frst. Returnerar true om filen kunde mappas, annars false,
+   *       exempelvis om filen saknas eller r tom.
+   *
+   *       - path: Skvg till filen.
+   ********************************************************************************/
+   bool open(const char* path)
+   {
+      this->unmap();
+      return this->map(path);
+   }
+
+   /********************************************************************************
+   * close: Frigr mappningen och stnger filen.
+   ********************************************************************************/
+   void close(void)
+   {
+      this->unmap();
+      return;
+   }
+
+   /********************************************************************************
+   * is_open: Indikerar ifall en fil fr nrvarande r mappad.
+   ********************************************************************************/
+   bool is_open(void) const
+   {
+      return this->address_ != nullptr;
+   }
+
+   /********************************************************************************
+   * data: Returnerar startadressen fr mappad fil, eller nullptr om ingen fil
+   *       r mappad. Adressen ligger alltid i brjan av en minnessida.
+   ********************************************************************************/
+   const void* data(void) const
+   {
+      return this->address_;
+   }
+
+   /********************************************************************************
+   * size: Returnerar storleken p mappad fil i byte.
+   ********************************************************************************/
+   std::size_t size(void) const
+   {
+      return this->size_;
+   }
+
+private:
+#if defined(_WIN32)
+   /********************************************************************************
+   * map: ppnar och minnesmappar angiven fil enbart fr lsning.
+   *
+   *      - path: Skvg till filen.
+   ********************************************************************************/
+   bool map(const char* path)
+   {
+      this->file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (this->file_ == INVALID_HANDLE_VALUE) return false;
+      LARGE_INTEGER size;
+
+      if (!GetFileSizeEx(this->file_, &size) || size.QuadPart == 0)
+      {
+         this->unmap();
+         return false;
+      }
+
+      this->size_ = static_cast<std::size_t>(size.QuadPart);
+      this->mapping_ = CreateFileMappingA(this->file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (this->mapping_) this->address_ = MapViewOfFile(this->mapping_, FILE_MAP_READ, 0, 0, 0);
+
+      if (!this->address_)
+      {
+         this->unmap();
+         return false;
+      }
+      return true;
+   }
+
+   /********************************************************************************
+   * unmap: Frigr minnesmappningen och stnger filen.
+   ********************************************************************************/
+   void unmap(void)
+   {
+      if (this->address_) UnmapViewOfFile(this->address_);
+      if (this->mapping_) CloseHandle(this->mapping_);
+      if (this->file_ != INVALID_HANDLE_VALUE) CloseHandle(this->file_);
+      this->address_ = nullptr;
+      this->mapping_ = nullptr;
+      this->file_ = INVALID_HANDLE_VALUE;
+      this->size_ = 0;
+      return;
+   }
+
+   HANDLE file_{INVALID_HANDLE_VALUE}; /* ppnad fil. */
+   HANDLE mapping_{nullptr};           /* Filens mappningsobjekt. */
+#else
+   /********************************************************************************
+   * map: ppnar och minnesmappar angiven fil enbart fr lsning.
+   *
+   *      - path: Skvg till filen.
+   ********************************************************************************/
+   bool map(const char* path)
+   {
+      const auto file = ::open(path, O_RDONLY);
+      if (file < 0) return false;
+      struct stat status;
+
+      if (::fstat(file, &status) != 0 || status.st_size <= 0)
+      {
+         ::close(file);
+         return false;
+      }
+
+      this->size_ = static_cast<std::size_t>(status.st_size);
+      auto address = ::mmap(nullptr, this->size_, PROT_READ, MAP_SHARED, file, 0);
+      ::close(file);
+
+      if (address == MAP_FAILED)
+      {
+         this->size_ = 0;
+         return false;
+      }
+
+      this->address_ = address;
+      return true;
+   }
+
+   /********************************************************************************
+   * unmap: Frigr minnesmappningen.
+   ********************************************************************************/
+   void unmap(void)
+   {
+      if (this->address_) ::munmap(this->address_, this->size_);
+      this->address_ = nullptr;
+      this->size_ = 0;
+      return;
+   }
+#endif
+
+   void* address_{nullptr}; /* Startadress fr mappad fil. */
+   std::size_t size_{0};    /* Filens storlek i byte. */
+};
+
+#endif /* MAPPED_FILE_HPP_ */
@@ -0,0 +1,811 @@
+/********************************************************************************
+* matrix.hpp: Innehller funktionalitet fr lagring av flyttal i ett enda
+*             sammanhngande och justerat (aligned) minnesblock via
+*             klasstemplaten basic_matrix samt allokeraren aligned_allocator.
+*             Flera matriser kan ven placeras i ett gemensamt minnesblock via
+*             klassen memory_arena. Befintliga minnesblock kan ven lsas
+*             radvis utan kopiering via klasstemplaten basic_matrix_view.
+********************************************************************************/
+#ifndef MATRIX_HPP_
+#define MATRIX_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "instrumentation.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+/********************************************************************************
+* aligned_allocator: Allokerare fr std::vector, dr allokerat minne alltid
+*                    startar p en adress som r jmnt delbar med angiven
+*                    justering (default = 64 byte, allts en cache-linje).
+*                    Minnet allokeras med extra utrymme, dr den ursprungliga
+*                    adressen lagras precis innan den justerade adressen s
+*                    att minnet kan frigras korrekt.
+********************************************************************************/
+template <typename T, std::size_t Alignment = 64>
+struct aligned_allocator
+{
+   using value_type = T;
+
+   template <typename U>
+   struct rebind
+   {
+      using other = aligned_allocator<U, Alignment>;
+   };
+
+   aligned_allocator(void) noexcept { }
+
+   template <typename U>
+   aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept { }
+
+   /********************************************************************************
+   * allocate: Allokerar justerat minne fr angivet antal element och returnerar
+   *           en pekare till det justerade minnet.
+   *
+   *           - size: Antalet element som ska allokeras.
+   ********************************************************************************/
+   T* allocate(const std::size_t size)
+   {
+      const auto num_bytes = size * sizeof(T) + Alignment + sizeof(void*);
+      auto raw = static_cast<char*>(::operator new(num_bytes));
+      auto address = reinterpret_cast<std::uintptr_t>(raw + sizeof(void*));
+      address = (address + Alignment - 1) & ~static_cast<std::uintptr_t>(Alignment - 1);
+      auto aligned = reinterpret_cast<void**>(address);
+      aligned[-1] = raw;
+      return reinterpret_cast<T*>(aligned);
+   }
+
+   /********************************************************************************
+   * deallocate: Frigr minne som tidigare har allokerats via allocate.
+   *
+   *             - data: Pekare till det justerade minnet som ska frigras.
+   ********************************************************************************/
+   void deallocate(T* data, const std::size_t) noexcept
+   {
+      if (data) ::operator delete(reinterpret_cast<void**>(data)[-1]);
+      return;
+   }
+};
+
+template <typename T, typename U, std::size_t Alignment>
+inline bool operator==(const aligned_allocator<T, Alignment>&,
+                       const aligned_allocator<U, Alignment>&) noexcept
+{
+   return true;
+}
+
+template <typename T, typename U, std::size_t Alignment>
+inline bool operator!=(const aligned_allocator<T, Alignment>&,
+                       const aligned_allocator<U, Alignment>&) noexcept
+{
+   return false;
+}
+
+/********************************************************************************
+* memory_arena: Klass fr ett sammanhngande minnesblock justerat till en
+*               cache-linje, dr minne tilldelas i fljd via medlemsfunktionen
+*               allocate och varje tilldelning avrundas uppt till en jmn
+*               multipel av 64 byte. Drmed delar tv tilldelningar aldrig en
+*               cache-linje, samtidigt som samtliga ryms i en enda allokering.
+*               Enskilda tilldelningar frigrs inte, utan hela blocket frigrs
+*               nr arenan frstrs. Minnesblocket nollstlls vid allokeringen
+*               av anropande trd, vilket p system med flera NUMA-noder gr
+*               att minnet placeras nra den trden.
+*
+*               Matriser som placeras i en arena ger inte sitt minne, varfr
+*               arenan mste finnas kvar s lnge matriserna anvnds. En kopia
+*               av en arena r drfr alltid tom, medan en arena som flyttas
+*               behller sitt minnesblock.
+********************************************************************************/
+class memory_arena
+{
+public:
+   static constexpr std::size_t alignment = 64; /* Justering i byte per tilldelning. */
+
+   /********************************************************************************
+   * memory_arena: Initierar ny tom arena.
+   ********************************************************************************/
+   memory_arena(void) { }
+
+   /********************************************************************************
+   * memory_arena: Initierar ny arena med angiven kapacitet.
+   *
+   *               - capacity: Arenans storlek i byte.
+   ********************************************************************************/
+   explicit memory_arena(const std::size_t capacity)
+   {
+      this->reserve(capacity);
+      return;
+   }
+
+   /********************************************************************************
+   * memory_arena: Initierar ny tom arena vid kopiering, d minnet i en arena
+   *               enbart anvnds av garens matriser.
+   ********************************************************************************/
+   memory_arena(const memory_arena&) { }
+
+   /********************************************************************************
+   * operator=: Behller arenans minnesblock vid tilldelning via kopiering, d
+   *            garens matriser fortfarande kan vara placerade i arenan.
+   ********************************************************************************/
+   memory_arena& operator=(const memory_arena&)
+   {
+      return *this;
+   }
+
+   memory_arena(memory_arena&&) = default;
+   memory_arena& operator=(memory_arena&&) = default;
+
+   /********************************************************************************
+   * reserve: Erstter arenans minnesblock med ett nytt nollstllt block av
+   *          angiven storlek, avrundad uppt till en jmn multipel av 64 byte.
+   *          Samtliga tidigare tilldelningar blir drmed ogiltiga.
+   *
+   *          - capacity: Arenans nya storlek i byte.
+   ********************************************************************************/
+   void reserve(const std::size_t capacity)
+   {
+      const auto size = round_up(capacity);
+      if (size > this->data_.capacity()) ANN_INSTRUMENT_ALLOCATION(size);
+      this->data_.assign(size, 0);
+      this->used_ = 0;
+      return;
+   }
+
+   /********************************************************************************
+   * allocate: Tilldelar angivet antal byte ur arenan och returnerar en pekare
+   *           till minnet, vilket alltid startar p en ny cache-linje.
+   *           Returnerar nullptr om arenan saknar tillrckligt utrymme.
+   *
+   *           - size: Antalet byte som ska tilldelas.
+   ********************************************************************************/
+   void* allocate(const std::size_t size)
+   {
+      const auto num_bytes = round_up(size);
+      if (num_bytes == 0 || num_bytes > this->data_.size() - this->used_) return nullptr;
+      const auto result = this->data_.data() + this->used_;
+      this->used_ += num_bytes;
+      return result;
+   }
+
+   /********************************************************************************
+   * contains: Indikerar ifall angiven adress ligger i arenans minnesblock.
+   *
+   *           - address: Adressen som ska kontrolleras.
+   ********************************************************************************/
+   bool contains(const void* address) const
+   {
+      const auto first = reinterpret_cast<std::uintptr_t>(this->data_.data());
+      const auto value = reinterpret_cast<std::uintptr_t>(address);
+      return address != nullptr && value >= first && value < first + this->data_.size();
+   }
+
+   /********************************************************************************
+   * capacity: Returnerar arenans storlek i byte.
+   ********************************************************************************/
+   std::size_t capacity(void) const
+   {
+      return this->data_.size();
+   }
+
+   /********************************************************************************
+   * used: Returnerar antalet tilldelade byte.
+   ********************************************************************************/
+   std::size_t used(void) const
+   {
+      return this->used_;
+   }
+
+   /********************************************************************************
+   * round_up: Returnerar angivet antal byte avrundat uppt till en jmn
+   *           multipel av 64 byte, allts utrymmet som en tilldelning krver.
+   *
+   *           - size: Antalet byte.
+   ********************************************************************************/
+   static constexpr std::size_t round_up(const std::size_t size)
+   {
+      return (size + alignment - 1) / alignment * alignment;
+   }
+
+private:
+   std::vector<unsigned char, aligned_allocator<unsigned char, alignment>> data_; /* Arenans minnesblock. */
+   std::size_t used_{0};                                                          /* Antalet tilldelade byte. */
+};
+
+/********************************************************************************
+* basic_matrix: Klasstemplat fr lagring av en matris med flyttal av typen T
+*               (float eller double) radvis (row-major) i ett enda
+*               sammanhngande minnesblock. Varje rad startar p en ny
+*               cache-linje, d radlngden (stride) avrundas uppt till en
+*               jmn multipel av 64 byte. Utfyllnaden mellan raderna stts
+*               alltid till 0. Indexering sker som fr en vektor av vektorer,
+*               allts via matrix[i][j], dr operatorn [] returnerar en pekare
+*               till rad i. Minnesblocket gs som default av matrisen, men kan
+*               ven placeras i en arena, se klassen memory_arena, dr en
+*               kopia av matrisen alltid ger sitt minne. Tv matriser av
+*               samma storlek kan dessutom placeras med raderna vxelvis i
+*               arenan, se medlemsfunktionen resize_interleaved, varvid
+*               avstndet mellan raderna blir dubbelt s stort.
+********************************************************************************/
+template <typename T>
+class basic_matrix
+{
+   static_assert(std::is_floating_point<T>::value, "basic_matrix requires a floating point type!");
+
+public:
+   using value_type = T;                        /* Elementtyp. */
+   static constexpr std::size_t alignment = 64; /* Justering i byte per rad. */
+
+   /********************************************************************************
+   * basic_matrix: Initierar ny tom matris.
+   ********************************************************************************/
+   basic_matrix(void) { }
+
+   /********************************************************************************
+   * basic_matrix: Initierar ny matris av angiven storlek.
+   *
+   *               - num_rows   : Antalet rader i matrisen.
+   *               - num_columns: Antalet kolumner per rad i matrisen.
+   *               - value      : Startvrde fr samtliga element (default = 0).
+   ********************************************************************************/
+   basic_matrix(const std::size_t num_rows,
+                const std::size_t num_columns,
+                const T value = 0)
+   {
+      this->resize(num_rows, num_columns, value);
+      return;
+   }
+
+   /********************************************************************************
+   * basic_matrix: Initierar ny matris som kopia av angiven matris, dr
+   *               kopian alltid ger sitt minne.
+   *
+   *               - source: Referens till matrisen som ska kopieras.
+   ********************************************************************************/
+   basic_matrix(const basic_matrix& source)
+      : storage_(source.rows_ * stride_for(source.columns_)), rows_{source.rows_},
+        columns_{source.columns_}, stride_{stride_for(source.columns_)}
+   {
+      this->data_ = this->storage_.data();
+      this->copy_rows(source);
+      return;
+   }
+
+   /********************************************************************************
+   * basic_matrix: Flyttar angiven matris minnesblock till den nya matrisen.
+   *
+   *               - source: Referens till matrisen som ska flyttas.
+   ********************************************************************************/
+   basic_matrix(basic_matrix&& source) noexcept
+      : storage_(std::move(source.storage_)), data_{source.data_}, rows_{source.rows_},
+        columns_{source.columns_}, stride_{source.stride_}
+   {
+      source.release();
+      return;
+   }
+
+   /********************************************************************************
+   * operator=: Kopierar innehllet frn angiven matris. Vid samma storlek
+   *            kopieras elementen radvis till befintligt minne, vilket gr att
+   *            en matris som r placerad i en arena frblir det, annars
+   *            allokeras nytt minne som gs av matrisen.
+   *
+   *            - source: Referens till matrisen som ska kopieras.
+   ********************************************************************************/
+   basic_matrix& operator=(const basic_matrix& source)
+   {
+      if (this == &source) return *this;
+
+      if (this->rows_ != source.rows_ || this->columns_ != source.columns_ || this->data_ == nullptr)
+      {
+         this->rows_ = source.rows_;
+         this->columns_ = source.columns_;
+         this->stride_ = stride_for(source.columns_);
+         this->storage_.assign(this->size(), T(0));
+         this->data_ = this->storage_.data();
+      }
+
+      this->copy_rows(source);
+      return *this;
+   }
+
+   /********************************************************************************
+   * operator=: Flyttar angiven matris minnesblock till denna matris.
+   *
+   *            - source: Referens till matrisen som ska flyttas.
+   ********************************************************************************/
+   basic_matrix& operator=(basic_matrix&& source) noexcept
+   {
+      if (this == &source) return *this;
+      this->storage_ = std::move(source.storage_);
+      this->data_ = source.data_;
+      this->rows_ = source.rows_;
+      this->columns_ = source.columns_;
+      this->stride_ = source.stride_;
+      source.release();
+      return *this;
+   }
+
+   /********************************************************************************
+   * rows: Returnerar antalet rader i angiven matris.
+   ********************************************************************************/
+   inline std::size_t rows(void) const
+   {
+      return this->rows_;
+   }
+
+   /********************************************************************************
+   * columns: Returnerar antalet kolumner per rad i angiven matris.
+   ********************************************************************************/
+   inline std::size_t columns(void) const
+   {
+      return this->columns_;
+   }
+
+   /********************************************************************************
+   * stride: Returnerar avstndet mellan tv efterfljande rader i antalet
+   *         element, inklusive eventuell utfyllnad.
+   ********************************************************************************/
+   inline std::size_t stride(void) const
+   {
+      return this->stride_;
+   }
+
+   /********************************************************************************
+   * empty: Indikerar ifall angiven matris r tom.
+   ********************************************************************************/
+   inline bool empty(void) const
+   {
+      return this->rows_ == 0 || this->columns_ == 0;
+   }
+
+   /********************************************************************************
+   * data: Returnerar en pekare till brjan av matrisens minnesblock.
+   ********************************************************************************/
+   inline T* data(void)
+   {
+      return this->data_;
+   }
+
+   /********************************************************************************
+   * data: Returnerar en konstant pekare till brjan av matrisens minnesblock.
+   ********************************************************************************/
+   inline const T* data(void) const
+   {
+      return this->data_;
+   }
+
+   /********************************************************************************
+   * operator[]: Returnerar en pekare till brjan av angiven rad, vilket gr att
+   *             enskilda element kan lsas och skrivas via matrix[i][j].
+   *
+   *             - row: Index fr aktuell rad.
+   ********************************************************************************/
+   inline T* operator[](const std::size_t row)
+   {
+      return this->data_ + row * this->stride_;
+   }
+
+   /********************************************************************************
+   * operator[]: Returnerar en konstant pekare till brjan av angiven rad, vilket
+   *             gr att enskilda element kan lsas via matrix[i][j].
+   *
+   *             - row: Index fr aktuell rad.
+   ********************************************************************************/
+   inline const T* operator[](const std::size_t row) const
+   {
+      return this->data_ + row * this->stride_;
+   }
+
+   /********************************************************************************
+   * storage_bytes: Returnerar antalet byte som en matris av angiven storlek
+   *                krver inklusive utfyllnad, exempelvis fr att berkna
+   *                storleken p en arena.
+   *
+   *                - num_rows   : Antalet rader i matrisen.
+   *                - num_columns: Antalet kolumner per rad i matrisen.
+   ********************************************************************************/
+   static constexpr std::size_t storage_bytes(const std::size_t num_rows,
+                                              const std::size_t num_columns)
+   {
+      return num_rows * stride_for(num_columns) * sizeof(T);
+   }
+
+   /********************************************************************************
+   * resize: Stter antalet rader och kolumner i angiven matris. Samtliga element
+   *         tilldelas angivet startvrde, medan utfyllnaden stts till 0.
+   *
+   *         - num_rows   : Antalet rader i matrisen.
+   *         - num_columns: Antalet kolumner per rad i matrisen.
+   *         - value      : Startvrde fr samtliga element (default = 0).
+   ********************************************************************************/
+   void resize(const std::size_t num_rows,
+               const std::size_t num_columns,
+               const T value = 0)
+   {
+      this->rows_ = num_rows;
+      this->columns_ = num_columns;
+      this->stride_ = stride_for(num_columns);
+      const auto size = this->rows_ * this->stride_;
+      if (this->data_ != this->storage_.data()) this->storage_.clear();
+      if (size > this->storage_.capacity()) ANN_INSTRUMENT_ALLOCATION(size * sizeof(T));
+      this->storage_.assign(size, T(0));
+      this->data_ = this->storage_.data();
+      this->fill(value);
+      return;
+   }
+
+   /********************************************************************************
+   * resize: Stter antalet rader och kolumner i angiven matris, dr minnet
+   *         tilldelas frn angiven arena. Om arenan saknar tillrckligt
+   *         utrymme allokeras i stllet minne som gs av matrisen.
+   *
+   *         - num_rows   : Antalet rader i matrisen.
+   *         - num_columns: Antalet kolumner per rad i matrisen.
+   *         - value      : Startvrde fr samtliga element.
+   *         - arena      : Referens till arenan som minnet tilldelas frn.
+   ********************************************************************************/
+   void resize(const std::size_t num_rows,
+               const std::size_t num_columns,
+               const T value,
+               memory_arena& arena)
+   {
+      const auto memory = arena.allocate(storage_bytes(num_rows, num_columns));
+      if (memory == nullptr) return this->resize(num_rows, num_columns, value);
+      std::vector<T, aligned_allocator<T, alignment>>().swap(this->storage_);
+      this->data_ = static_cast<T*>(memory);
+      this->rows_ = num_rows;
+      this->columns_ = num_columns;
+      this->stride_ = stride_for(num_columns);
+      std::fill(this->data_, this->data_ + this->size(), T(0));
+      this->fill(value);
+      return;
+   }
+
+   /********************************************************************************
+   * move_to: Flyttar matrisens element inklusive utfyllnad till minne som
+   *          tilldelas frn angiven arena, varefter eventuellt eget minne
+   *          frigrs. Returnerar false om arenan saknar tillrckligt utrymme,
+   *          varvid matrisen lmnas orrd.
+   *
+   *          - arena: Referens till arenan som minnet tilldelas frn.
+   ********************************************************************************/
+   bool move_to(memory_arena& arena)
+   {
+      if (this->size() == 0) return true;
+      const auto memory = static_cast<T*>(arena.allocate(storage_bytes(this->rows_, this->columns_)));
+      if (memory == nullptr) return false;
+      basic_matrix source{std::move(*this)};
+      this->data_ = memory;
+      this->rows_ = source.rows_;
+      this->columns_ = source.columns_;
+      this->stride_ = stride_for(source.columns_);
+      this->copy_rows(source);
+      return true;
+   }
+
+   /********************************************************************************
+   * resize_interleaved: Stter antalet rader och kolumner i tv matriser av
+   *                     samma storlek, vars rader placeras vxelvis i ett
+   *                     gemensamt minnesblock som tilldelas frn angiven arena.
+   *                     Rad i i den andra matrisen fljer drmed direkt efter
+   *                     rad i i den frsta, exempelvis s att ett lagers
+   *                     utsignaler och fel fr samma trningsexempel ligger
+   *                     intill varandra och hmtas tillsammans vid
+   *                     baktpropagering. Minnesbehovet r detsamma som fr tv
+   *                     separata matriser. Om arenan saknar tillrckligt
+   *                     utrymme allokeras i stllet minne som gs av respektive
+   *                     matris.
+   *
+   *                     - first      : Referens till den frsta matrisen.
+   *                     - second     : Referens till den andra matrisen.
+   *                     - num_rows   : Antalet rader i matriserna.
+   *                     - num_columns: Antalet kolumner per rad i matriserna.
+   *                     - value      : Startvrde fr samtliga element.
+   *                     - arena      : Referens till arenan som minnet
+   *                                    tilldelas frn.
+   ********************************************************************************/
+   static void resize_interleaved(basic_matrix& first,
+                                  basic_matrix& second,
+                                  const std::size_t num_rows,
+                                  const std::size_t num_columns,
+                                  const T value,
+                                  memory_arena& arena)
+   {
+      const auto memory = static_cast<T*>(arena.allocate(2 * storage_bytes(num_rows, num_columns)));
+
+      if (memory == nullptr)
+      {
+         first.resize(num_rows, num_columns, value);
+         second.resize(num_rows, num_columns, value);
+         return;
+      }
+
+      std::fill(memory, memory + 2 * num_rows * stride_for(num_columns), T(0));
+      first.place(memory, num_rows, num_columns, 2 * stride_for(num_columns));
+      second.place(memory + stride_for(num_columns), num_rows, num_columns, 2 * stride_for(num_columns));
+      first.fill(value);
+      second.fill(value);
+      return;
+   }
+
+   /********************************************************************************
+   * move_interleaved: Flyttar tv matriser av samma storlek till ett gemensamt
+   *                   minnesblock som tilldelas frn angiven arena, dr
+   *                   matrisernas rader placeras vxelvis, se medlemsfunktionen
+   *                   resize_interleaved. Matriser av olika storlek flyttas
+   *                   i stllet var fr sig via medlemsfunktionen move_to.
+   *                   Returnerar false om arenan saknar tillrckligt utrymme,
+   *                   varvid matriserna lmnas orrda.
+   *
+   *                   - first : Referens till den frsta matrisen.
+   *                   - second: Referens till den andra matrisen.
+   *                   - arena : Referens till arenan som minnet tilldelas frn.
+   ********************************************************************************/
+   static bool move_interleaved(basic_matrix& first,
+                                basic_matrix& second,
+                                memory_arena& arena)
+   {
+      if (first.rows_ != second.rows_ || first.columns_ != second.columns_)
+      {
+         const auto moved = first.move_to(arena);
+         return second.move_to(arena) && moved;
+      }
+
+      if (first.size() == 0) return true;
+      const auto memory = static_cast<T*>(arena.allocate(2 * storage_bytes(first.rows_, first.columns_)));
+      if (memory == nullptr) return false;
+      const auto stride = stride_for(first.columns_);
+      basic_matrix source1{std::move(first)}, source2{std::move(second)};
+      first.place(memory, source1.rows_, source1.columns_, 2 * stride);
+      second.place(memory + stride, source2.rows_, source2.columns_, 2 * stride);
+      first.copy_rows(source1);
+      second.copy_rows(source2);
+      return true;
+   }
+
+   /********************************************************************************
+   * is_placed_in: Indikerar ifall matrisen r tom eller placerad i angiven
+   *               arena.
+   *
+   *               - arena: Referens till arenan som ska kontrolleras.
+   ********************************************************************************/
+   bool is_placed_in(const memory_arena& arena) const
+   {
+      return this->size() == 0 || arena.contains(this->data_);
+   }
+
+   /********************************************************************************
+   * fill: Tilldelar samtliga element i angiven matris angivet vrde. Utfyllnaden
+   *       mellan raderna lmnas orrd.
+   *
+   *       - value: Det vrde som samtliga element ska tilldelas.
+   ********************************************************************************/
+   void fill(const T value)
+   {
+      for (std::size_t i = 0; i < this->rows_; ++i)
+      {
+         auto row = (*this)[i];
+
+         for (std::size_t j = 0; j < this->columns_; ++j)
+         {
+            row[j] = value;
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * clear: Tmmer angiven matris.
+   ********************************************************************************/
+   void clear(void)
+   {
+      this->storage_.clear();
+      this->release();
+      return;
+   }
+
+private:
+   /********************************************************************************
+   * size: Returnerar antalet element inklusive utfyllnad.
+   ********************************************************************************/
+   std::size_t size(void) const
+   {
+      return this->rows_ * this->stride_;
+   }
+
+   /********************************************************************************
+   * stride_for: Returnerar radlngden inklusive utfyllnad fr angivet antal
+   *             kolumner, avrundad uppt till en jmn multipel av 64 byte.
+   *
+   *             - num_columns: Antalet kolumner per rad.
+   ********************************************************************************/
+   static constexpr std::size_t stride_for(const std::size_t num_columns)
+   {
+      return (num_columns + alignment / sizeof(T) - 1) / (alignment / sizeof(T)) * (alignment / sizeof(T));
+   }
+
+   /********************************************************************************
+   * place: Placerar matrisen p angiven adress med angivet avstnd mellan
+   *        raderna, varefter eventuellt eget minne frigrs.
+   *
+   *        - memory     : Pekare till minnet dr matrisen placeras.
+   *        - num_rows   : Antalet rader i matrisen.
+   *        - num_columns: Antalet kolumner per rad i matrisen.
+   *        - stride     : Avstndet mellan tv efterfljande rader i antalet
+   *                       element.
+   ********************************************************************************/
+   void place(T* memory,
+              const std::size_t num_rows,
+              const std::size_t num_columns,
+              const std::size_t stride)
+   {
+      std::vector<T, aligned_allocator<T, alignment>>().swap(this->storage_);
+      this->data_ = memory;
+      this->rows_ = num_rows;
+      this->columns_ = num_columns;
+      this->stride_ = stride;
+      return;
+   }
+
+   /********************************************************************************
+   * copy_rows: Kopierar angiven matris element inklusive utfyllnad radvis till
+   *            denna matris, vilken mste ha samma storlek. Raderna kopieras
+   *            var fr sig, d matriserna kan ha olika avstnd mellan raderna,
+   *            se medlemsfunktionen resize_interleaved.
+   *
+   *            - source: Referens till matrisen som ska kopieras.
+   ********************************************************************************/
+   void copy_rows(const basic_matrix& source)
+   {
+      const auto size = stride_for(this->columns_);
+
+      for (std::size_t i = 0; i < this->rows_; ++i)
+      {
+         std::copy(source[i], source[i] + size, (*this)[i]);
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * release: terstller matrisen till en tom matris utan att frigra minne,
+   *          exempelvis efter att minnesblocket har flyttats.
+   ********************************************************************************/
+   void release(void)
+   {
+      this->data_ = nullptr;
+      this->rows_ = 0;
+      this->columns_ = 0;
+      this->stride_ = 0;
+      return;
+   }
+
+   std::vector<T, aligned_allocator<T, alignment>> storage_; /* Matrisens eget minne. */
+   T* data_{nullptr};                                        /* Frsta elementet, i eget minne eller i en arena. */
+   std::size_t rows_{0};                                     /* Antalet rader. */
+   std::size_t columns_{0};                                  /* Antalet kolumner per rad. */
+   std::size_t stride_{0};                                   /* Avstnd mellan rader. */
+};
+
+/********************************************************************************
+* basic_matrix_view: Klasstemplat fr lsning av en befintlig matris med flyttal
+*                    av typen T lagrad radvis i ett sammanhngande minnesblock,
+*                    exempelvis en buffert som tillhandahlls av anvndaren.
+*                    Vyn ger inte minnet, vilket innebr att ingen kopiering
+*                    sker, men att minnesblocket mste finnas kvar s lnge
+*                    vyn anvnds. Avstndet mellan tv efterfljande rader
+*                    (stride) kan vara strre n antalet kolumner, exempelvis
+*                    om varje rad ven innehller andra vrden.
+********************************************************************************/
+template <typename T>
+class basic_matrix_view
+{
+public:
+   using value_type = T; /* Elementtyp. */
+
+   /********************************************************************************
+   * basic_matrix_view: Initierar ny tom vy.
+   ********************************************************************************/
+   basic_matrix_view(void) { }
+
+   /********************************************************************************
+   * basic_matrix_view: Initierar ny vy ver angivet minnesblock.
+   *
+   *                    - data       : Pekare till det frsta elementet p den
+   *                                   frsta raden.
+   *                    - num_rows   : Antalet rader.
+   *                    - num_columns: Antalet kolumner per rad.
+   *                    - stride     : Avstndet mellan tv rader i antalet
+   *                                   element (default = 0, vilket innebr
+   *                                   samma som antalet kolumner).
+   ********************************************************************************/
+   basic_matrix_view(const T* data,
+                     const std::size_t num_rows,
+                     const std::size_t num_columns,
+                     const std::size_t stride = 0)
+      : data_{data}, rows_{num_rows}, columns_{num_columns},
+        stride_{stride > 0 ? stride : num_columns} { }
+
+   /********************************************************************************
+   * basic_matrix_view: Initierar ny vy ver samtliga rader i angiven matris.
+   *
+   *                    - source: Referens till matrisen som vyn ska lsa.
+   ********************************************************************************/
+   basic_matrix_view(const basic_matrix<T>& source)
+      : data_{source.data()}, rows_{source.rows()}, columns_{source.columns()},
+        stride_{source.stride()} { }
+
+   /********************************************************************************
+   * rows: Returnerar antalet rader i angiven vy.
+   ********************************************************************************/
+   inline std::size_t rows(void) const
+   {
+      return this->rows_;
+   }
+
+   /********************************************************************************
+   * columns: Returnerar antalet kolumner per rad i angiven vy.
+   ********************************************************************************/
+   inline std::size_t columns(void) const
+   {
+      return this->columns_;
+   }
+
+   /********************************************************************************
+   * stride: Returnerar avstndet mellan tv efterfljande rader i antalet
+   *         element.
+   ********************************************************************************/
+   inline std::size_t stride(void) const
+   {
+      return this->stride_;
+   }
+
+   /********************************************************************************
+   * empty: Indikerar ifall angiven vy r tom.
+   ********************************************************************************/
+   inline bool empty(void) const
+   {
+      return this->data_ == nullptr || this->rows_ == 0;
+   }
+
+   /********************************************************************************
+   * data: Returnerar en pekare till det frsta elementet i vyn.
+   ********************************************************************************/
+   inline const T* data(void) const
+   {
+      return this->data_;
+   }
+
+   /********************************************************************************
+   * operator[]: Returnerar en pekare till brjan av angiven rad.
+   *
+   *             - row: Index fr aktuell rad.
+   ********************************************************************************/
+   inline const T* operator[](const std::size_t row) const
+   {
+      return this->data_ + row * this->stride_;
+   }
+
+private:
+   const T* data_{nullptr}; /* Pekare till det frsta elementet. */
+   std::size_t rows_{0};    /* Antalet rader. */
+   std::size_t columns_{0}; /* Antalet kolumner per rad. */
+   std::size_t stride_{0};  /* Avstnd mellan rader. */
+};
+
+/********************************************************************************
+* matrix: Matris med flyttal av typen double, vilket r standardtypen fr
+*         samtliga dense-lager och neurala ntverk.
+********************************************************************************/
+using matrix = basic_matrix<double>;
+
+/********************************************************************************
+* matrix_view: Vy ver en matris med flyttal av typen double.
+********************************************************************************/
+using matrix_view = basic_matrix_view<double>;
+
+#endif /* MATRIX_HPP_ */
@@ -0,0 +1,505 @@
+/********************************************************************************
+* model_file.hpp: Innehller funktionalitet fr lagring av trnade neurala
+*                 ntverk i ett binrt filformat via klasstemplaten
+*                 basic_model_file. Vikterna lagras p samma stt som i
+*                 minnet, vilket gr att en sparad modell kan minnesmappas
+*                 (mmap) och anvndas fr prediktion direkt, utan tolkning
+*                 eller kopiering av filens innehll.
+*
+*                 Filformatet bestr av ett huvud om 64 byte, fljt av en
+*                 tabell med en post om 64 byte per lager, fljt av varje
+*                 lagers bias och vikter. Samtliga block startar p en adress
+*                 som r jmnt delbar med 64 byte:
+*
+*                 Huvud:
+*                 Offset  Storlek  Innehll
+*                 0       8        Identifierare "ANNMODEL" (utan '\0').
+*                 8       4        Formatets version (fr nrvarande 1).
+*                 12      4        Byteordning, 0x01020304 lagrat i vrdens
+*                                  byteordning.
+*                 16      4        Flyttalstyp (4 = float, 8 = double).
+*                 20      4        Antalet lager (dolda lager + utgngslagret).
+*                 24      40       Reserverat, stts till 0.
+*
+*                 Lagerpost:
+*                 Offset  Storlek  Innehll
+*                 0       8        Antalet noder.
+*                 8       8        Antalet vikter per nod.
+*                 16      8        Avstndet mellan tv viktrader i antalet
+*                                  flyttal (stride), inklusive utfyllnad.
+*                 24      8        Offset i filen till lagrets bias.
+*                 32      8        Offset i filen till lagrets vikter, vilka
+*                                  lagras radvis med utfyllnad precis som i
+*                                  klassen matrix.
+*                 40      4        Lagrets aktiveringsfunktion, se
+*                                  enumerationen activation_function. Filer
+*                                  dr fltet r 0 anvnder drmed ReLU.
+*                 44      20       Reserverat, stts till 0.
+********************************************************************************/
+#ifndef MODEL_FILE_HPP_
+#define MODEL_FILE_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "dense_layer.hpp"
+#include "mapped_file.hpp"
+#include <vector>
+#include <fstream>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/********************************************************************************
+* model_header: Huvudet i brjan av varje modellfil, se beskrivningen av
+*               filformatet ovan.
+********************************************************************************/
+struct model_header
+{
+   char magic[8];              /* Identifierare "ANNMODEL". */
+   std::uint32_t version;      /* Formatets version. */
+   std::uint32_t byte_order;   /* Byteordning (0x01020304). */
+   std::uint32_t value_size;   /* Storlek per flyttal i byte. */
+   std::uint32_t num_layers;   /* Antalet lager. */
+   std::uint64_t reserved[5];  /* Reserverat. */
+
+   static constexpr std::uint32_t current_version = 1;            /* Aktuell version. */
+   static constexpr std::uint32_t native_byte_order = 0x01020304; /* Vrdens byteordning. */
+   static constexpr std::size_t alignment = 64;                   /* Justering fr samtliga block. */
+};
+
+/********************************************************************************
+* model_layer_header: Post i lagertabellen fr ett lager i en modellfil, se
+*                     beskrivningen av filformatet ovan.
+********************************************************************************/
+struct model_layer_header
+{
+   std::uint64_t num_nodes;      /* Antalet noder. */
+   std::uint64_t num_weights;    /* Antalet vikter per nod. */
+   std::uint64_t stride;         /* Avstnd mellan viktrader i antalet flyttal. */
+   std::uint64_t bias_offset;    /* Offset till lagrets bias. */
+   std::uint64_t weights_offset; /* Offset till lagrets vikter. */
+   std::uint32_t activation;     /* Lagrets aktiveringsfunktion. */
+   std::uint32_t reserved0;      /* Reserverat. */
+   std::uint64_t reserved[2];    /* Reserverat. */
+};
+
+static_assert(sizeof(model_header) == 64, "model_header must be 64 bytes!");
+static_assert(sizeof(model_layer_header) == 64, "model_layer_header must be 64 bytes!");
+
+/********************************************************************************
+* basic_model_file: Klasstemplat fr lsning av en modellfil med flyttal av
+*                   typen T. Filen minnesmappas enbart fr lsning, varefter
+*                   varje lagers vikter och bias kan lsas direkt ur filen.
+*                   Prediktion kan genomfras direkt via medlemsfunktionerna
+*                   predict och predict_batch, vilka inte ndrar modellen och
+*                   drmed kan anropas frn flera trdar samtidigt, s lnge
+*                   varje trd anvnder egna buffertar. Modellen kan ven
+*                   lsas in i ett neuralt ntverk fr fortsatt trning via
+*                   medlemsfunktionen load i klassen ann.
+********************************************************************************/
+template <typename T>
+class basic_model_file
+{
+public:
+   using value_type = T;                                 /* Flyttalstyp i filen. */
+   using layer_type = basic_dense_layer<T>;              /* Dense-lager som kan sparas. */
+   using matrix_view_type = basic_matrix_view<T>;        /* Vy ver ett lagers vikter. */
+   using inference_context = basic_inference_context<T>; /* Buffertar fr prediktion. */
+
+   /********************************************************************************
+   * basic_model_file: Initierar nytt objekt utan ppnad fil.
+   ********************************************************************************/
+   basic_model_file(void) { }
+
+   /********************************************************************************
+   * basic_model_file: ppnar angiven modellfil, se medlemsfunktionen open.
+   *
+   *                   - path: Skvg till modellfilen.
+   ********************************************************************************/
+   explicit basic_model_file(const char* path)
+   {
+      this->open(path);
+      return;
+   }
+
+   basic_model_file(const basic_model_file&) = delete;
+   basic_model_file& operator=(const basic_model_file&) = delete;
+
+   /********************************************************************************
+   * ~basic_model_file: Stnger modellfilen nr objektet gr ur scope.
+   ********************************************************************************/
+   ~basic_model_file(void)
+   {
+      this->close();
+      return;
+   }
+
+   /********************************************************************************
+   * open: ppnar och minnesmappar angiven modellfil. Eventuell tidigare ppnad
+   *       fil stngs frst. Returnerar true om filen kunde ppnas, annars
+   *       false, exempelvis om filen saknas, har fel format, annan
+   *       byteordning, en annan flyttalstyp n T eller om lagrens storlekar
+   *       inte passar ihop.
+   *
+   *       - path: Skvg till modellfilen.
+   ********************************************************************************/
+   bool open(const char* path)
+   {
+      this->close();
+      if (!this->file_.open(path)) return false;
+
+      if (!this->validate())
+      {
+         this->close();
+         return false;
+      }
+      return true;
+   }
+
+   /********************************************************************************
+   * close: Stnger modellfilen och frigr minnesmappningen.
+   ********************************************************************************/
+   void close(void)
+   {
+      this->file_.close();
+      this->layers_ = nullptr;
+      this->num_layers_ = 0;
+      return;
+   }
+
+   /********************************************************************************
+   * is_open: Indikerar ifall en modellfil fr nrvarande r ppen.
+   ********************************************************************************/
+   bool is_open(void) const
+   {
+      return this->layers_ != nullptr;
+   }
+
+   /********************************************************************************
+   * num_layers: Returnerar antalet lager (dolda lager samt utgngslagret).
+   ********************************************************************************/
+   std::size_t num_layers(void) const
+   {
+      return this->num_layers_;
+   }
+
+   /********************************************************************************
+   * num_inputs: Returnerar antalet insignaler till modellen.
+   ********************************************************************************/
+   std::size_t num_inputs(void) const
+   {
+      return this->num_layers_ > 0 ? this->num_weights(0) : 0;
+   }
+
+   /********************************************************************************
+   * num_outputs: Returnerar antalet utsignaler frn modellen.
+   ********************************************************************************/
+   std::size_t num_outputs(void) const
+   {
+      return this->num_layers_ > 0 ? this->num_nodes(this->num_layers_ - 1) : 0;
+   }
+
+   /********************************************************************************
+   * num_nodes: Returnerar antalet noder i angivet lager.
+   *
+   *            - layer: Index fr aktuellt lager.
+   ********************************************************************************/
+   std::size_t num_nodes(const std::size_t layer) const
+   {
+      return static_cast<std::size_t>(this->layers_[layer].num_nodes);
+   }
+
+   /********************************************************************************
+   * num_weights: Returnerar antalet vikter per nod i angivet lager.
+   *
+   *              - layer: Index fr aktuellt lager.
+   ********************************************************************************/
+   std::size_t num_weights(const std::size_t layer) const
+   {
+      return static_cast<std::size_t>(this->layers_[layer].num_weights);
+   }
+
+   /********************************************************************************
+   * activation: Returnerar aktiveringsfunktionen i angivet lager.
+   *
+   *             - layer: Index fr aktuellt lager.
+   ********************************************************************************/
+   activation_function activation(const std::size_t layer) const
+   {
+      return static_cast<activation_function>(this->layers_[layer].activation);
+   }
+
+   /********************************************************************************
+   * weights: Returnerar en vy ver vikterna i angivet lager, en rad per nod.
+   *
+   *          - layer: Index fr aktuellt lager.
+   ********************************************************************************/
+   matrix_view_type weights(const std::size_t layer) const
+   {
+      const auto& entry = this->layers_[layer];
+      return matrix_view_type(this->at(entry.weights_offset), static_cast<std::size_t>(entry.num_nodes),
+                              static_cast<std::size_t>(entry.num_weights), static_cast<std::size_t>(entry.stride));
+   }
+
+   /********************************************************************************
+   * bias: Returnerar en pekare till nodernas bias i angivet lager.
+   *
+   *       - layer: Index fr aktuellt lager.
+   ********************************************************************************/
+   const T* bias(const std::size_t layer) const
+   {
+      return this->at(this->layers_[layer].bias_offset);
+   }
+
+   /********************************************************************************
+   * make_inference_context: Returnerar buffertar fr prediktion med angiven
+   *                         modell, dr batchbufferten rymmer angivet antal
+   *                         exempel.
+   *
+   *                         - batch_size: Antalet exempel som batchbufferten
+   *                                       rymmer (default = 64).
+   ********************************************************************************/
+   inference_context make_inference_context(const std::size_t batch_size = 64) const
+   {
+      inference_context context;
+      this->prepare(context, batch_size);
+      return context;
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via angiven indata och skriver utsignalerna
+   *          till angiven adress.
+   *
+   *          - input  : Pekare till indatan, vilken mste innehlla
+   *                     num_inputs() flyttal.
+   *          - output : Pekare till buffert dr utdatan lagras, vilken mste
+   *                     rymma num_outputs() flyttal.
+   *          - context: Referens till buffertar fr prediktion.
+   ********************************************************************************/
+   void predict(const T* input,
+                T* output,
+                inference_context& context) const
+   {
+      if (this->num_layers_ == 0) return;
+      this->prepare(context, context.batch_size);
+      auto source = input;
+      auto size = this->num_inputs();
+
+      for (std::size_t i = 0; i < this->num_layers_; ++i)
+      {
+         const auto target = context.target(i, this->num_layers_);
+         layer_type::feedforward(this->weights(i), this->bias(i), source, size, target, this->activation(i));
+         source = target;
+         size = this->num_nodes(i);
+      }
+
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         output[i] = source[i];
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * predict_batch: Genomfr prediktion fr angivet antal exempel lagrade radvis
+   *                i en sammanhngande matris. Exemplen behandlas i omgngar
+   *                om batchbuffertens storlek.
+   *
+   *                - input      : Pekare till indatan, num_inputs() flyttal per
+   *                               exempel lagrade direkt efter varandra.
+   *                - num_samples: Antalet exempel.
+   *                - output     : Pekare till buffert dr utdatan lagras, vilken
+   *                               mste rymma num_outputs() flyttal per exempel.
+   *                - context    : Referens till buffertar fr prediktion.
+   ********************************************************************************/
+   void predict_batch(const T* input,
+                      const std::size_t num_samples,
+                      T* output,
+                      inference_context& context) const
+   {
+      if (this->num_layers_ == 0) return;
+      this->prepare(context, context.batch_size > 0 ? context.batch_size : 1);
+      const auto chunk_size = context.batch_size;
+      const auto last = this->num_layers_ - 1;
+
+      for (std::size_t i = 0; i < num_samples; i += chunk_size)
+      {
+         const auto remaining = num_samples - i;
+         const auto count = remaining < chunk_size ? remaining : chunk_size;
+         auto source = input + i * this->num_inputs();
+         auto stride = this->num_inputs();
+         auto columns = this->num_inputs();
+
+         for (std::size_t j = 0; j < last; ++j)
+         {
+            auto& buffer = context.batch_target(j);
+            layer_type::feedforward(this->weights(j), this->bias(j), source, stride, columns, count,
+                                    buffer.data(), buffer.stride(), this->activation(j));
+            source = buffer.data();
+            stride = buffer.stride();
+            columns = this->num_nodes(j);
+         }
+
+         layer_type::feedforward(this->weights(last), this->bias(last), source, stride, columns, count,
+                                 output + i * this->num_outputs(), this->num_outputs(), this->activation(last));
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * write: Skriver angivna dense-lager till en ny modellfil. Returnerar true om
+   *        filen kunde skrivas, annars false.
+   *
+   *        - path  : Skvg till modellfilen som ska skapas.
+   *        - layers: Referens till lagren som ska sparas, dr det sista lagret
+   *                  utgr utgngslagret.
+   ********************************************************************************/
+   static bool write(const char* path,
+                     const std::vector<layer_type>& layers)
+   {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      if (!file || layers.empty()) return false;
+
+      model_header header;
+      std::memset(&header, 0, sizeof(header));
+      std::memcpy(header.magic, "ANNMODEL", 8);
+      header.version = model_header::current_version;
+      header.byte_order = model_header::native_byte_order;
+      header.value_size = sizeof(T);
+      header.num_layers = static_cast<std::uint32_t>(layers.size());
+
+      std::vector<model_layer_header> entries(layers.size());
+      std::memset(entries.data(), 0, entries.size() * sizeof(model_layer_header));
+      auto offset = static_cast<std::uint64_t>(sizeof(model_header) + entries.size() * sizeof(model_layer_header));
+
+      for (std::size_t i = 0; i < layers.size(); ++i)
+      {
+         const auto& layer = layers[i];
+         entries[i].num_nodes = layer.num_nodes();
+         entries[i].num_weights = layer.num_weights();
+         entries[i].stride = layer.weights.stride();
+         entries[i].bias_offset = offset;
+         offset += align(layer.num_nodes() * sizeof(T));
+         entries[i].weights_offset = offset;
+         entries[i].activation = static_cast<std::uint32_t>(layer.activation);
+         offset += align(layer.weights.rows() * layer.weights.stride() * sizeof(T));
+      }
+
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(model_layer_header));
+      const char padding[model_header::alignment] = { };
+
+      for (const auto& layer : layers)
+      {
+         const auto bias_size = layer.num_nodes() * sizeof(T);
+         const auto weights_size = layer.weights.rows() * layer.weights.stride() * sizeof(T);
+         file.write(reinterpret_cast<const char*>(layer.bias.data()), bias_size);
+         file.write(padding, align(bias_size) - bias_size);
+         file.write(reinterpret_cast<const char*>(layer.weights.data()), weights_size);
+         file.write(padding, align(weights_size) - weights_size);
+      }
+      return static_cast<bool>(file);
+   }
+
+private:
+   /********************************************************************************
+   * align: Avrundar angiven storlek i byte uppt till en jmn multipel av
+   *        justeringen fr modellfilens block.
+   *
+   *        - size: Storleken som ska avrundas.
+   ********************************************************************************/
+   static std::size_t align(const std::size_t size)
+   {
+      return (size + model_header::alignment - 1) / model_header::alignment * model_header::alignment;
+   }
+
+   /********************************************************************************
+   * at: Returnerar en pekare till flyttalet p angiven offset i filen.
+   *
+   *     - offset: Offset i byte frn filens brjan.
+   ********************************************************************************/
+   const T* at(const std::uint64_t offset) const
+   {
+      return reinterpret_cast<const T*>(static_cast<const char*>(this->file_.data()) + offset);
+   }
+
+   /********************************************************************************
+   * fits: Indikerar ifall ett block med angivet antal flyttal p angiven offset
+   *       ryms i filen och r justerat.
+   *
+   *       - offset    : Blockets offset i byte frn filens brjan.
+   *       - num_values: Antalet flyttal i blocket.
+   ********************************************************************************/
+   bool fits(const std::uint64_t offset,
+             const std::uint64_t num_values) const
+   {
+      const auto size = static_cast<std::uint64_t>(this->file_.size());
+      if (offset % model_header::alignment != 0 || offset > size) return false;
+      return num_values <= (size - offset) / sizeof(T);
+   }
+
+   /********************************************************************************
+   * validate: Kontrollerar att huvudet samt lagertabellen i mappad fil r
+   *           giltiga, att samtliga block ryms i filen, att antalet vikter
+   *           per nod i varje lager matchar antalet noder i fregende lager
+   *           och att varje lagers aktiveringsfunktion r knd.
+   ********************************************************************************/
+   bool validate(void)
+   {
+      const auto size = this->file_.size();
+      if (size < sizeof(model_header)) return false;
+      const auto header = static_cast<const model_header*>(this->file_.data());
+
+      if (std::memcmp(header->magic, "ANNMODEL", 8) != 0 ||
+          header->version != model_header::current_version ||
+          header->byte_order != model_header::native_byte_order ||
+          header->value_size != sizeof(T) ||
+          header->num_layers == 0 ||
+          header->num_layers > (size - sizeof(model_header)) / sizeof(model_layer_header))
+      {
+         return false;
+      }
+
+      const auto layers = reinterpret_cast<const model_layer_header*>(header + 1);
+
+      for (std::size_t i = 0; i < header->num_layers; ++i)
+      {
+         const auto& entry = layers[i];
+         if (entry.num_nodes == 0 || entry.stride < entry.num_weights) return false;
+         if (entry.activation > static_cast<std::uint32_t>(activation_function::softmax)) return false;
+         if (i > 0 && entry.num_weights != layers[i - 1].num_nodes) return false;
+         if (!this->fits(entry.bias_offset, entry.num_nodes)) return false;
+         if (entry.stride > 0 && entry.num_nodes > UINT64_MAX / entry.stride) return false;
+         if (!this->fits(entry.weights_offset, entry.num_nodes * entry.stride)) return false;
+      }
+
+      this->layers_ = layers;
+      this->num_layers_ = header->num_layers;
+      return true;
+   }
+
+   /********************************************************************************
+   * prepare: Kontrollerar att angivna buffertar fr prediktion har rtt storlek
+   *          fr angiven modell och allokerar om dem annars.
+   *
+   *          - context   : Referens till buffertar fr prediktion.
+   *          - batch_size: Antalet exempel som batchbufferten ska rymma.
+   ********************************************************************************/
+   void prepare(inference_context& context,
+                const std::size_t batch_size) const
+   {
+      context.prepare(this->num_layers_, batch_size,
+                      [this](const std::size_t i) { return this->num_nodes(i); });
+      return;
+   }
+
+   mapped_file file_;                           /* Minnesmappad modellfil. */
+   const model_layer_header* layers_{nullptr};  /* Lagertabellen, eller nullptr om stngd. */
+   std::size_t num_layers_{0};                  /* Antalet lager. */
+};
+
+/********************************************************************************
+* model_file: Modellfil med flyttal av typen double.
+********************************************************************************/
+using model_file = basic_model_file<double>;
+
+#endif /* MODEL_FILE_HPP_ */
@@ -0,0 +1,314 @@
+/********************************************************************************
+* optimizer.hpp: Innehller metoder fr justering av parametrar vid trning
+*                via strukttemplaten basic_optimizer samt schemalagda
+*                lrhastigheter via strukttemplaten basic_schedule. Utver
+*                vanlig gradientnedstigning (SGD) stds momentum, Nesterov,
+*                RMSProp och Adam, dr varje lager lagrar sina tillstnd i
+*                matriser med samma layout som lagrets vikter, s att
+*                tillstnden lses sekventiellt tillsammans med vikterna.
+********************************************************************************/
+#ifndef OPTIMIZER_HPP_
+#define OPTIMIZER_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "simd.hpp"
+#include <cstddef>
+#include <cmath>
+
+/********************************************************************************
+* optimizer_method: Metod fr justering av parametrar, dr g utgr aktuellt
+*                   bidrag (fel * insignal) och r lrhastigheten:
+*
+*                   - sgd     : p += r * g.
+*                   - momentum: v = momentum * v + g, p += r * v.
+*                   - nesterov: v = momentum * v + g, p += r * (g + momentum * v).
+*                   - rmsprop : s = beta2 * s + (1 - beta2) * g^2,
+*                               p += r * g / (sqrt(s) + epsilon).
+*                   - adam    : m = beta1 * m + (1 - beta1) * g,
+*                               s = beta2 * s + (1 - beta2) * g^2,
+*                               p += r * m' / (sqrt(s') + epsilon), dr m' och s'
+*                               utgr m och s korrigerade fr startvrdet 0.
+********************************************************************************/
+enum class optimizer_method { sgd, momentum, nesterov, rmsprop, adam };
+
+/********************************************************************************
+* schedule_method: Metod fr schemalggning av lrhastigheten under trning:
+*
+*                  - constant: Samma lrhastighet under samtliga epoker.
+*                  - step    : Lrhastigheten multipliceras med gamma efter
+*                              varje step_size epoker.
+*                  - cosine  : Lrhastigheten minskar frn angivet vrde till
+*                              min_rate lngs en halv cosinusperiod.
+********************************************************************************/
+enum class schedule_method { constant, step, cosine };
+
+/********************************************************************************
+* basic_optimizer_update: Instllningar fr en enskild justering, vilka berknas
+*                         en gng per justering via medlemsfunktionen update i
+*                         strukten basic_optimizer. Korrektionen av Adams
+*                         startvrden ingr drmed redan i lrhastigheten,
+*                         vilket gr att ingen potensberkning sker per rad.
+********************************************************************************/
+template <typename T>
+struct basic_optimizer_update
+{
+   using kernels_type = basic_simd_kernels<T>; /* Berkningskrnor fr aktuell flyttalstyp. */
+
+   optimizer_method method; /* Metod fr justeringen. */
+   T rate;                  /* Lrhastighet (inklusive eventuell korrektion). */
+   T momentum;              /* Andel av fregende riktning som behlls. */
+   T beta1;                 /* Avklingning fr frsta ordningens moment. */
+   T beta2;                 /* Avklingning fr andra ordningens moment. */
+   T epsilon;               /* Term som frhindrar division med 0 (inklusive korrektion). */
+
+   /********************************************************************************
+   * apply: Justerar angivna parametrar via angivna bidrag multiplicerade med
+   *        angiven skalfaktor enligt vald metod, dr tillstnden uppdateras.
+   *        Tillstnd som inte anvnds av vald metod fr vara nullptr.
+   *        Samtliga metoder berknas via vektoriserade berkningskrnor, se
+   *        strukten basic_simd_kernels.
+   *
+   *        - parameters: Pekare till parametrarna som ska justeras.
+   *        - moment1   : Pekare till frsta ordningens tillstnd.
+   *        - moment2   : Pekare till andra ordningens tillstnd.
+   *        - gradient  : Pekare till bidragen, ett per parameter.
+   *        - size      : Antalet parametrar.
+   *        - scale     : Skalfaktor fr bidragen, exempelvis nodens fel eller
+   *                      1 / batchstorleken.
+   ********************************************************************************/
+   void apply(T* parameters,
+              T* moment1,
+              T* moment2,
+              const T* gradient,
+              const std::size_t size,
+              const T scale) const
+   {
+      const auto& kernels = kernels_type::get();
+
+      switch (this->method)
+      {
+         case optimizer_method::momentum:
+         case optimizer_method::nesterov:
+            kernels.momentum(this->rate, this->momentum, scale, gradient, moment1, parameters, size,
+                             this->method == optimizer_method::nesterov);
+            break;
+         case optimizer_method::rmsprop:
+            kernels.rmsprop(this->rate, this->beta2, this->epsilon, scale, gradient, moment2, parameters, size);
+            break;
+         case optimizer_method::adam:
+            kernels.adam(this->rate, this->beta1, this->beta2, this->epsilon, scale,
+                         gradient, moment1, moment2, parameters, size);
+            break;
+         default:
+            kernels.axpy(this->rate * scale, gradient, parameters, size);
+            break;
+      }
+      return;
+   }
+};
+
+/********************************************************************************
+* basic_optimizer: Instllningar fr justering av parametrar med flyttal av
+*                  typen T, se enumerationen optimizer_method. Skapas lmpligen
+*                  via ngon av de statiska medlemsfunktionerna, exempelvis
+*                  basic_optimizer<double>::adam(). Som default anvnds SGD.
+********************************************************************************/
+template <typename T>
+struct basic_optimizer
+{
+   using update_type = basic_optimizer_update<T>; /* Instllningar fr en justering. */
+
+   optimizer_method method{optimizer_method::sgd}; /* Metod fr justering. */
+   T momentum{T(0.9)};                            /* Momentum (momentum och nesterov). */
+   T beta1{T(0.9)};                               /* Avklingning fr m (adam). */
+   T beta2{T(0.999)};                             /* Avklingning fr s (rmsprop och adam). */
+   T epsilon{T(1e-8)};                            /* Term som frhindrar division med 0. */
+
+   /********************************************************************************
+   * sgd: Returnerar instllningar fr vanlig gradientnedstigning.
+   ********************************************************************************/
+   static basic_optimizer sgd(void)
+   {
+      return basic_optimizer();
+   }
+
+   /********************************************************************************
+   * with_momentum: Returnerar instllningar fr gradientnedstigning med momentum.
+   *
+   *                - momentum: Andel av fregende riktning som behlls
+   *                            (default = 0.9).
+   *                - nesterov: Indikerar ifall Nesterovs variant ska anvndas,
+   *                            dr bidraget utvrderas efter steget i
+   *                            fregende riktning (default = false).
+   ********************************************************************************/
+   static basic_optimizer with_momentum(const T momentum = T(0.9),
+                                        const bool nesterov = false)
+   {
+      basic_optimizer optimizer;
+      optimizer.method = nesterov ? optimizer_method::nesterov : optimizer_method::momentum;
+      optimizer.momentum = momentum;
+      return optimizer;
+   }
+
+   /********************************************************************************
+   * rmsprop: Returnerar instllningar fr RMSProp.
+   *
+   *          - decay  : Avklingning fr medelvrdet av kvadrerade bidrag
+   *                     (default = 0.9).
+   *          - epsilon: Term som frhindrar division med 0 (default = 1e-8).
+   ********************************************************************************/
+   static basic_optimizer rmsprop(const T decay = T(0.9),
+                                  const T epsilon = T(1e-8))
+   {
+      basic_optimizer optimizer;
+      optimizer.method = optimizer_method::rmsprop;
+      optimizer.beta2 = decay;
+      optimizer.epsilon = epsilon;
+      return optimizer;
+   }
+
+   /********************************************************************************
+   * adam: Returnerar instllningar fr Adam.
+   *
+   *       - beta1  : Avklingning fr medelvrdet av bidragen (default = 0.9).
+   *       - beta2  : Avklingning fr medelvrdet av kvadrerade bidrag
+   *                  (default = 0.999).
+   *       - epsilon: Term som frhindrar division med 0 (default = 1e-8).
+   ********************************************************************************/
+   static basic_optimizer adam(const T beta1 = T(0.9),
+                               const T beta2 = T(0.999),
+                               const T epsilon = T(1e-8))
+   {
+      basic_optimizer optimizer;
+      optimizer.method = optimizer_method::adam;
+      optimizer.beta1 = beta1;
+      optimizer.beta2 = beta2;
+      optimizer.epsilon = epsilon;
+      return optimizer;
+   }
+
+   /********************************************************************************
+   * uses_moment1: Indikerar ifall vald metod krver frsta ordningens tillstnd.
+   ********************************************************************************/
+   bool uses_moment1(void) const
+   {
+      return this->method == optimizer_method::momentum ||
+             this->method == optimizer_method::nesterov ||
+             this->method == optimizer_method::adam;
+   }
+
+   /********************************************************************************
+   * uses_moment2: Indikerar ifall vald metod krver andra ordningens tillstnd.
+   ********************************************************************************/
+   bool uses_moment2(void) const
+   {
+      return this->method == optimizer_method::rmsprop ||
+             this->method == optimizer_method::adam;
+   }
+
+   /********************************************************************************
+   * update: Returnerar instllningar fr angiven justering. Vid Adam korrigeras
+   *         lrhastigheten och epsilon fr att momenten startar p 0, vilket
+   *         motsvarar att m och s divideras med (1 - beta1^step) respektive
+   *         (1 - beta2^step).
+   *
+   *         - learning_rate: Lrhastigheten fr aktuell justering.
+   *         - step         : Justeringens ordningsnummer, rknat frn 1.
+   ********************************************************************************/
+   update_type update(const T learning_rate,
+                      const std::size_t step) const
+   {
+      update_type result{ this->method, learning_rate, this->momentum, this->beta1, this->beta2, this->epsilon };
+
+      if (this->method == optimizer_method::adam)
+      {
+         const auto exponent = static_cast<T>(step > 0 ? step : 1);
+         const auto correction1 = T(1) - std::pow(this->beta1, exponent);
+         const auto correction2 = std::sqrt(T(1) - std::pow(this->beta2, exponent));
+         result.rate = learning_rate * correction2 / correction1;
+         result.epsilon = this->epsilon * correction2;
+      }
+      return result;
+   }
+};
+
+/********************************************************************************
+* basic_schedule: Schemalggning av lrhastigheten under trning med flyttal
+*                 av typen T, se enumerationen schedule_method. Lrhastigheten
+*                 berknas en gng per epok. Som default anvnds samma
+*                 lrhastighet under samtliga epoker.
+********************************************************************************/
+template <typename T>
+struct basic_schedule
+{
+   schedule_method method{schedule_method::constant}; /* Metod fr schemalggning. */
+   std::size_t step_size{10};                         /* Antalet epoker per steg (step). */
+   T gamma{T(0.1)};                                   /* Faktor per steg (step). */
+   T min_rate{T(0)};                                  /* Lrhastighet vid sista epoken (cosine). */
+
+   /********************************************************************************
+   * constant: Returnerar en schemalggning med konstant lrhastighet.
+   ********************************************************************************/
+   static basic_schedule constant(void)
+   {
+      return basic_schedule();
+   }
+
+   /********************************************************************************
+   * step: Returnerar en schemalggning dr lrhastigheten multipliceras med
+   *       angiven faktor efter angivet antal epoker.
+   *
+   *       - step_size: Antalet epoker per steg.
+   *       - gamma    : Faktor som lrhastigheten multipliceras med per steg.
+   ********************************************************************************/
+   static basic_schedule step(const std::size_t step_size,
+                              const T gamma = T(0.1))
+   {
+      basic_schedule schedule;
+      schedule.method = schedule_method::step;
+      schedule.step_size = step_size;
+      schedule.gamma = gamma;
+      return schedule;
+   }
+
+   /********************************************************************************
+   * cosine: Returnerar en schemalggning dr lrhastigheten minskar lngs en
+   *         halv cosinusperiod frn angiven lrhastighet vid frsta epoken
+   *         till angiven minsta lrhastighet vid sista epoken.
+   *
+   *         - min_rate: Lrhastigheten vid sista epoken (default = 0).
+   ********************************************************************************/
+   static basic_schedule cosine(const T min_rate = T(0))
+   {
+      basic_schedule schedule;
+      schedule.method = schedule_method::cosine;
+      schedule.min_rate = min_rate;
+      return schedule;
+   }
+
+   /********************************************************************************
+   * rate: Returnerar lrhastigheten fr angiven epok.
+   *
+   *       - learning_rate: Lrhastigheten vid frsta epoken.
+   *       - epoch        : Aktuell epok, rknat frn 0.
+   *       - num_epochs   : Antalet epoker som trningen omfattar.
+   ********************************************************************************/
+   T rate(const T learning_rate,
+          const std::size_t epoch,
+          const std::size_t num_epochs) const
+   {
+      if (this->method == schedule_method::step && this->step_size > 0)
+      {
+         return learning_rate * std::pow(this->gamma, static_cast<T>(epoch / this->step_size));
+      }
+      else if (this->method == schedule_method::cosine && num_epochs > 1)
+      {
+         const auto pi = T(3.14159265358979323846);
+         const auto progress = static_cast<T>(epoch) / static_cast<T>(num_epochs - 1);
+         return this->min_rate + (learning_rate - this->min_rate) * (T(1) + std::cos(pi * progress)) / T(2);
+      }
+      return learning_rate;
+   }
+};
+
+#endif /* OPTIMIZER_HPP_ */
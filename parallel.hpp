@@ -0,0 +1,171 @@
+/********************************************************************************
+* parallel.hpp: Innehller funktionalitet fr synkronisering av trdar vid
+*               parallell trning via klassen barrier, asynkron krning av
+*               uppgifter i ordning via klassen task_queue samt funktionen
+*               default_num_threads.
+********************************************************************************/
+#ifndef PARALLEL_HPP_
+#define PARALLEL_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <deque>
+#include <cstddef>
+
+/********************************************************************************
+* barrier: Klass fr synkronisering av ett fast antal trdar, dr varje trd
+*          som anropar medlemsfunktionen wait vntar tills samtliga trdar har
+*          ntt samma punkt. Drefter kan barriren teranvndas direkt, d
+*          varje passage rknas som en ny generation.
+********************************************************************************/
+class barrier
+{
+public:
+   /********************************************************************************
+   * barrier: Initierar ny barrir fr angivet antal trdar.
+   *
+   *          - num_threads: Antalet trdar som ska synkroniseras.
+   ********************************************************************************/
+   explicit barrier(const std::size_t num_threads)
+      : num_threads_{num_threads}, num_waiting_{0}, generation_{0} { }
+
+   barrier(const barrier&) = delete;
+   barrier& operator=(const barrier&) = delete;
+
+   /********************************************************************************
+   * wait: Blockerar anropande trd tills samtliga trdar har anropat wait.
+   *       Samtliga skrivningar som gjorts fre anropet r synliga fr vriga
+   *       trdar efter att anropet har slutfrts.
+   ********************************************************************************/
+   void wait(void)
+   {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      const auto generation = this->generation_;
+
+      if (++this->num_waiting_ == this->num_threads_)
+      {
+         this->num_waiting_ = 0;
+         this->generation_++;
+         this->condition_.notify_all();
+      }
+      else
+      {
+         this->condition_.wait(lock, [&] { return generation != this->generation_; });
+      }
+      return;
+   }
+
+private:
+   std::mutex mutex_;                  /* Skyddar rknarna nedan. */
+   std::condition_variable condition_; /* Vcker vntande trdar. */
+   std::size_t num_threads_;           /* Antalet trdar som synkroniseras. */
+   std::size_t num_waiting_;           /* Antalet trdar som fr nrvarande vntar. */
+   std::size_t generation_;            /* Rknas upp vid varje passage. */
+};
+
+/********************************************************************************
+* task_queue: Klass fr asynkron krning av uppgifter via en egen trd, dr
+*             uppgifterna krs en i taget i samma ordning som de lades till.
+*             Exempelvis kan kommunikation fr ett lager pbrjas medan
+*             anropande trd fortstter att berkna nsta lager, dr samtliga
+*             uppgifter sedan invntas via medlemsfunktionen wait.
+********************************************************************************/
+class task_queue
+{
+public:
+   /********************************************************************************
+   * task_queue: Initierar ny k och startar kns trd.
+   ********************************************************************************/
+   task_queue(void)
+      : thread_(&task_queue::run, this) { }
+
+   task_queue(const task_queue&) = delete;
+   task_queue& operator=(const task_queue&) = delete;
+
+   /********************************************************************************
+   * ~task_queue: Kr kvarvarande uppgifter och avslutar kns trd.
+   ********************************************************************************/
+   ~task_queue(void)
+   {
+      {
+         std::lock_guard<std::mutex> lock(this->mutex_);
+         this->stopping_ = true;
+         this->condition_.notify_all();
+      }
+      this->thread_.join();
+      return;
+   }
+
+   /********************************************************************************
+   * push: Lgger till angiven uppgift sist i kn.
+   *
+   *       - task: Uppgiften som ska kras av kns trd.
+   ********************************************************************************/
+   void push(std::function<void()> task)
+   {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->tasks_.push_back(std::move(task));
+      this->condition_.notify_all();
+      return;
+   }
+
+   /********************************************************************************
+   * wait: Blockerar anropande trd tills samtliga tillagda uppgifter har krts.
+   *       Samtliga skrivningar som uppgifterna har gjort r drefter synliga
+   *       fr anropande trd.
+   ********************************************************************************/
+   void wait(void)
+   {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+      this->condition_.wait(lock, [&] { return this->tasks_.empty() && !this->running_; });
+      return;
+   }
+
+private:
+   /********************************************************************************
+   * run: Kns huvudloop, dr uppgifterna krs utan lsning i tur och ordning.
+   ********************************************************************************/
+   void run(void)
+   {
+      std::unique_lock<std::mutex> lock(this->mutex_);
+
+      while (true)
+      {
+         this->condition_.wait(lock, [&] { return this->stopping_ || !this->tasks_.empty(); });
+         if (this->tasks_.empty()) return;
+         auto task = std::move(this->tasks_.front());
+         this->tasks_.pop_front();
+         this->running_ = true;
+         lock.unlock();
+         task();
+         lock.lock();
+         this->running_ = false;
+         this->condition_.notify_all();
+      }
+   }
+
+   std::mutex mutex_;                        /* Skyddar kns tillstnd nedan. */
+   std::condition_variable condition_;       /* Vcker vntande trdar vid ndringar i kn. */
+   std::deque<std::function<void()>> tasks_; /* Uppgifter som nnu inte har krts. */
+   bool running_{false};                     /* Indikerar ifall en uppgift krs. */
+   bool stopping_{false};                    /* Indikerar ifall kns trd ska avslutas. */
+   std::thread thread_;                      /* Kns trd, vilken startas sist. */
+};
+
+/********************************************************************************
+* default_num_threads: Returnerar angivet antal trdar, eller antalet
+*                      tillgngliga hrdvarutrdar om angivet antal r 0.
+*
+*                      - num_threads: nskat antal trdar (0 = automatiskt).
+********************************************************************************/
+inline std::size_t default_num_threads(const std::size_t num_threads = 0)
+{
+   if (num_threads > 0) return num_threads;
+   const auto hardware_threads = std::thread::hardware_concurrency();
+   return hardware_threads > 0 ? hardware_threads : 1;
+}
+
+#endif /* PARALLEL_HPP_ */
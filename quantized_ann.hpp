@@ -0,0 +1,394 @@
+/********************************************************************************
+* quantized_ann.hpp: Innehller kvantiserad prediktion via klasstemplaten
+*                    basic_quantized_ann, dr ett trnat neuralt ntverks
+*                    vikter konverteras till heltal om 8 bitar med en
+*                    skalfaktor per nod (rad), vilket gr att vikterna krver
+*                    en ttondel av minnet jmfrt med double. Vid prediktion
+*                    kvantiseras ven varje lagers insignaler, varefter
+*                    skalrprodukterna berknas via heltalskrnorna i strukten
+*                    int8_kernels (VNNI respektive dotprod dr det stds).
+********************************************************************************/
+#ifndef QUANTIZED_ANN_HPP_
+#define QUANTIZED_ANN_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "ann.hpp"
+#include "simd.hpp"
+#include "activation.hpp"
+#include "matrix.hpp"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+/********************************************************************************
+* basic_quantization_report: Jmfrelse mellan ett kvantiserat ntverk och
+*                            flyttalsntverket det skapades frn, berknad
+*                            via flyttalsntverkets trningsdata. Samtliga
+*                            avvikelser anges per utsignal.
+********************************************************************************/
+template <typename T>
+struct basic_quantization_report
+{
+   std::size_t num_samples{0};     /* Antalet jmfrda trningsuppsttningar. */
+   T max_error{0};                 /* Strsta absoluta avvikelse mot flyttalsntverket. */
+   T mean_error{0};                /* Genomsnittlig absolut avvikelse mot flyttalsntverket. */
+   T mse{0};                       /* Medelkvadratisk avvikelse mot flyttalsntverket. */
+   T agreement{0};                 /* Andel (0 - 1) trningsuppsttningar med samma klass. */
+   T float_loss{0};                /* Flyttalsntverkets medelkvadratfel mot referensvrdena. */
+   T quantized_loss{0};            /* Det kvantiserade ntverkets medelkvadratfel mot referensvrdena. */
+   std::size_t float_bytes{0};     /* Minnesbehov fr flyttalsntverkets bias och vikter. */
+   std::size_t quantized_bytes{0}; /* Minnesbehov fr det kvantiserade ntverkets parametrar. */
+};
+
+/********************************************************************************
+* basic_quantized_ann: Klass fr kvantiserad prediktion via ett trnat neuralt
+*                      ntverk med flyttal av typen T. Varje viktrad lagras
+*                      som heltal mellan -127 och 127 tillsammans med en
+*                      skalfaktor, dr radens strsta absoluta vikt motsvarar
+*                      127. Bias lagras fortfarande som flyttal, d varje nod
+*                      enbart har ett biasvrde och en gemensam skalfaktor fr
+*                      bias och vikter annars skulle ge stora avrundningsfel.
+*                      Insignalerna till varje lager kvantiseras p samma stt
+*                      vid varje prediktion, varefter nodernas summor berknas
+*                      som bias + (viktskala * insignalsskala) * heltalsprodukt
+*                      och aktiveras enligt respektive lagers
+*                      aktiveringsfunktion. Det kvantiserade ntverket r
+*                      fristende, vilket gr att flyttalsntverket kan frigras
+*                      efter kvantiseringen.
+********************************************************************************/
+template <typename T>
+class basic_quantized_ann
+{
+public:
+   using value_type = T;                                                         /* Flyttalstyp fr in- och utdata. */
+   using ann_type = basic_ann<T>;                                                /* Flyttalsntverket som kvantiseras. */
+   using layer_type = basic_dense_layer<T>;                                      /* Flyttalsntverkets dense-lager. */
+   using report_type = basic_quantization_report<T>;                             /* Jmfrelse mot flyttalsntverket. */
+   using buffer_type = std::vector<std::int8_t, aligned_allocator<std::int8_t>>; /* Cache-linjejusterade heltal. */
+
+private:
+   /********************************************************************************
+   * quantized_layer: Kvantiserade parametrar fr ett dense-lager, dr varje
+   *                  viktrad startar p en ny cache-linje.
+   ********************************************************************************/
+   struct quantized_layer
+   {
+      buffer_type weights;                                       /* Kvantiserade vikter, en rad per nod. */
+      std::vector<T> scales;                                     /* Skalfaktor fr varje viktrad. */
+      std::vector<T> bias;                                       /* Nodernas bias. */
+      std::size_t num_weights{0};                                /* Antalet vikter per nod. */
+      std::size_t stride{0};                                     /* Antalet heltal per rad inklusive utfyllnad. */
+      activation_function activation{activation_function::relu}; /* Lagrets aktiveringsfunktion. */
+   };
+
+   std::vector<quantized_layer> layers_; /* Kvantiserade dolda lager fljt av utgngslagret. */
+   std::vector<std::vector<T>> outputs_; /* Utsignaler fr varje lager. */
+   buffer_type input_;                   /* Kvantiserade insignaler fr aktuellt lager. */
+
+   static constexpr std::size_t alignment = 64; /* Radlngden avrundas uppt till en multipel av 64 byte. */
+   static constexpr T max_value = T(127);       /* Strsta heltal efter kvantisering. */
+
+   /********************************************************************************
+   * quantize_values: Kvantiserar angivna flyttal till heltal mellan -127 och
+   *                  127, dr det strsta absoluta vrdet motsvarar 127 och
+   *                  vriga vrden avrundas till nrmaste heltal. Returnerar
+   *                  skalfaktorn, allts flyttalet som motsvarar heltalet 1,
+   *                  vilket r 0 om samtliga vrden r 0.
+   *
+   *                  - values     : Pekare till flyttalen som ska kvantiseras.
+   *                  - size       : Antalet flyttal.
+   *                  - destination: Pekare till buffert dr heltalen lagras.
+   ********************************************************************************/
+   static T quantize_values(const T* values,
+                            const std::size_t size,
+                            std::int8_t* destination)
+   {
+      auto max = T(0);
+
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         const auto value = std::fabs(values[i]);
+         max = value > max ? value : max;
+      }
+
+      const auto inverse = max > 0 ? max_value / max : T(0);
+
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         const auto value = values[i] * inverse;
+         destination[i] = static_cast<std::int8_t>(static_cast<std::int32_t>(value + (value < 0 ? T(-0.5) : T(0.5))));
+      }
+      return max / max_value;
+   }
+
+   /********************************************************************************
+   * feedforward: Berknar utsignaler fr angivet kvantiserat lager via angivna
+   *              insignaler, vilka frst kvantiseras till buffern input_.
+   *
+   *              - layer  : Referens till det kvantiserade lagret.
+   *              - input  : Pekare till insignalerna.
+   *              - size   : Antalet insignaler.
+   *              - outputs: Referens till vektor dr utsignalerna lagras.
+   ********************************************************************************/
+   void feedforward(const quantized_layer& layer,
+                    const T* input,
+                    const std::size_t size,
+                    std::vector<T>& outputs)
+   {
+      const auto& kernels = int8_kernels::get();
+      const auto num_inputs = layer.num_weights < size ? layer.num_weights : size;
+      const auto input_scale = quantize_values(input, num_inputs, this->input_.data());
+
+      for (std::size_t i = 0; i < outputs.size(); ++i)
+      {
+         const auto sum = kernels.dot(this->input_.data(), layer.weights.data() + i * layer.stride, num_inputs);
+         outputs[i] = layer.bias[i] + layer.scales[i] * input_scale * static_cast<T>(sum);
+      }
+
+      basic_activation<T>::activate(layer.activation, outputs.data(), outputs.size());
+      return;
+   }
+
+   /********************************************************************************
+   * classify: Returnerar klassen fr angivna utsignaler, vilken utgrs av index
+   *           fr den strsta utsignalen vid flera utsignaler, annars 1 om
+   *           utsignalen uppgr till minst 0.5, annars 0.
+   *
+   *           - output: Pekare till utsignalerna.
+   *           - size  : Antalet utsignaler.
+   ********************************************************************************/
+   static std::size_t classify(const T* output,
+                               const std::size_t size)
+   {
+      if (size == 1) return output[0] >= T(0.5) ? 1 : 0;
+      std::size_t result = 0;
+
+      for (std::size_t i = 1; i < size; ++i)
+      {
+         if (output[i] > output[result]) result = i;
+      }
+      return result;
+   }
+
+public:
+   /********************************************************************************
+   * basic_quantized_ann: Defaultkonstruktor, initierar ett tomt kvantiserat
+   *                      ntverk.
+   ********************************************************************************/
+   basic_quantized_ann(void) { }
+
+   /********************************************************************************
+   * basic_quantized_ann: Initierar kvantiserat ntverk via angivet trnat
+   *                      neuralt ntverk, se medlemsfunktionen quantize.
+   *
+   *                      - network: Referens till det trnade ntverket.
+   ********************************************************************************/
+   explicit basic_quantized_ann(const ann_type& network)
+   {
+      this->quantize(network.layers());
+      return;
+   }
+
+   /********************************************************************************
+   * quantize: Kvantiserar angivna lager, dr eventuella tidigare lager
+   *           erstts. Samtliga buffertar allokeras hr, s att ingen
+   *           allokering sker vid prediktion.
+   *
+   *           - layers: Referens till lagren som ska kvantiseras, exempelvis
+   *                     via medlemsfunktionen layers i klassen ann.
+   ********************************************************************************/
+   void quantize(const std::vector<layer_type>& layers)
+   {
+      std::size_t max_inputs = 0;
+      this->layers_.assign(layers.size(), quantized_layer());
+      this->outputs_.assign(layers.size(), std::vector<T>());
+
+      for (std::size_t i = 0; i < layers.size(); ++i)
+      {
+         const auto& source = layers[i];
+         auto& layer = this->layers_[i];
+         layer.num_weights = source.num_weights();
+         layer.stride = (layer.num_weights + alignment - 1) / alignment * alignment;
+         layer.weights.assign(source.num_nodes() * layer.stride, 0);
+         layer.scales.assign(source.num_nodes(), T(0));
+         layer.bias = source.bias;
+         layer.activation = source.activation;
+
+         for (std::size_t j = 0; j < source.num_nodes(); ++j)
+         {
+            layer.scales[j] = quantize_values(source.weights[j], layer.num_weights,
+                                              layer.weights.data() + j * layer.stride);
+         }
+
+         this->outputs_[i].assign(source.num_nodes(), T(0));
+         max_inputs = layer.stride > max_inputs ? layer.stride : max_inputs;
+      }
+
+      this->input_.assign(max_inputs, 0);
+      return;
+   }
+
+   /********************************************************************************
+   * num_inputs: Returnerar antalet insignaler.
+   ********************************************************************************/
+   std::size_t num_inputs(void) const
+   {
+      return this->layers_.empty() ? 0 : this->layers_.front().num_weights;
+   }
+
+   /********************************************************************************
+   * num_outputs: Returnerar antalet utsignaler.
+   ********************************************************************************/
+   std::size_t num_outputs(void) const
+   {
+      return this->outputs_.empty() ? 0 : this->outputs_.back().size();
+   }
+
+   /********************************************************************************
+   * num_layers: Returnerar antalet lager (dolda lager samt utgngslagret).
+   ********************************************************************************/
+   std::size_t num_layers(void) const
+   {
+      return this->layers_.size();
+   }
+
+   /********************************************************************************
+   * size_bytes: Returnerar minnesbehovet fr samtliga kvantiserade vikter,
+   *             skalfaktorer och bias, exklusive utfyllnad.
+   ********************************************************************************/
+   std::size_t size_bytes(void) const
+   {
+      std::size_t result = 0;
+
+      for (const auto& layer : this->layers_)
+      {
+         result += layer.bias.size() * (layer.num_weights + 2 * sizeof(T));
+      }
+      return result;
+   }
+
+   /********************************************************************************
+   * output: Returnerar en referens till utsignalerna frn senaste prediktion.
+   ********************************************************************************/
+   const std::vector<T>& output(void) const
+   {
+      static const std::vector<T> empty;
+      return this->outputs_.empty() ? empty : this->outputs_.back();
+   }
+
+   /********************************************************************************
+   * predict: Genomfr kvantiserad prediktion via angiven indata och returnerar
+   *          en referens till en vektor innehllande utdatan.
+   *
+   *          - input: Referens till vektor innehllande indata.
+   ********************************************************************************/
+   const std::vector<T>& predict(const std::vector<T>& input)
+   {
+      return this->predict(input.data(), input.size());
+   }
+
+   /********************************************************************************
+   * predict: Genomfr kvantiserad prediktion via indata lagrad p angiven
+   *          adress och returnerar en referens till en vektor innehllande
+   *          utdatan.
+   *
+   *          - input: Pekare till indatan.
+   *          - size : Antalet insignaler.
+   ********************************************************************************/
+   const std::vector<T>& predict(const T* input,
+                                 const std::size_t size)
+   {
+      for (std::size_t i = 0; i < this->layers_.size(); ++i)
+      {
+         if (i == 0)
+         {
+            this->feedforward(this->layers_[0], input, size, this->outputs_[0]);
+         }
+         else
+         {
+            const auto& previous = this->outputs_[i - 1];
+            this->feedforward(this->layers_[i], previous.data(), previous.size(), this->outputs_[i]);
+         }
+      }
+      return this->output();
+   }
+
+   /********************************************************************************
+   * compare: Jmfr det kvantiserade ntverket med angivet flyttalsntverk via
+   *          flyttalsntverkets trningsdata och returnerar avvikelserna per
+   *          utsignal, andelen trningsuppsttningar som erhller samma klass
+   *          (index fr strsta utsignal, alternativt avrundad utsignal vid en
+   *          utsignal), bgge ntverkens frlust mot referensvrdena samt
+   *          bgge ntverkens minnesbehov.
+   *
+   *          - network: Referens till flyttalsntverket som jmfrs.
+   ********************************************************************************/
+   report_type compare(const ann_type& network)
+   {
+      report_type report;
+      auto context = network.make_inference_context(1);
+      std::vector<T> input(network.num_inputs(), T(0));
+      std::vector<T> expected(network.num_outputs(), T(0));
+      const auto& in_view = network.train_in_view();
+      const auto& out_view = network.train_out_view();
+      std::size_t matches = 0;
+
+      for (const auto& layer : network.layers())
+      {
+         report.float_bytes += layer.num_nodes() * (layer.num_weights() + 1) * sizeof(T);
+      }
+
+      report.quantized_bytes = this->size_bytes();
+      if (network.num_outputs() != this->num_outputs() || network.num_inputs() != this->num_inputs()) return report;
+
+      for (std::size_t i = 0; i < network.num_training_sets(); ++i)
+      {
+         const auto row = in_view.empty() ? network.train_in()[i].data() : in_view[i];
+         const auto size = in_view.empty() ? network.train_in()[i].size() : in_view.columns();
+         const auto reference = out_view.empty() ? network.train_out()[i].data() : out_view[i];
+         const auto reference_size = out_view.empty() ? network.train_out()[i].size() : out_view.columns();
+
+         for (std::size_t j = 0; j < input.size(); ++j)
+         {
+            input[j] = j < size ? row[j] : T(0);
+         }
+
+         network.predict(input.data(), expected.data(), context);
+         const auto& actual = this->predict(input.data(), input.size());
+
+         for (std::size_t j = 0; j < expected.size(); ++j)
+         {
+            const auto error = actual[j] - expected[j];
+            const auto target = j < reference_size ? reference[j] : T(0);
+            const auto magnitude = std::fabs(error);
+            report.max_error = magnitude > report.max_error ? magnitude : report.max_error;
+            report.mean_error += magnitude;
+            report.mse += error * error;
+            report.float_loss += (target - expected[j]) * (target - expected[j]);
+            report.quantized_loss += (target - actual[j]) * (target - actual[j]);
+         }
+
+         if (classify(expected.data(), expected.size()) == classify(actual.data(), actual.size())) ++matches;
+         ++report.num_samples;
+      }
+
+      if (report.num_samples > 0)
+      {
+         const auto num_values = static_cast<T>(report.num_samples * this->num_outputs());
+         report.mean_error /= num_values;
+         report.mse /= num_values;
+         report.float_loss /= num_values;
+         report.quantized_loss /= num_values;
+         report.agreement = static_cast<T>(matches) / static_cast<T>(report.num_samples);
+      }
+      return report;
+   }
+};
+
+/********************************************************************************
+* quantized_ann: Kvantiserat neuralt ntverk skapat frn klassen ann.
+********************************************************************************/
+using quantized_ann = basic_quantized_ann<double>;
+
+#endif /* QUANTIZED_ANN_HPP_ */
@@ -0,0 +1,300 @@
+/********************************************************************************
+* random.hpp: Innehller funktionalitet fr generering av slumptal via klassen
+*             random_generator, vilken erstter std::rand vid initiering av
+*             parametrar samt vid randomisering av trningsordningen. Varje
+*             neuralt ntverk har en egen generator, vilket gr att krningar
+*             blir reproducerbara via medlemsfunktionen seed, ven nr flera
+*             ntverk trnas parallellt i olika trdar. Via enumerationen
+*             weight_init kan ven startvrden enligt Xavier eller He vljas.
+********************************************************************************/
+#ifndef RANDOM_HPP_
+#define RANDOM_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+/********************************************************************************
+* weight_init: Metod fr tilldelning av startvrden fr ett lagers parametrar:
+*
+*              - uniform: Bias och vikter erhller startvrden mellan 0 - 1.
+*              - xavier : Vikterna erhller startvrden mellan -a och a, dr
+*                         a = sqrt(6 / (num_weights + num_nodes)), vilket
+*                         lmpar sig fr symmetriska aktiveringsfunktioner.
+*                         Bias stts till 0.
+*              - he     : Vikterna erhller startvrden mellan -a och a, dr
+*                         a = sqrt(6 / num_weights), vilket lmpar sig fr
+*                         ReLU. Bias stts till 0.
+********************************************************************************/
+enum class weight_init { uniform, xavier, he };
+
+/********************************************************************************
+* random_generator: Klass fr snabb generering av slumptal via algoritmen
+*                   xoshiro256**, vars tillstnd om 256 bitar initieras frn
+*                   ett startvrde via splitmix64. Generatorn saknar delat
+*                   tillstnd, vilket gr att varje trd kan ha en egen
+*                   generator utan lsning. Klassen uppfyller kraven fr
+*                   UniformRandomBitGenerator och kan drmed ven anvndas
+*                   med frdelningarna i <random>.
+********************************************************************************/
+class random_generator
+{
+public:
+   using result_type = std::uint64_t;                      /* Typ fr genererade slumptal. */
+   static constexpr result_type default_seed = 0x20231012; /* Startvrde som anvnds om inget anges. */
+
+   /********************************************************************************
+   * random_generator: Initierar ny generator med angivet startvrde.
+   *
+   *                   - seed: Startvrde fr generatorn (default = default_seed).
+   ********************************************************************************/
+   explicit random_generator(const result_type seed = default_seed)
+   {
+      this->seed(seed);
+      return;
+   }
+
+   /********************************************************************************
+   * seed: Initierar om generatorns tillstnd frn angivet startvrde, vilket
+   *       gr att samma fljd av slumptal erhlls igen.
+   *
+   *       - seed: Nytt startvrde fr generatorn.
+   ********************************************************************************/
+   void seed(const result_type seed)
+   {
+      auto state = seed;
+
+      for (auto& i : this->state_)
+      {
+         i = splitmix64(state);
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * min: Returnerar det minsta slumptal som kan genereras.
+   ********************************************************************************/
+   static constexpr result_type min(void)
+   {
+      return std::numeric_limits<result_type>::min();
+   }
+
+   /********************************************************************************
+   * max: Returnerar det strsta slumptal som kan genereras.
+   ********************************************************************************/
+   static constexpr result_type max(void)
+   {
+      return std::numeric_limits<result_type>::max();
+   }
+
+   /********************************************************************************
+   * operator(): Returnerar nsta slumptal om 64 bitar.
+   ********************************************************************************/
+   inline result_type operator()(void)
+   {
+      auto& s = this->state_;
+      const auto result = rotl(s[1] * 5, 7) * 9;
+      const auto t = s[1] << 17;
+      s[2] ^= s[0];
+      s[3] ^= s[1];
+      s[1] ^= s[2];
+      s[0] ^= s[3];
+      s[2] ^= t;
+      s[3] = rotl(s[3], 45);
+      return result;
+   }
+
+   /********************************************************************************
+   * uniform: Returnerar ett likformigt frdelat flyttal i intervallet [0, 1),
+   *          dr de mest signifikanta bitarna av nsta slumptal anvnds.
+   ********************************************************************************/
+   template <typename T>
+   inline T uniform(void)
+   {
+      constexpr auto digits = std::numeric_limits<T>::digits;
+      return static_cast<T>((*this)() >> (64 - digits)) * (T(1) / static_cast<T>(result_type(1) << digits));
+   }
+
+   /********************************************************************************
+   * uniform: Returnerar ett likformigt frdelat flyttal i intervallet [min, max).
+   *
+   *          - min: Intervallets nedre grns.
+   *          - max: Intervallets vre grns.
+   ********************************************************************************/
+   template <typename T>
+   inline T uniform(const T min, const T max)
+   {
+      return min + (max - min) * this->uniform<T>();
+   }
+
+   /********************************************************************************
+   * below: Returnerar ett likformigt frdelat heltal i intervallet [0, bound)
+   *        utan den snedvridning som uppstr vid modulo, via Lemires metod med
+   *        multiplikation samt frkastning av ett ftal vrden.
+   *
+   *        - bound: vre grns, vilken mste verstiga 0.
+   ********************************************************************************/
+   inline std::size_t below(const std::size_t bound)
+   {
+      const auto range = static_cast<std::uint32_t>(bound);
+      if (static_cast<std::size_t>(range) == bound)
+      {
+         auto product = static_cast<std::uint64_t>(static_cast<std::uint32_t>((*this)() >> 32)) * range;
+         auto low = static_cast<std::uint32_t>(product);
+
+         if (low < range)
+         {
+            const auto threshold = static_cast<std::uint32_t>(0u - range) % range;
+
+            while (low < threshold)
+            {
+               product = static_cast<std::uint64_t>(static_cast<std::uint32_t>((*this)() >> 32)) * range;
+               low = static_cast<std::uint32_t>(product);
+            }
+         }
+         return static_cast<std::size_t>(product >> 32);
+      }
+
+      const auto limit = max() - max() % static_cast<result_type>(bound);
+      auto value = (*this)();
+      while (value >= limit) value = (*this)();
+      return static_cast<std::size_t>(value % static_cast<result_type>(bound));
+   }
+
+   /********************************************************************************
+   * shuffle: Blandar elementen i angiven vektor via Fisher-Yates algoritm,
+   *          dr samtliga permutationer r lika sannolika.
+   *
+   *          - data: Referens till vektorn vars element ska blandas.
+   ********************************************************************************/
+   template <typename T>
+   void shuffle(std::vector<T>& data)
+   {
+      for (std::size_t i = data.size(); i > 1; --i)
+      {
+         const auto r = this->below(i);
+         std::swap(data[i - 1], data[r]);
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * jump: Flyttar fram generatorn 2^128 steg, vilket motsvarar 2^128 anrop av
+   *       operator(). Via upprepade anrop erhlls drmed fljder som garanterat
+   *       inte verlappar, exempelvis en per trd frn samma startvrde.
+   ********************************************************************************/
+   void jump(void)
+   {
+      static constexpr result_type polynomial[] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+                                                    0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+      result_type state[4] = { 0, 0, 0, 0 };
+
+      for (const auto word : polynomial)
+      {
+         for (int bit = 0; bit < 64; ++bit)
+         {
+            if (word & (result_type(1) << bit))
+            {
+               for (int i = 0; i < 4; ++i) state[i] ^= this->state_[i];
+            }
+            (*this)();
+         }
+      }
+
+      for (int i = 0; i < 4; ++i) this->state_[i] = state[i];
+      return;
+   }
+
+   /********************************************************************************
+   * thread_local_instance: Returnerar en referens till en generator som r
+   *                        unik fr anropande trd, vilken anvnds d ingen
+   *                        generator anges. Trdarnas generatorer initieras
+   *                        frn default_seed fljt av ett hopp per tidigare
+   *                        skapad trdgenerator, vilket gr att den frsta
+   *                        trden alltid erhller samma fljd av slumptal.
+   ********************************************************************************/
+   static random_generator& thread_local_instance(void)
+   {
+      thread_local random_generator generator = make_thread_generator();
+      return generator;
+   }
+
+private:
+   /********************************************************************************
+   * rotl: Roterar angivet heltal angivet antal bitar t vnster.
+   *
+   *       - value: Heltalet som ska roteras.
+   *       - shift: Antalet bitar att rotera (1 - 63).
+   ********************************************************************************/
+   static constexpr result_type rotl(const result_type value,
+                                     const int shift)
+   {
+      return (value << shift) | (value >> (64 - shift));
+   }
+
+   /********************************************************************************
+   * splitmix64: Returnerar nsta slumptal via algoritmen splitmix64, vilken
+   *             anvnds fr att sprida ett startvrde ver generatorns
+   *             tillstnd, s att ven nrliggande startvrden ger helt
+   *             olika fljder.
+   *
+   *             - state: Referens till splitmix64-tillstndet, vilket uppdateras.
+   ********************************************************************************/
+   static result_type splitmix64(result_type& state)
+   {
+      auto z = (state += 0x9e3779b97f4a7c15);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      return z ^ (z >> 31);
+   }
+
+   /********************************************************************************
+   * make_thread_generator: Skapar generatorn fr en ny trd, se medlemsfunktionen
+   *                        thread_local_instance.
+   ********************************************************************************/
+   static random_generator make_thread_generator(void)
+   {
+      static std::atomic<std::size_t> num_threads{0};
+      const auto index = num_threads++;
+      random_generator generator;
+
+      for (std::size_t i = 0; i < index; ++i)
+      {
+         generator.jump();
+      }
+      return generator;
+   }
+
+   result_type state_[4]; /* Generatorns tillstnd om 256 bitar. */
+};
+
+/********************************************************************************
+* weight_init_limit: Returnerar grnsen a fr startvrden mellan -a och a enligt
+*                    angiven metod, se enumerationen weight_init.
+*
+*                    - init       : Metod fr tilldelning av startvrden.
+*                    - num_nodes  : Antalet noder i lagret.
+*                    - num_weights: Antalet vikter per nod i lagret.
+********************************************************************************/
+template <typename T>
+inline T weight_init_limit(const weight_init init,
+                           const std::size_t num_nodes,
+                           const std::size_t num_weights)
+{
+   if (init == weight_init::xavier && num_weights + num_nodes > 0)
+   {
+      return static_cast<T>(std::sqrt(6.0 / static_cast<double>(num_weights + num_nodes)));
+   }
+   else if (init == weight_init::he && num_weights > 0)
+   {
+      return static_cast<T>(std::sqrt(6.0 / static_cast<double>(num_weights)));
+   }
+   return T(0);
+}
+
+#endif /* RANDOM_HPP_ */
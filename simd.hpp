@@ -0,0 +1,3118 @@
+/********************************************************************************
+* simd.hpp: Innehller vektoriserade berkningskrnor (SIMD) fr dense-lager
+*           via strukten simd_kernels. Krnorna finns i en skalr
+*           referensversion samt i versioner fr AVX2, AVX-512 och NEON, bde
+*           fr flyttal av typen double och float. Strukten int8_kernels
+*           innehller motsvarande krnor fr heltal om 8 bitar, vilka
+*           anvnds vid kvantiserad prediktion. Mikrokrnan gemm anvnds av
+*           den blockade matrismultiplikationen i "gemm.hpp", medan
+*           mikrokrnan gemv anvnds av kompilerade ntverk i
+*           "compiled_ann.hpp".
+*           Vilken version som anvnds vljs automatiskt vid krning utefter
+*           processorns std, men kan ven vljas manuellt, exempelvis fr
+*           att jmfra resultatet mot referensversionen.
+*
+*           Vid kompilering med makrot ANN_DISABLE_SIMD anvnds enbart den
+*           skalra referensversionen.
+********************************************************************************/
+#ifndef SIMD_HPP_
+#define SIMD_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#if !defined(ANN_DISABLE_SIMD)
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ANN_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define ANN_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+/********************************************************************************
+* ANN_TARGET: Anger vilken instruktionsuppsttning en given funktion fr
+*             anvnda vid kompilering med GCC eller Clang, s att exempelvis
+*             AVX2-instruktioner kan anvndas utan att hela programmet
+*             kompileras fr AVX2. MSVC krver ingen motsvarighet.
+********************************************************************************/
+#if defined(__GNUC__) || defined(__clang__)
+#define ANN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ANN_TARGET(isa)
+#endif
+
+/********************************************************************************
+* ANN_UNROLL: Begr att efterfljande loop med fast antal iterationer rullas
+*             ut helt, s att exempelvis en array av ackumulatorer i en
+*             mikrokrna kan placeras i register. vriga kompilatorer rullar
+*             ut sdana loopar p egen hand.
+********************************************************************************/
+#if defined(__clang__)
+#define ANN_UNROLL _Pragma("clang loop unroll(full)")
+#elif defined(__GNUC__)
+#define ANN_UNROLL _Pragma("GCC unroll 16")
+#else
+#define ANN_UNROLL
+#endif
+
+/********************************************************************************
+* simd_support: Strukt fr detektering av vilka instruktionsuppsttningar som
+*               stds av aktuell processor. Detekteringen r gemensam fr
+*               berkningskrnorna fr samtliga flyttalstyper.
+********************************************************************************/
+struct simd_support
+{
+   /********************************************************************************
+   * isa: Enumeration fr tillgngliga instruktionsuppsttningar.
+   ********************************************************************************/
+   enum class isa { scalar, neon, avx2, avx512 };
+
+   /********************************************************************************
+   * supported: Indikerar ifall angiven instruktionsuppsttning stds bde vid
+   *            kompilering och av aktuell processor.
+   *
+   *            - type: Instruktionsuppsttningen som ska kontrolleras.
+   ********************************************************************************/
+   static bool supported(const isa type)
+   {
+      switch (type)
+      {
+         case isa::scalar:
+            return true;
+#if defined(ANN_SIMD_X86)
+         case isa::avx2:
+            return cpu_has_avx2();
+         case isa::avx512:
+            return cpu_has_avx512();
+#elif defined(ANN_SIMD_NEON)
+         case isa::neon:
+            return true;
+#endif
+         default:
+            return false;
+      }
+   }
+
+   /********************************************************************************
+   * detect: Returnerar den snabbaste instruktionsuppsttningen som stds.
+   ********************************************************************************/
+   static isa detect(void)
+   {
+      if (supported(isa::avx512)) return isa::avx512;
+      if (supported(isa::avx2)) return isa::avx2;
+      if (supported(isa::neon)) return isa::neon;
+      return isa::scalar;
+   }
+
+   /********************************************************************************
+   * name: Returnerar namnet p angiven instruktionsuppsttning som text.
+   *
+   *       - type: Aktuell instruktionsuppsttning.
+   ********************************************************************************/
+   static const char* name(const isa type)
+   {
+      switch (type)
+      {
+         case isa::neon:   return "neon";
+         case isa::avx2:   return "avx2";
+         case isa::avx512: return "avx512";
+         default:          return "scalar";
+      }
+   }
+
+protected:
+#if defined(ANN_SIMD_X86)
+   /********************************************************************************
+   * cpuid: Lser processorinformation fr angivet lv (leaf) samt dellv.
+   ********************************************************************************/
+   static void cpuid(const int leaf, const int subleaf, unsigned int regs[4])
+   {
+#if defined(_MSC_VER)
+      int data[4];
+      __cpuidex(data, leaf, subleaf);
+      for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned int>(data[i]);
+#else
+      __asm__ __volatile__("cpuid"
+                           : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]), "=d"(regs[3])
+                           : "a"(leaf), "c"(subleaf));
+#endif
+      return;
+   }
+
+   /********************************************************************************
+   * os_xsave_mask: Returnerar de register som operativsystemet sparar vid
+   *                trdbyte (XCR0), vilket krvs fr att AVX-register ska
+   *                kunna anvndas. Returnerar 0 om XSAVE inte stds.
+   ********************************************************************************/
+   static unsigned long long os_xsave_mask(void)
+   {
+      unsigned int regs[4];
+      cpuid(1, 0, regs);
+      if (!(regs[2] & (1u << 27))) return 0;
+#if defined(_MSC_VER)
+      return _xgetbv(0);
+#else
+      unsigned int low, high;
+      __asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+      return (static_cast<unsigned long long>(high) << 32) | low;
+#endif
+   }
+
+   /********************************************************************************
+   * cpu_has_avx2: Indikerar ifall processorn och operativsystemet stder AVX2
+   *               samt FMA.
+   ********************************************************************************/
+   static bool cpu_has_avx2(void)
+   {
+      unsigned int regs[4];
+      if ((os_xsave_mask() & 0x6) != 0x6) return false;
+      cpuid(1, 0, regs);
+      const bool fma = (regs[2] & (1u << 12)) != 0;
+      cpuid(7, 0, regs);
+      return fma && (regs[1] & (1u << 5)) != 0;
+   }
+
+   /********************************************************************************
+   * cpu_has_avx512: Indikerar ifall processorn och operativsystemet stder
+   *                 AVX-512 (grunduppsttningen AVX512F).
+   ********************************************************************************/
+   static bool cpu_has_avx512(void)
+   {
+      unsigned int regs[4];
+      if ((os_xsave_mask() & 0xE6) != 0xE6) return false;
+      cpuid(7, 0, regs);
+      return cpu_has_avx2() && (regs[1] & (1u << 16)) != 0;
+   }
+
+   /********************************************************************************
+   * cpu_has_avx512bw: Indikerar ifall processorn stder AVX-512 fr heltal om
+   *                   8 och 16 bitar (AVX512BW).
+   ********************************************************************************/
+   static bool cpu_has_avx512bw(void)
+   {
+      unsigned int regs[4];
+      if (!cpu_has_avx512()) return false;
+      cpuid(7, 0, regs);
+      return (regs[1] & (1u << 30)) != 0;
+   }
+
+   /********************************************************************************
+   * cpu_has_avx512_vnni: Indikerar ifall processorn stder instruktionerna fr
+   *                      skalrprodukter av heltal om 8 bitar (AVX512_VNNI).
+   ********************************************************************************/
+   static bool cpu_has_avx512_vnni(void)
+   {
+      unsigned int regs[4];
+      if (!cpu_has_avx512bw()) return false;
+      cpuid(7, 0, regs);
+      return (regs[2] & (1u << 11)) != 0;
+   }
+#endif
+};
+
+/********************************************************************************
+* basic_simd_kernels: Strukt innehllande pekare till berkningskrnorna som
+*                     anvnds av dense-lager med flyttal av typen T (float
+*                     eller double). Samtliga krnor utfr samma berkning som
+*                     motsvarande skalra referensversion, men summerings-
+*                     ordningen kan skilja sig t, vilket kan ge avrundnings-
+*                     skillnader i sista decimalen:
+*
+*                     - dot       : Returnerar skalrprodukten av x och y.
+*                     - axpy      : Berknar y += alpha * x.
+*                     - relu      : Stter samtliga negativa vrden i data till 0.
+*                     - delta_relu: Multiplicerar error med derivatan av ReLU-
+*                                   funktionen, allts nollstller felet fr
+*                                   samtliga noder vars utsignal inte
+*                                   verstiger 0.
+*                     - exp       : Erstter samtliga vrden i data med e^x.
+*                     - sigmoid   : Erstter samtliga vrden i data med
+*                                   1 / (1 + e^-x).
+*                     - tanh      : Erstter samtliga vrden i data med tanh(x).
+*                     - sparse_dot: Returnerar skalrprodukten av values och de
+*                                   element i x som anges av indices, allts
+*                                   summan av values[i] * x[indices[i]], vilket
+*                                   anvnds av glesa lager (CSR). Elementen i
+*                                   x hmtas via gather-instruktioner.
+*                     - momentum  : Justerar parameters enligt momentum eller,
+*                                   om nesterov r satt, Nesterovs variant.
+*                     - rmsprop   : Justerar parameters enligt RMSProp.
+*                     - adam      : Justerar parameters enligt Adam, se
+*                                   enumerationen optimizer_method i
+*                                   "optimizer.hpp". Tillstnd som
+*                                   understiger minsta normaliserade flyttal
+*                                   nollstlls av samtliga tre krnor.
+*
+*                     Krnorna exp, sigmoid och tanh anvnder i de vektoriserade
+*                     versionerna en approximation av exponentialfunktionen via
+*                     ett polynom, vilken ger ett relativt fel av samma
+*                     storleksordning som avrundningsfelet fr aktuell
+*                     flyttalstyp, medan referensversionen anvnder <cmath>.
+*                     Liksom std::exp ger exp ondligheten vid verfld, 0 vid
+*                     underfld och subnormala tal dremellan, i samtliga
+*                     instruktionsuppsttningar.
+*                     Krnan tanh berknar i versionerna fr AVX2 och AVX-512
+*                     sm argument via en Taylorserie, s att det relativa
+*                     felet frblir litet ven nra 0.
+*
+*                     Versionerna fr float behandlar dubbelt s mnga element
+*                     per instruktion som versionerna fr double.
+********************************************************************************/
+template <typename T>
+struct basic_simd_kernels : simd_support
+{
+   static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                 "basic_simd_kernels requires float or double!");
+
+   isa type;                                                        /* Instruktionsuppsttning. */
+   T (*dot)(const T* x, const T* y, std::size_t size);              /* Skalrprodukt. */
+   void (*axpy)(T alpha, const T* x, T* y, std::size_t size);       /* y += alpha * x. */
+   void (*relu)(T* data, std::size_t size);                         /* ReLU p plats. */
+   void (*delta_relu)(T* error, const T* output, std::size_t size); /* Fel * ReLU'. */
+   void (*exp)(T* data, std::size_t size);                          /* e^x p plats. */
+   void (*sigmoid)(T* data, std::size_t size);                      /* 1 / (1 + e^-x) p plats. */
+   void (*tanh)(T* data, std::size_t size);                         /* tanh(x) p plats. */
+   T (*sparse_dot)(const T* values, const std::uint32_t* indices,
+                   const T* x, std::size_t size);                   /* Gles skalrprodukt. */
+   void (*gemm)(std::size_t depth, const T* a, const T* b,
+                T* c, std::size_t stride);                          /* C += A * B fr ett block. */
+   std::size_t gemm_rows;                                           /* Antalet rader i gemms block. */
+   std::size_t gemm_columns;                                        /* Antalet kolumner i gemms block. */
+   void (*gemv)(std::size_t depth, const T* a, const T* x,
+                const T* bias, T* y, bool relu);                    /* y = bias + A * x fr en panel. */
+   void (*momentum)(T rate, T momentum, T scale, const T* gradient,
+                    T* velocity, T* parameters, std::size_t size,
+                    bool nesterov);                                 /* Momentum eller Nesterov. */
+   void (*rmsprop)(T rate, T beta2, T epsilon, T scale,
+                   const T* gradient, T* moment2,
+                   T* parameters, std::size_t size);                /* RMSProp. */
+   void (*adam)(T rate, T beta1, T beta2, T epsilon, T scale,
+                const T* gradient, T* moment1, T* moment2,
+                T* parameters, std::size_t size);                   /* Adam. */
+
+   /********************************************************************************
+   * get: Returnerar en referens till de berkningskrnor som fr nrvarande
+   *      anvnds. Vid frsta anropet vljs den snabbaste version som stds av
+   *      processorn.
+   ********************************************************************************/
+   static const basic_simd_kernels& get(void)
+   {
+      return active();
+   }
+
+   /********************************************************************************
+   * get: Returnerar berkningskrnorna fr angiven instruktionsuppsttning.
+   *      Om angiven instruktionsuppsttning inte r tillgnglig vid kompilering
+   *      returneras den skalra referensversionen. Rtt version fr aktuell
+   *      flyttalstyp vljs via verlagring.
+   *
+   *      - type: nskad instruktionsuppsttning.
+   ********************************************************************************/
+   static basic_simd_kernels get(const isa type)
+   {
+#if defined(ANN_SIMD_X86)
+      if (type == isa::avx512) return { {}, isa::avx512, dot_avx512, axpy_avx512, relu_avx512, delta_relu_avx512,
+                                        exp_avx512, sigmoid_avx512, tanh_avx512, sparse_dot_avx512,
+                                        gemm_avx512, gemm_rows_avx512, gemm_columns_avx512, gemv_avx512,
+                                        momentum_avx512, rmsprop_avx512, adam_avx512 };
+      if (type == isa::avx2) return { {}, isa::avx2, dot_avx2, axpy_avx2, relu_avx2, delta_relu_avx2,
+                                      exp_avx2, sigmoid_avx2, tanh_avx2, sparse_dot_avx2,
+                                      gemm_avx2, gemm_rows_avx2, gemm_columns_avx2, gemv_avx2,
+                                      momentum_avx2, rmsprop_avx2, adam_avx2 };
+#elif defined(ANN_SIMD_NEON)
+      if (type == isa::neon) return { {}, isa::neon, dot_neon, axpy_neon, relu_neon, delta_relu_neon,
+                                      exp_neon, sigmoid_neon, tanh_neon, sparse_dot_neon,
+                                      gemm_neon, gemm_rows_neon, gemm_columns_neon, gemv_neon,
+                                      momentum_neon, rmsprop_neon, adam_neon };
+#endif
+      (void)type;
+      return { {}, isa::scalar, dot_scalar, axpy_scalar, relu_scalar, delta_relu_scalar,
+               exp_scalar, sigmoid_scalar, tanh_scalar, sparse_dot_scalar,
+               gemm_scalar, gemm_rows_scalar, gemm_columns_scalar, gemv_scalar,
+               momentum_scalar, rmsprop_scalar, adam_scalar };
+   }
+
+   /********************************************************************************
+   * select: Vljer vilken instruktionsuppsttning som ska anvndas av samtliga
+   *         dense-lager med flyttal av typen T. Om processorn inte stder
+   *         angiven instruktionsuppsttning vljs den skalra referensversionen.
+   *         OBS! Fr inte anropas medan trning eller prediktion pgr i en
+   *         annan trd.
+   *
+   *         - type: nskad instruktionsuppsttning.
+   ********************************************************************************/
+   static void select(const isa type)
+   {
+      active() = supported(type) ? get(type) : get(isa::scalar);
+      return;
+   }
+
+private:
+   /********************************************************************************
+   * active: Returnerar en referens till de berkningskrnor som fr nrvarande
+   *         anvnds, vilka initieras vid frsta anropet.
+   ********************************************************************************/
+   static basic_simd_kernels& active(void)
+   {
+      static basic_simd_kernels kernels = get(detect());
+      return kernels;
+   }
+
+   /********************************************************************************
+   * Konstanter fr de vektoriserade approximationerna av exponentialfunktionen.
+   * Argumentet x begrnsas frst till ett intervall strax utanfr det dr
+   * e^x r ndligt och skilt frn 0, s att strre argument ger ondligheten
+   * och mindre argument ger 0, precis som std::exp. Drefter delas x upp i
+   * n * ln(2) + r, dr n r ett heltal och |r| <= ln(2) / 2. Produkten
+   * n * ln(2) dras av i tv steg (hi + lo) fr att behlla precisionen i r.
+   * Sedan berknas e^r via Taylorpolynomet nedan (Horners metod, hgsta graden
+   * frst) och resultatet skalas med 2^n. Versionerna fr AVX-512 skalar med
+   * scalef, medan versionerna fr AVX2 och NEON multiplicerar med faktorerna
+   * 2^(n / 2) och 2^(n - n / 2), vilka bda r normaliserade, s att ven
+   * verfld och subnormala resultat avrundas korrekt.
+   ********************************************************************************/
+   static constexpr double exp_min_f64 = -746.0;                   /* Minsta argument (double). */
+   static constexpr double exp_max_f64 = 710.0;                    /* Strsta argument (double). */
+   static constexpr double ln2_hi_f64 = 0.693145751953125;         /* ln(2), vre del (double). */
+   static constexpr double ln2_lo_f64 = 1.42860682030941723212e-6; /* ln(2), nedre del (double). */
+   static constexpr float exp_min_f32 = -104.0f;                   /* Minsta argument (float). */
+   static constexpr float exp_max_f32 = 89.0f;                     /* Strsta argument (float). */
+   static constexpr float ln2_hi_f32 = 0.693359375f;               /* ln(2), vre del (float). */
+   static constexpr float ln2_lo_f32 = -2.12194440e-4f;            /* ln(2), nedre del (float). */
+   static constexpr double log2e = 1.44269504088896340736;         /* 1 / ln(2). */
+
+   static constexpr double exp_poly_f64[] = { 1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0,
+                                              1.0 / 3628800.0, 1.0 / 362880.0, 1.0 / 40320.0, 1.0 / 5040.0,
+                                              1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0 };
+   static constexpr float exp_poly_f32[] = { 1.0f / 5040.0f, 1.0f / 720.0f, 1.0f / 120.0f, 1.0f / 24.0f,
+                                             1.0f / 6.0f, 0.5f, 1.0f, 1.0f };
+
+   /********************************************************************************
+   * Konstanter fr de vektoriserade approximationerna av tanh, som berknas
+   * som (1 - e) / (1 + e) med e = e^-2x. Nra 0 tar tljarens termer nstan ut
+   * varandra, varfr |x| < tanh_small i versionerna fr AVX2 och AVX-512 i
+   * stllet berknas via Taylorserien x + x^3 * p(x^2), dr polynomet p nedan
+   * anges med hgsta graden frst.
+   * Vid grnsen r det relativa felet fr bda uttrycken hgst ett ftal
+   * avrundningsfel. Argumentet till e begrnsas till |x| <= tanh_max, dr
+   * tanh(x) redan avrundas till +-1, s att e aldrig blir ondligt.
+   ********************************************************************************/
+   static constexpr double tanh_small = 0.125;                     /* Grns fr Taylorserien. */
+   static constexpr double tanh_max = 20.0;                        /* Grns fr e^-2x. */
+   static constexpr double tanh_poly_f64[] = { -929569.0 / 638512875.0, 21844.0 / 6081075.0, -1382.0 / 155925.0,
+                                               62.0 / 2835.0, -17.0 / 315.0, 2.0 / 15.0, -1.0 / 3.0 };
+   static constexpr float tanh_poly_f32[] = { -17.0f / 315.0f, 2.0f / 15.0f, -1.0f / 3.0f };
+
+   /********************************************************************************
+   * Skalra referensversioner, vilka motsvarar de ursprungliga looparna i
+   * strukten dense_layer.
+   ********************************************************************************/
+   static T dot_scalar(const T* x, const T* y, const std::size_t size)
+   {
+      T sum = 0;
+
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         sum += x[i] * y[i];
+      }
+      return sum;
+   }
+
+   static void axpy_scalar(const T alpha, const T* x, T* y, const std::size_t size)
+   {
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         y[i] += alpha * x[i];
+      }
+      return;
+   }
+
+   static void relu_scalar(T* data, const std::size_t size)
+   {
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         data[i] = data[i] > 0 ? data[i] : 0;
+      }
+      return;
+   }
+
+   static void delta_relu_scalar(T* error, const T* output, const std::size_t size)
+   {
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         error[i] = output[i] > 0 ? error[i] : 0;
+      }
+      return;
+   }
+
+   static void exp_scalar(T* data, const std::size_t size)
+   {
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         data[i] = std::exp(data[i]);
+      }
+      return;
+   }
+
+   static void sigmoid_scalar(T* data, const std::size_t size)
+   {
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         data[i] = T(1) / (T(1) + std::exp(-data[i]));
+      }
+      return;
+   }
+
+   static void tanh_scalar(T* data, const std::size_t size)
+   {
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         data[i] = std::tanh(data[i]);
+      }
+      return;
+   }
+
+   static T sparse_dot_scalar(const T* values, const std::uint32_t* indices, const T* x, const std::size_t size)
+   {
+      T sum = 0;
+
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         sum += values[i] * x[indices[i]];
+      }
+      return sum;
+   }
+
+   /********************************************************************************
+   * flush: Returnerar 0 om beloppet av angivet tillstnd understiger minsta
+   *        normaliserade flyttal, annars tillstndet. Tillstnd fr parametrar
+   *        vars bidrag r 0, exempelvis vikter till inaktiva ReLU-noder,
+   *        avklingar annars till subnormala flyttal, vilka berknas
+   *        mngfalt lngsammare n normaliserade flyttal p mnga processorer.
+   ********************************************************************************/
+   static T flush(const T value)
+   {
+      return std::fabs(value) < std::numeric_limits<T>::min() ? T(0) : value;
+   }
+
+   static void momentum_scalar(const T rate, const T momentum, const T scale, const T* gradient,
+                               T* velocity, T* parameters, const std::size_t size, const bool nesterov)
+   {
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         const auto g = scale * gradient[i];
+         velocity[i] = flush(momentum * velocity[i] + g);
+         parameters[i] += nesterov ? rate * (g + momentum * velocity[i]) : rate * velocity[i];
+      }
+      return;
+   }
+
+   static void rmsprop_scalar(const T rate, const T beta2, const T epsilon, const T scale,
+                              const T* gradient, T* moment2, T* parameters, const std::size_t size)
+   {
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         const auto g = scale * gradient[i];
+         moment2[i] = flush(beta2 * moment2[i] + (T(1) - beta2) * g * g);
+         parameters[i] += rate * g / (std::sqrt(moment2[i]) + epsilon);
+      }
+      return;
+   }
+
+   static void adam_scalar(const T rate, const T beta1, const T beta2, const T epsilon,
+                           const T scale, const T* gradient, T* moment1, T* moment2,
+                           T* parameters, const std::size_t size)
+   {
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         const auto g = scale * gradient[i];
+         moment1[i] = flush(beta1 * moment1[i] + (T(1) - beta1) * g);
+         moment2[i] = flush(beta2 * moment2[i] + (T(1) - beta2) * g * g);
+         parameters[i] += rate * moment1[i] / (std::sqrt(moment2[i]) + epsilon);
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * Mikrokrnor fr blockad matrismultiplikation, vilka adderar produkten av
+   * ett packat block ur A med gemm_rows rader och ett packat block ur B med
+   * gemm_columns kolumner till motsvarande block i C, dr raderna i C ligger
+   * p angivet avstnd (stride). Bda blocken lagras kolumn fr kolumn
+   * respektive rad fr rad lngs den gemensamma dimensionen, allts
+   * a[p * gemm_rows + i] och b[p * gemm_columns + j], vilket gr att varje
+   * steg lser en sammanhngande vektor ur B samt ett flyttal per rad ur A.
+   * Hela blocket i C hlls i register under berkningen, vilket gr att varje
+   * flyttal ur A och B anvnds gemm_columns respektive gemm_rows gnger per
+   * lsning. Blockens storlek vljs per instruktionsuppsttning s att
+   * ackumulatorerna, en rad i B samt ett flyttal ur A ryms i registren.
+   * Blocken lses via ojusterade instruktioner och krver drfr ingen
+   * srskild justering, men br ligga p egna cache-linjer, exempelvis via
+   * aligned_allocator, s att ingen vektor delas mellan tv cache-linjer.
+   ********************************************************************************/
+   static constexpr std::size_t gemm_rows_scalar = 4;    /* Rader per block (skalr). */
+   static constexpr std::size_t gemm_columns_scalar = 4; /* Kolumner per block (skalr). */
+
+   static void gemm_scalar(const std::size_t depth, const T* a, const T* b, T* c, const std::size_t stride)
+   {
+      T sum[gemm_rows_scalar][gemm_columns_scalar] = {};
+
+      for (std::size_t p = 0; p < depth; ++p, a += gemm_rows_scalar, b += gemm_columns_scalar)
+      {
+         for (std::size_t i = 0; i < gemm_rows_scalar; ++i)
+         {
+            for (std::size_t j = 0; j < gemm_columns_scalar; ++j)
+            {
+               sum[i][j] += a[i] * b[j];
+            }
+         }
+      }
+
+      for (std::size_t i = 0; i < gemm_rows_scalar; ++i)
+      {
+         for (std::size_t j = 0; j < gemm_columns_scalar; ++j)
+         {
+            c[i * stride + j] += sum[i][j];
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * Mikrokrnor fr prediktion med ett exempel i taget, vilka berknar
+   * utsignalerna fr en panel om gemm_columns noder via en packad panel ur
+   * viktmatrisen lagrad p samma stt som ett block ur B ovan, allts
+   * a[p * gemm_columns + j] fr nod j och insignal p. Varje steg lser en
+   * sammanhngande vektor ur panelen samt en insignal, vilket gr att inga
+   * horisontella summeringar krvs. Resultatet initieras med panelens bias
+   * och stts vid ReLU-aktivering till 0 fr negativa summor innan det
+   * skrivs, s att bias, skalrprodukt och aktivering berknas i ett svep.
+   * Ett ftal steg lngs den gemensamma dimensionen summeras i separata
+   * ackumulatorer fr att dlja latensen fr multiplikation med addition.
+   * Liksom ovan krver panelen ingen srskild justering.
+   ********************************************************************************/
+   static constexpr std::size_t gemv_steps = 4; /* Antalet steg som summeras separat. */
+
+   static void gemv_scalar(const std::size_t depth, const T* a, const T* x, const T* bias, T* y,
+                           const bool relu)
+   {
+      T sum[gemm_columns_scalar];
+
+      for (std::size_t j = 0; j < gemm_columns_scalar; ++j)
+      {
+         sum[j] = bias[j];
+      }
+
+      for (std::size_t p = 0; p < depth; ++p, a += gemm_columns_scalar)
+      {
+         for (std::size_t j = 0; j < gemm_columns_scalar; ++j)
+         {
+            sum[j] += x[p] * a[j];
+         }
+      }
+
+      for (std::size_t j = 0; j < gemm_columns_scalar; ++j)
+      {
+         y[j] = !relu || sum[j] > 0 ? sum[j] : 0;
+      }
+      return;
+   }
+
+#if defined(ANN_SIMD_X86)
+   /********************************************************************************
+   * AVX2-versioner, dr fyra flyttal av typen double eller tta flyttal av
+   * typen float behandlas per instruktion. Skalrprodukten anvnder tv
+   * oberoende ackumulatorer fr att dlja latensen hos FMA-instruktionerna.
+   ********************************************************************************/
+   ANN_TARGET("avx2,fma")
+   static double dot_avx2(const double* x, const double* y, const std::size_t size)
+   {
+      auto sum0 = _mm256_setzero_pd();
+      auto sum1 = _mm256_setzero_pd();
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), sum0);
+         sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), sum1);
+      }
+
+      for (; i + 4 <= size; i += 4)
+      {
+         sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), sum0);
+      }
+
+      sum0 = _mm256_add_pd(sum0, sum1);
+      const auto half = _mm_add_pd(_mm256_castpd256_pd128(sum0), _mm256_extractf128_pd(sum0, 1));
+      auto sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+
+      for (; i < size; ++i)
+      {
+         sum += x[i] * y[i];
+      }
+      return sum;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void axpy_avx2(const double alpha, const double* x, double* y, const std::size_t size)
+   {
+      const auto a = _mm256_set1_pd(alpha);
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+      }
+
+      for (; i < size; ++i)
+      {
+         y[i] += alpha * x[i];
+      }
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void relu_avx2(double* data, const std::size_t size)
+   {
+      const auto zero = _mm256_setzero_pd();
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         _mm256_storeu_pd(data + i, _mm256_max_pd(_mm256_loadu_pd(data + i), zero));
+      }
+
+      for (; i < size; ++i)
+      {
+         data[i] = data[i] > 0.0 ? data[i] : 0.0;
+      }
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void delta_relu_avx2(double* error, const double* output, const std::size_t size)
+   {
+      const auto zero = _mm256_setzero_pd();
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto mask = _mm256_cmp_pd(_mm256_loadu_pd(output + i), zero, _CMP_GT_OQ);
+         _mm256_storeu_pd(error + i, _mm256_and_pd(_mm256_loadu_pd(error + i), mask));
+      }
+
+      for (; i < size; ++i)
+      {
+         error[i] = output[i] > 0.0 ? error[i] : 0.0;
+      }
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static __m256d vexp_avx2(const __m256d value)
+   {
+      const auto x = _mm256_min_pd(_mm256_max_pd(value, _mm256_set1_pd(exp_min_f64)), _mm256_set1_pd(exp_max_f64));
+      const auto n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+      const auto r = _mm256_fnmadd_pd(n, _mm256_set1_pd(ln2_lo_f64), _mm256_fnmadd_pd(n, _mm256_set1_pd(ln2_hi_f64), x));
+      auto p = _mm256_set1_pd(exp_poly_f64[0]);
+
+      for (std::size_t i = 1; i < sizeof(exp_poly_f64) / sizeof(double); ++i)
+      {
+         p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(exp_poly_f64[i]));
+      }
+
+      const auto bias = _mm_set1_epi32(1023);
+      const auto n0 = _mm256_cvtpd_epi32(n);
+      const auto n1 = _mm_srai_epi32(n0, 1);
+      const auto n2 = _mm_sub_epi32(n0, n1);
+      const auto scale1 = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm_add_epi32(n1, bias)), 52));
+      const auto scale2 = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm_add_epi32(n2, bias)), 52));
+      return _mm256_mul_pd(_mm256_mul_pd(p, scale1), scale2);
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void exp_avx2(double* data, const std::size_t size)
+   {
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         _mm256_storeu_pd(data + i, vexp_avx2(_mm256_loadu_pd(data + i)));
+      }
+
+      exp_scalar(data + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void sigmoid_avx2(double* data, const std::size_t size)
+   {
+      const auto zero = _mm256_setzero_pd();
+      const auto one = _mm256_set1_pd(1.0);
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto e = vexp_avx2(_mm256_sub_pd(zero, _mm256_loadu_pd(data + i)));
+         _mm256_storeu_pd(data + i, _mm256_div_pd(one, _mm256_add_pd(one, e)));
+      }
+
+      sigmoid_scalar(data + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static __m256d vtanh_avx2(const __m256d x)
+   {
+      const auto one = _mm256_set1_pd(1.0);
+      const auto t = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(-tanh_max)), _mm256_set1_pd(tanh_max));
+      const auto e = vexp_avx2(_mm256_mul_pd(_mm256_set1_pd(-2.0), t));
+      const auto rational = _mm256_div_pd(_mm256_sub_pd(one, e), _mm256_add_pd(one, e));
+      const auto u = _mm256_mul_pd(x, x);
+      auto p = _mm256_set1_pd(tanh_poly_f64[0]);
+
+      for (std::size_t i = 1; i < sizeof(tanh_poly_f64) / sizeof(double); ++i)
+      {
+         p = _mm256_fmadd_pd(p, u, _mm256_set1_pd(tanh_poly_f64[i]));
+      }
+
+      const auto series = _mm256_fmadd_pd(_mm256_mul_pd(x, u), p, x);
+      const auto small = _mm256_cmp_pd(_mm256_andnot_pd(_mm256_set1_pd(-0.0), x), _mm256_set1_pd(tanh_small), _CMP_LT_OQ);
+      return _mm256_blendv_pd(rational, series, small);
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void tanh_avx2(double* data, const std::size_t size)
+   {
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         _mm256_storeu_pd(data + i, vtanh_avx2(_mm256_loadu_pd(data + i)));
+      }
+
+      tanh_scalar(data + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static double sparse_dot_avx2(const double* values, const std::uint32_t* indices, const double* x,
+                                 const std::size_t size)
+   {
+      const auto zero = _mm256_setzero_pd();
+      const auto mask = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+      auto sum0 = zero;
+      auto sum1 = zero;
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto index0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+         const auto index1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i + 4));
+         sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(values + i), _mm256_mask_i32gather_pd(zero, x, index0, mask, 8), sum0);
+         sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(values + i + 4), _mm256_mask_i32gather_pd(zero, x, index1, mask, 8), sum1);
+      }
+
+      sum0 = _mm256_add_pd(sum0, sum1);
+      const auto half = _mm_add_pd(_mm256_castpd256_pd128(sum0), _mm256_extractf128_pd(sum0, 1));
+      return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half))) +
+             sparse_dot_scalar(values + i, indices + i, x, size - i);
+   }
+
+   ANN_TARGET("avx2,fma")
+   static float dot_avx2(const float* x, const float* y, const std::size_t size)
+   {
+      auto sum0 = _mm256_setzero_ps();
+      auto sum1 = _mm256_setzero_ps();
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), sum0);
+         sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), sum1);
+      }
+
+      for (; i + 8 <= size; i += 8)
+      {
+         sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), sum0);
+      }
+
+      sum0 = _mm256_add_ps(sum0, sum1);
+      auto half = _mm_add_ps(_mm256_castps256_ps128(sum0), _mm256_extractf128_ps(sum0, 1));
+      half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+      auto sum = _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+
+      for (; i < size; ++i)
+      {
+         sum += x[i] * y[i];
+      }
+      return sum;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void axpy_avx2(const float alpha, const float* x, float* y, const std::size_t size)
+   {
+      const auto a = _mm256_set1_ps(alpha);
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+      }
+
+      for (; i < size; ++i)
+      {
+         y[i] += alpha * x[i];
+      }
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void relu_avx2(float* data, const std::size_t size)
+   {
+      const auto zero = _mm256_setzero_ps();
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         _mm256_storeu_ps(data + i, _mm256_max_ps(_mm256_loadu_ps(data + i), zero));
+      }
+
+      for (; i < size; ++i)
+      {
+         data[i] = data[i] > 0.0f ? data[i] : 0.0f;
+      }
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void delta_relu_avx2(float* error, const float* output, const std::size_t size)
+   {
+      const auto zero = _mm256_setzero_ps();
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto mask = _mm256_cmp_ps(_mm256_loadu_ps(output + i), zero, _CMP_GT_OQ);
+         _mm256_storeu_ps(error + i, _mm256_and_ps(_mm256_loadu_ps(error + i), mask));
+      }
+
+      for (; i < size; ++i)
+      {
+         error[i] = output[i] > 0.0f ? error[i] : 0.0f;
+      }
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static __m256 vexp_avx2(const __m256 value)
+   {
+      const auto x = _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(exp_min_f32)), _mm256_set1_ps(exp_max_f32));
+      const auto n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(static_cast<float>(log2e))),
+                                     _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+      const auto r = _mm256_fnmadd_ps(n, _mm256_set1_ps(ln2_lo_f32), _mm256_fnmadd_ps(n, _mm256_set1_ps(ln2_hi_f32), x));
+      auto p = _mm256_set1_ps(exp_poly_f32[0]);
+
+      for (std::size_t i = 1; i < sizeof(exp_poly_f32) / sizeof(float); ++i)
+      {
+         p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(exp_poly_f32[i]));
+      }
+
+      const auto bias = _mm256_set1_epi32(127);
+      const auto n0 = _mm256_cvtps_epi32(n);
+      const auto n1 = _mm256_srai_epi32(n0, 1);
+      const auto n2 = _mm256_sub_epi32(n0, n1);
+      const auto scale1 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n1, bias), 23));
+      const auto scale2 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n2, bias), 23));
+      return _mm256_mul_ps(_mm256_mul_ps(p, scale1), scale2);
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void exp_avx2(float* data, const std::size_t size)
+   {
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         _mm256_storeu_ps(data + i, vexp_avx2(_mm256_loadu_ps(data + i)));
+      }
+
+      exp_scalar(data + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void sigmoid_avx2(float* data, const std::size_t size)
+   {
+      const auto zero = _mm256_setzero_ps();
+      const auto one = _mm256_set1_ps(1.0f);
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto e = vexp_avx2(_mm256_sub_ps(zero, _mm256_loadu_ps(data + i)));
+         _mm256_storeu_ps(data + i, _mm256_div_ps(one, _mm256_add_ps(one, e)));
+      }
+
+      sigmoid_scalar(data + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static __m256 vtanh_avx2(const __m256 x)
+   {
+      const auto one = _mm256_set1_ps(1.0f);
+      const auto t = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(static_cast<float>(-tanh_max))),
+                                   _mm256_set1_ps(static_cast<float>(tanh_max)));
+      const auto e = vexp_avx2(_mm256_mul_ps(_mm256_set1_ps(-2.0f), t));
+      const auto rational = _mm256_div_ps(_mm256_sub_ps(one, e), _mm256_add_ps(one, e));
+      const auto u = _mm256_mul_ps(x, x);
+      auto p = _mm256_set1_ps(tanh_poly_f32[0]);
+
+      for (std::size_t i = 1; i < sizeof(tanh_poly_f32) / sizeof(float); ++i)
+      {
+         p = _mm256_fmadd_ps(p, u, _mm256_set1_ps(tanh_poly_f32[i]));
+      }
+
+      const auto series = _mm256_fmadd_ps(_mm256_mul_ps(x, u), p, x);
+      const auto small = _mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), x),
+                                       _mm256_set1_ps(static_cast<float>(tanh_small)), _CMP_LT_OQ);
+      return _mm256_blendv_ps(rational, series, small);
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void tanh_avx2(float* data, const std::size_t size)
+   {
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         _mm256_storeu_ps(data + i, vtanh_avx2(_mm256_loadu_ps(data + i)));
+      }
+
+      tanh_scalar(data + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static float sparse_dot_avx2(const float* values, const std::uint32_t* indices, const float* x,
+                                const std::size_t size)
+   {
+      const auto zero = _mm256_setzero_ps();
+      const auto mask = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+      auto sum0 = zero;
+      auto sum1 = zero;
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         const auto index0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+         const auto index1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i + 8));
+         sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i), _mm256_mask_i32gather_ps(zero, x, index0, mask, 4), sum0);
+         sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(values + i + 8), _mm256_mask_i32gather_ps(zero, x, index1, mask, 4), sum1);
+      }
+
+      sum0 = _mm256_add_ps(sum0, sum1);
+      auto half = _mm_add_ps(_mm256_castps256_ps128(sum0), _mm256_extractf128_ps(sum0, 1));
+      half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+      return _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1))) +
+             sparse_dot_scalar(values + i, indices + i, x, size - i);
+   }
+
+   /********************************************************************************
+   * Justering av parametrar enligt optimeringsmetoderna i "optimizer.hpp",
+   * dr samtliga tillstnd lses och skrivs en vektor i taget. Kvadratroten
+   * och divisionen berknas via vektorinstruktioner, medan resterande
+   * element hanteras av de skalra referensversionerna. Tillstnd vars
+   * belopp understiger minsta normaliserade flyttal nollstlls, se flush.
+   ********************************************************************************/
+   ANN_TARGET("avx2,fma")
+   static void momentum_avx2(const double rate, const double momentum, const double scale, const double* gradient,
+                             double* velocity, double* parameters, const std::size_t size, const bool nesterov)
+   {
+      const auto mu = _mm256_set1_pd(momentum);
+      const auto k = _mm256_set1_pd(scale);
+      const auto rate_v = _mm256_set1_pd(nesterov ? rate * momentum : rate);
+      const auto rate_g = _mm256_set1_pd(nesterov ? rate : 0.0);
+      const auto tiny = _mm256_set1_pd(std::numeric_limits<double>::min());
+      const auto sign = _mm256_set1_pd(-0.0);
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto g = _mm256_mul_pd(k, _mm256_loadu_pd(gradient + i));
+         auto v = _mm256_fmadd_pd(mu, _mm256_loadu_pd(velocity + i), g);
+         v = _mm256_and_pd(v, _mm256_cmp_pd(_mm256_andnot_pd(sign, v), tiny, _CMP_GE_OQ));
+         _mm256_storeu_pd(velocity + i, v);
+         const auto p = _mm256_fmadd_pd(rate_g, g, _mm256_loadu_pd(parameters + i));
+         _mm256_storeu_pd(parameters + i, _mm256_fmadd_pd(rate_v, v, p));
+      }
+
+      momentum_scalar(rate, momentum, scale, gradient + i, velocity + i, parameters + i, size - i, nesterov);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void rmsprop_avx2(const double rate, const double beta2, const double epsilon, const double scale,
+                            const double* gradient, double* moment2, double* parameters, const std::size_t size)
+   {
+      const auto b2 = _mm256_set1_pd(beta2);
+      const auto c2 = _mm256_set1_pd(1.0 - beta2);
+      const auto r = _mm256_set1_pd(rate);
+      const auto k = _mm256_set1_pd(scale);
+      const auto eps = _mm256_set1_pd(epsilon);
+      const auto tiny = _mm256_set1_pd(std::numeric_limits<double>::min());
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto g = _mm256_mul_pd(k, _mm256_loadu_pd(gradient + i));
+         auto s = _mm256_fmadd_pd(_mm256_mul_pd(c2, g), g, _mm256_mul_pd(b2, _mm256_loadu_pd(moment2 + i)));
+         s = _mm256_and_pd(s, _mm256_cmp_pd(s, tiny, _CMP_GE_OQ));
+         _mm256_storeu_pd(moment2 + i, s);
+         const auto step = _mm256_div_pd(_mm256_mul_pd(r, g), _mm256_add_pd(_mm256_sqrt_pd(s), eps));
+         _mm256_storeu_pd(parameters + i, _mm256_add_pd(_mm256_loadu_pd(parameters + i), step));
+      }
+
+      rmsprop_scalar(rate, beta2, epsilon, scale, gradient + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void adam_avx2(const double rate, const double beta1, const double beta2, const double epsilon,
+                         const double scale, const double* gradient, double* moment1, double* moment2,
+                         double* parameters, const std::size_t size)
+   {
+      const auto b1 = _mm256_set1_pd(beta1);
+      const auto b2 = _mm256_set1_pd(beta2);
+      const auto c1 = _mm256_set1_pd(1.0 - beta1);
+      const auto c2 = _mm256_set1_pd(1.0 - beta2);
+      const auto k = _mm256_set1_pd(scale);
+      const auto r = _mm256_set1_pd(rate);
+      const auto eps = _mm256_set1_pd(epsilon);
+      const auto tiny = _mm256_set1_pd(std::numeric_limits<double>::min());
+      const auto sign = _mm256_set1_pd(-0.0);
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto g = _mm256_mul_pd(k, _mm256_loadu_pd(gradient + i));
+         auto m = _mm256_fmadd_pd(c1, g, _mm256_mul_pd(b1, _mm256_loadu_pd(moment1 + i)));
+         m = _mm256_and_pd(m, _mm256_cmp_pd(_mm256_andnot_pd(sign, m), tiny, _CMP_GE_OQ));
+         auto s = _mm256_fmadd_pd(_mm256_mul_pd(c2, g), g, _mm256_mul_pd(b2, _mm256_loadu_pd(moment2 + i)));
+         s = _mm256_and_pd(s, _mm256_cmp_pd(s, tiny, _CMP_GE_OQ));
+         _mm256_storeu_pd(moment1 + i, m);
+         _mm256_storeu_pd(moment2 + i, s);
+         const auto step = _mm256_div_pd(_mm256_mul_pd(r, m), _mm256_add_pd(_mm256_sqrt_pd(s), eps));
+         _mm256_storeu_pd(parameters + i, _mm256_add_pd(_mm256_loadu_pd(parameters + i), step));
+      }
+
+      adam_scalar(rate, beta1, beta2, epsilon, scale, gradient + i, moment1 + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void momentum_avx2(const float rate, const float momentum, const float scale, const float* gradient,
+                             float* velocity, float* parameters, const std::size_t size, const bool nesterov)
+   {
+      const auto mu = _mm256_set1_ps(momentum);
+      const auto k = _mm256_set1_ps(scale);
+      const auto rate_v = _mm256_set1_ps(nesterov ? rate * momentum : rate);
+      const auto rate_g = _mm256_set1_ps(nesterov ? rate : 0.0f);
+      const auto tiny = _mm256_set1_ps(std::numeric_limits<float>::min());
+      const auto sign = _mm256_set1_ps(-0.0f);
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto g = _mm256_mul_ps(k, _mm256_loadu_ps(gradient + i));
+         auto v = _mm256_fmadd_ps(mu, _mm256_loadu_ps(velocity + i), g);
+         v = _mm256_and_ps(v, _mm256_cmp_ps(_mm256_andnot_ps(sign, v), tiny, _CMP_GE_OQ));
+         _mm256_storeu_ps(velocity + i, v);
+         const auto p = _mm256_fmadd_ps(rate_g, g, _mm256_loadu_ps(parameters + i));
+         _mm256_storeu_ps(parameters + i, _mm256_fmadd_ps(rate_v, v, p));
+      }
+
+      momentum_scalar(rate, momentum, scale, gradient + i, velocity + i, parameters + i, size - i, nesterov);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void rmsprop_avx2(const float rate, const float beta2, const float epsilon, const float scale,
+                            const float* gradient, float* moment2, float* parameters, const std::size_t size)
+   {
+      const auto b2 = _mm256_set1_ps(beta2);
+      const auto c2 = _mm256_set1_ps(1.0f - beta2);
+      const auto r = _mm256_set1_ps(rate);
+      const auto k = _mm256_set1_ps(scale);
+      const auto eps = _mm256_set1_ps(epsilon);
+      const auto tiny = _mm256_set1_ps(std::numeric_limits<float>::min());
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto g = _mm256_mul_ps(k, _mm256_loadu_ps(gradient + i));
+         auto s = _mm256_fmadd_ps(_mm256_mul_ps(c2, g), g, _mm256_mul_ps(b2, _mm256_loadu_ps(moment2 + i)));
+         s = _mm256_and_ps(s, _mm256_cmp_ps(s, tiny, _CMP_GE_OQ));
+         _mm256_storeu_ps(moment2 + i, s);
+         const auto step = _mm256_div_ps(_mm256_mul_ps(r, g), _mm256_add_ps(_mm256_sqrt_ps(s), eps));
+         _mm256_storeu_ps(parameters + i, _mm256_add_ps(_mm256_loadu_ps(parameters + i), step));
+      }
+
+      rmsprop_scalar(rate, beta2, epsilon, scale, gradient + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void adam_avx2(const float rate, const float beta1, const float beta2, const float epsilon,
+                         const float scale, const float* gradient, float* moment1, float* moment2,
+                         float* parameters, const std::size_t size)
+   {
+      const auto b1 = _mm256_set1_ps(beta1);
+      const auto b2 = _mm256_set1_ps(beta2);
+      const auto c1 = _mm256_set1_ps(1.0f - beta1);
+      const auto c2 = _mm256_set1_ps(1.0f - beta2);
+      const auto k = _mm256_set1_ps(scale);
+      const auto r = _mm256_set1_ps(rate);
+      const auto eps = _mm256_set1_ps(epsilon);
+      const auto tiny = _mm256_set1_ps(std::numeric_limits<float>::min());
+      const auto sign = _mm256_set1_ps(-0.0f);
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto g = _mm256_mul_ps(k, _mm256_loadu_ps(gradient + i));
+         auto m = _mm256_fmadd_ps(c1, g, _mm256_mul_ps(b1, _mm256_loadu_ps(moment1 + i)));
+         m = _mm256_and_ps(m, _mm256_cmp_ps(_mm256_andnot_ps(sign, m), tiny, _CMP_GE_OQ));
+         auto s = _mm256_fmadd_ps(_mm256_mul_ps(c2, g), g, _mm256_mul_ps(b2, _mm256_loadu_ps(moment2 + i)));
+         s = _mm256_and_ps(s, _mm256_cmp_ps(s, tiny, _CMP_GE_OQ));
+         _mm256_storeu_ps(moment1 + i, m);
+         _mm256_storeu_ps(moment2 + i, s);
+         const auto step = _mm256_div_ps(_mm256_mul_ps(r, m), _mm256_add_ps(_mm256_sqrt_ps(s), eps));
+         _mm256_storeu_ps(parameters + i, _mm256_add_ps(_mm256_loadu_ps(parameters + i), step));
+      }
+
+      adam_scalar(rate, beta1, beta2, epsilon, scale, gradient + i, moment1 + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   static constexpr std::size_t gemm_rows_avx2 = 6;                       /* Rader per block (AVX2). */
+   static constexpr std::size_t gemm_columns_avx2 = 2 * 32 / sizeof(T);   /* Kolumner per block (AVX2). */
+
+   ANN_TARGET("avx2,fma")
+   static void gemm_avx2(const std::size_t depth, const double* a, const double* b, double* c,
+                         const std::size_t stride)
+   {
+      __m256d sum0[gemm_rows_avx2], sum1[gemm_rows_avx2];
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_avx2; ++i)
+      {
+         sum0[i] = _mm256_loadu_pd(c + i * stride);
+         sum1[i] = _mm256_loadu_pd(c + i * stride + 4);
+      }
+
+      for (std::size_t p = 0; p < depth; ++p, a += gemm_rows_avx2, b += 8)
+      {
+         const auto b0 = _mm256_loadu_pd(b);
+         const auto b1 = _mm256_loadu_pd(b + 4);
+
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemm_rows_avx2; ++i)
+         {
+            const auto x = _mm256_broadcast_sd(a + i);
+            sum0[i] = _mm256_fmadd_pd(x, b0, sum0[i]);
+            sum1[i] = _mm256_fmadd_pd(x, b1, sum1[i]);
+         }
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_avx2; ++i)
+      {
+         _mm256_storeu_pd(c + i * stride, sum0[i]);
+         _mm256_storeu_pd(c + i * stride + 4, sum1[i]);
+      }
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void gemm_avx2(const std::size_t depth, const float* a, const float* b, float* c,
+                         const std::size_t stride)
+   {
+      __m256 sum0[gemm_rows_avx2], sum1[gemm_rows_avx2];
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_avx2; ++i)
+      {
+         sum0[i] = _mm256_loadu_ps(c + i * stride);
+         sum1[i] = _mm256_loadu_ps(c + i * stride + 8);
+      }
+
+      for (std::size_t p = 0; p < depth; ++p, a += gemm_rows_avx2, b += 16)
+      {
+         const auto b0 = _mm256_loadu_ps(b);
+         const auto b1 = _mm256_loadu_ps(b + 8);
+
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemm_rows_avx2; ++i)
+         {
+            const auto x = _mm256_broadcast_ss(a + i);
+            sum0[i] = _mm256_fmadd_ps(x, b0, sum0[i]);
+            sum1[i] = _mm256_fmadd_ps(x, b1, sum1[i]);
+         }
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_avx2; ++i)
+      {
+         _mm256_storeu_ps(c + i * stride, sum0[i]);
+         _mm256_storeu_ps(c + i * stride + 8, sum1[i]);
+      }
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void gemv_avx2(const std::size_t depth, const double* a, const double* x, const double* bias,
+                         double* y, const bool relu)
+   {
+      __m256d sum0[gemv_steps], sum1[gemv_steps];
+      sum0[0] = _mm256_loadu_pd(bias);
+      sum1[0] = _mm256_loadu_pd(bias + 4);
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[i] = _mm256_setzero_pd();
+         sum1[i] = _mm256_setzero_pd();
+      }
+
+      std::size_t p = 0;
+
+      for (; p + gemv_steps <= depth; p += gemv_steps, a += gemv_steps * 8)
+      {
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemv_steps; ++i)
+         {
+            const auto value = _mm256_broadcast_sd(x + p + i);
+            sum0[i] = _mm256_fmadd_pd(value, _mm256_loadu_pd(a + i * 8), sum0[i]);
+            sum1[i] = _mm256_fmadd_pd(value, _mm256_loadu_pd(a + i * 8 + 4), sum1[i]);
+         }
+      }
+
+      for (; p < depth; ++p, a += 8)
+      {
+         const auto value = _mm256_broadcast_sd(x + p);
+         sum0[0] = _mm256_fmadd_pd(value, _mm256_loadu_pd(a), sum0[0]);
+         sum1[0] = _mm256_fmadd_pd(value, _mm256_loadu_pd(a + 4), sum1[0]);
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[0] = _mm256_add_pd(sum0[0], sum0[i]);
+         sum1[0] = _mm256_add_pd(sum1[0], sum1[i]);
+      }
+
+      if (relu)
+      {
+         sum0[0] = _mm256_max_pd(sum0[0], _mm256_setzero_pd());
+         sum1[0] = _mm256_max_pd(sum1[0], _mm256_setzero_pd());
+      }
+
+      _mm256_storeu_pd(y, sum0[0]);
+      _mm256_storeu_pd(y + 4, sum1[0]);
+      return;
+   }
+
+   ANN_TARGET("avx2,fma")
+   static void gemv_avx2(const std::size_t depth, const float* a, const float* x, const float* bias,
+                         float* y, const bool relu)
+   {
+      __m256 sum0[gemv_steps], sum1[gemv_steps];
+      sum0[0] = _mm256_loadu_ps(bias);
+      sum1[0] = _mm256_loadu_ps(bias + 8);
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[i] = _mm256_setzero_ps();
+         sum1[i] = _mm256_setzero_ps();
+      }
+
+      std::size_t p = 0;
+
+      for (; p + gemv_steps <= depth; p += gemv_steps, a += gemv_steps * 16)
+      {
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemv_steps; ++i)
+         {
+            const auto value = _mm256_broadcast_ss(x + p + i);
+            sum0[i] = _mm256_fmadd_ps(value, _mm256_loadu_ps(a + i * 16), sum0[i]);
+            sum1[i] = _mm256_fmadd_ps(value, _mm256_loadu_ps(a + i * 16 + 8), sum1[i]);
+         }
+      }
+
+      for (; p < depth; ++p, a += 16)
+      {
+         const auto value = _mm256_broadcast_ss(x + p);
+         sum0[0] = _mm256_fmadd_ps(value, _mm256_loadu_ps(a), sum0[0]);
+         sum1[0] = _mm256_fmadd_ps(value, _mm256_loadu_ps(a + 8), sum1[0]);
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[0] = _mm256_add_ps(sum0[0], sum0[i]);
+         sum1[0] = _mm256_add_ps(sum1[0], sum1[i]);
+      }
+
+      if (relu)
+      {
+         sum0[0] = _mm256_max_ps(sum0[0], _mm256_setzero_ps());
+         sum1[0] = _mm256_max_ps(sum1[0], _mm256_setzero_ps());
+      }
+
+      _mm256_storeu_ps(y, sum0[0]);
+      _mm256_storeu_ps(y + 8, sum1[0]);
+      return;
+   }
+
+   /********************************************************************************
+   * AVX-512-versioner, dr tta flyttal av typen double eller sexton flyttal
+   * av typen float behandlas per instruktion. Resterande element hanteras
+   * via maskade lsningar och skrivningar. Approximationen av exponential-
+   * funktionen samt kvoten i vdivide_root anvnder de maskade varianterna av
+   * max, min, roundscale, scalef, rsqrt14 och rcp14 med samtliga element
+   * aktiva, d de omaskade varianterna ger felaktiga varningar om
+   * oinitierade variabler i vissa versioner av GCC.
+   ********************************************************************************/
+   ANN_TARGET("avx512f")
+   static double dot_avx512(const double* x, const double* y, const std::size_t size)
+   {
+      auto sum0 = _mm512_setzero_pd();
+      auto sum1 = _mm512_setzero_pd();
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), sum0);
+         sum1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), sum1);
+      }
+
+      for (; i + 8 <= size; i += 8)
+      {
+         sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), sum0);
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask8>((1u << (size - i)) - 1);
+         sum1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), sum1);
+      }
+
+      alignas(64) double lanes[8];
+      _mm512_store_pd(lanes, _mm512_add_pd(sum0, sum1));
+      return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+   }
+
+   ANN_TARGET("avx512f")
+   static void axpy_avx512(const double alpha, const double* x, double* y, const std::size_t size)
+   {
+      const auto a = _mm512_set1_pd(alpha);
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         _mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask8>((1u << (size - i)) - 1);
+         const auto result = _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i));
+         _mm512_mask_storeu_pd(y + i, mask, result);
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void relu_avx512(double* data, const std::size_t size)
+   {
+      const auto zero = _mm512_setzero_pd();
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto x = _mm512_loadu_pd(data + i);
+         _mm512_storeu_pd(data + i, _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(x, zero, _CMP_GT_OQ), x));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask8>((1u << (size - i)) - 1);
+         const auto x = _mm512_maskz_loadu_pd(mask, data + i);
+         _mm512_mask_storeu_pd(data + i, mask, _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(x, zero, _CMP_GT_OQ), x));
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void delta_relu_avx512(double* error, const double* output, const std::size_t size)
+   {
+      const auto zero = _mm512_setzero_pd();
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto active = _mm512_cmp_pd_mask(_mm512_loadu_pd(output + i), zero, _CMP_GT_OQ);
+         _mm512_storeu_pd(error + i, _mm512_maskz_mov_pd(active, _mm512_loadu_pd(error + i)));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask8>((1u << (size - i)) - 1);
+         const auto active = _mm512_mask_cmp_pd_mask(mask, _mm512_maskz_loadu_pd(mask, output + i), zero, _CMP_GT_OQ);
+         _mm512_mask_storeu_pd(error + i, mask, _mm512_maskz_mov_pd(active, _mm512_maskz_loadu_pd(mask, error + i)));
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static __m512d vexp_avx512(const __m512d value)
+   {
+      const auto all = static_cast<__mmask8>(-1);
+      const auto low = _mm512_maskz_max_pd(all, value, _mm512_set1_pd(exp_min_f64));
+      const auto x = _mm512_maskz_min_pd(all, low, _mm512_set1_pd(exp_max_f64));
+      const auto n = _mm512_maskz_roundscale_pd(all, _mm512_mul_pd(x, _mm512_set1_pd(log2e)),
+                                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+      const auto r = _mm512_fnmadd_pd(n, _mm512_set1_pd(ln2_lo_f64), _mm512_fnmadd_pd(n, _mm512_set1_pd(ln2_hi_f64), x));
+      auto p = _mm512_set1_pd(exp_poly_f64[0]);
+
+      for (std::size_t i = 1; i < sizeof(exp_poly_f64) / sizeof(double); ++i)
+      {
+         p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(exp_poly_f64[i]));
+      }
+      return _mm512_maskz_scalef_pd(all, p, n);
+   }
+
+   ANN_TARGET("avx512f")
+   static void exp_avx512(double* data, const std::size_t size)
+   {
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         _mm512_storeu_pd(data + i, vexp_avx512(_mm512_loadu_pd(data + i)));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask8>((1u << (size - i)) - 1);
+         _mm512_mask_storeu_pd(data + i, mask, vexp_avx512(_mm512_maskz_loadu_pd(mask, data + i)));
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void sigmoid_avx512(double* data, const std::size_t size)
+   {
+      const auto zero = _mm512_setzero_pd();
+      const auto one = _mm512_set1_pd(1.0);
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto e = vexp_avx512(_mm512_sub_pd(zero, _mm512_loadu_pd(data + i)));
+         _mm512_storeu_pd(data + i, _mm512_div_pd(one, _mm512_add_pd(one, e)));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask8>((1u << (size - i)) - 1);
+         const auto e = vexp_avx512(_mm512_sub_pd(zero, _mm512_maskz_loadu_pd(mask, data + i)));
+         _mm512_mask_storeu_pd(data + i, mask, _mm512_div_pd(one, _mm512_add_pd(one, e)));
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static __m512d vtanh_avx512(const __m512d x)
+   {
+      const auto one = _mm512_set1_pd(1.0);
+      const auto all = static_cast<__mmask8>(-1);
+      const auto low = _mm512_maskz_max_pd(all, x, _mm512_set1_pd(-tanh_max));
+      const auto t = _mm512_maskz_min_pd(all, low, _mm512_set1_pd(tanh_max));
+      const auto e = vexp_avx512(_mm512_mul_pd(_mm512_set1_pd(-2.0), t));
+      const auto rational = _mm512_div_pd(_mm512_sub_pd(one, e), _mm512_add_pd(one, e));
+      const auto u = _mm512_mul_pd(x, x);
+      auto p = _mm512_set1_pd(tanh_poly_f64[0]);
+
+      for (std::size_t i = 1; i < sizeof(tanh_poly_f64) / sizeof(double); ++i)
+      {
+         p = _mm512_fmadd_pd(p, u, _mm512_set1_pd(tanh_poly_f64[i]));
+      }
+
+      const auto series = _mm512_fmadd_pd(_mm512_mul_pd(x, u), p, x);
+      const auto small = _mm512_cmp_pd_mask(_mm512_abs_pd(x), _mm512_set1_pd(tanh_small), _CMP_LT_OQ);
+      return _mm512_mask_blend_pd(small, rational, series);
+   }
+
+   ANN_TARGET("avx512f")
+   static void tanh_avx512(double* data, const std::size_t size)
+   {
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         _mm512_storeu_pd(data + i, vtanh_avx512(_mm512_loadu_pd(data + i)));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask8>((1u << (size - i)) - 1);
+         _mm512_mask_storeu_pd(data + i, mask, vtanh_avx512(_mm512_maskz_loadu_pd(mask, data + i)));
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static double sparse_dot_avx512(const double* values, const std::uint32_t* indices, const double* x,
+                                   const std::size_t size)
+   {
+      const auto zero = _mm512_setzero_pd();
+      auto sum0 = _mm512_setzero_pd();
+      auto sum1 = _mm512_setzero_pd();
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         const auto index0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+         const auto index1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i + 8));
+         sum0 = _mm512_fmadd_pd(_mm512_loadu_pd(values + i), _mm512_mask_i32gather_pd(zero, 0xFF, index0, x, 8), sum0);
+         sum1 = _mm512_fmadd_pd(_mm512_loadu_pd(values + i + 8), _mm512_mask_i32gather_pd(zero, 0xFF, index1, x, 8), sum1);
+      }
+
+      alignas(64) double lanes[8];
+      _mm512_store_pd(lanes, _mm512_add_pd(sum0, sum1));
+      return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7])) +
+             sparse_dot_scalar(values + i, indices + i, x, size - i);
+   }
+
+   ANN_TARGET("avx512f")
+   static float dot_avx512(const float* x, const float* y, const std::size_t size)
+   {
+      auto sum0 = _mm512_setzero_ps();
+      auto sum1 = _mm512_setzero_ps();
+      std::size_t i = 0;
+
+      for (; i + 32 <= size; i += 32)
+      {
+         sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), sum0);
+         sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), sum1);
+      }
+
+      for (; i + 16 <= size; i += 16)
+      {
+         sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), sum0);
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+         sum1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), sum1);
+      }
+
+      alignas(64) float lanes[16];
+      _mm512_store_ps(lanes, _mm512_add_ps(sum0, sum1));
+
+      for (std::size_t j = 0; j < 8; ++j)
+      {
+         lanes[j] += lanes[j + 8];
+      }
+      return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+   }
+
+   ANN_TARGET("avx512f")
+   static void axpy_avx512(const float alpha, const float* x, float* y, const std::size_t size)
+   {
+      const auto a = _mm512_set1_ps(alpha);
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         _mm512_storeu_ps(y + i, _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+         const auto result = _mm512_fmadd_ps(a, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i));
+         _mm512_mask_storeu_ps(y + i, mask, result);
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void relu_avx512(float* data, const std::size_t size)
+   {
+      const auto zero = _mm512_setzero_ps();
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         const auto x = _mm512_loadu_ps(data + i);
+         _mm512_storeu_ps(data + i, _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, zero, _CMP_GT_OQ), x));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+         const auto x = _mm512_maskz_loadu_ps(mask, data + i);
+         _mm512_mask_storeu_ps(data + i, mask, _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, zero, _CMP_GT_OQ), x));
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void delta_relu_avx512(float* error, const float* output, const std::size_t size)
+   {
+      const auto zero = _mm512_setzero_ps();
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         const auto active = _mm512_cmp_ps_mask(_mm512_loadu_ps(output + i), zero, _CMP_GT_OQ);
+         _mm512_storeu_ps(error + i, _mm512_maskz_mov_ps(active, _mm512_loadu_ps(error + i)));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+         const auto active = _mm512_mask_cmp_ps_mask(mask, _mm512_maskz_loadu_ps(mask, output + i), zero, _CMP_GT_OQ);
+         _mm512_mask_storeu_ps(error + i, mask, _mm512_maskz_mov_ps(active, _mm512_maskz_loadu_ps(mask, error + i)));
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static __m512 vexp_avx512(const __m512 value)
+   {
+      const auto all = static_cast<__mmask16>(-1);
+      const auto low = _mm512_maskz_max_ps(all, value, _mm512_set1_ps(exp_min_f32));
+      const auto x = _mm512_maskz_min_ps(all, low, _mm512_set1_ps(exp_max_f32));
+      const auto n = _mm512_maskz_roundscale_ps(all, _mm512_mul_ps(x, _mm512_set1_ps(static_cast<float>(log2e))),
+                                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+      const auto r = _mm512_fnmadd_ps(n, _mm512_set1_ps(ln2_lo_f32), _mm512_fnmadd_ps(n, _mm512_set1_ps(ln2_hi_f32), x));
+      auto p = _mm512_set1_ps(exp_poly_f32[0]);
+
+      for (std::size_t i = 1; i < sizeof(exp_poly_f32) / sizeof(float); ++i)
+      {
+         p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(exp_poly_f32[i]));
+      }
+      return _mm512_maskz_scalef_ps(all, p, n);
+   }
+
+   ANN_TARGET("avx512f")
+   static void exp_avx512(float* data, const std::size_t size)
+   {
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         _mm512_storeu_ps(data + i, vexp_avx512(_mm512_loadu_ps(data + i)));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+         _mm512_mask_storeu_ps(data + i, mask, vexp_avx512(_mm512_maskz_loadu_ps(mask, data + i)));
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void sigmoid_avx512(float* data, const std::size_t size)
+   {
+      const auto zero = _mm512_setzero_ps();
+      const auto one = _mm512_set1_ps(1.0f);
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         const auto e = vexp_avx512(_mm512_sub_ps(zero, _mm512_loadu_ps(data + i)));
+         _mm512_storeu_ps(data + i, _mm512_div_ps(one, _mm512_add_ps(one, e)));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+         const auto e = vexp_avx512(_mm512_sub_ps(zero, _mm512_maskz_loadu_ps(mask, data + i)));
+         _mm512_mask_storeu_ps(data + i, mask, _mm512_div_ps(one, _mm512_add_ps(one, e)));
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static __m512 vtanh_avx512(const __m512 x)
+   {
+      const auto one = _mm512_set1_ps(1.0f);
+      const auto all = static_cast<__mmask16>(-1);
+      const auto low = _mm512_maskz_max_ps(all, x, _mm512_set1_ps(static_cast<float>(-tanh_max)));
+      const auto t = _mm512_maskz_min_ps(all, low, _mm512_set1_ps(static_cast<float>(tanh_max)));
+      const auto e = vexp_avx512(_mm512_mul_ps(_mm512_set1_ps(-2.0f), t));
+      const auto rational = _mm512_div_ps(_mm512_sub_ps(one, e), _mm512_add_ps(one, e));
+      const auto u = _mm512_mul_ps(x, x);
+      auto p = _mm512_set1_ps(tanh_poly_f32[0]);
+
+      for (std::size_t i = 1; i < sizeof(tanh_poly_f32) / sizeof(float); ++i)
+      {
+         p = _mm512_fmadd_ps(p, u, _mm512_set1_ps(tanh_poly_f32[i]));
+      }
+
+      const auto series = _mm512_fmadd_ps(_mm512_mul_ps(x, u), p, x);
+      const auto small = _mm512_cmp_ps_mask(_mm512_abs_ps(x), _mm512_set1_ps(static_cast<float>(tanh_small)), _CMP_LT_OQ);
+      return _mm512_mask_blend_ps(small, rational, series);
+   }
+
+   ANN_TARGET("avx512f")
+   static void tanh_avx512(float* data, const std::size_t size)
+   {
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         _mm512_storeu_ps(data + i, vtanh_avx512(_mm512_loadu_ps(data + i)));
+      }
+
+      if (i < size)
+      {
+         const auto mask = static_cast<__mmask16>((1u << (size - i)) - 1);
+         _mm512_mask_storeu_ps(data + i, mask, vtanh_avx512(_mm512_maskz_loadu_ps(mask, data + i)));
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static float sparse_dot_avx512(const float* values, const std::uint32_t* indices, const float* x,
+                                  const std::size_t size)
+   {
+      const auto zero = _mm512_setzero_ps();
+      auto sum0 = _mm512_setzero_ps();
+      auto sum1 = _mm512_setzero_ps();
+      std::size_t i = 0;
+
+      for (; i + 32 <= size; i += 32)
+      {
+         const auto index0 = _mm512_loadu_si512(indices + i);
+         const auto index1 = _mm512_loadu_si512(indices + i + 16);
+         sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(values + i), _mm512_mask_i32gather_ps(zero, 0xFFFF, index0, x, 4), sum0);
+         sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(values + i + 16), _mm512_mask_i32gather_ps(zero, 0xFFFF, index1, x, 4), sum1);
+      }
+
+      alignas(64) float lanes[16];
+      _mm512_store_ps(lanes, _mm512_add_ps(sum0, sum1));
+
+      for (std::size_t j = 0; j < 8; ++j)
+      {
+         lanes[j] += lanes[j + 8];
+      }
+      return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7])) +
+             sparse_dot_scalar(values + i, indices + i, x, size - i);
+   }
+
+   /********************************************************************************
+   * Justering av parametrar enligt optimeringsmetoderna i "optimizer.hpp",
+   * dr samtliga tillstnd lses och skrivs en vektor i taget, medan
+   * resterande element hanteras av de skalra referensversionerna. Tillstnd
+   * vars belopp understiger minsta normaliserade flyttal nollstlls, se
+   * flush. Kvoten g / (sqrt(s) + epsilon) berknas via vdivide_root utan
+   * kvadratrot och division, vilka delar samma lngsamma berkningsenhet,
+   * genom att uppskattningar av 1 / sqrt(s) respektive inversen frfinas med
+   * Newtons metod, ett steg fr float och tv steg fr double.
+   ********************************************************************************/
+   ANN_TARGET("avx512f")
+   static __m512d vdivide_root_avx512(const __m512d numerator, const __m512d s, const __m512d epsilon)
+   {
+      const auto all = static_cast<__mmask8>(-1);
+      const auto half_s = _mm512_mul_pd(_mm512_set1_pd(0.5), s);
+      const auto three_halves = _mm512_set1_pd(1.5);
+      const auto two = _mm512_set1_pd(2.0);
+      auto y = _mm512_maskz_rsqrt14_pd(all, s);
+
+      for (int i = 0; i < 2; ++i)
+      {
+         y = _mm512_mul_pd(y, _mm512_fnmadd_pd(_mm512_mul_pd(half_s, y), y, three_halves));
+      }
+
+      const auto root = _mm512_maskz_mul_pd(_mm512_cmp_pd_mask(s, _mm512_setzero_pd(), _CMP_GT_OQ), s, y);
+      const auto denominator = _mm512_add_pd(root, epsilon);
+      auto q = _mm512_maskz_rcp14_pd(all, denominator);
+
+      for (int i = 0; i < 2; ++i)
+      {
+         q = _mm512_mul_pd(q, _mm512_fnmadd_pd(denominator, q, two));
+      }
+      return _mm512_mul_pd(numerator, q);
+   }
+
+   ANN_TARGET("avx512f")
+   static void momentum_avx512(const double rate, const double momentum, const double scale, const double* gradient,
+                               double* velocity, double* parameters, const std::size_t size, const bool nesterov)
+   {
+      const auto mu = _mm512_set1_pd(momentum);
+      const auto k = _mm512_set1_pd(scale);
+      const auto rate_v = _mm512_set1_pd(nesterov ? rate * momentum : rate);
+      const auto rate_g = _mm512_set1_pd(nesterov ? rate : 0.0);
+      const auto tiny = _mm512_set1_pd(std::numeric_limits<double>::min());
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto g = _mm512_mul_pd(k, _mm512_loadu_pd(gradient + i));
+         auto v = _mm512_fmadd_pd(mu, _mm512_loadu_pd(velocity + i), g);
+         v = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(_mm512_abs_pd(v), tiny, _CMP_GE_OQ), v);
+         _mm512_storeu_pd(velocity + i, v);
+         const auto p = _mm512_fmadd_pd(rate_g, g, _mm512_loadu_pd(parameters + i));
+         _mm512_storeu_pd(parameters + i, _mm512_fmadd_pd(rate_v, v, p));
+      }
+
+      momentum_scalar(rate, momentum, scale, gradient + i, velocity + i, parameters + i, size - i, nesterov);
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void rmsprop_avx512(const double rate, const double beta2, const double epsilon, const double scale,
+                              const double* gradient, double* moment2, double* parameters, const std::size_t size)
+   {
+      const auto b2 = _mm512_set1_pd(beta2);
+      const auto c2 = _mm512_set1_pd(1.0 - beta2);
+      const auto r = _mm512_set1_pd(rate);
+      const auto k = _mm512_set1_pd(scale);
+      const auto eps = _mm512_set1_pd(epsilon);
+      const auto tiny = _mm512_set1_pd(std::numeric_limits<double>::min());
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto g = _mm512_mul_pd(k, _mm512_loadu_pd(gradient + i));
+         auto s = _mm512_fmadd_pd(_mm512_mul_pd(c2, g), g, _mm512_mul_pd(b2, _mm512_loadu_pd(moment2 + i)));
+         s = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(s, tiny, _CMP_GE_OQ), s);
+         _mm512_storeu_pd(moment2 + i, s);
+         const auto step = vdivide_root_avx512(_mm512_mul_pd(r, g), s, eps);
+         _mm512_storeu_pd(parameters + i, _mm512_add_pd(_mm512_loadu_pd(parameters + i), step));
+      }
+
+      rmsprop_scalar(rate, beta2, epsilon, scale, gradient + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void adam_avx512(const double rate, const double beta1, const double beta2, const double epsilon,
+                           const double scale, const double* gradient, double* moment1, double* moment2,
+                           double* parameters, const std::size_t size)
+   {
+      const auto b1 = _mm512_set1_pd(beta1);
+      const auto b2 = _mm512_set1_pd(beta2);
+      const auto c1 = _mm512_set1_pd(1.0 - beta1);
+      const auto c2 = _mm512_set1_pd(1.0 - beta2);
+      const auto k = _mm512_set1_pd(scale);
+      const auto r = _mm512_set1_pd(rate);
+      const auto eps = _mm512_set1_pd(epsilon);
+      const auto tiny = _mm512_set1_pd(std::numeric_limits<double>::min());
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const auto g = _mm512_mul_pd(k, _mm512_loadu_pd(gradient + i));
+         auto m = _mm512_fmadd_pd(c1, g, _mm512_mul_pd(b1, _mm512_loadu_pd(moment1 + i)));
+         m = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(_mm512_abs_pd(m), tiny, _CMP_GE_OQ), m);
+         auto s = _mm512_fmadd_pd(_mm512_mul_pd(c2, g), g, _mm512_mul_pd(b2, _mm512_loadu_pd(moment2 + i)));
+         s = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(s, tiny, _CMP_GE_OQ), s);
+         _mm512_storeu_pd(moment1 + i, m);
+         _mm512_storeu_pd(moment2 + i, s);
+         const auto step = vdivide_root_avx512(_mm512_mul_pd(r, m), s, eps);
+         _mm512_storeu_pd(parameters + i, _mm512_add_pd(_mm512_loadu_pd(parameters + i), step));
+      }
+
+      adam_scalar(rate, beta1, beta2, epsilon, scale, gradient + i, moment1 + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static __m512 vdivide_root_avx512(const __m512 numerator, const __m512 s, const __m512 epsilon)
+   {
+      const auto all = static_cast<__mmask16>(-1);
+      const auto y = _mm512_maskz_rsqrt14_ps(all, s);
+      const auto refined = _mm512_mul_ps(y, _mm512_fnmadd_ps(_mm512_mul_ps(_mm512_set1_ps(0.5f), s),
+                                                             _mm512_mul_ps(y, y), _mm512_set1_ps(1.5f)));
+      const auto root = _mm512_maskz_mul_ps(_mm512_cmp_ps_mask(s, _mm512_setzero_ps(), _CMP_GT_OQ), s, refined);
+      const auto denominator = _mm512_add_ps(root, epsilon);
+      const auto q = _mm512_maskz_rcp14_ps(all, denominator);
+      return _mm512_mul_ps(numerator, _mm512_mul_ps(q, _mm512_fnmadd_ps(denominator, q, _mm512_set1_ps(2.0f))));
+   }
+
+   ANN_TARGET("avx512f")
+   static void momentum_avx512(const float rate, const float momentum, const float scale, const float* gradient,
+                               float* velocity, float* parameters, const std::size_t size, const bool nesterov)
+   {
+      const auto mu = _mm512_set1_ps(momentum);
+      const auto k = _mm512_set1_ps(scale);
+      const auto rate_v = _mm512_set1_ps(nesterov ? rate * momentum : rate);
+      const auto rate_g = _mm512_set1_ps(nesterov ? rate : 0.0f);
+      const auto tiny = _mm512_set1_ps(std::numeric_limits<float>::min());
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         const auto g = _mm512_mul_ps(k, _mm512_loadu_ps(gradient + i));
+         auto v = _mm512_fmadd_ps(mu, _mm512_loadu_ps(velocity + i), g);
+         v = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(_mm512_abs_ps(v), tiny, _CMP_GE_OQ), v);
+         _mm512_storeu_ps(velocity + i, v);
+         const auto p = _mm512_fmadd_ps(rate_g, g, _mm512_loadu_ps(parameters + i));
+         _mm512_storeu_ps(parameters + i, _mm512_fmadd_ps(rate_v, v, p));
+      }
+
+      momentum_scalar(rate, momentum, scale, gradient + i, velocity + i, parameters + i, size - i, nesterov);
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void rmsprop_avx512(const float rate, const float beta2, const float epsilon, const float scale,
+                              const float* gradient, float* moment2, float* parameters, const std::size_t size)
+   {
+      const auto b2 = _mm512_set1_ps(beta2);
+      const auto c2 = _mm512_set1_ps(1.0f - beta2);
+      const auto r = _mm512_set1_ps(rate);
+      const auto k = _mm512_set1_ps(scale);
+      const auto eps = _mm512_set1_ps(epsilon);
+      const auto tiny = _mm512_set1_ps(std::numeric_limits<float>::min());
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         const auto g = _mm512_mul_ps(k, _mm512_loadu_ps(gradient + i));
+         auto s = _mm512_fmadd_ps(_mm512_mul_ps(c2, g), g, _mm512_mul_ps(b2, _mm512_loadu_ps(moment2 + i)));
+         s = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(s, tiny, _CMP_GE_OQ), s);
+         _mm512_storeu_ps(moment2 + i, s);
+         const auto step = vdivide_root_avx512(_mm512_mul_ps(r, g), s, eps);
+         _mm512_storeu_ps(parameters + i, _mm512_add_ps(_mm512_loadu_ps(parameters + i), step));
+      }
+
+      rmsprop_scalar(rate, beta2, epsilon, scale, gradient + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void adam_avx512(const float rate, const float beta1, const float beta2, const float epsilon,
+                           const float scale, const float* gradient, float* moment1, float* moment2,
+                           float* parameters, const std::size_t size)
+   {
+      const auto b1 = _mm512_set1_ps(beta1);
+      const auto b2 = _mm512_set1_ps(beta2);
+      const auto c1 = _mm512_set1_ps(1.0f - beta1);
+      const auto c2 = _mm512_set1_ps(1.0f - beta2);
+      const auto k = _mm512_set1_ps(scale);
+      const auto r = _mm512_set1_ps(rate);
+      const auto eps = _mm512_set1_ps(epsilon);
+      const auto tiny = _mm512_set1_ps(std::numeric_limits<float>::min());
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         const auto g = _mm512_mul_ps(k, _mm512_loadu_ps(gradient + i));
+         auto m = _mm512_fmadd_ps(c1, g, _mm512_mul_ps(b1, _mm512_loadu_ps(moment1 + i)));
+         m = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(_mm512_abs_ps(m), tiny, _CMP_GE_OQ), m);
+         auto s = _mm512_fmadd_ps(_mm512_mul_ps(c2, g), g, _mm512_mul_ps(b2, _mm512_loadu_ps(moment2 + i)));
+         s = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(s, tiny, _CMP_GE_OQ), s);
+         _mm512_storeu_ps(moment1 + i, m);
+         _mm512_storeu_ps(moment2 + i, s);
+         const auto step = vdivide_root_avx512(_mm512_mul_ps(r, m), s, eps);
+         _mm512_storeu_ps(parameters + i, _mm512_add_ps(_mm512_loadu_ps(parameters + i), step));
+      }
+
+      adam_scalar(rate, beta1, beta2, epsilon, scale, gradient + i, moment1 + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   static constexpr std::size_t gemm_rows_avx512 = 8;                     /* Rader per block (AVX-512). */
+   static constexpr std::size_t gemm_columns_avx512 = 2 * 64 / sizeof(T); /* Kolumner per block (AVX-512). */
+
+   ANN_TARGET("avx512f")
+   static void gemm_avx512(const std::size_t depth, const double* a, const double* b, double* c,
+                           const std::size_t stride)
+   {
+      __m512d sum0[gemm_rows_avx512], sum1[gemm_rows_avx512];
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_avx512; ++i)
+      {
+         sum0[i] = _mm512_loadu_pd(c + i * stride);
+         sum1[i] = _mm512_loadu_pd(c + i * stride + 8);
+      }
+
+      for (std::size_t p = 0; p < depth; ++p, a += gemm_rows_avx512, b += 16)
+      {
+         const auto b0 = _mm512_loadu_pd(b);
+         const auto b1 = _mm512_loadu_pd(b + 8);
+
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemm_rows_avx512; ++i)
+         {
+            const auto x = _mm512_set1_pd(a[i]);
+            sum0[i] = _mm512_fmadd_pd(x, b0, sum0[i]);
+            sum1[i] = _mm512_fmadd_pd(x, b1, sum1[i]);
+         }
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_avx512; ++i)
+      {
+         _mm512_storeu_pd(c + i * stride, sum0[i]);
+         _mm512_storeu_pd(c + i * stride + 8, sum1[i]);
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void gemm_avx512(const std::size_t depth, const float* a, const float* b, float* c,
+                           const std::size_t stride)
+   {
+      __m512 sum0[gemm_rows_avx512], sum1[gemm_rows_avx512];
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_avx512; ++i)
+      {
+         sum0[i] = _mm512_loadu_ps(c + i * stride);
+         sum1[i] = _mm512_loadu_ps(c + i * stride + 16);
+      }
+
+      for (std::size_t p = 0; p < depth; ++p, a += gemm_rows_avx512, b += 32)
+      {
+         const auto b0 = _mm512_loadu_ps(b);
+         const auto b1 = _mm512_loadu_ps(b + 16);
+
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemm_rows_avx512; ++i)
+         {
+            const auto x = _mm512_set1_ps(a[i]);
+            sum0[i] = _mm512_fmadd_ps(x, b0, sum0[i]);
+            sum1[i] = _mm512_fmadd_ps(x, b1, sum1[i]);
+         }
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_avx512; ++i)
+      {
+         _mm512_storeu_ps(c + i * stride, sum0[i]);
+         _mm512_storeu_ps(c + i * stride + 16, sum1[i]);
+      }
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void gemv_avx512(const std::size_t depth, const double* a, const double* x, const double* bias,
+                           double* y, const bool relu)
+   {
+      __m512d sum0[gemv_steps], sum1[gemv_steps];
+      sum0[0] = _mm512_loadu_pd(bias);
+      sum1[0] = _mm512_loadu_pd(bias + 8);
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[i] = _mm512_setzero_pd();
+         sum1[i] = _mm512_setzero_pd();
+      }
+
+      std::size_t p = 0;
+
+      for (; p + gemv_steps <= depth; p += gemv_steps, a += gemv_steps * 16)
+      {
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemv_steps; ++i)
+         {
+            const auto value = _mm512_set1_pd(x[p + i]);
+            sum0[i] = _mm512_fmadd_pd(value, _mm512_loadu_pd(a + i * 16), sum0[i]);
+            sum1[i] = _mm512_fmadd_pd(value, _mm512_loadu_pd(a + i * 16 + 8), sum1[i]);
+         }
+      }
+
+      for (; p < depth; ++p, a += 16)
+      {
+         const auto value = _mm512_set1_pd(x[p]);
+         sum0[0] = _mm512_fmadd_pd(value, _mm512_loadu_pd(a), sum0[0]);
+         sum1[0] = _mm512_fmadd_pd(value, _mm512_loadu_pd(a + 8), sum1[0]);
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[0] = _mm512_add_pd(sum0[0], sum0[i]);
+         sum1[0] = _mm512_add_pd(sum1[0], sum1[i]);
+      }
+
+      if (relu)
+      {
+         const auto zero = _mm512_setzero_pd();
+         sum0[0] = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(sum0[0], zero, _CMP_GT_OQ), sum0[0]);
+         sum1[0] = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(sum1[0], zero, _CMP_GT_OQ), sum1[0]);
+      }
+
+      _mm512_storeu_pd(y, sum0[0]);
+      _mm512_storeu_pd(y + 8, sum1[0]);
+      return;
+   }
+
+   ANN_TARGET("avx512f")
+   static void gemv_avx512(const std::size_t depth, const float* a, const float* x, const float* bias,
+                           float* y, const bool relu)
+   {
+      __m512 sum0[gemv_steps], sum1[gemv_steps];
+      sum0[0] = _mm512_loadu_ps(bias);
+      sum1[0] = _mm512_loadu_ps(bias + 16);
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[i] = _mm512_setzero_ps();
+         sum1[i] = _mm512_setzero_ps();
+      }
+
+      std::size_t p = 0;
+
+      for (; p + gemv_steps <= depth; p += gemv_steps, a += gemv_steps * 32)
+      {
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemv_steps; ++i)
+         {
+            const auto value = _mm512_set1_ps(x[p + i]);
+            sum0[i] = _mm512_fmadd_ps(value, _mm512_loadu_ps(a + i * 32), sum0[i]);
+            sum1[i] = _mm512_fmadd_ps(value, _mm512_loadu_ps(a + i * 32 + 16), sum1[i]);
+         }
+      }
+
+      for (; p < depth; ++p, a += 32)
+      {
+         const auto value = _mm512_set1_ps(x[p]);
+         sum0[0] = _mm512_fmadd_ps(value, _mm512_loadu_ps(a), sum0[0]);
+         sum1[0] = _mm512_fmadd_ps(value, _mm512_loadu_ps(a + 16), sum1[0]);
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[0] = _mm512_add_ps(sum0[0], sum0[i]);
+         sum1[0] = _mm512_add_ps(sum1[0], sum1[i]);
+      }
+
+      if (relu)
+      {
+         const auto zero = _mm512_setzero_ps();
+         sum0[0] = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(sum0[0], zero, _CMP_GT_OQ), sum0[0]);
+         sum1[0] = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(sum1[0], zero, _CMP_GT_OQ), sum1[0]);
+      }
+
+      _mm512_storeu_ps(y, sum0[0]);
+      _mm512_storeu_ps(y + 16, sum1[0]);
+      return;
+   }
+
+#elif defined(ANN_SIMD_NEON)
+   /********************************************************************************
+   * NEON-versioner, dr tv flyttal av typen double eller fyra flyttal av
+   * typen float behandlas per instruktion. NEON ingr
+   * alltid i arkitekturen AArch64, varfr ingen kontroll sker vid krning.
+   ********************************************************************************/
+   static double dot_neon(const double* x, const double* y, const std::size_t size)
+   {
+      auto sum0 = vdupq_n_f64(0.0);
+      auto sum1 = vdupq_n_f64(0.0);
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         sum0 = vfmaq_f64(sum0, vld1q_f64(x + i), vld1q_f64(y + i));
+         sum1 = vfmaq_f64(sum1, vld1q_f64(x + i + 2), vld1q_f64(y + i + 2));
+      }
+
+      auto sum = vaddvq_f64(vaddq_f64(sum0, sum1));
+
+      for (; i < size; ++i)
+      {
+         sum += x[i] * y[i];
+      }
+      return sum;
+   }
+
+   static void axpy_neon(const double alpha, const double* x, double* y, const std::size_t size)
+   {
+      const auto a = vdupq_n_f64(alpha);
+      std::size_t i = 0;
+
+      for (; i + 2 <= size; i += 2)
+      {
+         vst1q_f64(y + i, vfmaq_f64(vld1q_f64(y + i), a, vld1q_f64(x + i)));
+      }
+
+      for (; i < size; ++i)
+      {
+         y[i] += alpha * x[i];
+      }
+      return;
+   }
+
+   static void relu_neon(double* data, const std::size_t size)
+   {
+      const auto zero = vdupq_n_f64(0.0);
+      std::size_t i = 0;
+
+      for (; i + 2 <= size; i += 2)
+      {
+         vst1q_f64(data + i, vmaxq_f64(vld1q_f64(data + i), zero));
+      }
+
+      for (; i < size; ++i)
+      {
+         data[i] = data[i] > 0.0 ? data[i] : 0.0;
+      }
+      return;
+   }
+
+   static void delta_relu_neon(double* error, const double* output, const std::size_t size)
+   {
+      const auto zero = vdupq_n_f64(0.0);
+      std::size_t i = 0;
+
+      for (; i + 2 <= size; i += 2)
+      {
+         const auto mask = vcgtq_f64(vld1q_f64(output + i), zero);
+         const auto masked = vandq_u64(vreinterpretq_u64_f64(vld1q_f64(error + i)), mask);
+         vst1q_f64(error + i, vreinterpretq_f64_u64(masked));
+      }
+
+      for (; i < size; ++i)
+      {
+         error[i] = output[i] > 0.0 ? error[i] : 0.0;
+      }
+      return;
+   }
+
+   static float64x2_t vexp_neon(const float64x2_t value)
+   {
+      const auto x = vminq_f64(vmaxq_f64(value, vdupq_n_f64(exp_min_f64)), vdupq_n_f64(exp_max_f64));
+      const auto n = vrndnq_f64(vmulq_f64(x, vdupq_n_f64(log2e)));
+      const auto r = vfmsq_f64(vfmsq_f64(x, n, vdupq_n_f64(ln2_hi_f64)), n, vdupq_n_f64(ln2_lo_f64));
+      auto p = vdupq_n_f64(exp_poly_f64[0]);
+
+      for (std::size_t i = 1; i < sizeof(exp_poly_f64) / sizeof(double); ++i)
+      {
+         p = vfmaq_f64(vdupq_n_f64(exp_poly_f64[i]), p, r);
+      }
+
+      const auto bias = vdupq_n_s64(1023);
+      const auto n0 = vcvtq_s64_f64(n);
+      const auto n1 = vshrq_n_s64(n0, 1);
+      const auto n2 = vsubq_s64(n0, n1);
+      const auto scale1 = vreinterpretq_f64_s64(vshlq_n_s64(vaddq_s64(n1, bias), 52));
+      const auto scale2 = vreinterpretq_f64_s64(vshlq_n_s64(vaddq_s64(n2, bias), 52));
+      return vmulq_f64(vmulq_f64(p, scale1), scale2);
+   }
+
+   static void exp_neon(double* data, const std::size_t size)
+   {
+      std::size_t i = 0;
+
+      for (; i + 2 <= size; i += 2)
+      {
+         vst1q_f64(data + i, vexp_neon(vld1q_f64(data + i)));
+      }
+
+      exp_scalar(data + i, size - i);
+      return;
+   }
+
+   static void sigmoid_neon(double* data, const std::size_t size)
+   {
+      const auto one = vdupq_n_f64(1.0);
+      std::size_t i = 0;
+
+      for (; i + 2 <= size; i += 2)
+      {
+         const auto e = vexp_neon(vnegq_f64(vld1q_f64(data + i)));
+         vst1q_f64(data + i, vdivq_f64(one, vaddq_f64(one, e)));
+      }
+
+      sigmoid_scalar(data + i, size - i);
+      return;
+   }
+
+   static void tanh_neon(double* data, const std::size_t size)
+   {
+      const auto one = vdupq_n_f64(1.0);
+      const auto minus_two = vdupq_n_f64(-2.0);
+      const auto low = vdupq_n_f64(-tanh_max);
+      const auto high = vdupq_n_f64(tanh_max);
+      std::size_t i = 0;
+
+      for (; i + 2 <= size; i += 2)
+      {
+         const auto t = vminq_f64(vmaxq_f64(vld1q_f64(data + i), low), high);
+         const auto e = vexp_neon(vmulq_f64(minus_two, t));
+         vst1q_f64(data + i, vdivq_f64(vsubq_f64(one, e), vaddq_f64(one, e)));
+      }
+
+      tanh_scalar(data + i, size - i);
+      return;
+   }
+
+   static double sparse_dot_neon(const double* values, const std::uint32_t* indices, const double* x,
+                                 const std::size_t size)
+   {
+      auto sum0 = vdupq_n_f64(0.0);
+      auto sum1 = vdupq_n_f64(0.0);
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const double lanes[4] = { x[indices[i]], x[indices[i + 1]], x[indices[i + 2]], x[indices[i + 3]] };
+         sum0 = vfmaq_f64(sum0, vld1q_f64(values + i), vld1q_f64(lanes));
+         sum1 = vfmaq_f64(sum1, vld1q_f64(values + i + 2), vld1q_f64(lanes + 2));
+      }
+      return vaddvq_f64(vaddq_f64(sum0, sum1)) + sparse_dot_scalar(values + i, indices + i, x, size - i);
+   }
+
+   static float dot_neon(const float* x, const float* y, const std::size_t size)
+   {
+      auto sum0 = vdupq_n_f32(0.0f);
+      auto sum1 = vdupq_n_f32(0.0f);
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         sum0 = vfmaq_f32(sum0, vld1q_f32(x + i), vld1q_f32(y + i));
+         sum1 = vfmaq_f32(sum1, vld1q_f32(x + i + 4), vld1q_f32(y + i + 4));
+      }
+
+      auto sum = vaddvq_f32(vaddq_f32(sum0, sum1));
+
+      for (; i < size; ++i)
+      {
+         sum += x[i] * y[i];
+      }
+      return sum;
+   }
+
+   static void axpy_neon(const float alpha, const float* x, float* y, const std::size_t size)
+   {
+      const auto a = vdupq_n_f32(alpha);
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         vst1q_f32(y + i, vfmaq_f32(vld1q_f32(y + i), a, vld1q_f32(x + i)));
+      }
+
+      for (; i < size; ++i)
+      {
+         y[i] += alpha * x[i];
+      }
+      return;
+   }
+
+   static void relu_neon(float* data, const std::size_t size)
+   {
+      const auto zero = vdupq_n_f32(0.0f);
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         vst1q_f32(data + i, vmaxq_f32(vld1q_f32(data + i), zero));
+      }
+
+      for (; i < size; ++i)
+      {
+         data[i] = data[i] > 0.0f ? data[i] : 0.0f;
+      }
+      return;
+   }
+
+   static void delta_relu_neon(float* error, const float* output, const std::size_t size)
+   {
+      const auto zero = vdupq_n_f32(0.0f);
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto mask = vcgtq_f32(vld1q_f32(output + i), zero);
+         const auto masked = vandq_u32(vreinterpretq_u32_f32(vld1q_f32(error + i)), mask);
+         vst1q_f32(error + i, vreinterpretq_f32_u32(masked));
+      }
+
+      for (; i < size; ++i)
+      {
+         error[i] = output[i] > 0.0f ? error[i] : 0.0f;
+      }
+      return;
+   }
+
+   static float32x4_t vexp_neon(const float32x4_t value)
+   {
+      const auto x = vminq_f32(vmaxq_f32(value, vdupq_n_f32(exp_min_f32)), vdupq_n_f32(exp_max_f32));
+      const auto n = vrndnq_f32(vmulq_f32(x, vdupq_n_f32(static_cast<float>(log2e))));
+      const auto r = vfmsq_f32(vfmsq_f32(x, n, vdupq_n_f32(ln2_hi_f32)), n, vdupq_n_f32(ln2_lo_f32));
+      auto p = vdupq_n_f32(exp_poly_f32[0]);
+
+      for (std::size_t i = 1; i < sizeof(exp_poly_f32) / sizeof(float); ++i)
+      {
+         p = vfmaq_f32(vdupq_n_f32(exp_poly_f32[i]), p, r);
+      }
+
+      const auto bias = vdupq_n_s32(127);
+      const auto n0 = vcvtq_s32_f32(n);
+      const auto n1 = vshrq_n_s32(n0, 1);
+      const auto n2 = vsubq_s32(n0, n1);
+      const auto scale1 = vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(n1, bias), 23));
+      const auto scale2 = vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(n2, bias), 23));
+      return vmulq_f32(vmulq_f32(p, scale1), scale2);
+   }
+
+   static void exp_neon(float* data, const std::size_t size)
+   {
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         vst1q_f32(data + i, vexp_neon(vld1q_f32(data + i)));
+      }
+
+      exp_scalar(data + i, size - i);
+      return;
+   }
+
+   static void sigmoid_neon(float* data, const std::size_t size)
+   {
+      const auto one = vdupq_n_f32(1.0f);
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto e = vexp_neon(vnegq_f32(vld1q_f32(data + i)));
+         vst1q_f32(data + i, vdivq_f32(one, vaddq_f32(one, e)));
+      }
+
+      sigmoid_scalar(data + i, size - i);
+      return;
+   }
+
+   static void tanh_neon(float* data, const std::size_t size)
+   {
+      const auto one = vdupq_n_f32(1.0f);
+      const auto minus_two = vdupq_n_f32(-2.0f);
+      const auto low = vdupq_n_f32(static_cast<float>(-tanh_max));
+      const auto high = vdupq_n_f32(static_cast<float>(tanh_max));
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto t = vminq_f32(vmaxq_f32(vld1q_f32(data + i), low), high);
+         const auto e = vexp_neon(vmulq_f32(minus_two, t));
+         vst1q_f32(data + i, vdivq_f32(vsubq_f32(one, e), vaddq_f32(one, e)));
+      }
+
+      tanh_scalar(data + i, size - i);
+      return;
+   }
+
+   static float sparse_dot_neon(const float* values, const std::uint32_t* indices, const float* x,
+                                const std::size_t size)
+   {
+      auto sum0 = vdupq_n_f32(0.0f);
+      auto sum1 = vdupq_n_f32(0.0f);
+      std::size_t i = 0;
+
+      for (; i + 8 <= size; i += 8)
+      {
+         const float lanes[8] = { x[indices[i]], x[indices[i + 1]], x[indices[i + 2]], x[indices[i + 3]],
+                                  x[indices[i + 4]], x[indices[i + 5]], x[indices[i + 6]], x[indices[i + 7]] };
+         sum0 = vfmaq_f32(sum0, vld1q_f32(values + i), vld1q_f32(lanes));
+         sum1 = vfmaq_f32(sum1, vld1q_f32(values + i + 4), vld1q_f32(lanes + 4));
+      }
+      return vaddvq_f32(vaddq_f32(sum0, sum1)) + sparse_dot_scalar(values + i, indices + i, x, size - i);
+   }
+
+   /********************************************************************************
+   * Justering av parametrar enligt optimeringsmetoderna i "optimizer.hpp",
+   * dr samtliga tillstnd lses och skrivs en vektor i taget. Kvadratroten
+   * och divisionen berknas via vektorinstruktioner, medan resterande
+   * element hanteras av de skalra referensversionerna. Tillstnd vars
+   * belopp understiger minsta normaliserade flyttal nollstlls, se flush.
+   ********************************************************************************/
+   static void momentum_neon(const double rate, const double momentum, const double scale, const double* gradient,
+                             double* velocity, double* parameters, const std::size_t size, const bool nesterov)
+   {
+      const auto mu = vdupq_n_f64(momentum);
+      const auto k = vdupq_n_f64(scale);
+      const auto rate_v = vdupq_n_f64(nesterov ? rate * momentum : rate);
+      const auto rate_g = vdupq_n_f64(nesterov ? rate : 0.0);
+      const auto tiny = vdupq_n_f64(std::numeric_limits<double>::min());
+      std::size_t i = 0;
+
+      for (; i + 2 <= size; i += 2)
+      {
+         const auto g = vmulq_f64(k, vld1q_f64(gradient + i));
+         auto v = vfmaq_f64(g, mu, vld1q_f64(velocity + i));
+         v = vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(v), vcageq_f64(v, tiny)));
+         vst1q_f64(velocity + i, v);
+         const auto p = vfmaq_f64(vld1q_f64(parameters + i), rate_g, g);
+         vst1q_f64(parameters + i, vfmaq_f64(p, rate_v, v));
+      }
+
+      momentum_scalar(rate, momentum, scale, gradient + i, velocity + i, parameters + i, size - i, nesterov);
+      return;
+   }
+
+   static void rmsprop_neon(const double rate, const double beta2, const double epsilon, const double scale,
+                            const double* gradient, double* moment2, double* parameters, const std::size_t size)
+   {
+      const auto b2 = vdupq_n_f64(beta2);
+      const auto c2 = vdupq_n_f64(1.0 - beta2);
+      const auto r = vdupq_n_f64(rate);
+      const auto k = vdupq_n_f64(scale);
+      const auto eps = vdupq_n_f64(epsilon);
+      const auto tiny = vdupq_n_f64(std::numeric_limits<double>::min());
+      std::size_t i = 0;
+
+      for (; i + 2 <= size; i += 2)
+      {
+         const auto g = vmulq_f64(k, vld1q_f64(gradient + i));
+         auto s = vfmaq_f64(vmulq_f64(b2, vld1q_f64(moment2 + i)), vmulq_f64(c2, g), g);
+         s = vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(s), vcgeq_f64(s, tiny)));
+         vst1q_f64(moment2 + i, s);
+         const auto step = vdivq_f64(vmulq_f64(r, g), vaddq_f64(vsqrtq_f64(s), eps));
+         vst1q_f64(parameters + i, vaddq_f64(vld1q_f64(parameters + i), step));
+      }
+
+      rmsprop_scalar(rate, beta2, epsilon, scale, gradient + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   static void adam_neon(const double rate, const double beta1, const double beta2, const double epsilon,
+                         const double scale, const double* gradient, double* moment1, double* moment2,
+                         double* parameters, const std::size_t size)
+   {
+      const auto b1 = vdupq_n_f64(beta1);
+      const auto b2 = vdupq_n_f64(beta2);
+      const auto c1 = vdupq_n_f64(1.0 - beta1);
+      const auto c2 = vdupq_n_f64(1.0 - beta2);
+      const auto k = vdupq_n_f64(scale);
+      const auto r = vdupq_n_f64(rate);
+      const auto eps = vdupq_n_f64(epsilon);
+      const auto tiny = vdupq_n_f64(std::numeric_limits<double>::min());
+      std::size_t i = 0;
+
+      for (; i + 2 <= size; i += 2)
+      {
+         const auto g = vmulq_f64(k, vld1q_f64(gradient + i));
+         auto m = vfmaq_f64(vmulq_f64(b1, vld1q_f64(moment1 + i)), c1, g);
+         m = vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(m), vcageq_f64(m, tiny)));
+         auto s = vfmaq_f64(vmulq_f64(b2, vld1q_f64(moment2 + i)), vmulq_f64(c2, g), g);
+         s = vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(s), vcgeq_f64(s, tiny)));
+         vst1q_f64(moment1 + i, m);
+         vst1q_f64(moment2 + i, s);
+         const auto step = vdivq_f64(vmulq_f64(r, m), vaddq_f64(vsqrtq_f64(s), eps));
+         vst1q_f64(parameters + i, vaddq_f64(vld1q_f64(parameters + i), step));
+      }
+
+      adam_scalar(rate, beta1, beta2, epsilon, scale, gradient + i, moment1 + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   static void momentum_neon(const float rate, const float momentum, const float scale, const float* gradient,
+                             float* velocity, float* parameters, const std::size_t size, const bool nesterov)
+   {
+      const auto mu = vdupq_n_f32(momentum);
+      const auto k = vdupq_n_f32(scale);
+      const auto rate_v = vdupq_n_f32(nesterov ? rate * momentum : rate);
+      const auto rate_g = vdupq_n_f32(nesterov ? rate : 0.0f);
+      const auto tiny = vdupq_n_f32(std::numeric_limits<float>::min());
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto g = vmulq_f32(k, vld1q_f32(gradient + i));
+         auto v = vfmaq_f32(g, mu, vld1q_f32(velocity + i));
+         v = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), vcageq_f32(v, tiny)));
+         vst1q_f32(velocity + i, v);
+         const auto p = vfmaq_f32(vld1q_f32(parameters + i), rate_g, g);
+         vst1q_f32(parameters + i, vfmaq_f32(p, rate_v, v));
+      }
+
+      momentum_scalar(rate, momentum, scale, gradient + i, velocity + i, parameters + i, size - i, nesterov);
+      return;
+   }
+
+   static void rmsprop_neon(const float rate, const float beta2, const float epsilon, const float scale,
+                            const float* gradient, float* moment2, float* parameters, const std::size_t size)
+   {
+      const auto b2 = vdupq_n_f32(beta2);
+      const auto c2 = vdupq_n_f32(1.0f - beta2);
+      const auto r = vdupq_n_f32(rate);
+      const auto k = vdupq_n_f32(scale);
+      const auto eps = vdupq_n_f32(epsilon);
+      const auto tiny = vdupq_n_f32(std::numeric_limits<float>::min());
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto g = vmulq_f32(k, vld1q_f32(gradient + i));
+         auto s = vfmaq_f32(vmulq_f32(b2, vld1q_f32(moment2 + i)), vmulq_f32(c2, g), g);
+         s = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(s), vcgeq_f32(s, tiny)));
+         vst1q_f32(moment2 + i, s);
+         const auto step = vdivq_f32(vmulq_f32(r, g), vaddq_f32(vsqrtq_f32(s), eps));
+         vst1q_f32(parameters + i, vaddq_f32(vld1q_f32(parameters + i), step));
+      }
+
+      rmsprop_scalar(rate, beta2, epsilon, scale, gradient + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   static void adam_neon(const float rate, const float beta1, const float beta2, const float epsilon,
+                         const float scale, const float* gradient, float* moment1, float* moment2,
+                         float* parameters, const std::size_t size)
+   {
+      const auto b1 = vdupq_n_f32(beta1);
+      const auto b2 = vdupq_n_f32(beta2);
+      const auto c1 = vdupq_n_f32(1.0f - beta1);
+      const auto c2 = vdupq_n_f32(1.0f - beta2);
+      const auto k = vdupq_n_f32(scale);
+      const auto r = vdupq_n_f32(rate);
+      const auto eps = vdupq_n_f32(epsilon);
+      const auto tiny = vdupq_n_f32(std::numeric_limits<float>::min());
+      std::size_t i = 0;
+
+      for (; i + 4 <= size; i += 4)
+      {
+         const auto g = vmulq_f32(k, vld1q_f32(gradient + i));
+         auto m = vfmaq_f32(vmulq_f32(b1, vld1q_f32(moment1 + i)), c1, g);
+         m = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(m), vcageq_f32(m, tiny)));
+         auto s = vfmaq_f32(vmulq_f32(b2, vld1q_f32(moment2 + i)), vmulq_f32(c2, g), g);
+         s = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(s), vcgeq_f32(s, tiny)));
+         vst1q_f32(moment1 + i, m);
+         vst1q_f32(moment2 + i, s);
+         const auto step = vdivq_f32(vmulq_f32(r, m), vaddq_f32(vsqrtq_f32(s), eps));
+         vst1q_f32(parameters + i, vaddq_f32(vld1q_f32(parameters + i), step));
+      }
+
+      adam_scalar(rate, beta1, beta2, epsilon, scale, gradient + i, moment1 + i, moment2 + i, parameters + i, size - i);
+      return;
+   }
+
+   static constexpr std::size_t gemm_rows_neon = 8;                     /* Rader per block (NEON). */
+   static constexpr std::size_t gemm_columns_neon = 2 * 16 / sizeof(T); /* Kolumner per block (NEON). */
+
+   static void gemm_neon(const std::size_t depth, const double* a, const double* b, double* c,
+                         const std::size_t stride)
+   {
+      float64x2_t sum0[gemm_rows_neon], sum1[gemm_rows_neon];
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_neon; ++i)
+      {
+         sum0[i] = vld1q_f64(c + i * stride);
+         sum1[i] = vld1q_f64(c + i * stride + 2);
+      }
+
+      for (std::size_t p = 0; p < depth; ++p, a += gemm_rows_neon, b += 4)
+      {
+         const auto b0 = vld1q_f64(b);
+         const auto b1 = vld1q_f64(b + 2);
+
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemm_rows_neon; ++i)
+         {
+            sum0[i] = vfmaq_n_f64(sum0[i], b0, a[i]);
+            sum1[i] = vfmaq_n_f64(sum1[i], b1, a[i]);
+         }
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_neon; ++i)
+      {
+         vst1q_f64(c + i * stride, sum0[i]);
+         vst1q_f64(c + i * stride + 2, sum1[i]);
+      }
+      return;
+   }
+
+   static void gemm_neon(const std::size_t depth, const float* a, const float* b, float* c,
+                         const std::size_t stride)
+   {
+      float32x4_t sum0[gemm_rows_neon], sum1[gemm_rows_neon];
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_neon; ++i)
+      {
+         sum0[i] = vld1q_f32(c + i * stride);
+         sum1[i] = vld1q_f32(c + i * stride + 4);
+      }
+
+      for (std::size_t p = 0; p < depth; ++p, a += gemm_rows_neon, b += 8)
+      {
+         const auto b0 = vld1q_f32(b);
+         const auto b1 = vld1q_f32(b + 4);
+
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemm_rows_neon; ++i)
+         {
+            sum0[i] = vfmaq_n_f32(sum0[i], b0, a[i]);
+            sum1[i] = vfmaq_n_f32(sum1[i], b1, a[i]);
+         }
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 0; i < gemm_rows_neon; ++i)
+      {
+         vst1q_f32(c + i * stride, sum0[i]);
+         vst1q_f32(c + i * stride + 4, sum1[i]);
+      }
+      return;
+   }
+
+   static void gemv_neon(const std::size_t depth, const double* a, const double* x, const double* bias,
+                         double* y, const bool relu)
+   {
+      float64x2_t sum0[gemv_steps], sum1[gemv_steps];
+      sum0[0] = vld1q_f64(bias);
+      sum1[0] = vld1q_f64(bias + 2);
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[i] = vdupq_n_f64(0.0);
+         sum1[i] = vdupq_n_f64(0.0);
+      }
+
+      std::size_t p = 0;
+
+      for (; p + gemv_steps <= depth; p += gemv_steps, a += gemv_steps * 4)
+      {
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemv_steps; ++i)
+         {
+            sum0[i] = vfmaq_n_f64(sum0[i], vld1q_f64(a + i * 4), x[p + i]);
+            sum1[i] = vfmaq_n_f64(sum1[i], vld1q_f64(a + i * 4 + 2), x[p + i]);
+         }
+      }
+
+      for (; p < depth; ++p, a += 4)
+      {
+         sum0[0] = vfmaq_n_f64(sum0[0], vld1q_f64(a), x[p]);
+         sum1[0] = vfmaq_n_f64(sum1[0], vld1q_f64(a + 2), x[p]);
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[0] = vaddq_f64(sum0[0], sum0[i]);
+         sum1[0] = vaddq_f64(sum1[0], sum1[i]);
+      }
+
+      if (relu)
+      {
+         sum0[0] = vmaxq_f64(sum0[0], vdupq_n_f64(0.0));
+         sum1[0] = vmaxq_f64(sum1[0], vdupq_n_f64(0.0));
+      }
+
+      vst1q_f64(y, sum0[0]);
+      vst1q_f64(y + 2, sum1[0]);
+      return;
+   }
+
+   static void gemv_neon(const std::size_t depth, const float* a, const float* x, const float* bias,
+                         float* y, const bool relu)
+   {
+      float32x4_t sum0[gemv_steps], sum1[gemv_steps];
+      sum0[0] = vld1q_f32(bias);
+      sum1[0] = vld1q_f32(bias + 4);
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[i] = vdupq_n_f32(0.0f);
+         sum1[i] = vdupq_n_f32(0.0f);
+      }
+
+      std::size_t p = 0;
+
+      for (; p + gemv_steps <= depth; p += gemv_steps, a += gemv_steps * 8)
+      {
+         ANN_UNROLL
+         for (std::size_t i = 0; i < gemv_steps; ++i)
+         {
+            sum0[i] = vfmaq_n_f32(sum0[i], vld1q_f32(a + i * 8), x[p + i]);
+            sum1[i] = vfmaq_n_f32(sum1[i], vld1q_f32(a + i * 8 + 4), x[p + i]);
+         }
+      }
+
+      for (; p < depth; ++p, a += 8)
+      {
+         sum0[0] = vfmaq_n_f32(sum0[0], vld1q_f32(a), x[p]);
+         sum1[0] = vfmaq_n_f32(sum1[0], vld1q_f32(a + 4), x[p]);
+      }
+
+      ANN_UNROLL
+      for (std::size_t i = 1; i < gemv_steps; ++i)
+      {
+         sum0[0] = vaddq_f32(sum0[0], sum0[i]);
+         sum1[0] = vaddq_f32(sum1[0], sum1[i]);
+      }
+
+      if (relu)
+      {
+         sum0[0] = vmaxq_f32(sum0[0], vdupq_n_f32(0.0f));
+         sum1[0] = vmaxq_f32(sum1[0], vdupq_n_f32(0.0f));
+      }
+
+      vst1q_f32(y, sum0[0]);
+      vst1q_f32(y + 4, sum1[0]);
+      return;
+   }
+#endif
+};
+
+/********************************************************************************
+* int8_kernels: Strukt innehllande pekare till berkningskrnor fr heltal om
+*               8 bitar, vilka anvnds vid kvantiserad prediktion:
+*
+*               - dot: Returnerar skalrprodukten av x och y som ett heltal om
+*                      32 bitar. Samtliga vrden mste ligga mellan -127 och
+*                      127, vilket gr att krnorna kan anvnda instruktioner
+*                      fr produkter av tal med och utan tecken (VNNI samt
+*                      pmaddubsw) utan risk fr mttnad. Resultatet r exakt
+*                      och drmed identiskt fr samtliga versioner.
+*
+*               Vid AVX-512 anvnds VNNI (vpdpbusd) om processorn stder det,
+*               annars AVX512BW. Vid NEON anvnds dotprod (sdot) ifall
+*               programmet kompileras med std fr det. Instruktions-
+*               uppsttningen vljs p samma stt som fr basic_simd_kernels.
+********************************************************************************/
+struct int8_kernels : simd_support
+{
+   isa type;                                                                          /* Instruktionsuppsttning. */
+   bool dot_product;                                                                  /* Indikerar ifall VNNI/dotprod anvnds. */
+   std::int32_t (*dot)(const std::int8_t* x, const std::int8_t* y, std::size_t size); /* Skalrprodukt. */
+
+   /********************************************************************************
+   * get: Returnerar en referens till de berkningskrnor som fr nrvarande
+   *      anvnds. Vid frsta anropet vljs den snabbaste version som stds av
+   *      processorn.
+   ********************************************************************************/
+   static const int8_kernels& get(void)
+   {
+      return active();
+   }
+
+   /********************************************************************************
+   * get: Returnerar berkningskrnorna fr angiven instruktionsuppsttning.
+   *      Om angiven instruktionsuppsttning inte r tillgnglig vid kompilering
+   *      returneras den skalra referensversionen. Vid AVX-512 krvs ven
+   *      AVX512BW, annars returneras versionen fr AVX2.
+   *
+   *      - type: nskad instruktionsuppsttning.
+   ********************************************************************************/
+   static int8_kernels get(const isa type)
+   {
+#if defined(ANN_SIMD_X86)
+      if (type == isa::avx512 && cpu_has_avx512_vnni()) return { {}, isa::avx512, true, dot_avx512_vnni };
+      if (type == isa::avx512 && cpu_has_avx512bw()) return { {}, isa::avx512, false, dot_avx512 };
+      if (type == isa::avx512 || type == isa::avx2) return { {}, isa::avx2, false, dot_avx2 };
+#elif defined(ANN_SIMD_NEON)
+#if defined(__ARM_FEATURE_DOTPROD)
+      if (type == isa::neon) return { {}, isa::neon, true, dot_neon };
+#else
+      if (type == isa::neon) return { {}, isa::neon, false, dot_neon };
+#endif
+#endif
+      (void)type;
+      return { {}, isa::scalar, false, dot_scalar };
+   }
+
+   /********************************************************************************
+   * select: Vljer vilken instruktionsuppsttning som ska anvndas vid
+   *         kvantiserad prediktion. Om processorn inte stder angiven
+   *         instruktionsuppsttning vljs den skalra referensversionen.
+   *         OBS! Fr inte anropas medan prediktion pgr i en annan trd.
+   *
+   *         - type: nskad instruktionsuppsttning.
+   ********************************************************************************/
+   static void select(const isa type)
+   {
+      active() = supported(type) ? get(type) : get(isa::scalar);
+      return;
+   }
+
+private:
+   /********************************************************************************
+   * active: Returnerar en referens till de berkningskrnor som fr nrvarande
+   *         anvnds, vilka initieras vid frsta anropet.
+   ********************************************************************************/
+   static int8_kernels& active(void)
+   {
+      static int8_kernels kernels = get(detect());
+      return kernels;
+   }
+
+   /********************************************************************************
+   * Skalr referensversion.
+   ********************************************************************************/
+   static std::int32_t dot_scalar(const std::int8_t* x, const std::int8_t* y, const std::size_t size)
+   {
+      std::int32_t sum = 0;
+
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         sum += static_cast<std::int32_t>(x[i]) * static_cast<std::int32_t>(y[i]);
+      }
+      return sum;
+   }
+
+#if defined(ANN_SIMD_X86)
+   /********************************************************************************
+   * Versioner fr x86, dr 32 (AVX2) eller 64 (AVX-512) heltal behandlas per
+   * instruktion. Tecknet fr x flyttas frst ver till y, s att |x| kan
+   * behandlas som tal utan tecken. Vid AVX2 och AVX512BW multipliceras
+   * talen parvis och summeras till heltal om 16 bitar (pmaddubsw), vilket
+   * inte kan ge mttnad d 2 * 127 * 127 < 2^15, varefter summorna utkas
+   * till 32 bitar. Vid VNNI utfrs samtliga steg via en instruktion.
+   ********************************************************************************/
+   ANN_TARGET("avx2")
+   static std::int32_t dot_avx2(const std::int8_t* x, const std::int8_t* y, const std::size_t size)
+   {
+      const auto ones = _mm256_set1_epi16(1);
+      auto sum = _mm256_setzero_si256();
+      std::size_t i = 0;
+
+      for (; i + 32 <= size; i += 32)
+      {
+         const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+         const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+         const auto products = _mm256_maddubs_epi16(_mm256_abs_epi8(a), _mm256_sign_epi8(b, a));
+         sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+      }
+
+      auto half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+      half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+      half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+      return _mm_cvtsi128_si32(half) + dot_scalar(x + i, y + i, size - i);
+   }
+
+   ANN_TARGET("avx512f,avx512bw")
+   static std::int32_t dot_avx512(const std::int8_t* x, const std::int8_t* y, const std::size_t size)
+   {
+      const auto ones = _mm512_set1_epi16(1);
+      const auto zero = _mm512_setzero_si512();
+      auto sum = _mm512_setzero_si512();
+
+      for (std::size_t i = 0; i < size; i += 64)
+      {
+         const auto remaining = size - i;
+         const auto mask = remaining >= 64 ? ~__mmask64(0) : (__mmask64(1) << remaining) - 1;
+         const auto a = _mm512_maskz_loadu_epi8(mask, x + i);
+         const auto b = _mm512_maskz_loadu_epi8(mask, y + i);
+         const auto signed_b = _mm512_mask_sub_epi8(b, _mm512_movepi8_mask(a), zero, b);
+         const auto products = _mm512_maddubs_epi16(_mm512_abs_epi8(a), signed_b);
+         sum = _mm512_add_epi32(sum, _mm512_madd_epi16(products, ones));
+      }
+      return reduce_avx512(sum);
+   }
+
+   ANN_TARGET("avx512f,avx512bw,avx512vnni")
+   static std::int32_t dot_avx512_vnni(const std::int8_t* x, const std::int8_t* y, const std::size_t size)
+   {
+      const auto zero = _mm512_setzero_si512();
+      auto sum0 = _mm512_setzero_si512();
+      auto sum1 = _mm512_setzero_si512();
+      std::size_t i = 0;
+
+      for (; i + 128 <= size; i += 128)
+      {
+         const auto a0 = _mm512_loadu_si512(x + i);
+         const auto b0 = _mm512_loadu_si512(y + i);
+         const auto a1 = _mm512_loadu_si512(x + i + 64);
+         const auto b1 = _mm512_loadu_si512(y + i + 64);
+         sum0 = _mm512_dpbusd_epi32(sum0, _mm512_abs_epi8(a0), _mm512_mask_sub_epi8(b0, _mm512_movepi8_mask(a0), zero, b0));
+         sum1 = _mm512_dpbusd_epi32(sum1, _mm512_abs_epi8(a1), _mm512_mask_sub_epi8(b1, _mm512_movepi8_mask(a1), zero, b1));
+      }
+
+      for (; i < size; i += 64)
+      {
+         const auto remaining = size - i;
+         const auto mask = remaining >= 64 ? ~__mmask64(0) : (__mmask64(1) << remaining) - 1;
+         const auto a = _mm512_maskz_loadu_epi8(mask, x + i);
+         const auto b = _mm512_maskz_loadu_epi8(mask, y + i);
+         sum0 = _mm512_dpbusd_epi32(sum0, _mm512_abs_epi8(a), _mm512_mask_sub_epi8(b, _mm512_movepi8_mask(a), zero, b));
+      }
+      return reduce_avx512(_mm512_add_epi32(sum0, sum1));
+   }
+
+   /********************************************************************************
+   * reduce_avx512: Returnerar summan av samtliga heltal i angivet register.
+   *                Halvorna extraheras via den maskade varianten med samtliga
+   *                element aktiva, d _mm512_reduce_add_epi32 samt
+   *                _mm512_castsi512_si256 ger felaktiga varningar om
+   *                oinitierade variabler i vissa versioner av GCC.
+   ********************************************************************************/
+   ANN_TARGET("avx512f")
+   static std::int32_t reduce_avx512(const __m512i sum)
+   {
+      const auto lower = _mm512_maskz_extracti64x4_epi64(0xFF, sum, 0);
+      const auto upper = _mm512_maskz_extracti64x4_epi64(0xFF, sum, 1);
+      const auto half = _mm256_add_epi32(lower, upper);
+      auto quarter = _mm_add_epi32(_mm256_castsi256_si128(half), _mm256_extracti128_si256(half, 1));
+      quarter = _mm_add_epi32(quarter, _mm_shuffle_epi32(quarter, 0x4E));
+      quarter = _mm_add_epi32(quarter, _mm_shuffle_epi32(quarter, 0xB1));
+      return _mm_cvtsi128_si32(quarter);
+   }
+#elif defined(ANN_SIMD_NEON)
+   /********************************************************************************
+   * NEON-version, dr 16 heltal behandlas per instruktion. Med dotprod
+   * summeras fyra produkter direkt till varje heltal om 32 bitar (sdot),
+   * annars multipliceras talen till heltal om 16 bitar, dr tv produkter
+   * summeras innan de utkas till 32 bitar, vilket inte kan ge verspill
+   * d 2 * 127 * 127 < 2^15.
+   ********************************************************************************/
+   static std::int32_t dot_neon(const std::int8_t* x, const std::int8_t* y, const std::size_t size)
+   {
+      auto sum = vdupq_n_s32(0);
+      std::size_t i = 0;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         const auto a = vld1q_s8(x + i);
+         const auto b = vld1q_s8(y + i);
+#if defined(__ARM_FEATURE_DOTPROD)
+         sum = vdotq_s32(sum, a, b);
+#else
+         const auto products = vmlal_s8(vmull_s8(vget_low_s8(a), vget_low_s8(b)), vget_high_s8(a), vget_high_s8(b));
+         sum = vpadalq_s16(sum, products);
+#endif
+      }
+      return vaddvq_s32(sum) + dot_scalar(x + i, y + i, size - i);
+   }
+#endif
+};
+
+/********************************************************************************
+* simd_kernels: Berkningskrnor fr flyttal av typen double.
+********************************************************************************/
+using simd_kernels = basic_simd_kernels<double>;
+
+#endif /* SIMD_HPP_ */
\ No newline at end of file
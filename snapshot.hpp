@@ -0,0 +1,378 @@
+/********************************************************************************
+* snapshot.hpp: Innehller publicering av modeller under pgende prediktion
+*               via klasstemplaten basic_snapshot_publisher. En trnande trd
+*               publicerar nya versioner av ett ntverks modell, vilka
+*               drefter aldrig ndras, medan godtyckligt antal lsande
+*               trdar hmtar senast publicerade version utan lsning och
+*               utan att ngonsin behva vnta p den trnande trden.
+*
+*               ldre versioner frigrs frst nr ingen lsare lngre
+*               anvnder dem, vilket avgrs via s kallade hazard pointers:
+*               varje lsare har en egen plats dr versionen som anvnds
+*               deklareras, och versioner som ersatts frigrs enbart om de
+*               inte finns p ngon lsares plats.
+********************************************************************************/
+#ifndef SNAPSHOT_HPP_
+#define SNAPSHOT_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "ann.hpp"
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+/********************************************************************************
+* basic_model_snapshot: Publicerad version av ett ntverks modell, vilken inte
+*                       ndras efter publiceringen. Prediktion sker via de
+*                       konstanta varianterna av medlemsfunktionerna predict
+*                       och predict_batch med en egen inference_context per
+*                       lsare.
+********************************************************************************/
+template <typename T>
+struct basic_model_snapshot
+{
+   std::uint64_t version{0}; /* Versionsnummer, rknas upp frn 1 vid varje publicering. */
+   basic_ann<T> network;     /* Modellen, utan trningsdata och tillstnd fr justering. */
+};
+
+/********************************************************************************
+* basic_snapshot_publisher: Klass fr publicering av modeller till lsande
+*                           trdar. Publicering via medlemsfunktionen publish
+*                           erstter aktuell version atomiskt, dr samtidiga
+*                           publiceringar serialiseras via en mutex som
+*                           lsarna aldrig anvnder. Varje lsande trd skapar
+*                           en egen lsare via medlemsfunktionen make_reader,
+*                           vilken reserverar en av ett fast antal platser,
+*                           och hmtar senast publicerade version via lsarens
+*                           medlemsfunktion acquire infr varje prediktion.
+*
+*                           Samtliga lsare mste ha frstrts innan
+*                           publiceraren frstrs.
+********************************************************************************/
+template <typename T>
+class basic_snapshot_publisher
+{
+public:
+   using value_type = T;                          /* Flyttalstyp fr modellen. */
+   using ann_type = basic_ann<T>;                 /* Ntverket som publiceras. */
+   using snapshot_type = basic_model_snapshot<T>; /* Publicerad version av modellen. */
+
+private:
+   /********************************************************************************
+   * reader_slot: Plats fr en lsare, placerad p en egen cache-linje s att
+   *              lsarnas skrivningar inte pverkar varandra.
+   ********************************************************************************/
+   struct alignas(64) reader_slot
+   {
+      std::atomic<bool> used{false};                     /* Indikerar ifall platsen r reserverad. */
+      std::atomic<const snapshot_type*> hazard{nullptr}; /* Versionen som lsaren anvnder. */
+   };
+
+public:
+   /********************************************************************************
+   * reader: Lsare fr en enskild trd, vilken reserverar en plats hos
+   *         publiceraren vid skapandet och frigr den nr lsaren frstrs.
+   *         En lsare fr enbart anvndas av en trd t gngen.
+   ********************************************************************************/
+   class reader
+   {
+   public:
+      /********************************************************************************
+      * reader: Initierar ny lsare utan plats, vilken inte kan hmta ngon
+      *         version.
+      ********************************************************************************/
+      reader(void) { }
+
+      reader(const reader&) = delete;
+      reader& operator=(const reader&) = delete;
+
+      /********************************************************************************
+      * reader: Flyttar angiven lsares plats till den nya lsaren.
+      *
+      *         - source: Referens till lsaren som flyttas.
+      ********************************************************************************/
+      reader(reader&& source) noexcept
+         : publisher_{source.publisher_}, slot_{source.slot_}, current_{source.current_}
+      {
+         source.slot_ = nullptr;
+         source.current_ = nullptr;
+      }
+
+      /********************************************************************************
+      * operator=: Frigr lsarens plats och flyttar angiven lsares plats
+      *            till denna lsare.
+      *
+      *            - source: Referens till lsaren som flyttas.
+      ********************************************************************************/
+      reader& operator=(reader&& source) noexcept
+      {
+         if (this != &source)
+         {
+            this->close();
+            this->publisher_ = source.publisher_;
+            this->slot_ = source.slot_;
+            this->current_ = source.current_;
+            source.slot_ = nullptr;
+            source.current_ = nullptr;
+         }
+         return *this;
+      }
+
+      /********************************************************************************
+      * ~reader: Frigr lsarens plats, varefter versionen som senast hmtades
+      *          kan frigras av publiceraren.
+      ********************************************************************************/
+      ~reader(void)
+      {
+         this->close();
+         return;
+      }
+
+      /********************************************************************************
+      * is_valid: Indikerar ifall lsaren har en plats, vilket saknas om
+      *           samtliga platser redan var reserverade nr lsaren skapades.
+      ********************************************************************************/
+      bool is_valid(void) const
+      {
+         return this->slot_ != nullptr;
+      }
+
+      /********************************************************************************
+      * acquire: Returnerar en pekare till senast publicerade version, vilken
+      *          frblir giltig tills nsta anrop av acquire eller release,
+      *          alternativt tills lsaren frstrs. Om ingen ny version har
+      *          publicerats sedan fregende anrop krvs enbart en atomisk
+      *          lsning. Returnerar nullptr om ingen version har publicerats
+      *          eller om lsaren saknar plats.
+      ********************************************************************************/
+      const snapshot_type* acquire(void)
+      {
+         if (this->slot_ == nullptr) return nullptr;
+         const auto& published = this->publisher_->current_;
+         auto current = published.load(std::memory_order_acquire);
+         if (current == this->current_) return current;
+
+         while (true)
+         {
+            this->slot_->hazard.store(current, std::memory_order_seq_cst);
+            const auto latest = published.load(std::memory_order_seq_cst);
+            if (latest == current) break;
+            current = latest;
+         }
+
+         this->current_ = current;
+         return current;
+      }
+
+      /********************************************************************************
+      * release: Deklarerar att lsaren inte lngre anvnder senast hmtad
+      *          version, s att den kan frigras ven om lsaren finns kvar.
+      ********************************************************************************/
+      void release(void)
+      {
+         if (this->slot_ == nullptr) return;
+         this->slot_->hazard.store(nullptr, std::memory_order_release);
+         this->current_ = nullptr;
+         return;
+      }
+
+   private:
+      friend class basic_snapshot_publisher;
+
+      /********************************************************************************
+      * reader: Initierar ny lsare via angiven reserverad plats.
+      *
+      *         - publisher: Pekare till publiceraren som lsaren hmtar frn.
+      *         - slot     : Pekare till lsarens reserverade plats.
+      ********************************************************************************/
+      reader(const basic_snapshot_publisher* publisher,
+             reader_slot* slot)
+         : publisher_{publisher}, slot_{slot} { }
+
+      /********************************************************************************
+      * close: Frigr lsarens plats.
+      ********************************************************************************/
+      void close(void)
+      {
+         if (this->slot_ == nullptr) return;
+         this->release();
+         this->slot_->used.store(false, std::memory_order_release);
+         this->slot_ = nullptr;
+         return;
+      }
+
+      const basic_snapshot_publisher* publisher_{nullptr}; /* Publiceraren som lsaren hmtar frn. */
+      reader_slot* slot_{nullptr};                         /* Lsarens plats hos publiceraren. */
+      const snapshot_type* current_{nullptr};              /* Senast hmtad version. */
+   };
+
+   /********************************************************************************
+   * basic_snapshot_publisher: Initierar ny publicerare utan publicerad version.
+   *
+   *                           - max_readers: Maximalt antal samtidiga lsare
+   *                                          (default = 64).
+   ********************************************************************************/
+   explicit basic_snapshot_publisher(const std::size_t max_readers = 64)
+      : slots_(new reader_slot[max_readers > 0 ? max_readers : 1]),
+        num_slots_{max_readers > 0 ? max_readers : 1} { }
+
+   basic_snapshot_publisher(const basic_snapshot_publisher&) = delete;
+   basic_snapshot_publisher& operator=(const basic_snapshot_publisher&) = delete;
+
+   /********************************************************************************
+   * ~basic_snapshot_publisher: Frigr aktuell version samt samtliga ersatta
+   *                            versioner.
+   ********************************************************************************/
+   ~basic_snapshot_publisher(void)
+   {
+      delete this->current_.load(std::memory_order_acquire);
+
+      for (const auto i : this->retired_)
+      {
+         delete i;
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * make_reader: Returnerar en ny lsare, vilken reserverar en ledig plats.
+   *              Om samtliga platser r reserverade returneras en lsare utan
+   *              plats, se medlemsfunktionen is_valid i klassen reader.
+   ********************************************************************************/
+   reader make_reader(void)
+   {
+      for (std::size_t i = 0; i < this->num_slots_; ++i)
+      {
+         auto expected = false;
+
+         if (this->slots_[i].used.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+         {
+            return reader(this, &this->slots_[i]);
+         }
+      }
+      return reader();
+   }
+
+   /********************************************************************************
+   * publish: Publicerar en kopia av angivet ntverks modell som ny version,
+   *          se medlemsfunktionen copy_model i klassen ann, och returnerar
+   *          versionsnumret. Lsarna erhller den nya versionen vid nsta
+   *          anrop av acquire. Drefter frigrs ersatta versioner som ingen
+   *          lsare lngre anvnder.
+   *
+   *          - network: Referens till ntverket vars modell publiceras.
+   ********************************************************************************/
+   std::uint64_t publish(const ann_type& network)
+   {
+      return this->publish_model(network.copy_model());
+   }
+
+   /********************************************************************************
+   * publish_model: Publicerar angivet ntverk som ny version utan kopiering,
+   *                exempelvis ett ntverk som har lsts in frn fil, och
+   *                returnerar versionsnumret.
+   *
+   *                - network: Ntverket som publiceras.
+   ********************************************************************************/
+   std::uint64_t publish_model(ann_type&& network)
+   {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      std::unique_ptr<snapshot_type> snapshot(new snapshot_type());
+      const auto version = this->version_.load(std::memory_order_relaxed) + 1;
+      snapshot->version = version;
+      snapshot->network = std::move(network);
+      const auto previous = this->current_.exchange(snapshot.release(), std::memory_order_seq_cst);
+      this->version_.store(version, std::memory_order_release);
+      if (previous != nullptr) this->retired_.push_back(previous);
+      this->reclaim_retired();
+      return version;
+   }
+
+   /********************************************************************************
+   * reclaim: Frigr ersatta versioner som ingen lsare lngre anvnder och
+   *          returnerar antalet versioner som fortfarande vntar p att
+   *          frigras. Anropas automatiskt vid varje publicering.
+   ********************************************************************************/
+   std::size_t reclaim(void)
+   {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->reclaim_retired();
+      return this->retired_.size();
+   }
+
+   /********************************************************************************
+   * version: Returnerar versionsnumret fr senast publicerade version
+   *          (0 = ingen version har publicerats). Numret lagras separat frn
+   *          versionerna, d en version kan frigras av en samtidig
+   *          publicering s snart den har ersatts.
+   ********************************************************************************/
+   std::uint64_t version(void) const
+   {
+      return this->version_.load(std::memory_order_acquire);
+   }
+
+   /********************************************************************************
+   * max_readers: Returnerar maximalt antal samtidiga lsare.
+   ********************************************************************************/
+   std::size_t max_readers(void) const
+   {
+      return this->num_slots_;
+   }
+
+private:
+   /********************************************************************************
+   * reclaim_retired: Frigr ersatta versioner som inte finns p ngon lsares
+   *                  plats, vilket frutstter att mutexen r lst. En lsare
+   *                  som deklarerar en ersatt version efter genomlsningen
+   *                  upptcker ersttningen vid sin kontrollsning och vljer
+   *                  i stllet aktuell version.
+   ********************************************************************************/
+   void reclaim_retired(void)
+   {
+      if (this->retired_.empty()) return;
+      std::vector<const snapshot_type*> hazards;
+      hazards.reserve(this->num_slots_);
+
+      for (std::size_t i = 0; i < this->num_slots_; ++i)
+      {
+         const auto hazard = this->slots_[i].hazard.load(std::memory_order_seq_cst);
+         if (hazard != nullptr) hazards.push_back(hazard);
+      }
+
+      std::size_t num_kept = 0;
+
+      for (const auto i : this->retired_)
+      {
+         if (std::find(hazards.begin(), hazards.end(), i) != hazards.end())
+         {
+            this->retired_[num_kept++] = i;
+         }
+         else
+         {
+            delete i;
+         }
+      }
+
+      this->retired_.resize(num_kept);
+      return;
+   }
+
+   std::unique_ptr<reader_slot[]> slots_;               /* Platser fr lsarna. */
+   std::size_t num_slots_;                              /* Antalet platser. */
+   std::atomic<const snapshot_type*> current_{nullptr}; /* Senast publicerade version. */
+   std::vector<const snapshot_type*> retired_;          /* Ersatta versioner som inte har frigjorts. */
+   std::atomic<std::uint64_t> version_{0};              /* Senast publicerat versionsnummer. */
+   std::mutex mutex_;                                   /* Serialiserar publicering och frigring. */
+};
+
+/********************************************************************************
+* snapshot_publisher: Publicerare fr modeller skapade frn klassen ann.
+********************************************************************************/
+using snapshot_publisher = basic_snapshot_publisher<double>;
+
+#endif /* SNAPSHOT_HPP_ */
@@ -0,0 +1,288 @@
+/********************************************************************************
+* sparse_ann.hpp: Innehller gles prediktion via klasstemplaten basic_sparse_ann,
+*                 dr ett beskuret neuralt ntverks vikter lagras i formatet
+*                 CSR (compressed sparse row). Enbart vikter skilda frn 0
+*                 lagras tillsammans med sina kolumnindex, vilket gr att bde
+*                 minnesbehov och berkningstid vid prediktion minskar i
+*                 proportion till andelen vikter som satts till 0, exempelvis
+*                 via medlemsfunktionen prune i klassen ann. Nodernas summor
+*                 berknas via krnan sparse_dot i strukten simd_kernels, vilken
+*                 hmtar insignalerna via gather-instruktioner dr det stds.
+********************************************************************************/
+#ifndef SPARSE_ANN_HPP_
+#define SPARSE_ANN_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "ann.hpp"
+#include "simd.hpp"
+#include "activation.hpp"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/********************************************************************************
+* basic_sparse_ann: Klass fr gles prediktion via ett beskuret neuralt ntverk
+*                   med flyttal av typen T. Varje lager lagrar sina vikter
+*                   skilda frn 0 radvis efter varandra tillsammans med
+*                   respektive vikts kolumnindex (index fr motsvarande
+*                   insignal) samt startindex fr varje rad, dr rad i
+*                   omfattar elementen frn row_offsets[i] till
+*                   row_offsets[i + 1]. Bias lagras som i flyttalsntverket.
+*                   Berkningarna r ekvivalenta med flyttalsntverkets,
+*                   bortsett frn avrundningsskillnader till fljd av annan
+*                   summeringsordning. Det glesa ntverket r fristende,
+*                   vilket gr att flyttalsntverket kan frigras efter
+*                   konverteringen.
+********************************************************************************/
+template <typename T>
+class basic_sparse_ann
+{
+public:
+   using value_type = T;                       /* Flyttalstyp fr in- och utdata. */
+   using ann_type = basic_ann<T>;              /* Flyttalsntverket som konverteras. */
+   using layer_type = basic_dense_layer<T>;    /* Flyttalsntverkets dense-lager. */
+   using kernels_type = basic_simd_kernels<T>; /* Berkningskrnor fr aktuell flyttalstyp. */
+   using index_type = std::uint32_t;           /* Typ fr kolumnindex. */
+
+private:
+   /********************************************************************************
+   * sparse_layer: Glesa parametrar fr ett dense-lager i formatet CSR.
+   ********************************************************************************/
+   struct sparse_layer
+   {
+      std::vector<T> values;                                     /* Vikter skilda frn 0, radvis. */
+      std::vector<index_type> columns;                           /* Kolumnindex fr varje lagrad vikt. */
+      std::vector<std::size_t> row_offsets;                      /* Startindex fr varje rad samt totalt antal. */
+      std::vector<T> bias;                                       /* Nodernas bias. */
+      std::size_t num_weights{0};                                /* Antalet vikter per nod innan konvertering. */
+      activation_function activation{activation_function::relu}; /* Lagrets aktiveringsfunktion. */
+   };
+
+   std::vector<sparse_layer> layers_;    /* Glesa dolda lager fljt av utgngslagret. */
+   std::vector<std::vector<T>> outputs_; /* Utsignaler fr varje lager. */
+   std::vector<T> input_;                /* Insignaler till ingngslagret, utfyllda med 0. */
+
+   /********************************************************************************
+   * feedforward: Berknar utsignaler fr angivet glest lager via angivna
+   *              insignaler, vars antal mste uppg till lagrets antal vikter
+   *              per nod.
+   *
+   *              - layer  : Referens till det glesa lagret.
+   *              - input  : Pekare till insignalerna.
+   *              - outputs: Referens till vektor dr utsignalerna lagras.
+   ********************************************************************************/
+   static void feedforward(const sparse_layer& layer,
+                           const T* input,
+                           std::vector<T>& outputs)
+   {
+      const auto& kernels = kernels_type::get();
+      const auto values = layer.values.data();
+      const auto columns = layer.columns.data();
+
+      for (std::size_t i = 0; i < outputs.size(); ++i)
+      {
+         const auto first = layer.row_offsets[i];
+         const auto size = layer.row_offsets[i + 1] - first;
+         outputs[i] = layer.bias[i] + kernels.sparse_dot(values + first, columns + first, input, size);
+      }
+
+      basic_activation<T>::activate(layer.activation, outputs.data(), outputs.size());
+      return;
+   }
+
+public:
+   /********************************************************************************
+   * basic_sparse_ann: Defaultkonstruktor, initierar ett tomt glest ntverk.
+   ********************************************************************************/
+   basic_sparse_ann(void) { }
+
+   /********************************************************************************
+   * basic_sparse_ann: Initierar glest ntverk via angivet trnat neuralt
+   *                   ntverk, se medlemsfunktionen convert.
+   *
+   *                   - network: Referens till det trnade ntverket.
+   ********************************************************************************/
+   explicit basic_sparse_ann(const ann_type& network)
+   {
+      this->convert(network.layers());
+      return;
+   }
+
+   /********************************************************************************
+   * convert: Konverterar angivna lager till formatet CSR, dr vikter som r
+   *          exakt 0 utelmnas och eventuella tidigare lager erstts. Samtliga
+   *          buffertar allokeras hr, s att ingen allokering sker vid
+   *          prediktion.
+   *
+   *          - layers: Referens till lagren som ska konverteras, exempelvis
+   *                    via medlemsfunktionen layers i klassen ann efter
+   *                    beskrning via medlemsfunktionen prune.
+   ********************************************************************************/
+   void convert(const std::vector<layer_type>& layers)
+   {
+      this->layers_.assign(layers.size(), sparse_layer());
+      this->outputs_.assign(layers.size(), std::vector<T>());
+
+      for (std::size_t i = 0; i < layers.size(); ++i)
+      {
+         const auto& source = layers[i];
+         auto& layer = this->layers_[i];
+         const auto num_nonzero = source.num_nonzero_weights();
+         layer.num_weights = source.num_weights();
+         layer.bias = source.bias;
+         layer.activation = source.activation;
+         layer.values.reserve(num_nonzero);
+         layer.columns.reserve(num_nonzero);
+         layer.row_offsets.reserve(source.num_nodes() + 1);
+         layer.row_offsets.push_back(0);
+
+         for (std::size_t j = 0; j < source.num_nodes(); ++j)
+         {
+            const auto row = source.weights[j];
+
+            for (std::size_t k = 0; k < layer.num_weights; ++k)
+            {
+               if (row[k] != T(0))
+               {
+                  layer.values.push_back(row[k]);
+                  layer.columns.push_back(static_cast<index_type>(k));
+               }
+            }
+            layer.row_offsets.push_back(layer.values.size());
+         }
+
+         this->outputs_[i].assign(source.num_nodes(), T(0));
+      }
+
+      this->input_.assign(this->num_inputs(), T(0));
+      return;
+   }
+
+   /********************************************************************************
+   * num_inputs: Returnerar antalet insignaler.
+   ********************************************************************************/
+   std::size_t num_inputs(void) const
+   {
+      return this->layers_.empty() ? 0 : this->layers_.front().num_weights;
+   }
+
+   /********************************************************************************
+   * num_outputs: Returnerar antalet utsignaler.
+   ********************************************************************************/
+   std::size_t num_outputs(void) const
+   {
+      return this->outputs_.empty() ? 0 : this->outputs_.back().size();
+   }
+
+   /********************************************************************************
+   * num_layers: Returnerar antalet lager (dolda lager samt utgngslagret).
+   ********************************************************************************/
+   std::size_t num_layers(void) const
+   {
+      return this->layers_.size();
+   }
+
+   /********************************************************************************
+   * num_nonzero: Returnerar antalet lagrade vikter, allts vikter skilda frn 0.
+   ********************************************************************************/
+   std::size_t num_nonzero(void) const
+   {
+      std::size_t result = 0;
+
+      for (const auto& layer : this->layers_)
+      {
+         result += layer.values.size();
+      }
+      return result;
+   }
+
+   /********************************************************************************
+   * density: Returnerar andelen (0 - 1) av flyttalsntverkets vikter som
+   *          lagras, allts 1 minus andelen beskurna vikter.
+   ********************************************************************************/
+   T density(void) const
+   {
+      std::size_t total = 0;
+
+      for (const auto& layer : this->layers_)
+      {
+         total += layer.bias.size() * layer.num_weights;
+      }
+      return total > 0 ? static_cast<T>(this->num_nonzero()) / static_cast<T>(total) : T(0);
+   }
+
+   /********************************************************************************
+   * size_bytes: Returnerar minnesbehovet fr samtliga lagrade vikter,
+   *             kolumnindex, radindex och bias.
+   ********************************************************************************/
+   std::size_t size_bytes(void) const
+   {
+      std::size_t result = 0;
+
+      for (const auto& layer : this->layers_)
+      {
+         result += layer.values.size() * (sizeof(T) + sizeof(index_type))
+            + layer.row_offsets.size() * sizeof(std::size_t) + layer.bias.size() * sizeof(T);
+      }
+      return result;
+   }
+
+   /********************************************************************************
+   * output: Returnerar en referens till utsignalerna frn senaste prediktion.
+   ********************************************************************************/
+   const std::vector<T>& output(void) const
+   {
+      static const std::vector<T> empty;
+      return this->outputs_.empty() ? empty : this->outputs_.back();
+   }
+
+   /********************************************************************************
+   * predict: Genomfr gles prediktion via angiven indata och returnerar en
+   *          referens till en vektor innehllande utdatan.
+   *
+   *          - input: Referens till vektor innehllande indata.
+   ********************************************************************************/
+   const std::vector<T>& predict(const std::vector<T>& input)
+   {
+      return this->predict(input.data(), input.size());
+   }
+
+   /********************************************************************************
+   * predict: Genomfr gles prediktion via indata lagrad p angiven adress och
+   *          returnerar en referens till en vektor innehllande utdatan.
+   *          Vid frre insignaler n frvntat stts resterande insignaler
+   *          till 0, medan verskjutande insignaler ignoreras.
+   *
+   *          - input: Pekare till indatan.
+   *          - size : Antalet insignaler.
+   ********************************************************************************/
+   const std::vector<T>& predict(const T* input,
+                                 const std::size_t size)
+   {
+      if (this->layers_.empty()) return this->output();
+
+      if (size < this->input_.size())
+      {
+         for (std::size_t i = 0; i < this->input_.size(); ++i)
+         {
+            this->input_[i] = i < size ? input[i] : T(0);
+         }
+         input = this->input_.data();
+      }
+
+      feedforward(this->layers_[0], input, this->outputs_[0]);
+
+      for (std::size_t i = 1; i < this->layers_.size(); ++i)
+      {
+         feedforward(this->layers_[i], this->outputs_[i - 1].data(), this->outputs_[i]);
+      }
+      return this->output();
+   }
+};
+
+/********************************************************************************
+* sparse_ann: Glest neuralt ntverk skapat frn klassen ann.
+********************************************************************************/
+using sparse_ann = basic_sparse_ann<double>;
+
+#endif /* SPARSE_ANN_HPP_ */
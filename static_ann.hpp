@@ -0,0 +1,509 @@
+/********************************************************************************
+* static_ann.hpp: Innehller funktionalitet fr implementering av sm neurala
+*                 ntverk med fast topologi via klassen static_ann samt strukten
+*                 static_dense_layer. Samtliga storlekar anges som mallparametrar,
+*                 vilket gr att samtliga parametrar lagras i std::array och att
+*                 samtliga loopar rullas ut vid kompilering. Trningen sker p
+*                 samma stt som fr klassen ann med ReLU-aktivering i samtliga
+*                 lager, vilket innebr att ett ntverk av typen
+*                 static_ann<2, 2, 1> ger samma resultat som ann(2, 2, 1) vid
+*                 samma startvrde fr respektive ntverks generator.
+********************************************************************************/
+#ifndef STATIC_ANN_HPP_
+#define STATIC_ANN_HPP_
+
+/* Inkluderingsdirektiv: */
+#include "random.hpp"
+#include <array>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <iostream>
+#include <iomanip>
+
+/********************************************************************************
+* static_dense_layer: Strukt fr implementering av dense-lager med fast antal
+*                     noder samt vikter per nod. Samtliga parametrar stts till
+*                     0 vid start. Via medlemsfunktionen randomize erhller bias
+*                     och vikter randomiserade startvrden i samma ordning och
+*                     enligt samma metoder som i strukten dense_layer.
+********************************************************************************/
+template <std::size_t Nodes, std::size_t Weights>
+struct static_dense_layer
+{
+   using input_type = std::array<double, Weights>; /* Lagrets insignaler. */
+   using output_type = std::array<double, Nodes>;  /* Lagrets utsignaler. */
+
+   output_type output{};                     /* Nodernas utsignaler. */
+   output_type error{};                      /* Nodernas uppmtta fel/avvikelser. */
+   output_type bias{};                       /* Nodernas vilovrden (m-vrden). */
+   std::array<input_type, Nodes> weights{};  /* Nodernas vikter (k-vrden). */
+
+   /********************************************************************************
+   * randomize: Tilldelar bias och vikter randomiserade startvrden frn angiven
+   *            generator, dr varje nods bias fljs av nodens vikter, se
+   *            motsvarande medlemsfunktion i strukten dense_layer.
+   *
+   *            - generator: Referens till generatorn som startvrdena hmtas frn.
+   *            - init     : Metod fr tilldelning av startvrden (default = uniform).
+   ********************************************************************************/
+   void randomize(random_generator& generator,
+                  const weight_init init = weight_init::uniform)
+   {
+      const auto limit = weight_init_limit<double>(init, Nodes, Weights);
+
+      for (std::size_t i = 0; i < Nodes; ++i)
+      {
+         this->bias[i] = init == weight_init::uniform ? generator.uniform<double>() : 0.0;
+
+         for (std::size_t j = 0; j < Weights; ++j)
+         {
+            this->weights[i][j] = init == weight_init::uniform ?
+               generator.uniform<double>() : generator.uniform<double>(-limit, limit);
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * num_nodes: Returnerar antalet noder i angivet dense-lager.
+   ********************************************************************************/
+   static constexpr std::size_t num_nodes(void)
+   {
+      return Nodes;
+   }
+
+   /********************************************************************************
+   * num_weights: Returnerar antalet vikter per nod i angivet dense-lager.
+   ********************************************************************************/
+   static constexpr std::size_t num_weights(void)
+   {
+      return Weights;
+   }
+
+   /********************************************************************************
+   * feedforward: Berknar nya utsignaler fr varje nod i angivet dense-lager via
+   *              angivna insignaler, se motsvarande medlemsfunktion i strukten
+   *              dense_layer.
+   *
+   *              - input: Referens till array med nya insignaler.
+   ********************************************************************************/
+   inline void feedforward(const input_type& input)
+   {
+      this->feedforward(input, std::make_index_sequence<Nodes>{});
+      return;
+   }
+
+   /********************************************************************************
+   * backpropagate: Berknar fel/avvikelser i angivet utgngslager via angivna
+   *                referensvrden. OBS! Denna medlemsfunktion r avsedd enbart
+   *                fr utgngslager.
+   *
+   *                - reference: Referens till array innehllande referensvrden.
+   ********************************************************************************/
+   inline void backpropagate(const output_type& reference)
+   {
+      this->backpropagate(reference, std::make_index_sequence<Nodes>{});
+      return;
+   }
+
+   /********************************************************************************
+   * backpropagate: Berknar fel/avvikelser i angivet dolt lager via parametrar
+   *                frn nsta lager. OBS! Denna medlemsfunktion r avsedd enbart
+   *                fr dolda lager.
+   *
+   *                - next_layer: Referens till nsta/efterfljande dense-lager.
+   ********************************************************************************/
+   template <std::size_t NextNodes>
+   inline void backpropagate(const static_dense_layer<NextNodes, Nodes>& next_layer)
+   {
+      this->backpropagate(next_layer, std::make_index_sequence<Nodes>{});
+      return;
+   }
+
+   /********************************************************************************
+   * optimize: Justerar bias och vikter i angivet dense-lager utefter berknade
+   *           felvrden samt angiven lrhastighet.
+   *
+   *           - input        : Referens till array innehllande insignaler.
+   *           - learning_rate: Indikerar hur hg andel av aktuell fel som
+   *                            bias och vikter ska justeras.
+   ********************************************************************************/
+   inline void optimize(const input_type& input,
+                        const double learning_rate)
+   {
+      this->optimize(input, learning_rate, std::make_index_sequence<Nodes>{});
+      return;
+   }
+
+private:
+   /********************************************************************************
+   * Hjlpfunktioner dr looparna ver noder och vikter utgrs av fold-uttryck
+   * ver indexsekvenser, vilket gr att de rullas ut helt vid kompilering.
+   * Summeringsordningen r densamma som i de skalra looparna i dense_layer.
+   ********************************************************************************/
+   template <std::size_t... I>
+   inline void feedforward(const input_type& input, std::index_sequence<I...>)
+   {
+      ((this->output[I] = relu(this->bias[I] + dot(input, this->weights[I], std::make_index_sequence<Weights>{}))), ...);
+      return;
+   }
+
+   template <std::size_t... I>
+   inline void backpropagate(const output_type& reference, std::index_sequence<I...>)
+   {
+      ((this->error[I] = (reference[I] - this->output[I]) * delta_relu(this->output[I])), ...);
+      return;
+   }
+
+   template <std::size_t NextNodes, std::size_t... I>
+   inline void backpropagate(const static_dense_layer<NextNodes, Nodes>& next_layer,
+                             std::index_sequence<I...>)
+   {
+      ((this->error[I] = backpropagated_error<I>(next_layer, std::make_index_sequence<NextNodes>{}) *
+                         delta_relu(this->output[I])), ...);
+      return;
+   }
+
+   template <std::size_t I, std::size_t NextNodes, std::size_t... J>
+   static inline double backpropagated_error(const static_dense_layer<NextNodes, Nodes>& next_layer,
+                                             std::index_sequence<J...>)
+   {
+      return (0.0 + ... + (next_layer.error[J] * next_layer.weights[J][I]));
+   }
+
+   template <std::size_t... I>
+   inline void optimize(const input_type& input, const double learning_rate, std::index_sequence<I...>)
+   {
+      (this->optimize_node<I>(input, learning_rate, std::make_index_sequence<Weights>{}), ...);
+      return;
+   }
+
+   template <std::size_t I, std::size_t... J>
+   inline void optimize_node(const input_type& input, const double learning_rate, std::index_sequence<J...>)
+   {
+      const auto delta = this->error[I] * learning_rate;
+      this->bias[I] += delta;
+      ((this->weights[I][J] += delta * input[J]), ...);
+      return;
+   }
+
+   template <std::size_t... J>
+   static inline double dot(const input_type& x, const input_type& y, std::index_sequence<J...>)
+   {
+      return (0.0 + ... + (x[J] * y[J]));
+   }
+
+   static inline double relu(const double sum)
+   {
+      return sum > 0.0 ? sum : 0.0;
+   }
+
+   static inline double delta_relu(const double output)
+   {
+      return output > 0.0 ? 1.0 : 0.0;
+   }
+};
+
+/********************************************************************************
+* static_ann: Klass fr implementering av neuralt ntverk med fast topologi,
+*             dr antalet noder i respektive lager anges som mallparametrar i
+*             ordning frn ingngslagret till utgngslagret. Exempelvis utgr
+*             static_ann<2, 2, 1> ett ntverk med tv ingngar, ett dolt lager
+*             med tv noder samt en utgng. Lagren lagras i en std::tuple, dr
+*             varje lager har sin egen typ och drmed sina egna storlekar.
+********************************************************************************/
+template <std::size_t... Sizes>
+class static_ann
+{
+   static_assert(sizeof...(Sizes) >= 2, "static_ann requires at least an input and an output size.");
+
+   static constexpr std::size_t num_sizes_ = sizeof...(Sizes);
+   static constexpr std::array<std::size_t, num_sizes_> sizes_{ Sizes... };
+
+   template <std::size_t... I>
+   static auto make_layers(std::index_sequence<I...>)
+      -> std::tuple<static_dense_layer<sizes_[I + 1], sizes_[I]>...>;
+
+public:
+   using layers_type = decltype(make_layers(std::make_index_sequence<num_sizes_ - 1>{})); /* Samtliga lager. */
+   using input_type = std::array<double, sizes_[0]>;                                     /* Ntverkets indata. */
+   using output_type = std::array<double, sizes_[num_sizes_ - 1]>;                       /* Ntverkets utdata. */
+
+   static constexpr std::size_t num_layers = num_sizes_ - 1; /* Antalet lager. */
+
+   /********************************************************************************
+   * static_ann: Initierar nytt neuralt ntverk med randomiserade parametrar, dr
+   *             lagren randomiseras i ordning frn det frsta dolda lagret.
+   ********************************************************************************/
+   static_ann(void)
+   {
+      this->randomize();
+      return;
+   }
+
+   /********************************************************************************
+   * seed: Initierar om ntverkets generator frn angivet startvrde, se
+   *       motsvarande medlemsfunktion i klassen ann.
+   *
+   *       - seed: Nytt startvrde fr generatorn.
+   ********************************************************************************/
+   void seed(const random_generator::result_type seed)
+   {
+      this->generator_.seed(seed);
+      return;
+   }
+
+   /********************************************************************************
+   * randomize: Tilldelar samtliga lager nya randomiserade startvrden frn
+   *            ntverkets generator, dr lagren randomiseras i ordning frn
+   *            det frsta dolda lagret.
+   *
+   *            - init: Metod fr tilldelning av startvrden (default = uniform).
+   ********************************************************************************/
+   void randomize(const weight_init init = weight_init::uniform)
+   {
+      this->randomize(init, std::make_index_sequence<num_layers>{});
+      return;
+   }
+
+   /********************************************************************************
+   * num_inputs: Returnerar antalet ingngsnoder i angivet neuralt ntverk.
+   ********************************************************************************/
+   static constexpr std::size_t num_inputs(void)
+   {
+      return sizes_[0];
+   }
+
+   /********************************************************************************
+   * num_outputs: Returnerar antalet utgngsnoder i angivet neuralt ntverk.
+   ********************************************************************************/
+   static constexpr std::size_t num_outputs(void)
+   {
+      return sizes_[num_sizes_ - 1];
+   }
+
+   /********************************************************************************
+   * layer: Returnerar en referens till lagret p angivet index, dr index 0
+   *        utgr det frsta dolda lagret och index num_layers - 1 utgr
+   *        utgngslagret.
+   ********************************************************************************/
+   template <std::size_t Index>
+   const auto& layer(void) const
+   {
+      return std::get<Index>(this->layers_);
+   }
+
+   /********************************************************************************
+   * output: Returnerar en referens till utsignalerna i utgngslagret.
+   ********************************************************************************/
+   const output_type& output(void) const
+   {
+      return std::get<num_layers - 1>(this->layers_).output;
+   }
+
+   /********************************************************************************
+   * num_training_sets: Returnerar antalet befintliga trningsuppsttningar.
+   ********************************************************************************/
+   std::size_t num_training_sets(void) const
+   {
+      return this->train_order_.size();
+   }
+
+   /********************************************************************************
+   * set_training_data: Lagrar trningsdata fr angivet neuralt ntverk via
+   *                    kopiering av innehllet frn refererade vektorer. Ifall
+   *                    ett ojmnt antal trningsuppsttningar passeras sparas
+   *                    endast de trningsuppsttningar som bestr av bde in-
+   *                    och utdata.
+   *
+   *                    - train_in : Referens till vektor innehllande indata.
+   *                    - train_out: Referens till vektor innehllande utdata.
+   ********************************************************************************/
+   void set_training_data(const std::vector<input_type>& train_in,
+                          const std::vector<output_type>& train_out)
+   {
+      const auto num_sets = train_in.size() < train_out.size() ? train_in.size() : train_out.size();
+      this->train_in_.assign(train_in.begin(), train_in.begin() + num_sets);
+      this->train_out_.assign(train_out.begin(), train_out.begin() + num_sets);
+      this->train_order_.resize(num_sets);
+
+      for (std::size_t i = 0; i < num_sets; ++i)
+      {
+         this->train_order_[i] = i;
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * train: Trnar angivet neuralt ntverk under angivet antal epoker med
+   *        godtycklig lrhastighet, se motsvarande medlemsfunktion i klassen ann.
+   *
+   *        - num_epochs   : Antalet epoker som trning ska genomfras under.
+   *        - learning_rate: Lrhastigheten, avgr hur mycket ntverkets
+   *                         parametrar justeras vid fel.
+   ********************************************************************************/
+   void train(const std::size_t num_epochs,
+              const double learning_rate)
+   {
+      for (std::size_t i = 0; i < num_epochs; ++i)
+      {
+         this->randomize_training_order();
+
+         for (auto& j : this->train_order_)
+         {
+            const auto& input = this->train_in_[j];
+            this->feedforward(input);
+            this->backpropagate(this->train_out_[j]);
+            this->optimize(input, learning_rate);
+         }
+      }
+      return;
+   }
+
+   /********************************************************************************
+   * predict: Genomfr prediktion via angiven indata och returnerar en referens
+   *          till utgngslagrets utsignaler.
+   *
+   *          - input: Referens till array innehllande indata.
+   ********************************************************************************/
+   const output_type& predict(const input_type& input)
+   {
+      this->feedforward(input);
+      return this->output();
+   }
+
+   /********************************************************************************
+   * print: Genomfr prediktion med samtliga befintliga trningsuppsttningars
+   *        indata och skriver ut predikterad utdata via angiven utstrm.
+   *
+   *        - num_decimals: Antalet decimaler vid utskrift (default = 1).
+   *        - ostream     : Referens till godtycklig utstrm (default = std::cout).
+   ********************************************************************************/
+   void print(const std::size_t num_decimals = 1,
+              std::ostream& ostream = std::cout)
+   {
+      if (this->train_in_.empty()) return;
+      ostream << "--------------------------------------------------------------------------------\n";
+
+      for (std::size_t i = 0; i < this->train_in_.size(); ++i)
+      {
+         ostream << "Input:\t";
+         print(this->train_in_[i], ostream, num_decimals);
+
+         ostream << "Output:\t";
+         print(this->predict(this->train_in_[i]), ostream, num_decimals);
+
+         if (i + 1 < this->train_in_.size()) ostream << "\n";
+      }
+
+      ostream << "--------------------------------------------------------------------------------\n\n";
+      return;
+   }
+
+private:
+   layers_type layers_;                   /* Dolda lager fljt av utgngslagret. */
+   std::vector<input_type> train_in_;     /* Trningsdata in (insignaler). */
+   std::vector<output_type> train_out_;   /* Trningsdata ut (referensvrden). */
+   std::vector<std::size_t> train_order_; /* Lagrar ordningsfljden fr trningsdatan. */
+   random_generator generator_;           /* Generator fr startvrden och trningsordning. */
+
+   /********************************************************************************
+   * randomize: Randomiserar parametrarna i samtliga lager i ordning, vilket
+   *            inte kan verltas t std::tuple, d ordningen som elementen
+   *            konstrueras i r ospecificerad.
+   ********************************************************************************/
+   template <std::size_t... I>
+   void randomize(const weight_init init,
+                  std::index_sequence<I...>)
+   {
+      (std::get<I>(this->layers_).randomize(this->generator_, init), ...);
+      return;
+   }
+
+   /********************************************************************************
+   * feedforward: Berknar nya utsignaler fr samtliga lager, dr varje lager
+   *              anvnder fregende lagers utsignaler som insignaler.
+   ********************************************************************************/
+   inline void feedforward(const input_type& input)
+   {
+      std::get<0>(this->layers_).feedforward(input);
+      this->feedforward(std::make_index_sequence<num_layers - 1>{});
+      return;
+   }
+
+   template <std::size_t... I>
+   inline void feedforward(std::index_sequence<I...>)
+   {
+      (std::get<I + 1>(this->layers_).feedforward(std::get<I>(this->layers_).output), ...);
+      return;
+   }
+
+   /********************************************************************************
+   * backpropagate: Berknar aktuella fel fr samtliga lager, dr utgngslagrets
+   *                fel berknas frst, fljt av de dolda lagren i omvnd ordning.
+   ********************************************************************************/
+   inline void backpropagate(const output_type& reference)
+   {
+      std::get<num_layers - 1>(this->layers_).backpropagate(reference);
+      this->backpropagate(std::make_index_sequence<num_layers - 1>{});
+      return;
+   }
+
+   template <std::size_t... I>
+   inline void backpropagate(std::index_sequence<I...>)
+   {
+      (std::get<num_layers - 2 - I>(this->layers_).backpropagate(std::get<num_layers - 1 - I>(this->layers_)), ...);
+      return;
+   }
+
+   /********************************************************************************
+   * optimize: Justerar parametrarna i samtliga lager, med brjan i utgngslagret.
+   ********************************************************************************/
+   inline void optimize(const input_type& input,
+                        const double learning_rate)
+   {
+      this->optimize(learning_rate, std::make_index_sequence<num_layers - 1>{});
+      std::get<0>(this->layers_).optimize(input, learning_rate);
+      return;
+   }
+
+   template <std::size_t... I>
+   inline void optimize(const double learning_rate, std::index_sequence<I...>)
+   {
+      (std::get<num_layers - 1 - I>(this->layers_).optimize(std::get<num_layers - 2 - I>(this->layers_).output, learning_rate), ...);
+      return;
+   }
+
+   /********************************************************************************
+   * randomize_training_order: Randomiserar ordningsfljden fr befintliga
+   *                           trningsuppsttningar p samma stt som i klassen
+   *                           ann.
+   ********************************************************************************/
+   void randomize_training_order(void)
+   {
+      this->generator_.shuffle(this->train_order_);
+      return;
+   }
+
+   /********************************************************************************
+   * print: Skriver ut flyttal frn angiven array p en rad via angiven utstrm.
+   ********************************************************************************/
+   template <std::size_t Size>
+   static void print(const std::array<double, Size>& data,
+                     std::ostream& ostream,
+                     const std::size_t num_decimals)
+   {
+      ostream << std::fixed;
+
+      for (auto& i : data)
+      {
+         ostream << std::setprecision(num_decimals) << i << " ";
+      }
+
+      ostream << "\n";
+      return;
+   }
+};
+
+#endif /* STATIC_ANN_HPP_ */